@@ -0,0 +1,178 @@
+/**
+ * Audio DSP Kernels
+ *
+ * 16-bit PCM helpers for the hot per-sample loops: channel conversion,
+ * saturating gain, mixing, the Q15 FIR tap used by the resampler and the
+ * frame energy behind voice activity detection. On ESP32-P4 the bulk of each buffer runs on
+ * the PIE vector unit (8 samples per instruction) when pointers are 16-byte
+ * aligned; tails and unaligned buffers use the scalar path. Also provides
+ * the base64 encoder used to frame PCM for JSON transports.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Required buffer alignment for the vector path
+ */
+#define AUDIO_DSP_ALIGN 16
+
+/**
+ * @brief Unity gain in Q8 format
+ */
+#define AUDIO_DSP_GAIN_UNITY 256
+
+/**
+ * @brief Extract the left channel of interleaved stereo
+ *
+ * @param stereo Interleaved L/R input, 2 * frames samples
+ * @param mono Output, frames samples (may not overlap stereo)
+ * @param frames Number of stereo frames
+ */
+void audio_dsp_deinterleave_left(const int16_t *stereo, int16_t *mono, size_t frames);
+
+/**
+ * @brief Duplicate mono into both stereo channels with saturating gain
+ *
+ * @param mono Input, frames samples
+ * @param stereo Interleaved output, 2 * frames samples
+ * @param frames Number of frames
+ * @param gain_q8 Gain in Q8 (256 = 1.0, 512 = 2.0)
+ */
+void audio_dsp_mono_to_stereo_gain(const int16_t *mono, int16_t *stereo, size_t frames, uint16_t gain_q8);
+
+/**
+ * @brief Apply saturating gain
+ *
+ * @param src Input samples
+ * @param dst Output samples (may equal src)
+ * @param samples Number of samples
+ * @param gain_q8 Gain in Q8 (256 = 1.0)
+ */
+void audio_dsp_gain(const int16_t *src, int16_t *dst, size_t samples, uint16_t gain_q8);
+
+/**
+ * @brief Mix src into dst with saturation (dst = sat(dst + src))
+ *
+ * @param dst Accumulator samples
+ * @param src Samples to add
+ * @param samples Number of samples
+ */
+void audio_dsp_mix(int16_t *dst, const int16_t *src, size_t samples);
+
+/**
+ * @brief Q15 FIR tap: sat16(sum(x[i] * coef_q15[i]) >> 15)
+ *
+ * Runs on the vector unit when both pointers are 16-byte aligned and taps
+ * is a multiple of 8, otherwise on the scalar path. Both accumulate without
+ * intermediate rounding, so they produce identical results.
+ *
+ * @param x Input window, taps samples
+ * @param coef_q15 Coefficients in Q15, taps values
+ * @param taps Number of taps
+ * @return Filtered sample
+ */
+int16_t audio_dsp_fir_q15(const int16_t *x, const int16_t *coef_q15, size_t taps);
+
+/**
+ * @brief Frame energy: sum(x[i]^2) >> 15
+ *
+ * Runs on the vector unit (the FIR tap with x as its own coefficients) when
+ * x is 16-byte aligned. Sums are taken in runs of 512 samples so the 40-bit
+ * accumulator cannot overflow, and each run is truncated separately.
+ *
+ * @param x Samples
+ * @param samples Number of samples
+ * @return Energy in Q15-scaled squared sample units
+ */
+uint32_t audio_dsp_energy(const int16_t *x, size_t samples);
+
+/**
+ * @brief Count sign changes between adjacent samples
+ */
+size_t audio_dsp_zero_crossings(const int16_t *x, size_t samples);
+
+/**
+ * @brief Voice activity detector state
+ *
+ * Classifies fixed-length frames as speech when their power stands above
+ * an adaptive noise floor and their zero-crossing rate is in the range of
+ * speech, which rejects hum below it and broadband hiss above it. Speech
+ * starts after onset_frames speech frames in a row and ends hangover_frames
+ * after the last one.
+ */
+typedef struct {
+    uint32_t frame_ms;
+    uint32_t threshold_q8;      // Speech when power > noise floor * threshold_q8 / 256
+    uint32_t onset_frames;
+    uint32_t hangover_frames;
+    uint32_t noise_floor;       // Mean square of the background
+    uint32_t power;             // Mean square of the last frame
+    uint32_t run;               // Consecutive speech frames
+    uint32_t hang;              // Frames left before speech ends
+    bool speech;
+    bool primed;                // Noise floor seeded from the first frame
+} audio_dsp_vad_t;
+
+/**
+ * @brief Initialize a voice activity detector
+ *
+ * @param vad State to initialize
+ * @param frame_ms Duration of each frame passed to audio_dsp_vad_process()
+ * @param threshold_db Margin above the noise floor that counts as speech
+ * @param hangover_ms How long speech persists after the last speech frame
+ */
+void audio_dsp_vad_init(audio_dsp_vad_t *vad, uint32_t frame_ms, uint32_t threshold_db, uint32_t hangover_ms);
+
+/**
+ * @brief Classify one frame
+ *
+ * @param vad Detector
+ * @param x Frame samples (16-byte aligned for the vector path)
+ * @param samples Samples in the frame
+ * @return true while speech is active (including the hangover)
+ */
+bool audio_dsp_vad_process(audio_dsp_vad_t *vad, const int16_t *x, size_t samples);
+
+/**
+ * @brief Convert a mean square power to dBFS (full-scale sine is about -3)
+ */
+int32_t audio_dsp_power_db(uint32_t power);
+
+/**
+ * @brief Base64 output length (with padding) for n input bytes
+ */
+#define AUDIO_DSP_BASE64_LEN(n) ((((n) + 2) / 3) * 4)
+
+/**
+ * @brief Base64 encode a PCM payload for JSON transports
+ *
+ * Uses a 12-bit pair table in internal RAM, so each 3 input bytes take two
+ * lookups and one 32-bit store when dst is 4-byte aligned. No terminator is
+ * written.
+ *
+ * @param src Input bytes
+ * @param len Input length
+ * @param dst Output, AUDIO_DSP_BASE64_LEN(len) bytes
+ * @return Number of characters written
+ */
+size_t audio_dsp_base64_encode(const uint8_t *src, size_t len, char *dst);
+
+/**
+ * @brief Log cycles per sample for every kernel
+ *
+ * Runs each kernel on a 1024-frame buffer, scalar and (if enabled) PIE,
+ * then reports base64 throughput in bytes per cycle.
+ */
+void audio_dsp_run_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
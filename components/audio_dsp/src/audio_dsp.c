@@ -0,0 +1,195 @@
+/**
+ * Audio DSP Kernels
+ *
+ * Dispatches to the PIE kernels for whole 8-sample blocks when both buffers
+ * are 16-byte aligned and finishes the remainder with the scalar kernels.
+ */
+
+#include "audio_dsp.h"
+#include "audio_dsp_priv.h"
+#include <string.h>
+
+#define IS_ALIGNED(p) ((((uintptr_t)(p)) & (AUDIO_DSP_ALIGN - 1)) == 0)
+
+static inline int16_t sat16(int32_t v)
+{
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+void audio_dsp_split_gain(uint16_t gain_q8, audio_dsp_gain_split_t *split)
+{
+    uint32_t doublings = 0;
+    while (((uint32_t)AUDIO_DSP_GAIN_UNITY << doublings) < gain_q8) {
+        doublings++;
+    }
+
+    split->doublings = doublings;
+    if (gain_q8 == ((uint32_t)AUDIO_DSP_GAIN_UNITY << doublings)) {
+        split->frac_q15 = 0;  // Exact power of two, no multiply
+    } else {
+        split->frac_q15 = ((uint32_t)gain_q8 << 7) >> doublings;
+    }
+}
+
+void audio_dsp_scalar_deinterleave_left(const int16_t *stereo, int16_t *mono, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        mono[i] = stereo[i * 2];
+    }
+}
+
+void audio_dsp_scalar_mono_to_stereo_gain(const int16_t *mono, int16_t *stereo, size_t frames, uint16_t gain_q8)
+{
+    for (size_t i = 0; i < frames; i++) {
+        int16_t sample = sat16(((int32_t)mono[i] * gain_q8) >> 8);
+        stereo[i * 2] = sample;
+        stereo[i * 2 + 1] = sample;
+    }
+}
+
+void audio_dsp_scalar_gain(const int16_t *src, int16_t *dst, size_t samples, uint16_t gain_q8)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = sat16(((int32_t)src[i] * gain_q8) >> 8);
+    }
+}
+
+void audio_dsp_scalar_mix(int16_t *dst, const int16_t *src, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = sat16((int32_t)dst[i] + src[i]);
+    }
+}
+
+int16_t audio_dsp_scalar_fir_q15(const int16_t *x, const int16_t *coef_q15, size_t taps)
+{
+    // 64-bit so long filters behave like the 40-bit vector accumulator
+    int64_t acc = 0;
+    for (size_t i = 0; i < taps; i++) {
+        acc += (int32_t)x[i] * coef_q15[i];
+    }
+    acc >>= 15;
+    if (acc > 32767) return 32767;
+    if (acc < -32768) return -32768;
+    return (int16_t)acc;
+}
+
+uint32_t audio_dsp_scalar_energy(const int16_t *x, size_t samples)
+{
+    uint32_t energy = 0;
+    while (samples > 0) {
+        size_t n = (samples < AUDIO_DSP_ENERGY_RUN) ? samples : AUDIO_DSP_ENERGY_RUN;
+        int64_t acc = 0;
+        for (size_t i = 0; i < n; i++) {
+            acc += (int32_t)x[i] * x[i];
+        }
+        energy += (uint32_t)(acc >> 15);
+        x += n;
+        samples -= n;
+    }
+    return energy;
+}
+
+void audio_dsp_deinterleave_left(const int16_t *stereo, int16_t *mono, size_t frames)
+{
+    size_t done = 0;
+#if CONFIG_AUDIO_DSP_USE_PIE
+    if (IS_ALIGNED(stereo) && IS_ALIGNED(mono)) {
+        size_t blocks = frames / AUDIO_DSP_BLOCK;
+        audio_dsp_pie_deinterleave_left(stereo, mono, blocks);
+        done = blocks * AUDIO_DSP_BLOCK;
+    }
+#endif
+    audio_dsp_scalar_deinterleave_left(stereo + done * 2, mono + done, frames - done);
+}
+
+void audio_dsp_mono_to_stereo_gain(const int16_t *mono, int16_t *stereo, size_t frames, uint16_t gain_q8)
+{
+    size_t done = 0;
+#if CONFIG_AUDIO_DSP_USE_PIE
+    if (gain_q8 != 0 && IS_ALIGNED(mono) && IS_ALIGNED(stereo)) {
+        audio_dsp_gain_split_t split;
+        audio_dsp_split_gain(gain_q8, &split);
+        size_t blocks = frames / AUDIO_DSP_BLOCK;
+        audio_dsp_pie_mono_to_stereo_gain(mono, stereo, blocks, split.doublings, split.frac_q15);
+        done = blocks * AUDIO_DSP_BLOCK;
+    }
+#endif
+    audio_dsp_scalar_mono_to_stereo_gain(mono + done, stereo + done * 2, frames - done, gain_q8);
+}
+
+void audio_dsp_gain(const int16_t *src, int16_t *dst, size_t samples, uint16_t gain_q8)
+{
+    if (gain_q8 == AUDIO_DSP_GAIN_UNITY) {
+        if (dst != src) {
+            memmove(dst, src, samples * sizeof(int16_t));
+        }
+        return;
+    }
+
+    size_t done = 0;
+#if CONFIG_AUDIO_DSP_USE_PIE
+    if (gain_q8 != 0 && IS_ALIGNED(src) && IS_ALIGNED(dst)) {
+        audio_dsp_gain_split_t split;
+        audio_dsp_split_gain(gain_q8, &split);
+        size_t blocks = samples / AUDIO_DSP_BLOCK;
+        audio_dsp_pie_gain(src, dst, blocks, split.doublings, split.frac_q15);
+        done = blocks * AUDIO_DSP_BLOCK;
+    }
+#endif
+    audio_dsp_scalar_gain(src + done, dst + done, samples - done, gain_q8);
+}
+
+void audio_dsp_mix(int16_t *dst, const int16_t *src, size_t samples)
+{
+    size_t done = 0;
+#if CONFIG_AUDIO_DSP_USE_PIE
+    if (IS_ALIGNED(dst) && IS_ALIGNED(src)) {
+        size_t blocks = samples / AUDIO_DSP_BLOCK;
+        audio_dsp_pie_mix(dst, src, blocks);
+        done = blocks * AUDIO_DSP_BLOCK;
+    }
+#endif
+    audio_dsp_scalar_mix(dst + done, src + done, samples - done);
+}
+
+int16_t audio_dsp_fir_q15(const int16_t *x, const int16_t *coef_q15, size_t taps)
+{
+#if CONFIG_AUDIO_DSP_USE_PIE
+    if ((taps % AUDIO_DSP_BLOCK) == 0 && IS_ALIGNED(x) && IS_ALIGNED(coef_q15)) {
+        return sat16(audio_dsp_pie_fir_q15(x, coef_q15, taps / AUDIO_DSP_BLOCK));
+    }
+#endif
+    return audio_dsp_scalar_fir_q15(x, coef_q15, taps);
+}
+
+uint32_t audio_dsp_energy(const int16_t *x, size_t samples)
+{
+#if CONFIG_AUDIO_DSP_USE_PIE
+    if (IS_ALIGNED(x)) {
+        uint32_t energy = 0;
+        while (samples >= AUDIO_DSP_BLOCK) {
+            size_t blocks = samples / AUDIO_DSP_BLOCK;
+            if (blocks > AUDIO_DSP_ENERGY_RUN / AUDIO_DSP_BLOCK) {
+                blocks = AUDIO_DSP_ENERGY_RUN / AUDIO_DSP_BLOCK;
+            }
+            energy += (uint32_t)audio_dsp_pie_fir_q15(x, x, blocks);
+            x += blocks * AUDIO_DSP_BLOCK;
+            samples -= blocks * AUDIO_DSP_BLOCK;
+        }
+        return energy + audio_dsp_scalar_energy(x, samples);
+    }
+#endif
+    return audio_dsp_scalar_energy(x, samples);
+}
+
+size_t audio_dsp_zero_crossings(const int16_t *x, size_t samples)
+{
+    size_t crossings = 0;
+    for (size_t i = 1; i < samples; i++) {
+        crossings += (x[i - 1] < 0) != (x[i] < 0);
+    }
+    return crossings;
+}
@@ -0,0 +1,99 @@
+/**
+ * Base64 Encoder
+ *
+ * Two lookups per 3 input bytes into a 4096-entry table of character pairs
+ * (8 KB, internal RAM). PIE has no byte permute that maps onto the 6-bit
+ * regrouping, so this stays scalar; the pair table already halves the work
+ * of the per-character alphabet lookup.
+ */
+
+#include "audio_dsp.h"
+#include "audio_dsp_priv.h"
+#include <string.h>
+
+static const char s_alphabet[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// pair[v] = alphabet[v >> 6] | alphabet[v & 63] << 8 (little-endian char order)
+static uint16_t s_pairs[4096];
+static volatile bool s_pairs_ready = false;
+
+static void build_pairs(void)
+{
+    // Idempotent, so a concurrent first call only repeats the work
+    for (uint32_t v = 0; v < 4096; v++) {
+        s_pairs[v] = (uint16_t)((uint8_t)s_alphabet[v >> 6] | ((uint8_t)s_alphabet[v & 63] << 8));
+    }
+    s_pairs_ready = true;
+}
+
+/**
+ * Encode the final 1 or 2 bytes with '=' padding
+ */
+static size_t encode_tail(const uint8_t *src, size_t rem, char *dst)
+{
+    if (rem == 0) {
+        return 0;
+    }
+    uint32_t v = (uint32_t)src[0] << 16;
+    if (rem == 2) {
+        v |= (uint32_t)src[1] << 8;
+    }
+    dst[0] = s_alphabet[(v >> 18) & 63];
+    dst[1] = s_alphabet[(v >> 12) & 63];
+    dst[2] = (rem == 2) ? s_alphabet[(v >> 6) & 63] : '=';
+    dst[3] = '=';
+    return 4;
+}
+
+size_t audio_dsp_base64_encode(const uint8_t *src, size_t len, char *dst)
+{
+    if (!s_pairs_ready) {
+        build_pairs();
+    }
+
+    size_t groups = len / 3;
+    char *out = dst;
+
+    if ((((uintptr_t)dst) & 3) == 0) {
+        uint32_t *out32 = (uint32_t *)dst;
+        for (size_t i = 0; i < groups; i++) {
+            uint32_t v = ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2];
+            out32[i] = s_pairs[v >> 12] | ((uint32_t)s_pairs[v & 0xfff] << 16);
+            src += 3;
+        }
+        out += groups * 4;
+    } else {
+        for (size_t i = 0; i < groups; i++) {
+            uint32_t v = ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2];
+            uint16_t hi = s_pairs[v >> 12];
+            uint16_t lo = s_pairs[v & 0xfff];
+            memcpy(out, &hi, 2);
+            memcpy(out + 2, &lo, 2);
+            src += 3;
+            out += 4;
+        }
+    }
+
+    out += encode_tail(src, len - groups * 3, out);
+    return out - dst;
+}
+
+size_t audio_dsp_base64_encode_reference(const uint8_t *src, size_t len, char *dst)
+{
+    size_t groups = len / 3;
+    char *out = dst;
+
+    for (size_t i = 0; i < groups; i++) {
+        uint32_t v = ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2];
+        out[0] = s_alphabet[(v >> 18) & 63];
+        out[1] = s_alphabet[(v >> 12) & 63];
+        out[2] = s_alphabet[(v >> 6) & 63];
+        out[3] = s_alphabet[v & 63];
+        src += 3;
+        out += 4;
+    }
+
+    out += encode_tail(src, len - groups * 3, out);
+    return out - dst;
+}
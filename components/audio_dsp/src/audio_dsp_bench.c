@@ -0,0 +1,212 @@
+/**
+ * Audio DSP Microbenchmark
+ *
+ * Reports cycles per sample for each kernel, scalar reference vs PIE, and
+ * bytes per cycle for the base64 encoder. The FIR figure is per output
+ * sample of a BENCH_FIR_TAPS filter.
+ */
+
+#include "audio_dsp.h"
+#include "audio_dsp_priv.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_dsp";
+
+#define BENCH_FRAMES 1024
+#define BENCH_ROUNDS 32
+#define BENCH_GAIN_Q8 384   // 1.5x exercises the multiply + doubling path
+#define BENCH_FIR_TAPS 32   // Taps per output of the 16 -> 24 kHz resampler
+
+typedef enum {
+    KERNEL_DEINTERLEAVE,
+    KERNEL_MONO_TO_STEREO,
+    KERNEL_GAIN,
+    KERNEL_MIX,
+    KERNEL_FIR,
+    KERNEL_ENERGY,
+    KERNEL_COUNT,
+} bench_kernel_t;
+
+static const char *s_kernel_names[KERNEL_COUNT] = {
+    "deinterleave_left",
+    "mono_to_stereo_gain",
+    "gain",
+    "mix",
+    "fir_q15",
+    "energy",
+};
+
+/**
+ * Run one kernel BENCH_ROUNDS times and return cycles per output sample x100
+ */
+static uint32_t bench_kernel(bench_kernel_t kernel, bool use_pie, int16_t *stereo, int16_t *mono)
+{
+#if !CONFIG_AUDIO_DSP_USE_PIE
+    (void)use_pie;
+#endif
+    uint32_t start = esp_cpu_get_cycle_count();
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        switch (kernel) {
+            case KERNEL_DEINTERLEAVE:
+#if CONFIG_AUDIO_DSP_USE_PIE
+                if (use_pie) {
+                    audio_dsp_pie_deinterleave_left(stereo, mono, BENCH_FRAMES / AUDIO_DSP_BLOCK);
+                    break;
+                }
+#endif
+                audio_dsp_scalar_deinterleave_left(stereo, mono, BENCH_FRAMES);
+                break;
+
+            case KERNEL_MONO_TO_STEREO:
+#if CONFIG_AUDIO_DSP_USE_PIE
+                if (use_pie) {
+                    audio_dsp_gain_split_t split;
+                    audio_dsp_split_gain(BENCH_GAIN_Q8, &split);
+                    audio_dsp_pie_mono_to_stereo_gain(mono, stereo, BENCH_FRAMES / AUDIO_DSP_BLOCK,
+                                                      split.doublings, split.frac_q15);
+                    break;
+                }
+#endif
+                audio_dsp_scalar_mono_to_stereo_gain(mono, stereo, BENCH_FRAMES, BENCH_GAIN_Q8);
+                break;
+
+            case KERNEL_GAIN:
+#if CONFIG_AUDIO_DSP_USE_PIE
+                if (use_pie) {
+                    audio_dsp_gain_split_t split;
+                    audio_dsp_split_gain(BENCH_GAIN_Q8, &split);
+                    audio_dsp_pie_gain(mono, mono, BENCH_FRAMES / AUDIO_DSP_BLOCK,
+                                       split.doublings, split.frac_q15);
+                    break;
+                }
+#endif
+                audio_dsp_scalar_gain(mono, mono, BENCH_FRAMES, BENCH_GAIN_Q8);
+                break;
+
+            case KERNEL_MIX:
+#if CONFIG_AUDIO_DSP_USE_PIE
+                if (use_pie) {
+                    audio_dsp_pie_mix(mono, stereo, BENCH_FRAMES / AUDIO_DSP_BLOCK);
+                    break;
+                }
+#endif
+                audio_dsp_scalar_mix(mono, stereo, BENCH_FRAMES);
+                break;
+
+            case KERNEL_FIR: {
+                // One output per frame, sliding an aligned window over stereo with mono as taps
+                volatile int16_t sink = 0;
+                for (int n = 0; n < BENCH_FRAMES; n++) {
+                    const int16_t *x = stereo + (n & ~(AUDIO_DSP_BLOCK - 1));
+#if CONFIG_AUDIO_DSP_USE_PIE
+                    if (use_pie) {
+                        sink = (int16_t)audio_dsp_pie_fir_q15(x, mono, BENCH_FIR_TAPS / AUDIO_DSP_BLOCK);
+                        continue;
+                    }
+#endif
+                    sink = audio_dsp_scalar_fir_q15(x, mono, BENCH_FIR_TAPS);
+                }
+                (void)sink;
+                break;
+            }
+
+            case KERNEL_ENERGY: {
+                volatile uint32_t sink = 0;
+#if CONFIG_AUDIO_DSP_USE_PIE
+                if (use_pie) {
+                    for (int n = 0; n < BENCH_FRAMES; n += AUDIO_DSP_ENERGY_RUN) {
+                        sink += (uint32_t)audio_dsp_pie_fir_q15(stereo + n, stereo + n,
+                                                                AUDIO_DSP_ENERGY_RUN / AUDIO_DSP_BLOCK);
+                    }
+                    (void)sink;
+                    break;
+                }
+#endif
+                sink = audio_dsp_scalar_energy(stereo, BENCH_FRAMES);
+                (void)sink;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    return (uint32_t)((uint64_t)cycles * 100 / (BENCH_ROUNDS * BENCH_FRAMES));
+}
+
+/**
+ * Run a base64 encoder BENCH_ROUNDS times and return input bytes per cycle x1000
+ */
+static uint32_t bench_base64(bool reference, const uint8_t *src, size_t len, char *dst)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        if (reference) {
+            audio_dsp_base64_encode_reference(src, len, dst);
+        } else {
+            audio_dsp_base64_encode(src, len, dst);
+        }
+    }
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    return cycles ? (uint32_t)((uint64_t)len * BENCH_ROUNDS * 1000 / cycles) : 0;
+}
+
+/**
+ * Log cycles per sample for every kernel
+ */
+void audio_dsp_run_benchmark(void)
+{
+    int16_t *stereo = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, BENCH_FRAMES * 2 * sizeof(int16_t),
+                                              MALLOC_CAP_INTERNAL);
+    int16_t *mono = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, BENCH_FRAMES * sizeof(int16_t),
+                                            MALLOC_CAP_INTERNAL);
+    if (!stereo || !mono) {
+        ESP_LOGE(TAG, "Benchmark allocation failed");
+        heap_caps_free(stereo);
+        heap_caps_free(mono);
+        return;
+    }
+
+    // Deterministic pseudo-random samples
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < BENCH_FRAMES * 2; i++) {
+        seed = seed * 1664525 + 1013904223;
+        stereo[i] = (int16_t)(seed >> 16);
+    }
+
+    ESP_LOGI(TAG, "Kernel benchmark (%d frames, %d rounds, cycles/sample):", BENCH_FRAMES, BENCH_ROUNDS);
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        uint32_t scalar_x100 = bench_kernel((bench_kernel_t)k, false, stereo, mono);
+#if CONFIG_AUDIO_DSP_USE_PIE
+        uint32_t pie_x100 = bench_kernel((bench_kernel_t)k, true, stereo, mono);
+        ESP_LOGI(TAG, "  %-20s scalar %lu.%02lu  pie %lu.%02lu",
+                 s_kernel_names[k],
+                 (unsigned long)(scalar_x100 / 100), (unsigned long)(scalar_x100 % 100),
+                 (unsigned long)(pie_x100 / 100), (unsigned long)(pie_x100 % 100));
+#else
+        ESP_LOGI(TAG, "  %-20s scalar %lu.%02lu",
+                 s_kernel_names[k],
+                 (unsigned long)(scalar_x100 / 100), (unsigned long)(scalar_x100 % 100));
+#endif
+    }
+
+    // Base64 over the stereo buffer, written into the mono one
+    size_t b64_len = (BENCH_FRAMES * sizeof(int16_t) / 4) * 3;
+    audio_dsp_base64_encode((const uint8_t *)stereo, 3, (char *)mono);  // Build the pair table
+    uint32_t ref_x1000 = bench_base64(true, (const uint8_t *)stereo, b64_len, (char *)mono);
+    uint32_t pair_x1000 = bench_base64(false, (const uint8_t *)stereo, b64_len, (char *)mono);
+    ESP_LOGI(TAG, "  %-20s 6-bit %lu.%03lu  pair %lu.%03lu bytes/cycle",
+             "base64",
+             (unsigned long)(ref_x1000 / 1000), (unsigned long)(ref_x1000 % 1000),
+             (unsigned long)(pair_x1000 / 1000), (unsigned long)(pair_x1000 % 1000));
+
+    heap_caps_free(stereo);
+    heap_caps_free(mono);
+}
@@ -0,0 +1,54 @@
+/**
+ * Audio DSP internals shared by the dispatcher and the benchmark
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_DSP_BLOCK 8   // int16 samples per 128-bit vector
+#define AUDIO_DSP_ENERGY_RUN 512  // Full-scale squares the 40-bit accumulator can sum
+
+/**
+ * Q8 gain split for the vector path: multiply by frac_q15 (skipped if 0),
+ * then double with saturation `doublings` times
+ */
+typedef struct {
+    uint32_t doublings;
+    uint32_t frac_q15;
+} audio_dsp_gain_split_t;
+
+void audio_dsp_split_gain(uint16_t gain_q8, audio_dsp_gain_split_t *split);
+
+// Scalar reference kernels
+void audio_dsp_scalar_deinterleave_left(const int16_t *stereo, int16_t *mono, size_t frames);
+void audio_dsp_scalar_mono_to_stereo_gain(const int16_t *mono, int16_t *stereo, size_t frames, uint16_t gain_q8);
+void audio_dsp_scalar_gain(const int16_t *src, int16_t *dst, size_t samples, uint16_t gain_q8);
+void audio_dsp_scalar_mix(int16_t *dst, const int16_t *src, size_t samples);
+int16_t audio_dsp_scalar_fir_q15(const int16_t *x, const int16_t *coef_q15, size_t taps);
+uint32_t audio_dsp_scalar_energy(const int16_t *x, size_t samples);
+
+// Base64 with a 6-bit alphabet lookup per character (benchmark baseline)
+size_t audio_dsp_base64_encode_reference(const uint8_t *src, size_t len, char *dst);
+
+#if CONFIG_AUDIO_DSP_USE_PIE
+// PIE kernels (audio_dsp_pie.S); counts are in 8-sample blocks, pointers 16-byte aligned
+void audio_dsp_pie_deinterleave_left(const int16_t *stereo, int16_t *mono, size_t blocks);
+void audio_dsp_pie_mono_to_stereo_gain(const int16_t *mono, int16_t *stereo, size_t blocks,
+                                       uint32_t doublings, uint32_t frac_q15);
+void audio_dsp_pie_gain(const int16_t *src, int16_t *dst, size_t blocks,
+                        uint32_t doublings, uint32_t frac_q15);
+void audio_dsp_pie_mix(int16_t *dst, const int16_t *src, size_t blocks);
+int32_t audio_dsp_pie_fir_q15(const int16_t *x, const int16_t *coef_q15, size_t blocks);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
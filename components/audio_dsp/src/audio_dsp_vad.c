@@ -0,0 +1,86 @@
+/**
+ * Voice Activity Detection
+ *
+ * Energy against a noise floor that falls quickly and rises slowly, so it
+ * settles on the quietest recent background, plus a zero-crossing gate as
+ * a coarse spectral check. The floor keeps adapting, very slowly, during
+ * speech so a step in background noise cannot latch the detector on.
+ */
+
+#include "audio_dsp.h"
+#include <math.h>
+
+#define VAD_MIN_POWER 3364          // -55 dBFS: quieter frames are never speech
+#define VAD_ONSET_MS 20
+#define VAD_ZCR_MIN_HZ 200          // Below: mains hum and rumble
+#define VAD_ZCR_MAX_HZ 10000        // Above: broadband hiss
+#define VAD_FLOOR_FALL_SHIFT 2      // Floor moves 1/4 of the way down per frame
+#define VAD_FLOOR_RISE_SHIFT 7      // 1/128 of the way up per silent frame
+#define VAD_FLOOR_SPEECH_SHIFT 12   // 1/4096 during speech
+
+void audio_dsp_vad_init(audio_dsp_vad_t *vad, uint32_t frame_ms, uint32_t threshold_db, uint32_t hangover_ms)
+{
+    *vad = (audio_dsp_vad_t){0};
+    vad->frame_ms = frame_ms ? frame_ms : 1;
+    vad->threshold_q8 = (uint32_t)(256.0f * powf(10.0f, threshold_db / 10.0f));
+    vad->onset_frames = (VAD_ONSET_MS + vad->frame_ms - 1) / vad->frame_ms;
+    vad->hangover_frames = hangover_ms / vad->frame_ms;
+}
+
+static void track_floor(audio_dsp_vad_t *vad, uint32_t power, uint32_t rise_shift)
+{
+    if (power < vad->noise_floor) {
+        vad->noise_floor -= (vad->noise_floor - power) >> VAD_FLOOR_FALL_SHIFT;
+    } else {
+        vad->noise_floor += ((power - vad->noise_floor) >> rise_shift) + 1;
+    }
+}
+
+bool audio_dsp_vad_process(audio_dsp_vad_t *vad, const int16_t *x, size_t samples)
+{
+    if (samples == 0) {
+        return vad->speech;
+    }
+
+    uint32_t power = (uint32_t)(((uint64_t)audio_dsp_energy(x, samples) << 15) / samples);
+    // A tone crosses zero twice per period, so half the crossing rate is its frequency
+    uint32_t zcr_hz = (uint32_t)(audio_dsp_zero_crossings(x, samples) * 500 / vad->frame_ms);
+    vad->power = power;
+
+    if (!vad->primed) {
+        vad->noise_floor = power;
+        vad->primed = true;
+    }
+
+    uint64_t threshold = ((uint64_t)vad->noise_floor * vad->threshold_q8) >> 8;
+    bool frame_speech = power > VAD_MIN_POWER && power > threshold &&
+                        zcr_hz >= VAD_ZCR_MIN_HZ && zcr_hz <= VAD_ZCR_MAX_HZ;
+
+    if (frame_speech) {
+        track_floor(vad, power, VAD_FLOOR_SPEECH_SHIFT);
+        vad->run++;
+        if (vad->run >= vad->onset_frames) {
+            vad->speech = true;
+        }
+        if (vad->speech) {
+            vad->hang = vad->hangover_frames;
+        }
+    } else {
+        track_floor(vad, power, VAD_FLOOR_RISE_SHIFT);
+        vad->run = 0;
+        if (vad->hang > 0) {
+            vad->hang--;
+        } else {
+            vad->speech = false;
+        }
+    }
+    return vad->speech;
+}
+
+int32_t audio_dsp_power_db(uint32_t power)
+{
+    if (power == 0) {
+        return -96;
+    }
+    return (int32_t)lroundf(10.0f * log10f(power / 1073741824.0f));  // Relative to 32768^2
+}
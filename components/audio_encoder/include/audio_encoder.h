@@ -0,0 +1,129 @@
+/**
+ * Audio Encoder
+ *
+ * Opus speech encoder running on its own task. PCM is pushed in from the
+ * capture path through a lock-free ring; encoded Ogg Opus pages are handed
+ * to a caller callback as soon as they are complete, so uploads can start
+ * while the user is still speaking.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called on the encoder task with one complete Ogg page
+ *
+ * @param data Page bytes (valid only during the call)
+ * @param len Page length
+ * @param user_ctx User context from the config
+ * @return ESP_OK to continue, error to stop encoding
+ */
+typedef esp_err_t (*audio_encoder_output_cb_t)(const uint8_t *data, size_t len, void *user_ctx);
+
+/**
+ * @brief Encoder configuration
+ */
+typedef struct {
+    uint32_t sample_rate;                   // Input rate: 8000, 12000, 16000, 24000 or 48000
+    uint32_t bitrate;                       // Bits per second, 0 for the current setting
+    uint32_t frames_per_page;               // 20 ms Opus frames per Ogg page (1 for lowest latency)
+    audio_encoder_output_cb_t output_cb;    // Receives each Ogg page
+    void *user_ctx;                         // Passed to output_cb
+} audio_encoder_config_t;
+
+/**
+ * @brief Opaque encoder handle
+ */
+typedef struct audio_encoder *audio_encoder_handle_t;
+
+/**
+ * @brief Create an encoder and start its task
+ *
+ * The OpusHead/OpusTags header pages are emitted before this returns.
+ *
+ * @param config Encoder configuration
+ * @param ret_encoder Output handle
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t audio_encoder_create(const audio_encoder_config_t *config, audio_encoder_handle_t *ret_encoder);
+
+/**
+ * @brief Queue mono 16-bit PCM for encoding
+ *
+ * Never blocks. Samples that do not fit in the input ring are dropped.
+ *
+ * @param encoder Encoder handle
+ * @param samples PCM samples
+ * @param count Number of samples
+ * @return Number of samples accepted
+ */
+size_t audio_encoder_write(audio_encoder_handle_t encoder, const int16_t *samples, size_t count);
+
+/**
+ * @brief Encode the remaining input and emit the end-of-stream page
+ *
+ * The last partial frame is padded with silence. No more writes are
+ * accepted afterwards.
+ *
+ * @param encoder Encoder handle
+ * @param timeout Max time to wait for the encoder to drain
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT, or the first output/encode error
+ */
+esp_err_t audio_encoder_finish(audio_encoder_handle_t encoder, TickType_t timeout);
+
+/**
+ * @brief Stop the encoder task and free all resources
+ *
+ * @param encoder Encoder handle (may be NULL)
+ */
+void audio_encoder_destroy(audio_encoder_handle_t encoder);
+
+/**
+ * @brief Get the number of encoded bytes emitted so far (including headers)
+ *
+ * @param encoder Encoder handle
+ * @return Bytes passed to output_cb
+ */
+size_t audio_encoder_bytes_out(audio_encoder_handle_t encoder);
+
+/**
+ * @brief Check whether uploads should be Opus encoded
+ *
+ * @return true if Opus is enabled
+ */
+bool audio_encoder_opus_enabled(void);
+
+/**
+ * @brief Enable or disable Opus for new uploads
+ *
+ * @param enabled true to encode, false to send raw PCM
+ */
+void audio_encoder_set_opus_enabled(bool enabled);
+
+/**
+ * @brief Get the bitrate used for new encoders
+ *
+ * @return Bits per second
+ */
+uint32_t audio_encoder_get_bitrate(void);
+
+/**
+ * @brief Set the bitrate used for new encoders
+ *
+ * @param bitrate Bits per second (6000-64000)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t audio_encoder_set_bitrate(uint32_t bitrate);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,364 @@
+/**
+ * Audio Encoder Implementation
+ *
+ * Capture tasks push PCM into a PSRAM SPSC ring; a task pinned to the
+ * other core pulls 20 ms frames, runs the Opus encoder and packs the
+ * packets into Ogg pages for the caller.
+ */
+
+#include "audio_encoder.h"
+
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "spsc_ring.h"
+#include "ogg_mux.h"
+#include "audio_pool.h"
+
+#ifdef CONFIG_AUDIO_ENCODER_OPUS
+#include "esp_opus_enc.h"
+#endif
+
+static const char *TAG = "audio_encoder";
+
+#define ENCODER_RING_SIZE       (64 * 1024)     // 2 s of 16 kHz mono PCM
+#define ENCODER_TASK_STACK      (32 * 1024)     // Opus (SILK) analysis is stack hungry
+#define ENCODER_TASK_PRIORITY   5
+#define ENCODER_FRAME_MS        20
+#define ENCODER_MAX_PACKET      1276            // Largest Opus packet (RFC 6716)
+#define OPUS_PRE_SKIP           312             // Encoder lookahead at 48 kHz
+#define OPUS_GRANULE_RATE       48000
+
+#define BITRATE_MIN             6000
+#define BITRATE_MAX             64000
+
+#ifdef CONFIG_AUDIO_ENCODER_OPUS
+#define DEFAULT_OPUS_ENABLED    true
+#define DEFAULT_BITRATE         CONFIG_AUDIO_ENCODER_OPUS_BITRATE
+#define ENCODER_CORE            CONFIG_AUDIO_ENCODER_CORE
+#else
+#define DEFAULT_OPUS_ENABLED    false
+#define DEFAULT_BITRATE         24000
+#endif
+
+struct audio_encoder {
+    spsc_ring_handle_t ring;
+    void *opus;
+    ogg_mux_t mux;
+    audio_encoder_output_cb_t output_cb;
+    void *user_ctx;
+    uint32_t sample_rate;
+    uint32_t frames_per_page;
+    uint32_t frames_in_page;
+    size_t frame_bytes;
+    int out_size;
+    uint8_t *frame_buf;
+    uint8_t *packet_buf;
+    uint64_t samples_encoded;
+    size_t bytes_out;
+    esp_err_t result;
+    TaskHandle_t task;
+    SemaphoreHandle_t done;
+    volatile bool finishing;
+    volatile bool stop;
+    bool task_exited;
+};
+
+static volatile bool s_opus_enabled = DEFAULT_OPUS_ENABLED;
+static volatile uint32_t s_bitrate = DEFAULT_BITRATE;
+
+bool audio_encoder_opus_enabled(void)
+{
+#ifdef CONFIG_AUDIO_ENCODER_OPUS
+    return s_opus_enabled;
+#else
+    return false;
+#endif
+}
+
+void audio_encoder_set_opus_enabled(bool enabled)
+{
+    s_opus_enabled = enabled;
+    ESP_LOGI(TAG, "Opus uploads %s", enabled ? "enabled" : "disabled");
+}
+
+uint32_t audio_encoder_get_bitrate(void)
+{
+    return s_bitrate;
+}
+
+esp_err_t audio_encoder_set_bitrate(uint32_t bitrate)
+{
+    if (bitrate < BITRATE_MIN || bitrate > BITRATE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_bitrate = bitrate;
+    ESP_LOGI(TAG, "Opus bitrate set to %lu bps", (unsigned long)bitrate);
+    return ESP_OK;
+}
+
+size_t audio_encoder_bytes_out(audio_encoder_handle_t encoder)
+{
+    return encoder ? __atomic_load_n(&encoder->bytes_out, __ATOMIC_RELAXED) : 0;
+}
+
+#ifdef CONFIG_AUDIO_ENCODER_OPUS
+
+/**
+ * Ogg page sink: counts bytes and forwards to the caller
+ */
+static esp_err_t page_out(const uint8_t *page, size_t len, void *user_ctx)
+{
+    audio_encoder_handle_t enc = user_ctx;
+    esp_err_t ret = enc->output_cb(page, len, enc->user_ctx);
+    __atomic_fetch_add(&enc->bytes_out, len, __ATOMIC_RELAXED);
+    return ret;
+}
+
+/**
+ * Encode one full frame from frame_buf and add it to the current page
+ */
+static esp_err_t encode_frame(audio_encoder_handle_t enc)
+{
+    esp_audio_enc_in_frame_t in = {
+        .buffer = enc->frame_buf,
+        .len = enc->frame_bytes,
+    };
+    esp_audio_enc_out_frame_t out = {
+        .buffer = enc->packet_buf,
+        .len = enc->out_size,
+    };
+
+    esp_audio_err_t err = esp_opus_enc_process(enc->opus, &in, &out);
+    if (err != ESP_AUDIO_ERR_OK) {
+        ESP_LOGE(TAG, "Opus encode failed: %d", err);
+        return ESP_FAIL;
+    }
+
+    enc->samples_encoded += enc->frame_bytes / sizeof(int16_t);
+    uint64_t granule = OPUS_PRE_SKIP + enc->samples_encoded * OPUS_GRANULE_RATE / enc->sample_rate;
+
+    esp_err_t ret = ogg_mux_add_packet(&enc->mux, enc->packet_buf, out.encoded_bytes, granule);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (++enc->frames_in_page >= enc->frames_per_page) {
+        enc->frames_in_page = 0;
+        ret = ogg_mux_flush(&enc->mux, false);
+    }
+    return ret;
+}
+
+static void encoder_task(void *arg)
+{
+    audio_encoder_handle_t enc = arg;
+
+    while (!enc->stop && enc->result == ESP_OK) {
+        spsc_ring_wait_data(enc->ring, enc->frame_bytes, pdMS_TO_TICKS(100));
+
+        while (enc->result == ESP_OK && spsc_ring_available(enc->ring) >= enc->frame_bytes) {
+            spsc_ring_read(enc->ring, enc->frame_buf, enc->frame_bytes);
+            enc->result = encode_frame(enc);
+        }
+
+        // finishing is set after the producer's last write, so once it is
+        // seen the ring only holds a partial frame at most
+        if (enc->finishing && enc->result == ESP_OK &&
+            spsc_ring_available(enc->ring) < enc->frame_bytes) {
+            size_t tail = spsc_ring_read(enc->ring, enc->frame_buf, enc->frame_bytes);
+            if (tail > 0) {
+                memset(enc->frame_buf + tail, 0, enc->frame_bytes - tail);
+                enc->result = encode_frame(enc);
+            }
+            if (enc->result == ESP_OK) {
+                enc->result = ogg_mux_flush(&enc->mux, true);
+            }
+            ESP_LOGI(TAG, "Encoded %llu samples into %zu bytes",
+                     (unsigned long long)enc->samples_encoded, enc->bytes_out);
+            break;
+        }
+    }
+
+    if (enc->result != ESP_OK) {
+        ESP_LOGE(TAG, "Encoder stopped: %s", esp_err_to_name(enc->result));
+    }
+
+    xSemaphoreGive(enc->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_encoder_create(const audio_encoder_config_t *config, audio_encoder_handle_t *ret_encoder)
+{
+    if (!config || !config->output_cb || !ret_encoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    audio_encoder_handle_t enc = audio_pool_calloc(AUDIO_POOL_INTERNAL, sizeof(*enc));
+    if (!enc) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    enc->output_cb = config->output_cb;
+    enc->user_ctx = config->user_ctx;
+    enc->sample_rate = config->sample_rate;
+    enc->frames_per_page = config->frames_per_page ? config->frames_per_page : 1;
+    enc->result = ESP_OK;
+
+    esp_err_t ret = ESP_OK;
+    esp_opus_enc_config_t opus_cfg = ESP_OPUS_ENC_CONFIG_DEFAULT();
+    opus_cfg.sample_rate = config->sample_rate;
+    opus_cfg.channel = ESP_AUDIO_MONO;
+    opus_cfg.bits_per_sample = ESP_AUDIO_BIT16;
+    opus_cfg.bitrate = config->bitrate ? config->bitrate : audio_encoder_get_bitrate();
+    opus_cfg.frame_duration = ESP_OPUS_ENC_FRAME_DURATION_20_MS;
+    opus_cfg.application_mode = ESP_OPUS_ENC_APPLICATION_VOIP;
+    opus_cfg.complexity = 5;
+    opus_cfg.enable_vbr = true;
+
+    if (esp_opus_enc_open(&opus_cfg, sizeof(opus_cfg), &enc->opus) != ESP_AUDIO_ERR_OK) {
+        ESP_LOGE(TAG, "Failed to open Opus encoder (%lu Hz, %d bps)",
+                 (unsigned long)config->sample_rate, opus_cfg.bitrate);
+        ret = ESP_FAIL;
+        goto err;
+    }
+
+    int in_size = 0;
+    esp_opus_enc_get_frame_size(enc->opus, &in_size, &enc->out_size);
+    enc->frame_bytes = in_size;
+    if (enc->out_size < ENCODER_MAX_PACKET) {
+        enc->out_size = ENCODER_MAX_PACKET;
+    }
+
+    enc->frame_buf = audio_pool_alloc(AUDIO_POOL_INTERNAL, enc->frame_bytes);
+    enc->packet_buf = audio_pool_alloc(AUDIO_POOL_INTERNAL, enc->out_size);
+    enc->done = xSemaphoreCreateBinary();
+    if (!enc->frame_buf || !enc->packet_buf || !enc->done) {
+        ret = ESP_ERR_NO_MEM;
+        goto err;
+    }
+
+    ret = spsc_ring_create(ENCODER_RING_SIZE, MALLOC_CAP_SPIRAM, &enc->ring);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    // Body sized for a full page of maximum-size packets
+    ret = ogg_mux_init(&enc->mux, enc->frames_per_page * ENCODER_MAX_PACKET,
+                       esp_random(), page_out, enc);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    ret = ogg_mux_write_opus_headers(&enc->mux, config->sample_rate, OPUS_PRE_SKIP);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write Opus headers");
+        goto err;
+    }
+
+    BaseType_t task_created = xTaskCreatePinnedToCore(
+        encoder_task, "audio_enc", ENCODER_TASK_STACK, enc,
+        ENCODER_TASK_PRIORITY, &enc->task, ENCODER_CORE);
+    if (task_created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create encoder task");
+        ret = ESP_ERR_NO_MEM;
+        goto err;
+    }
+
+    ESP_LOGI(TAG, "Opus encoder started: %lu Hz, %d bps, %lu frames/page",
+             (unsigned long)enc->sample_rate, opus_cfg.bitrate, (unsigned long)enc->frames_per_page);
+    *ret_encoder = enc;
+    return ESP_OK;
+
+err:
+    enc->task_exited = true;
+    audio_encoder_destroy(enc);
+    return ret;
+}
+
+size_t audio_encoder_write(audio_encoder_handle_t encoder, const int16_t *samples, size_t count)
+{
+    if (!encoder || encoder->finishing) {
+        return 0;
+    }
+
+    size_t written = spsc_ring_write(encoder->ring, samples, count * sizeof(int16_t));
+    if (written < count * sizeof(int16_t)) {
+        ESP_LOGW(TAG, "Encoder input overflow, dropped %zu bytes", count * sizeof(int16_t) - written);
+    }
+    return written / sizeof(int16_t);
+}
+
+esp_err_t audio_encoder_finish(audio_encoder_handle_t encoder, TickType_t timeout)
+{
+    if (!encoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (encoder->task_exited) {
+        return encoder->result;
+    }
+
+    encoder->finishing = true;
+    spsc_ring_wake(encoder->ring);
+
+    if (xSemaphoreTake(encoder->done, timeout) != pdTRUE) {
+        ESP_LOGW(TAG, "Encoder did not drain in time");
+        return ESP_ERR_TIMEOUT;
+    }
+    encoder->task_exited = true;
+    return encoder->result;
+}
+
+void audio_encoder_destroy(audio_encoder_handle_t encoder)
+{
+    if (!encoder) {
+        return;
+    }
+
+    if (!encoder->task_exited && encoder->task) {
+        encoder->stop = true;
+        spsc_ring_wake(encoder->ring);
+        xSemaphoreTake(encoder->done, portMAX_DELAY);
+    }
+
+    ogg_mux_deinit(&encoder->mux);
+    if (encoder->ring) {
+        spsc_ring_delete(encoder->ring);
+    }
+    if (encoder->opus) {
+        esp_opus_enc_close(encoder->opus);
+    }
+    if (encoder->done) {
+        vSemaphoreDelete(encoder->done);
+    }
+    audio_pool_free(encoder->frame_buf);
+    audio_pool_free(encoder->packet_buf);
+    audio_pool_free(encoder);
+}
+
+#else /* !CONFIG_AUDIO_ENCODER_OPUS */
+
+esp_err_t audio_encoder_create(const audio_encoder_config_t *config, audio_encoder_handle_t *ret_encoder)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+size_t audio_encoder_write(audio_encoder_handle_t encoder, const int16_t *samples, size_t count)
+{
+    return 0;
+}
+
+esp_err_t audio_encoder_finish(audio_encoder_handle_t encoder, TickType_t timeout)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void audio_encoder_destroy(audio_encoder_handle_t encoder)
+{
+}
+
+#endif /* CONFIG_AUDIO_ENCODER_OPUS */
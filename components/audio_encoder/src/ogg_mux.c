@@ -0,0 +1,201 @@
+/**
+ * Minimal Ogg page writer for a single Opus stream
+ *
+ * The page body is kept at a fixed offset behind the largest possible
+ * header, so on flush the header and segment table are written directly
+ * in front of it and the page goes out as one contiguous buffer.
+ */
+
+#include "ogg_mux.h"
+#include "audio_pool.h"
+
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "ogg_mux";
+
+#define OGG_FLAG_BOS 0x02
+#define OGG_FLAG_EOS 0x04
+
+static uint32_t s_crc_table[256];
+static bool s_crc_ready = false;
+
+static void crc_init(void)
+{
+    if (s_crc_ready) {
+        return;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t r = i << 24;
+        for (int j = 0; j < 8; j++) {
+            r = (r & 0x80000000u) ? (r << 1) ^ 0x04c11db7u : (r << 1);
+        }
+        s_crc_table[i] = r;
+    }
+    s_crc_ready = true;
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc << 8) ^ s_crc_table[((crc >> 24) & 0xff) ^ data[i]];
+    }
+    return crc;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+esp_err_t ogg_mux_init(ogg_mux_t *mux, size_t body_capacity, uint32_t serial,
+                       ogg_mux_page_cb_t page_cb, void *user_ctx)
+{
+    if (!mux || !page_cb || body_capacity == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    crc_init();
+    memset(mux, 0, sizeof(*mux));
+
+    mux->page = audio_pool_alloc(AUDIO_POOL_INTERNAL, OGG_PAGE_HEADER_MAX + body_capacity);
+    if (!mux->page) {
+        ESP_LOGE(TAG, "Failed to allocate page buffer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    mux->body_capacity = body_capacity;
+    mux->serial = serial;
+    mux->page_cb = page_cb;
+    mux->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+void ogg_mux_deinit(ogg_mux_t *mux)
+{
+    if (mux && mux->page) {
+        audio_pool_free(mux->page);
+        mux->page = NULL;
+    }
+}
+
+static esp_err_t emit_page(ogg_mux_t *mux, bool eos)
+{
+    size_t header_len = 27 + mux->segments;
+    uint8_t *hdr = mux->page + OGG_PAGE_HEADER_MAX - header_len;
+
+    uint8_t flags = 0;
+    if (!mux->bos_written) {
+        flags |= OGG_FLAG_BOS;
+        mux->bos_written = true;
+    }
+    if (eos) {
+        flags |= OGG_FLAG_EOS;
+    }
+
+    memcpy(hdr, "OggS", 4);
+    hdr[4] = 0;                             // Stream structure version
+    hdr[5] = flags;
+    put_le64(hdr + 6, mux->granule);
+    put_le32(hdr + 14, mux->serial);
+    put_le32(hdr + 18, mux->sequence++);
+    put_le32(hdr + 22, 0);                  // CRC, filled below
+    hdr[26] = (uint8_t)mux->segments;
+    memcpy(hdr + 27, mux->lacing, mux->segments);
+
+    size_t page_len = header_len + mux->body_len;
+    put_le32(hdr + 22, crc_update(0, hdr, page_len));
+
+    esp_err_t ret = mux->page_cb(hdr, page_len, mux->user_ctx);
+
+    mux->body_len = 0;
+    mux->segments = 0;
+    mux->packets = 0;
+    return ret;
+}
+
+esp_err_t ogg_mux_flush(ogg_mux_t *mux, bool eos)
+{
+    if (mux->packets == 0 && !eos) {
+        return ESP_OK;
+    }
+    return emit_page(mux, eos);
+}
+
+esp_err_t ogg_mux_add_packet(ogg_mux_t *mux, const uint8_t *packet, size_t len, uint64_t granule)
+{
+    size_t lacing_needed = len / 255 + 1;
+    if (lacing_needed > OGG_MAX_SEGMENTS || len > mux->body_capacity) {
+        ESP_LOGE(TAG, "Packet too large: %zu bytes", len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (mux->segments + lacing_needed > OGG_MAX_SEGMENTS ||
+        mux->body_len + len > mux->body_capacity) {
+        esp_err_t ret = emit_page(mux, false);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    size_t remaining = len;
+    while (remaining >= 255) {
+        mux->lacing[mux->segments++] = 255;
+        remaining -= 255;
+    }
+    mux->lacing[mux->segments++] = (uint8_t)remaining;
+
+    memcpy(mux->page + OGG_PAGE_HEADER_MAX + mux->body_len, packet, len);
+    mux->body_len += len;
+    mux->packets++;
+    mux->granule = granule;
+    return ESP_OK;
+}
+
+esp_err_t ogg_mux_write_opus_headers(ogg_mux_t *mux, uint32_t input_sample_rate, uint16_t pre_skip)
+{
+    // OpusHead (RFC 7845 section 5.1), mono, mapping family 0
+    uint8_t head[19];
+    memcpy(head, "OpusHead", 8);
+    head[8] = 1;                            // Version
+    head[9] = 1;                            // Channel count
+    head[10] = pre_skip & 0xff;
+    head[11] = (pre_skip >> 8) & 0xff;
+    put_le32(head + 12, input_sample_rate);
+    head[16] = 0;                           // Output gain
+    head[17] = 0;
+    head[18] = 0;                           // Mapping family
+
+    mux->granule = 0;
+    esp_err_t ret = ogg_mux_add_packet(mux, head, sizeof(head), 0);
+    if (ret == ESP_OK) {
+        ret = emit_page(mux, false);
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // OpusTags: vendor string, no user comments
+    static const char vendor[] = "espidf-chat";
+    uint8_t tags[8 + 4 + sizeof(vendor) - 1 + 4];
+    memcpy(tags, "OpusTags", 8);
+    put_le32(tags + 8, sizeof(vendor) - 1);
+    memcpy(tags + 12, vendor, sizeof(vendor) - 1);
+    put_le32(tags + 12 + sizeof(vendor) - 1, 0);
+
+    ret = ogg_mux_add_packet(mux, tags, sizeof(tags), 0);
+    if (ret == ESP_OK) {
+        ret = emit_page(mux, false);
+    }
+    return ret;
+}
@@ -0,0 +1,62 @@
+/**
+ * Minimal Ogg page writer for a single Opus stream (RFC 3533 / RFC 7845)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OGG_MAX_SEGMENTS 255
+#define OGG_PAGE_HEADER_MAX (27 + OGG_MAX_SEGMENTS)
+
+/**
+ * Called with one complete Ogg page
+ */
+typedef esp_err_t (*ogg_mux_page_cb_t)(const uint8_t *page, size_t len, void *user_ctx);
+
+typedef struct {
+    uint8_t *page;              // [header space | segment table | body]
+    size_t body_capacity;
+    size_t body_len;
+    uint8_t lacing[OGG_MAX_SEGMENTS];
+    size_t segments;
+    size_t packets;
+    uint32_t serial;
+    uint32_t sequence;
+    uint64_t granule;           // Granule position of the last packet in the page
+    bool bos_written;
+    ogg_mux_page_cb_t page_cb;
+    void *user_ctx;
+} ogg_mux_t;
+
+esp_err_t ogg_mux_init(ogg_mux_t *mux, size_t body_capacity, uint32_t serial,
+                       ogg_mux_page_cb_t page_cb, void *user_ctx);
+void ogg_mux_deinit(ogg_mux_t *mux);
+
+/**
+ * Write the OpusHead and OpusTags header pages
+ */
+esp_err_t ogg_mux_write_opus_headers(ogg_mux_t *mux, uint32_t input_sample_rate, uint16_t pre_skip);
+
+/**
+ * Append a packet to the current page; flushes first if it does not fit
+ */
+esp_err_t ogg_mux_add_packet(ogg_mux_t *mux, const uint8_t *packet, size_t len, uint64_t granule);
+
+/**
+ * Emit the current page (if any)
+ *
+ * @param eos Mark the page as end of stream (an empty page is emitted if needed)
+ */
+esp_err_t ogg_mux_flush(ogg_mux_t *mux, bool eos);
+
+#ifdef __cplusplus
+}
+#endif
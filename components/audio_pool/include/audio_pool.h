@@ -0,0 +1,90 @@
+/**
+ * Audio Buffer Pool
+ *
+ * Fixed-block arenas reserved once at boot for the buffers audio sessions
+ * allocate and free on every start and stop. Keeping them out of the
+ * general heap stops long uptimes from fragmenting internal RAM.
+ *
+ * Two arenas: internal DMA-capable RAM for buffers touched per sample, and
+ * PSRAM for large staging buffers. An allocation takes a run of adjacent
+ * blocks, so any size up to the arena works; every pointer is aligned for
+ * the DSP vector kernels.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Arena selector
+ */
+typedef enum {
+    AUDIO_POOL_INTERNAL = 0,    // Internal, DMA-capable
+    AUDIO_POOL_PSRAM,
+    AUDIO_POOL_MAX,
+} audio_pool_arena_t;
+
+/**
+ * @brief Arena statistics
+ */
+typedef struct {
+    uint32_t block_size;
+    uint32_t blocks;
+    uint32_t used;              // Blocks in use
+    uint32_t high_water;        // Most blocks ever in use at once
+    uint32_t allocs;
+    uint32_t fallbacks;         // Served from the heap because the arena was full
+    uint32_t failures;          // Could not be served at all
+} audio_pool_stats_t;
+
+/**
+ * @brief Reserve the arenas
+ *
+ * Call early at boot, before the heap fragments. Safe to call more than
+ * once. Until it succeeds, allocations fall back to the heap.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if an arena cannot be reserved
+ */
+esp_err_t audio_pool_init(void);
+
+/**
+ * @brief Allocate a buffer
+ *
+ * @param arena Arena to draw from
+ * @param size Bytes
+ * @return Buffer aligned to 16 bytes, or NULL
+ */
+void *audio_pool_alloc(audio_pool_arena_t arena, size_t size);
+
+/**
+ * @brief Allocate a zeroed buffer
+ */
+void *audio_pool_calloc(audio_pool_arena_t arena, size_t size);
+
+/**
+ * @brief Free a buffer from audio_pool_alloc() (NULL is ignored)
+ */
+void audio_pool_free(void *ptr);
+
+/**
+ * @brief Get arena statistics
+ *
+ * @param arena Arena
+ * @param stats Output statistics
+ */
+void audio_pool_get_stats(audio_pool_arena_t arena, audio_pool_stats_t *stats);
+
+/**
+ * @brief Get the name of an arena ("internal", "psram")
+ */
+const char *audio_pool_arena_name(audio_pool_arena_t arena);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,203 @@
+/**
+ * Audio Buffer Pool
+ *
+ * Each arena is one aligned allocation split into fixed blocks tracked by
+ * a 64-bit occupancy mask. An allocation takes the first run of free
+ * blocks that fits; the run length is recorded at its first block so a
+ * free needs only the pointer. Critical sections are a mask scan long.
+ */
+
+#include "audio_pool.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "audio_pool";
+
+#define POOL_ALIGN 16               // AUDIO_DSP_ALIGN, for the PIE kernels
+#define POOL_MAX_BLOCKS 64          // Bits in the occupancy mask
+
+#if CONFIG_AUDIO_POOL_INTERNAL_BLOCKS > POOL_MAX_BLOCKS || CONFIG_AUDIO_POOL_PSRAM_BLOCKS > POOL_MAX_BLOCKS
+#error "Audio pool arenas are limited to 64 blocks"
+#endif
+
+#define ALIGN_UP(x) (((x) + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1))
+
+typedef struct {
+    const char *name;
+    uint32_t caps;
+    size_t block_size;
+    uint32_t blocks;
+    uint8_t *base;                  // NULL until reserved
+    uint64_t used_mask;
+    uint8_t run_len[POOL_MAX_BLOCKS];
+    audio_pool_stats_t stats;
+} pool_arena_t;
+
+static pool_arena_t s_arenas[AUDIO_POOL_MAX] = {
+    [AUDIO_POOL_INTERNAL] = {
+        .name = "internal",
+        .caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT,
+        .block_size = ALIGN_UP(CONFIG_AUDIO_POOL_INTERNAL_BLOCK_SIZE),
+        .blocks = CONFIG_AUDIO_POOL_INTERNAL_BLOCKS,
+    },
+    [AUDIO_POOL_PSRAM] = {
+        .name = "psram",
+        .caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+        .block_size = ALIGN_UP(CONFIG_AUDIO_POOL_PSRAM_BLOCK_SIZE),
+        .blocks = CONFIG_AUDIO_POOL_PSRAM_BLOCKS,
+    },
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t audio_pool_init(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    for (int i = 0; i < AUDIO_POOL_MAX; i++) {
+        pool_arena_t *arena = &s_arenas[i];
+        if (arena->base) {
+            continue;
+        }
+
+        size_t bytes = arena->block_size * arena->blocks;
+        uint8_t *base = heap_caps_aligned_alloc(POOL_ALIGN, bytes, arena->caps);
+        if (!base) {
+            ESP_LOGE(TAG, "Failed to reserve %s arena (%d bytes)", arena->name, (int)bytes);
+            ret = ESP_ERR_NO_MEM;
+            continue;
+        }
+
+        taskENTER_CRITICAL(&s_lock);
+        arena->base = base;
+        arena->stats.block_size = arena->block_size;
+        arena->stats.blocks = arena->blocks;
+        taskEXIT_CRITICAL(&s_lock);
+        ESP_LOGI(TAG, "%s arena: %lu x %d bytes", arena->name, (unsigned long)arena->blocks,
+                 (int)arena->block_size);
+    }
+    return ret;
+}
+
+/**
+ * Find and claim n adjacent free blocks (lock held)
+ *
+ * @return First block index, or -1
+ */
+static int claim_run(pool_arena_t *arena, uint32_t n)
+{
+    uint64_t want = (n >= 64) ? ~0ULL : ((1ULL << n) - 1);
+
+    for (uint32_t first = 0; first + n <= arena->blocks; first++) {
+        if ((arena->used_mask & (want << first)) == 0) {
+            arena->used_mask |= want << first;
+            arena->run_len[first] = (uint8_t)n;
+            return (int)first;
+        }
+    }
+    return -1;
+}
+
+void *audio_pool_alloc(audio_pool_arena_t which, size_t size)
+{
+    if (which >= AUDIO_POOL_MAX || size == 0) {
+        return NULL;
+    }
+
+    pool_arena_t *arena = &s_arenas[which];
+    uint32_t n = (size + arena->block_size - 1) / arena->block_size;
+    void *ptr = NULL;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (arena->base && n <= arena->blocks) {
+        int first = claim_run(arena, n);
+        if (first >= 0) {
+            ptr = arena->base + (size_t)first * arena->block_size;
+            arena->stats.used += n;
+            arena->stats.allocs++;
+            if (arena->stats.used > arena->stats.high_water) {
+                arena->stats.high_water = arena->stats.used;
+            }
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (ptr) {
+        return ptr;
+    }
+
+#if CONFIG_AUDIO_POOL_HEAP_FALLBACK
+    ptr = heap_caps_aligned_alloc(POOL_ALIGN, size, arena->caps);
+#endif
+
+    taskENTER_CRITICAL(&s_lock);
+    if (ptr) {
+        arena->stats.fallbacks++;
+    } else {
+        arena->stats.failures++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (arena->base) {
+        ESP_LOGW(TAG, "%s arena exhausted for %d bytes, %s", arena->name, (int)size,
+                 ptr ? "using heap" : "failed");
+    }
+    return ptr;
+}
+
+void *audio_pool_calloc(audio_pool_arena_t arena, size_t size)
+{
+    void *ptr = audio_pool_alloc(arena, size);
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void audio_pool_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    uint8_t *p = ptr;
+    for (int i = 0; i < AUDIO_POOL_MAX; i++) {
+        pool_arena_t *arena = &s_arenas[i];
+        if (!arena->base || p < arena->base || p >= arena->base + arena->block_size * arena->blocks) {
+            continue;
+        }
+
+        uint32_t first = (p - arena->base) / arena->block_size;
+        taskENTER_CRITICAL(&s_lock);
+        uint32_t n = arena->run_len[first];
+        uint64_t run = (n >= 64) ? ~0ULL : ((1ULL << n) - 1);
+        arena->used_mask &= ~(run << first);
+        arena->run_len[first] = 0;
+        arena->stats.used -= n;
+        taskEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    heap_caps_free(ptr);  // Heap fallback
+}
+
+void audio_pool_get_stats(audio_pool_arena_t arena, audio_pool_stats_t *stats)
+{
+    if (arena >= AUDIO_POOL_MAX) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_arenas[arena].stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+const char *audio_pool_arena_name(audio_pool_arena_t arena)
+{
+    return (arena < AUDIO_POOL_MAX) ? s_arenas[arena].name : "unknown";
+}
@@ -0,0 +1,170 @@
+/**
+ * Audio I/O Engine
+ *
+ * Owns the ES8311 play/record devices and runs full-duplex I/O at one
+ * fixed native rate on a dedicated task. Clients open mono streams at
+ * their own sample rate: capture streams receive the microphone (left
+ * channel) and playback streams are mixed into the speaker output, so
+ * several modules can record and play at the same time without touching
+ * the codec configuration. A voice activity detector runs on every
+ * microphone period, so all capture clients share one speech decision.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque capture or playback stream
+ */
+typedef struct audio_engine_stream *audio_engine_stream_handle_t;
+
+/**
+ * @brief Engine statistics
+ */
+typedef struct {
+    uint32_t sample_rate;           // Native codec rate
+    uint32_t periods;               // I/O periods processed
+    uint32_t capture_streams;       // Open capture streams
+    uint32_t playback_streams;      // Open playback streams
+    uint32_t capture_overruns;      // Capture periods dropped because a client did not read in time
+    uint32_t playback_underruns;    // Playback periods padded with silence mid-stream
+    uint32_t io_errors;             // Codec read/write failures
+} audio_engine_stats_t;
+
+/**
+ * @brief Voice activity on the microphone
+ *
+ * The decision is made on each native-rate period before it is handed to
+ * the capture streams, so it is never behind the samples a client reads.
+ */
+typedef struct {
+    bool speech;                    // Speech active (including the hangover)
+    uint32_t silence_ms;            // Time since speech last ended, 0 while active
+    int32_t level_db;               // Last period, dBFS
+    int32_t noise_db;               // Background estimate, dBFS
+} audio_engine_vad_t;
+
+/**
+ * @brief Start the engine on already initialized codec devices
+ *
+ * Called by bsp_extra_codec_init(). Safe to call more than once.
+ *
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t audio_engine_start(void);
+
+/**
+ * @brief Check whether the engine is running
+ */
+bool audio_engine_is_running(void);
+
+/**
+ * @brief Get the fixed native codec rate
+ */
+uint32_t audio_engine_native_rate(void);
+
+/**
+ * @brief Open a microphone stream
+ *
+ * @param sample_rate Rate the client wants to receive, in Hz
+ * @param buffer_ms Audio the stream can hold before dropping periods
+ * @param ret_stream Output stream handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the engine is not
+ *         running, ESP_ERR_NO_MEM if no stream slot or memory is free
+ */
+esp_err_t audio_engine_capture_open(uint32_t sample_rate, uint32_t buffer_ms,
+                                    audio_engine_stream_handle_t *ret_stream);
+
+/**
+ * @brief Read captured mono samples
+ *
+ * Blocks until count samples are available or the timeout expires.
+ * Only one task may read a given stream.
+ *
+ * @param stream Capture stream
+ * @param samples Output buffer
+ * @param count Samples wanted
+ * @param timeout_ms Max time to wait
+ * @return Samples read (less than count on timeout)
+ */
+size_t audio_engine_capture_read(audio_engine_stream_handle_t stream, int16_t *samples,
+                                 size_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Open a speaker stream
+ *
+ * @param sample_rate Rate of the samples the client writes, in Hz
+ * @param buffer_ms Audio the stream can queue ahead of the codec
+ * @param gain_q8 Digital gain in Q8 (AUDIO_DSP_GAIN_UNITY = 1.0)
+ * @param ret_stream Output stream handle
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t audio_engine_playback_open(uint32_t sample_rate, uint32_t buffer_ms, uint16_t gain_q8,
+                                     audio_engine_stream_handle_t *ret_stream);
+
+/**
+ * @brief Queue mono samples for playback
+ *
+ * Blocks while the stream is full. Only one task may write a given stream.
+ *
+ * @param stream Playback stream
+ * @param samples Input samples
+ * @param count Number of samples
+ * @param timeout_ms Max time to wait for space
+ * @return Samples queued (less than count on timeout)
+ */
+size_t audio_engine_playback_write(audio_engine_stream_handle_t stream, const int16_t *samples,
+                                   size_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Wait until all queued samples have been sent to the codec
+ *
+ * Call from the task that writes the stream; it blocks on the stream's
+ * ring as a writer waiting for space would.
+ *
+ * @param stream Playback stream
+ * @param timeout_ms Max time to wait
+ * @return ESP_OK when drained, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t audio_engine_playback_drain(audio_engine_stream_handle_t stream, uint32_t timeout_ms);
+
+/**
+ * @brief Get the client-side sample rate of a stream
+ */
+uint32_t audio_engine_stream_rate(audio_engine_stream_handle_t stream);
+
+/**
+ * @brief Close a stream, discarding anything still buffered
+ *
+ * @param stream Stream to close (may be NULL)
+ */
+void audio_engine_stream_close(audio_engine_stream_handle_t stream);
+
+/**
+ * @brief Get the current voice activity decision
+ *
+ * With CONFIG_BSP_AUDIO_ENGINE_VAD disabled (or the engine stopped) speech
+ * is always reported, so gating clients pass everything through.
+ *
+ * @param vad Output state
+ */
+void audio_engine_vad_get(audio_engine_vad_t *vad);
+
+/**
+ * @brief Get engine statistics
+ *
+ * @param stats Output statistics
+ */
+void audio_engine_get_stats(audio_engine_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
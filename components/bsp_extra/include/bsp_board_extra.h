@@ -80,6 +80,9 @@ esp_err_t bsp_extra_codec_dev_resume(void);
  * @param bits_cfg: Bit lengths of one channel data
  * @param ch: Channels of sample
  *
+ * @note The audio engine owns the codec once started; clients use
+ *       audio_engine.h streams instead.
+ *
  * @return
  *    - ESP_OK: Success
  *    - Others: Fail
@@ -94,6 +97,9 @@ esp_err_t bsp_extra_codec_set_fs(uint32_t rate, uint32_t bits_cfg, i2s_slot_mode
  * @param bytes_read: Byte number that actually be read, can be NULL if not needed
  * @param timeout_ms: Max block time
  *
+ * @note The audio engine owns the codec once started; clients use
+ *       audio_engine.h streams instead.
+ *
  * @return
  *    - ESP_OK: Success
  *    - Others: Fail
@@ -108,6 +114,9 @@ esp_err_t bsp_extra_i2s_read(void *audio_buffer, size_t len, size_t *bytes_read,
  * @param bytes_written: Byte number that actually be sent, can be NULL if not needed
  * @param timeout_ms: Max block time
  *
+ * @note The audio engine owns the codec once started; clients use
+ *       audio_engine.h streams instead.
+ *
  * @return
  *    - ESP_OK: Success
  *    - Others: Fail
@@ -0,0 +1,500 @@
+/**
+ * Audio I/O Engine
+ *
+ * One task paced by the I2S DMA: each period it reads a stereo block from
+ * the microphone, hands the left channel to every capture stream
+ * (resampled to the stream rate) after running the voice activity
+ * detector on it, then pulls every playback stream,
+ * resamples it to the native rate, mixes and writes the speaker block.
+ * Streams are SPSC rings between the engine and one client task, so the
+ * period loop never waits on a client.
+ */
+
+#include "audio_engine.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "audio_dsp.h"
+#include "spsc_ring.h"
+#include "bsp_board_extra.h"
+#include "audio_engine_priv.h"
+
+static const char *TAG = "audio_engine";
+
+#define ENGINE_RATE             CONFIG_BSP_AUDIO_ENGINE_SAMPLE_RATE
+#define ENGINE_PERIOD_MS        CONFIG_BSP_AUDIO_ENGINE_PERIOD_MS
+#define ENGINE_PERIOD_FRAMES    (ENGINE_RATE * ENGINE_PERIOD_MS / 1000)
+#define ENGINE_MAX_STREAMS      8
+#define ENGINE_TASK_STACK       4096
+#define ENGINE_PRIME_PERIODS    2       // Silence queued ahead when output starts, absorbs scheduling jitter
+#define ENGINE_IO_TIMEOUT_MS    (ENGINE_PERIOD_MS * 10)
+
+typedef enum {
+    STREAM_CAPTURE = 0,
+    STREAM_PLAYBACK,
+} stream_dir_t;
+
+struct audio_engine_stream {
+    bool in_use;
+    stream_dir_t dir;
+    uint32_t sample_rate;
+    uint16_t gain_q8;
+    spsc_ring_handle_t ring;
+    audio_engine_resampler_t rs;
+    bool started;               // Playback: has produced audio at least once
+    volatile bool draining;     // Playback: client finished writing, short periods are expected
+};
+
+static struct {
+    bool running;
+    TaskHandle_t task;
+    SemaphoreHandle_t lock;
+    struct audio_engine_stream streams[ENGINE_MAX_STREAMS];
+    int16_t *stereo_in;         // Codec capture block
+    int16_t *stereo_out;        // Codec playback block
+    int16_t *mono;              // Native-rate capture
+    int16_t *mix;               // Native-rate playback accumulator
+    int16_t *scratch;           // Per-stream conversion output
+    bool output_active;
+    audio_engine_stats_t stats;
+#if CONFIG_BSP_AUDIO_ENGINE_VAD
+    audio_dsp_vad_t vad;
+    uint32_t silent_periods;    // Periods since speech ended
+#endif
+} s_engine = {0};
+
+static size_t ring_size_for(uint32_t sample_rate, uint32_t buffer_ms)
+{
+    size_t bytes = (size_t)sample_rate * sizeof(int16_t) * buffer_ms / 1000;
+    size_t size = 1024;
+    while (size < bytes) {
+        size <<= 1;
+    }
+    return size;
+}
+
+/**
+ * Fan the native-rate capture block out to every capture stream
+ */
+static void process_capture(void)
+{
+    for (int s = 0; s < ENGINE_MAX_STREAMS; s++) {
+        struct audio_engine_stream *stream = &s_engine.streams[s];
+        if (!stream->in_use || stream->dir != STREAM_CAPTURE) {
+            continue;
+        }
+
+        size_t used = 0;
+        size_t produced = audio_engine_resample(&stream->rs, s_engine.mono, ENGINE_PERIOD_FRAMES,
+                                                s_engine.scratch, ENGINE_PERIOD_FRAMES, &used);
+        size_t bytes = produced * sizeof(int16_t);
+        if (spsc_ring_write(stream->ring, s_engine.scratch, bytes) < bytes) {
+            s_engine.stats.capture_overruns++;
+        }
+    }
+}
+
+/**
+ * Pull one native-rate period from a playback stream into scratch
+ *
+ * @return Samples produced (the rest of the period is zeroed)
+ */
+static size_t pull_playback(struct audio_engine_stream *stream)
+{
+    size_t produced = 0;
+
+    while (produced < ENGINE_PERIOD_FRAMES) {
+        const uint8_t *data;
+        size_t avail = spsc_ring_peek_read(stream->ring, &data) / sizeof(int16_t);
+        if (avail == 0) {
+            break;
+        }
+
+        size_t used = 0;
+        size_t got = audio_engine_resample(&stream->rs, (const int16_t *)data, avail,
+                                           s_engine.scratch + produced,
+                                           ENGINE_PERIOD_FRAMES - produced, &used);
+        spsc_ring_commit_read(stream->ring, used * sizeof(int16_t));
+        produced += got;
+        if (used == 0 && got == 0) {
+            break;
+        }
+    }
+
+    if (produced > 0 && produced < ENGINE_PERIOD_FRAMES) {
+        memset(s_engine.scratch + produced, 0, (ENGINE_PERIOD_FRAMES - produced) * sizeof(int16_t));
+    }
+    return produced;
+}
+
+/**
+ * Mix every playback stream into the native-rate accumulator
+ *
+ * @return true if any stream contributed audio
+ */
+static bool process_playback(void)
+{
+    bool mixed = false;
+
+    for (int s = 0; s < ENGINE_MAX_STREAMS; s++) {
+        struct audio_engine_stream *stream = &s_engine.streams[s];
+        if (!stream->in_use || stream->dir != STREAM_PLAYBACK) {
+            continue;
+        }
+
+        size_t produced = pull_playback(stream);
+        if (produced == 0) {
+            if (stream->started && !stream->draining) {
+                s_engine.stats.playback_underruns++;
+            }
+            continue;
+        }
+        if (produced < ENGINE_PERIOD_FRAMES && !stream->draining) {
+            s_engine.stats.playback_underruns++;
+        }
+        stream->started = true;
+
+        if (stream->gain_q8 != AUDIO_DSP_GAIN_UNITY) {
+            audio_dsp_gain(s_engine.scratch, s_engine.scratch, ENGINE_PERIOD_FRAMES, stream->gain_q8);
+        }
+        if (mixed) {
+            audio_dsp_mix(s_engine.mix, s_engine.scratch, ENGINE_PERIOD_FRAMES);
+        } else {
+            memcpy(s_engine.mix, s_engine.scratch, ENGINE_PERIOD_FRAMES * sizeof(int16_t));
+            mixed = true;
+        }
+    }
+
+    return mixed;
+}
+
+static void write_output(const int16_t *stereo)
+{
+    size_t written = 0;
+    if (bsp_extra_i2s_write((void *)stereo, ENGINE_PERIOD_FRAMES * 2 * sizeof(int16_t),
+                            &written, ENGINE_IO_TIMEOUT_MS) != ESP_OK) {
+        s_engine.stats.io_errors++;
+    }
+}
+
+static void engine_task(void *arg)
+{
+    const size_t block_bytes = ENGINE_PERIOD_FRAMES * 2 * sizeof(int16_t);
+
+    ESP_LOGI(TAG, "Engine running: %d Hz, %d ms periods", ENGINE_RATE, ENGINE_PERIOD_MS);
+
+    while (true) {
+        // Blocks for one period of DMA; this is what paces the engine
+        size_t bytes_read = 0;
+        if (bsp_extra_i2s_read(s_engine.stereo_in, block_bytes, &bytes_read, ENGINE_IO_TIMEOUT_MS) != ESP_OK) {
+            s_engine.stats.io_errors++;
+            memset(s_engine.stereo_in, 0, block_bytes);
+            vTaskDelay(pdMS_TO_TICKS(ENGINE_PERIOD_MS));
+        }
+        audio_dsp_deinterleave_left(s_engine.stereo_in, s_engine.mono, ENGINE_PERIOD_FRAMES);
+#if CONFIG_BSP_AUDIO_ENGINE_VAD
+        bool speech = audio_dsp_vad_process(&s_engine.vad, s_engine.mono, ENGINE_PERIOD_FRAMES);
+#endif
+
+        xSemaphoreTake(s_engine.lock, portMAX_DELAY);
+#if CONFIG_BSP_AUDIO_ENGINE_VAD
+        s_engine.silent_periods = speech ? 0 : s_engine.silent_periods + 1;
+#endif
+        process_capture();
+        bool mixed = process_playback();
+        s_engine.stats.periods++;
+        xSemaphoreGive(s_engine.lock);
+
+        if (mixed) {
+            if (!s_engine.output_active) {
+                memset(s_engine.stereo_out, 0, block_bytes);
+                for (int i = 0; i < ENGINE_PRIME_PERIODS; i++) {
+                    write_output(s_engine.stereo_out);
+                }
+                s_engine.output_active = true;
+            }
+            audio_dsp_mono_to_stereo_gain(s_engine.mix, s_engine.stereo_out, ENGINE_PERIOD_FRAMES,
+                                          AUDIO_DSP_GAIN_UNITY);
+            write_output(s_engine.stereo_out);
+        } else if (s_engine.output_active) {
+            // One silent period so the DMA does not loop the last block
+            memset(s_engine.stereo_out, 0, block_bytes);
+            write_output(s_engine.stereo_out);
+            s_engine.output_active = false;
+        }
+    }
+}
+
+esp_err_t audio_engine_start(void)
+{
+    if (s_engine.running) {
+        return ESP_OK;
+    }
+
+    const size_t mono_bytes = ENGINE_PERIOD_FRAMES * sizeof(int16_t);
+    s_engine.lock = xSemaphoreCreateMutex();
+    s_engine.stereo_in = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, mono_bytes * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    s_engine.stereo_out = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, mono_bytes * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    s_engine.mono = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, mono_bytes, MALLOC_CAP_INTERNAL);
+    s_engine.mix = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, mono_bytes, MALLOC_CAP_INTERNAL);
+    s_engine.scratch = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, mono_bytes, MALLOC_CAP_INTERNAL);
+
+    if (!s_engine.lock || !s_engine.stereo_in || !s_engine.stereo_out ||
+        !s_engine.mono || !s_engine.mix || !s_engine.scratch) {
+        ESP_LOGE(TAG, "Failed to allocate engine buffers");
+        goto err;
+    }
+
+    s_engine.stats.sample_rate = ENGINE_RATE;
+#if CONFIG_BSP_AUDIO_ENGINE_VAD
+    audio_dsp_vad_init(&s_engine.vad, ENGINE_PERIOD_MS, CONFIG_BSP_AUDIO_ENGINE_VAD_THRESHOLD_DB,
+                       CONFIG_BSP_AUDIO_ENGINE_VAD_HANGOVER_MS);
+    s_engine.silent_periods = 0;
+#endif
+
+    BaseType_t task_created = xTaskCreatePinnedToCore(engine_task, "audio_engine", ENGINE_TASK_STACK, NULL,
+                                                      CONFIG_BSP_AUDIO_ENGINE_TASK_PRIORITY, &s_engine.task,
+                                                      CONFIG_BSP_AUDIO_ENGINE_CORE);
+    if (task_created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create engine task");
+        goto err;
+    }
+
+    s_engine.running = true;
+    return ESP_OK;
+
+err:
+    if (s_engine.lock) {
+        vSemaphoreDelete(s_engine.lock);
+        s_engine.lock = NULL;
+    }
+    heap_caps_free(s_engine.stereo_in);
+    heap_caps_free(s_engine.stereo_out);
+    heap_caps_free(s_engine.mono);
+    heap_caps_free(s_engine.mix);
+    heap_caps_free(s_engine.scratch);
+    s_engine.stereo_in = s_engine.stereo_out = s_engine.mono = s_engine.mix = s_engine.scratch = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+bool audio_engine_is_running(void)
+{
+    return s_engine.running;
+}
+
+uint32_t audio_engine_native_rate(void)
+{
+    return ENGINE_RATE;
+}
+
+static esp_err_t stream_open(stream_dir_t dir, uint32_t sample_rate, uint32_t buffer_ms, uint16_t gain_q8,
+                             audio_engine_stream_handle_t *ret_stream)
+{
+    ESP_RETURN_ON_FALSE(s_engine.running, ESP_ERR_INVALID_STATE, TAG, "Engine not running");
+    ESP_RETURN_ON_FALSE(ret_stream && sample_rate > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid stream arguments");
+    ESP_RETURN_ON_FALSE(dir == STREAM_PLAYBACK || sample_rate <= ENGINE_RATE, ESP_ERR_NOT_SUPPORTED,
+                        TAG, "Capture above %d Hz not supported", ENGINE_RATE);
+
+    // Rings live in PSRAM; the engine only touches them once per period
+    spsc_ring_handle_t ring = NULL;
+    ESP_RETURN_ON_ERROR(spsc_ring_create(ring_size_for(sample_rate, buffer_ms), MALLOC_CAP_SPIRAM, &ring),
+                        TAG, "Failed to create stream ring");
+
+    audio_engine_resampler_t rs;
+    esp_err_t ret = (dir == STREAM_CAPTURE) ? audio_engine_resampler_init(&rs, ENGINE_RATE, sample_rate)
+                                            : audio_engine_resampler_init(&rs, sample_rate, ENGINE_RATE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create resampler: %s", esp_err_to_name(ret));
+        spsc_ring_delete(ring);
+        return ret;
+    }
+
+    struct audio_engine_stream *stream = NULL;
+    xSemaphoreTake(s_engine.lock, portMAX_DELAY);
+    for (int s = 0; s < ENGINE_MAX_STREAMS; s++) {
+        if (!s_engine.streams[s].in_use) {
+            stream = &s_engine.streams[s];
+            memset(stream, 0, sizeof(*stream));
+            stream->dir = dir;
+            stream->sample_rate = sample_rate;
+            stream->gain_q8 = gain_q8;
+            stream->ring = ring;
+            stream->rs = rs;
+            if (dir == STREAM_CAPTURE) {
+                s_engine.stats.capture_streams++;
+            } else {
+                s_engine.stats.playback_streams++;
+            }
+            stream->in_use = true;
+            break;
+        }
+    }
+    xSemaphoreGive(s_engine.lock);
+
+    if (!stream) {
+        ESP_LOGE(TAG, "No free stream slot");
+        audio_engine_resampler_deinit(&rs);
+        spsc_ring_delete(ring);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Opened %s stream at %lu Hz", dir == STREAM_CAPTURE ? "capture" : "playback",
+             (unsigned long)sample_rate);
+    *ret_stream = stream;
+    return ESP_OK;
+}
+
+esp_err_t audio_engine_capture_open(uint32_t sample_rate, uint32_t buffer_ms,
+                                    audio_engine_stream_handle_t *ret_stream)
+{
+    return stream_open(STREAM_CAPTURE, sample_rate, buffer_ms, AUDIO_DSP_GAIN_UNITY, ret_stream);
+}
+
+esp_err_t audio_engine_playback_open(uint32_t sample_rate, uint32_t buffer_ms, uint16_t gain_q8,
+                                     audio_engine_stream_handle_t *ret_stream)
+{
+    return stream_open(STREAM_PLAYBACK, sample_rate, buffer_ms, gain_q8, ret_stream);
+}
+
+size_t audio_engine_capture_read(audio_engine_stream_handle_t stream, int16_t *samples,
+                                 size_t count, uint32_t timeout_ms)
+{
+    if (!stream || stream->dir != STREAM_CAPTURE) {
+        return 0;
+    }
+
+    size_t bytes = count * sizeof(int16_t);
+    spsc_ring_wait_data(stream->ring, bytes, pdMS_TO_TICKS(timeout_ms));
+    return spsc_ring_read(stream->ring, samples, bytes) / sizeof(int16_t);
+}
+
+size_t audio_engine_playback_write(audio_engine_stream_handle_t stream, const int16_t *samples,
+                                   size_t count, uint32_t timeout_ms)
+{
+    if (!stream || stream->dir != STREAM_PLAYBACK) {
+        return 0;
+    }
+
+    const uint8_t *data = (const uint8_t *)samples;
+    size_t remaining = count * sizeof(int16_t);
+    size_t half_ring = spsc_ring_size(stream->ring) / 2;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+    stream->draining = false;
+    while (remaining > 0) {
+        size_t written = spsc_ring_write(stream->ring, data, remaining);
+        data += written;
+        remaining -= written;
+        if (remaining == 0) {
+            break;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            break;
+        }
+        spsc_ring_wait_space(stream->ring, remaining < half_ring ? remaining : half_ring, timeout - elapsed);
+    }
+
+    return count - remaining / sizeof(int16_t);
+}
+
+esp_err_t audio_engine_playback_drain(audio_engine_stream_handle_t stream, uint32_t timeout_ms)
+{
+    if (!stream || stream->dir != STREAM_PLAYBACK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Empty means less than a sample left; the engine signals space as it pulls each period
+    stream->draining = true;
+    size_t size = spsc_ring_size(stream->ring);
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    while (spsc_ring_available(stream->ring) >= sizeof(int16_t)) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            return ESP_ERR_TIMEOUT;
+        }
+        spsc_ring_wait_space(stream->ring, size - (sizeof(int16_t) - 1), timeout - elapsed);
+    }
+
+    // The last pulled period is still on its way through the DMA
+    vTaskDelay(pdMS_TO_TICKS(ENGINE_PERIOD_MS * (ENGINE_PRIME_PERIODS + 1)));
+    return ESP_OK;
+}
+
+uint32_t audio_engine_stream_rate(audio_engine_stream_handle_t stream)
+{
+    return stream ? stream->sample_rate : 0;
+}
+
+void audio_engine_stream_close(audio_engine_stream_handle_t stream)
+{
+    if (!stream) {
+        return;
+    }
+
+    // Once the slot is released under the lock the engine no longer touches the ring
+    xSemaphoreTake(s_engine.lock, portMAX_DELAY);
+    spsc_ring_handle_t ring = stream->ring;
+    audio_engine_resampler_t rs = stream->rs;
+    if (stream->dir == STREAM_CAPTURE) {
+        s_engine.stats.capture_streams--;
+    } else {
+        s_engine.stats.playback_streams--;
+    }
+    stream->in_use = false;
+    stream->ring = NULL;
+    xSemaphoreGive(s_engine.lock);
+
+    audio_engine_resampler_deinit(&rs);
+    spsc_ring_delete(ring);
+}
+
+void audio_engine_get_stats(audio_engine_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+    if (!s_engine.running) {
+        memset(stats, 0, sizeof(*stats));
+        stats->sample_rate = ENGINE_RATE;
+        return;
+    }
+
+    xSemaphoreTake(s_engine.lock, portMAX_DELAY);
+    *stats = s_engine.stats;
+    xSemaphoreGive(s_engine.lock);
+}
+
+void audio_engine_vad_get(audio_engine_vad_t *vad)
+{
+    if (!vad) {
+        return;
+    }
+
+    *vad = (audio_engine_vad_t){ .speech = true, .level_db = -96, .noise_db = -96 };
+#if CONFIG_BSP_AUDIO_ENGINE_VAD
+    if (!s_engine.running) {
+        return;
+    }
+
+    xSemaphoreTake(s_engine.lock, portMAX_DELAY);
+    uint32_t silent_periods = s_engine.silent_periods;
+    uint32_t power = s_engine.vad.power;
+    uint32_t noise_floor = s_engine.vad.noise_floor;
+    xSemaphoreGive(s_engine.lock);
+
+    vad->speech = silent_periods == 0;
+    vad->silence_ms = silent_periods * ENGINE_PERIOD_MS;
+    vad->level_db = audio_dsp_power_db(power);
+    vad->noise_db = audio_dsp_power_db(noise_floor);
+#endif
+}
@@ -0,0 +1,80 @@
+/**
+ * Audio engine internals: per-stream sample rate conversion
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESAMPLE_MAX_FACTOR     6       // Largest reduced up/down factor handled by the polyphase path
+#define RESAMPLE_TAPS_PER_DOWN  16      // Taps per output, multiplied by the down factor
+
+typedef enum {
+    RESAMPLE_PASSTHROUGH = 0,
+    RESAMPLE_POLYPHASE,         // Rational L/M ratio (16/24/48 kHz): windowed-sinc Q15 filter bank
+    RESAMPLE_LINEAR,            // Any other ratio: linear interpolation
+} audio_engine_resample_mode_t;
+
+/**
+ * Streaming resampler state (one per stream)
+ *
+ * The polyphase path keeps its input history in `line` and picks, per
+ * output, the coefficient set for the filter phase and for the window's
+ * offset within a 16-byte block. Each set is zero-padded by one vector, so
+ * every dot product runs on aligned memory and the vector path never has to
+ * shift unaligned loads.
+ */
+typedef struct {
+    audio_engine_resample_mode_t mode;
+
+    // Polyphase
+    uint32_t up;                // L: interpolation factor
+    uint32_t down;              // M: decimation factor
+    uint32_t taps;              // Taps per phase (multiple of 8)
+    uint32_t set_len;           // taps + 8: padded coefficient set
+    int16_t *bank;              // [up][8 offsets][set_len] Q15 coefficients
+    int16_t *line;              // Input history, line_cap + 8 samples
+    uint32_t line_cap;
+    uint32_t fill;              // Valid samples in line
+    uint32_t pos;               // Line index of the newest input used by the next output
+    uint32_t frac;              // Filter phase of the next output (0..up-1)
+
+    // Linear
+    uint32_t step_q16;          // Input samples advanced per output sample (Q16)
+    uint32_t phase_q16;         // Position of the next output after `prev` (Q16)
+    int16_t prev;               // Last consumed input sample
+} audio_engine_resampler_t;
+
+/**
+ * Set up a resampler; the polyphase path allocates its filter bank and history
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t audio_engine_resampler_init(audio_engine_resampler_t *rs, uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * Free anything allocated by audio_engine_resampler_init()
+ */
+void audio_engine_resampler_deinit(audio_engine_resampler_t *rs);
+
+/**
+ * Convert as much input as fits in the output
+ *
+ * Only the input needed for the produced samples is consumed; the filter
+ * history is kept internally.
+ *
+ * @param in_used Input samples consumed
+ * @return Output samples produced
+ */
+size_t audio_engine_resample(audio_engine_resampler_t *rs, const int16_t *in, size_t in_count,
+                             int16_t *out, size_t out_cap, size_t *in_used);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,240 @@
+/**
+ * Audio engine sample rate conversion
+ *
+ * Rational ratios with small factors (16 <-> 24 <-> 48 kHz) go through a
+ * polyphase windowed-sinc filter in Q15: the prototype is designed once per
+ * stream at in_rate * L, split into L phases, and each output is one
+ * audio_dsp_fir_q15() call (PIE on ESP32-P4). Anything else falls back to
+ * linear interpolation.
+ */
+
+#include "audio_engine_priv.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "audio_dsp.h"
+
+#define Q16_ONE             (1u << 16)
+#define RESAMPLE_CUTOFF     0.90f   // Passband edge as a fraction of the lower Nyquist rate
+#define RESAMPLE_LINE_CHUNK 256     // Input samples buffered between history compactions
+#define RESAMPLE_OFFSETS    (AUDIO_DSP_ALIGN / sizeof(int16_t))  // Window start positions within a vector
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * Design the L-phase prototype and lay it out as aligned coefficient sets
+ *
+ * Set (p, a) holds phase p reversed for an ascending dot product, preceded
+ * by `a` zeros so a window starting `a` samples into a block lines up with
+ * the block boundary.
+ */
+static esp_err_t build_bank(audio_engine_resampler_t *rs)
+{
+    const uint32_t up = rs->up;
+    const uint32_t taps = rs->taps;
+    const uint32_t len = up * taps;
+
+    float *proto = heap_caps_malloc(len * sizeof(float), MALLOC_CAP_DEFAULT);
+    rs->bank = heap_caps_aligned_calloc(AUDIO_DSP_ALIGN, (size_t)up * RESAMPLE_OFFSETS * rs->set_len,
+                                        sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    if (!proto || !rs->bank) {
+        heap_caps_free(proto);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Lowpass at the lower of the two Nyquist rates, Blackman window
+    uint32_t widest = (rs->up > rs->down) ? rs->up : rs->down;
+    float fc = 0.5f * RESAMPLE_CUTOFF / (float)widest;
+    float center = (float)(len - 1) * 0.5f;
+    for (uint32_t k = 0; k < len; k++) {
+        float t = (float)k - center;
+        float sinc = (t == 0.0f) ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * t) / ((float)M_PI * t);
+        float w = 0.42f - 0.5f * cosf(2.0f * (float)M_PI * k / (len - 1)) +
+                  0.08f * cosf(4.0f * (float)M_PI * k / (len - 1));
+        proto[k] = sinc * w;
+    }
+
+    int16_t phase_q15[taps];
+    for (uint32_t p = 0; p < up; p++) {
+        // Normalize every phase to unity DC gain so interpolated samples carry no ripple
+        float sum = 0.0f;
+        for (uint32_t j = 0; j < taps; j++) {
+            sum += proto[p + up * j];
+        }
+
+        int32_t total = 0;
+        uint32_t peak = 0;
+        for (uint32_t i = 0; i < taps; i++) {
+            float c = proto[p + up * (taps - 1 - i)] / sum * 32768.0f;
+            int32_t q = (int32_t)lroundf(c);
+            q = (q > 32767) ? 32767 : (q < -32768) ? -32768 : q;
+            phase_q15[i] = (int16_t)q;
+            total += q;
+            if (abs(q) > abs(phase_q15[peak])) {
+                peak = i;
+            }
+        }
+        // Put the rounding residue on the largest tap
+        int32_t fixed = phase_q15[peak] + (32768 - total);
+        phase_q15[peak] = (int16_t)((fixed > 32767) ? 32767 : fixed);
+
+        for (uint32_t a = 0; a < RESAMPLE_OFFSETS; a++) {
+            int16_t *set = rs->bank + (p * RESAMPLE_OFFSETS + a) * rs->set_len;
+            memcpy(set + a, phase_q15, taps * sizeof(int16_t));
+        }
+    }
+
+    heap_caps_free(proto);
+    return ESP_OK;
+}
+
+esp_err_t audio_engine_resampler_init(audio_engine_resampler_t *rs, uint32_t in_rate, uint32_t out_rate)
+{
+    memset(rs, 0, sizeof(*rs));
+
+    if (in_rate == out_rate) {
+        rs->mode = RESAMPLE_PASSTHROUGH;
+        return ESP_OK;
+    }
+
+    uint32_t g = gcd_u32(in_rate, out_rate);
+    uint32_t up = out_rate / g;
+    uint32_t down = in_rate / g;
+    if (up > RESAMPLE_MAX_FACTOR || down > RESAMPLE_MAX_FACTOR) {
+        rs->mode = RESAMPLE_LINEAR;
+        rs->step_q16 = (uint32_t)(((uint64_t)in_rate << 16) / out_rate);
+        rs->phase_q16 = Q16_ONE;  // Consume the first input before interpolating
+        return ESP_OK;
+    }
+
+    rs->mode = RESAMPLE_POLYPHASE;
+    rs->up = up;
+    rs->down = down;
+    rs->taps = RESAMPLE_TAPS_PER_DOWN * down;
+    rs->set_len = rs->taps + RESAMPLE_OFFSETS;
+    rs->line_cap = rs->taps + RESAMPLE_LINE_CHUNK;
+
+    // Slack of one block past line_cap covers the padded tail of the last window
+    rs->line = heap_caps_aligned_calloc(AUDIO_DSP_ALIGN, rs->line_cap + RESAMPLE_OFFSETS, sizeof(int16_t),
+                                        MALLOC_CAP_INTERNAL);
+    if (!rs->line || build_bank(rs) != ESP_OK) {
+        audio_engine_resampler_deinit(rs);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Start from silent history so the first output needs only one input
+    rs->fill = rs->taps - 1;
+    rs->pos = rs->taps - 1;
+    return ESP_OK;
+}
+
+void audio_engine_resampler_deinit(audio_engine_resampler_t *rs)
+{
+    heap_caps_free(rs->bank);
+    heap_caps_free(rs->line);
+    rs->bank = NULL;
+    rs->line = NULL;
+    rs->mode = RESAMPLE_PASSTHROUGH;
+}
+
+static size_t resample_polyphase(audio_engine_resampler_t *rs, const int16_t *in, size_t in_count,
+                                 int16_t *out, size_t out_cap, size_t *in_used)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (o < out_cap) {
+        if (rs->pos >= rs->fill) {
+            if (i == in_count) {
+                break;
+            }
+            if (rs->fill == rs->line_cap) {
+                // Keep just the window of the next output
+                uint32_t drop = rs->pos - (rs->taps - 1);
+                memmove(rs->line, rs->line + drop, (rs->fill - drop) * sizeof(int16_t));
+                rs->fill -= drop;
+                rs->pos -= drop;
+            }
+
+            // Take only what the remaining outputs need, the rest stays with the caller
+            size_t need = rs->pos + (rs->frac + (out_cap - o - 1) * rs->down) / rs->up + 1 - rs->fill;
+            size_t n = in_count - i;
+            if (n > need) {
+                n = need;
+            }
+            if (n > rs->line_cap - rs->fill) {
+                n = rs->line_cap - rs->fill;
+            }
+            memcpy(rs->line + rs->fill, in + i, n * sizeof(int16_t));
+            rs->fill += n;
+            i += n;
+            continue;
+        }
+
+        uint32_t start = rs->pos - (rs->taps - 1);
+        uint32_t offset = start & (RESAMPLE_OFFSETS - 1);
+        const int16_t *set = rs->bank + (rs->frac * RESAMPLE_OFFSETS + offset) * rs->set_len;
+        out[o++] = audio_dsp_fir_q15(rs->line + (start - offset), set, rs->set_len);
+
+        rs->frac += rs->down;
+        rs->pos += rs->frac / rs->up;
+        rs->frac %= rs->up;
+    }
+
+    *in_used = i;
+    return o;
+}
+
+static size_t resample_linear(audio_engine_resampler_t *rs, const int16_t *in, size_t in_count,
+                              int16_t *out, size_t out_cap, size_t *in_used)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (o < out_cap) {
+        while (rs->phase_q16 >= Q16_ONE && i < in_count) {
+            rs->prev = in[i++];
+            rs->phase_q16 -= Q16_ONE;
+        }
+        if (rs->phase_q16 >= Q16_ONE || i >= in_count) {
+            break;  // Need the next input sample to interpolate
+        }
+
+        // Q15 fraction keeps the product inside int32
+        int32_t diff = (int32_t)in[i] - rs->prev;
+        out[o++] = (int16_t)(rs->prev + ((diff * (int32_t)(rs->phase_q16 >> 1)) >> 15));
+        rs->phase_q16 += rs->step_q16;
+    }
+
+    *in_used = i;
+    return o;
+}
+
+size_t audio_engine_resample(audio_engine_resampler_t *rs, const int16_t *in, size_t in_count,
+                             int16_t *out, size_t out_cap, size_t *in_used)
+{
+    switch (rs->mode) {
+        case RESAMPLE_POLYPHASE:
+            return resample_polyphase(rs, in, in_count, out, out_cap, in_used);
+
+        case RESAMPLE_LINEAR:
+            return resample_linear(rs, in, in_count, out, out_cap, in_used);
+
+        case RESAMPLE_PASSTHROUGH:
+        default: {
+            size_t n = (in_count < out_cap) ? in_count : out_cap;
+            memcpy(out, in, n * sizeof(int16_t));
+            *in_used = n;
+            return n;
+        }
+    }
+}
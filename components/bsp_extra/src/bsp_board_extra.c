@@ -15,6 +15,11 @@
 
 #include "bsp/esp-bsp.h"
 #include "bsp_board_extra.h"
+#include "audio_engine.h"
+#include "audio_dsp.h"
+
+#define PLAYER_STREAM_BUFFER_MS     200
+#define PLAYER_DRAIN_TIMEOUT_MS     1000
 
 static const char *TAG = "bsp_extra_board";
 
@@ -28,6 +33,10 @@ static int _volume_intensity = CODEC_DEFAULT_VOLUME;
 static audio_player_cb_t audio_idle_callback = NULL;
 static void *audio_idle_cb_user_data = NULL;
 
+// The file player feeds the audio engine like any other client
+static audio_engine_stream_handle_t player_stream = NULL;
+static i2s_slot_mode_t player_channels = I2S_SLOT_MODE_STEREO;
+
 static esp_err_t audio_mute_function(AUDIO_PLAYER_MUTE_SETTING setting)
 {
     bsp_extra_codec_mute_set(setting == AUDIO_PLAYER_MUTE ? true : false);
@@ -42,6 +51,12 @@ static esp_err_t audio_mute_function(AUDIO_PLAYER_MUTE_SETTING setting)
 
 static void audio_callback(audio_player_cb_ctx_t *ctx)
 {
+    if (ctx->audio_event == AUDIO_PLAYER_CALLBACK_EVENT_IDLE && player_stream) {
+        audio_engine_playback_drain(player_stream, PLAYER_DRAIN_TIMEOUT_MS);
+        audio_engine_stream_close(player_stream);
+        player_stream = NULL;
+    }
+
     if (audio_idle_callback) {
         ctx->user_ctx = audio_idle_cb_user_data;
         audio_idle_callback(ctx);
@@ -62,6 +77,48 @@ esp_err_t bsp_extra_i2s_write(void *audio_buffer, size_t len, size_t *bytes_writ
     return ret;
 }
 
+/**
+ * audio_player clock hook: (re)open the engine stream at the file's rate
+ */
+static esp_err_t player_clk_set(uint32_t rate, uint32_t bits_cfg, i2s_slot_mode_t ch)
+{
+    ESP_RETURN_ON_FALSE(bits_cfg == 16, ESP_ERR_NOT_SUPPORTED, TAG, "Only 16-bit files are supported");
+    player_channels = ch;
+
+    if (player_stream && audio_engine_stream_rate(player_stream) == rate) {
+        return ESP_OK;
+    }
+    if (player_stream) {
+        audio_engine_stream_close(player_stream);
+        player_stream = NULL;
+    }
+    return audio_engine_playback_open(rate, PLAYER_STREAM_BUFFER_MS, AUDIO_DSP_GAIN_UNITY, &player_stream);
+}
+
+/**
+ * audio_player write hook: take the left channel and queue it on the engine
+ */
+static esp_err_t player_write(void *audio_buffer, size_t len, size_t *bytes_written, uint32_t timeout_ms)
+{
+    int16_t *samples = audio_buffer;
+    size_t count = len / sizeof(int16_t);
+
+    *bytes_written = 0;
+    ESP_RETURN_ON_FALSE(player_stream, ESP_ERR_INVALID_STATE, TAG, "Player stream not open");
+
+    // In place is safe: the write index never passes the read index
+    if (player_channels == I2S_SLOT_MODE_STEREO) {
+        count /= 2;
+        for (size_t i = 0; i < count; i++) {
+            samples[i] = samples[i * 2];
+        }
+    }
+
+    size_t queued = audio_engine_playback_write(player_stream, samples, count, timeout_ms);
+    *bytes_written = (queued == count) ? len : queued * sizeof(int16_t);
+    return (queued == count) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
 esp_err_t bsp_extra_codec_set_fs(uint32_t rate, uint32_t bits_cfg, i2s_slot_mode_t ch)
 {
     esp_err_t ret = ESP_OK;
@@ -129,7 +186,7 @@ esp_err_t bsp_extra_codec_dev_stop(void)
 
 esp_err_t bsp_extra_codec_dev_resume(void)
 {
-    return bsp_extra_codec_set_fs(CODEC_DEFAULT_SAMPLE_RATE, CODEC_DEFAULT_BIT_WIDTH, CODEC_DEFAULT_CHANNEL);
+    return bsp_extra_codec_set_fs(CONFIG_BSP_AUDIO_ENGINE_SAMPLE_RATE, CODEC_DEFAULT_BIT_WIDTH, CODEC_DEFAULT_CHANNEL);
 }
 
 esp_err_t bsp_extra_codec_init(void)
@@ -144,7 +201,11 @@ esp_err_t bsp_extra_codec_init(void)
     record_dev_handle = bsp_audio_codec_microphone_init();
     ESP_RETURN_ON_FALSE(record_dev_handle, ESP_FAIL, TAG, "record_dev_handle not initialized");
 
-    bsp_extra_codec_set_fs(CODEC_DEFAULT_SAMPLE_RATE, CODEC_DEFAULT_BIT_WIDTH, CODEC_DEFAULT_CHANNEL);
+    // Fixed native rate; the audio engine converts per stream from here on
+    ESP_RETURN_ON_ERROR(bsp_extra_codec_set_fs(CONFIG_BSP_AUDIO_ENGINE_SAMPLE_RATE, CODEC_DEFAULT_BIT_WIDTH,
+                                               CODEC_DEFAULT_CHANNEL), TAG, "Codec open failed");
+    esp_codec_dev_set_out_mute(play_dev_handle, false);
+    ESP_RETURN_ON_ERROR(audio_engine_start(), TAG, "Audio engine start failed");
 
     _is_audio_init = true;
 
@@ -159,8 +220,8 @@ esp_err_t bsp_extra_player_init(void)
 
     audio_player_config_t config = {
         .mute_fn = audio_mute_function,
-        .write_fn = bsp_extra_i2s_write,
-        .clk_set_fn = bsp_extra_codec_set_fs,
+        .write_fn = player_write,
+        .clk_set_fn = player_clk_set,
         .priority = 5
     };
     ESP_RETURN_ON_ERROR(audio_player_new(config), TAG, "audio_player_init failed");
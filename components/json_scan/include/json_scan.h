@@ -0,0 +1,90 @@
+/**
+ * In-Place JSON Field Extraction
+ *
+ * Finds single values in a JSON text by path without building a tree or
+ * allocating: the scanner walks the text once and skips every member that
+ * is not on the path. Values are returned as spans into the input, which
+ * need not be NUL terminated.
+ *
+ * Paths are dotted member names with optional array indexes, e.g.
+ * "channel.alternatives[0].transcript" or "error.message".
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief JSON value type
+ */
+typedef enum {
+    JSON_SCAN_STRING = 0,
+    JSON_SCAN_NUMBER,
+    JSON_SCAN_OBJECT,
+    JSON_SCAN_ARRAY,
+    JSON_SCAN_TRUE,
+    JSON_SCAN_FALSE,
+    JSON_SCAN_NULL,
+} json_scan_type_t;
+
+/**
+ * @brief Span of a value in the input
+ *
+ * For strings the span is the raw contents between the quotes (escapes
+ * not decoded); for other types it is the whole value text.
+ */
+typedef struct {
+    json_scan_type_t type;
+    const char *ptr;
+    size_t len;
+    bool escaped;               // String contains backslash escapes
+} json_scan_value_t;
+
+/**
+ * @brief Find the value at a path
+ *
+ * @param json JSON text
+ * @param len Length of json in bytes
+ * @param path Member path
+ * @param value Output span
+ * @return true if the path exists and the text up to it is well formed
+ */
+bool json_scan_find(const char *json, size_t len, const char *path, json_scan_value_t *value);
+
+/**
+ * @brief Find a string value at a path
+ *
+ * @return true if the path exists and holds a string
+ */
+bool json_scan_find_string(const char *json, size_t len, const char *path, json_scan_value_t *value);
+
+/**
+ * @brief Compare a string value with a C string (no escapes in s)
+ *
+ * @param value String value
+ * @param s String to compare with
+ * @return true if equal
+ */
+bool json_scan_equals(const json_scan_value_t *value, const char *s);
+
+/**
+ * @brief Decode a string value into UTF-8
+ *
+ * Handles all JSON escapes including \\u surrogate pairs. Output is always
+ * NUL terminated and truncated at a character boundary if dst is too small.
+ *
+ * @param value String value
+ * @param dst Output buffer
+ * @param dst_size Size of dst (including the terminator)
+ * @return Bytes written, excluding the terminator
+ */
+size_t json_scan_unescape(const json_scan_value_t *value, char *dst, size_t dst_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,350 @@
+/**
+ * In-Place JSON Field Extraction
+ *
+ * Skipped containers are stepped over by bracket depth (strings aware)
+ * rather than parsed, so members off the path cost one pass over their
+ * bytes and no stack. Only the path itself is checked for structure.
+ */
+
+#include "json_scan.h"
+#include <string.h>
+
+typedef struct {
+    const char *p;
+    const char *end;
+} scanner_t;
+
+static void skip_ws(scanner_t *s)
+{
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) {
+        s->p++;
+    }
+}
+
+static bool expect(scanner_t *s, char c)
+{
+    skip_ws(s);
+    if (s->p < s->end && *s->p == c) {
+        s->p++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Scan a string starting at its opening quote
+ */
+static bool scan_string(scanner_t *s, json_scan_value_t *value)
+{
+    const char *start = ++s->p;
+    bool escaped = false;
+
+    while (s->p < s->end) {
+        char c = *s->p;
+        if (c == '"') {
+            if (value) {
+                value->type = JSON_SCAN_STRING;
+                value->ptr = start;
+                value->len = s->p - start;
+                value->escaped = escaped;
+            }
+            s->p++;
+            return true;
+        }
+        if (c == '\\') {
+            escaped = true;
+            s->p++;  // The escaped character cannot end the string
+        }
+        s->p++;
+    }
+    return false;
+}
+
+/**
+ * Step over one value of any type
+ */
+static bool skip_value(scanner_t *s)
+{
+    skip_ws(s);
+    if (s->p >= s->end) {
+        return false;
+    }
+
+    char c = *s->p;
+    if (c == '"') {
+        return scan_string(s, NULL);
+    }
+
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        while (s->p < s->end) {
+            c = *s->p;
+            if (c == '"') {
+                if (!scan_string(s, NULL)) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    s->p++;
+                    return true;
+                }
+            }
+            s->p++;
+        }
+        return false;
+    }
+
+    // Number or literal: runs to the next delimiter
+    const char *start = s->p;
+    while (s->p < s->end && *s->p != ',' && *s->p != '}' && *s->p != ']' &&
+           *s->p != ' ' && *s->p != '\t' && *s->p != '\n' && *s->p != '\r') {
+        s->p++;
+    }
+    return s->p > start;
+}
+
+static bool read_value(scanner_t *s, json_scan_value_t *value)
+{
+    skip_ws(s);
+    if (s->p >= s->end) {
+        return false;
+    }
+
+    const char *start = s->p;
+    char c = *start;
+    if (c == '"') {
+        return scan_string(s, value);
+    }
+    if (!skip_value(s)) {
+        return false;
+    }
+
+    value->ptr = start;
+    value->len = s->p - start;
+    value->escaped = false;
+    switch (c) {
+        case '{': value->type = JSON_SCAN_OBJECT; break;
+        case '[': value->type = JSON_SCAN_ARRAY; break;
+        case 't': value->type = JSON_SCAN_TRUE; break;
+        case 'f': value->type = JSON_SCAN_FALSE; break;
+        case 'n': value->type = JSON_SCAN_NULL; break;
+        default:
+            if (c != '-' && (c < '0' || c > '9')) {
+                return false;
+            }
+            value->type = JSON_SCAN_NUMBER;
+            break;
+    }
+    return true;
+}
+
+/**
+ * Enter the member named name[0..name_len) of the object at s
+ */
+static bool enter_member(scanner_t *s, const char *name, size_t name_len)
+{
+    if (!expect(s, '{')) {
+        return false;
+    }
+
+    skip_ws(s);
+    if (s->p < s->end && *s->p == '}') {
+        return false;
+    }
+
+    while (true) {
+        json_scan_value_t key;
+        skip_ws(s);
+        if (s->p >= s->end || *s->p != '"' || !scan_string(s, &key) || !expect(s, ':')) {
+            return false;
+        }
+        if (key.len == name_len && memcmp(key.ptr, name, name_len) == 0) {
+            return true;
+        }
+        if (!skip_value(s) || !expect(s, ',')) {
+            return false;  // Malformed, or '}' reached without a match
+        }
+    }
+}
+
+/**
+ * Enter element index of the array at s
+ */
+static bool enter_element(scanner_t *s, size_t index)
+{
+    if (!expect(s, '[')) {
+        return false;
+    }
+
+    skip_ws(s);
+    if (s->p < s->end && *s->p == ']') {
+        return false;
+    }
+
+    for (size_t i = 0; i < index; i++) {
+        if (!skip_value(s) || !expect(s, ',')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool json_scan_find(const char *json, size_t len, const char *path, json_scan_value_t *value)
+{
+    scanner_t s = { .p = json, .end = json + len };
+    const char *q = path;
+
+    while (*q) {
+        if (*q == '[') {
+            size_t index = 0;
+            for (q++; *q >= '0' && *q <= '9'; q++) {
+                index = index * 10 + (size_t)(*q - '0');
+            }
+            if (*q != ']' || !enter_element(&s, index)) {
+                return false;
+            }
+            q++;
+        } else {
+            const char *name = q;
+            while (*q && *q != '.' && *q != '[') {
+                q++;
+            }
+            if (!enter_member(&s, name, q - name)) {
+                return false;
+            }
+        }
+        if (*q == '.') {
+            q++;
+        }
+    }
+
+    return read_value(&s, value);
+}
+
+bool json_scan_find_string(const char *json, size_t len, const char *path, json_scan_value_t *value)
+{
+    return json_scan_find(json, len, path, value) && value->type == JSON_SCAN_STRING;
+}
+
+bool json_scan_equals(const json_scan_value_t *value, const char *s)
+{
+    size_t n = strlen(s);
+    return value->type == JSON_SCAN_STRING && !value->escaped && value->len == n &&
+           memcmp(value->ptr, s, n) == 0;
+}
+
+static int hex4(const char *p, const char *end)
+{
+    if (end - p < 4) {
+        return -1;
+    }
+
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+static size_t utf8_encode(unsigned cp, char *out)
+{
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+size_t json_scan_unescape(const json_scan_value_t *value, char *dst, size_t dst_size)
+{
+    if (dst_size == 0) {
+        return 0;
+    }
+
+    const char *p = value->ptr;
+    const char *end = value->ptr + value->len;
+    size_t n = 0;
+
+    while (p < end) {
+        char buf[4];
+        size_t len;
+        const char *src = buf;
+
+        if (*p != '\\') {
+            // Copy a whole raw UTF-8 character
+            unsigned char lead = (unsigned char)*p;
+            len = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : (lead >= 0xC0) ? 2 : 1;
+            if ((size_t)(end - p) < len) {
+                len = end - p;
+            }
+            src = p;
+            p += len;
+        } else if (end - p < 2) {
+            break;
+        } else {
+            char c = p[1];
+            p += 2;
+            switch (c) {
+                case 'b': buf[0] = '\b'; len = 1; break;
+                case 'f': buf[0] = '\f'; len = 1; break;
+                case 'n': buf[0] = '\n'; len = 1; break;
+                case 'r': buf[0] = '\r'; len = 1; break;
+                case 't': buf[0] = '\t'; len = 1; break;
+                case 'u': {
+                    int cp = hex4(p, end);
+                    if (cp < 0) {
+                        goto done;
+                    }
+                    p += 4;
+                    if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        int lo = hex4(p + 2, end);
+                        if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                            p += 6;
+                        }
+                    }
+                    if (cp >= 0xD800 && cp <= 0xDFFF) {
+                        cp = 0xFFFD;  // Unpaired surrogate
+                    }
+                    len = utf8_encode((unsigned)cp, buf);
+                    break;
+                }
+                default: buf[0] = c; len = 1; break;  // \" \\ \/
+            }
+        }
+
+        if (n + len >= dst_size) {
+            break;
+        }
+        memcpy(dst + n, src, len);
+        n += len;
+    }
+
+done:
+    dst[n] = '\0';
+    return n;
+}
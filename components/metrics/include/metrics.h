@@ -0,0 +1,167 @@
+/**
+ * Metrics Registry
+ *
+ * Counters, gauges and fixed-bucket histograms for the hot paths (TLS
+ * connect, first byte, first audio, WebSocket sends, underruns). Metrics
+ * are statically allocated by their owners and link themselves into a
+ * global list on first use; updates are single relaxed atomics, so they
+ * are safe from any task and never block.
+ *
+ * The registry is exported in Prometheus text format or as JSON, together
+ * with heap high-water marks and per-task CPU usage sampled at export.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Histogram bucket count, excluding the +Inf bucket
+ *
+ * Bucket bounds follow a 1-2-5 series across four decades of the
+ * histogram's unit scale (e.g. 1 ms .. 10 s).
+ */
+#define METRICS_HISTOGRAM_BUCKETS 13
+
+/**
+ * @brief Metric types
+ */
+typedef enum {
+    METRICS_TYPE_COUNTER = 0,
+    METRICS_TYPE_GAUGE,
+    METRICS_TYPE_HISTOGRAM,
+} metrics_type_t;
+
+/**
+ * @brief Metric
+ *
+ * Define with one of the METRICS_*_INIT initializers; never touch the
+ * fields directly.
+ */
+typedef struct metrics_metric {
+    const char *name;               // Prometheus name, e.g. "tts_first_audio_ms"
+    const char *help;
+    const char *label_key;          // Optional single label, e.g. "host" (NULL for none)
+    const char *label_value;
+    metrics_type_t type;
+    uint32_t unit_us;               // Histogram: microseconds per unit (1 or 1000)
+    uint32_t bound_scale;           // Histogram: multiplier applied to the 1-2-5 bounds
+    _Atomic int32_t value;          // Counter or gauge
+    _Atomic uint32_t count;         // Histogram observations
+    _Atomic uint64_t sum;           // Histogram sum, in units
+    _Atomic uint32_t buckets[METRICS_HISTOGRAM_BUCKETS + 1];  // Non-cumulative, last is +Inf
+    _Atomic bool registered;
+    struct metrics_metric *_Atomic next;
+} metrics_metric_t;
+
+#define METRICS_INIT_(n, h, k, v, t, unit, scale) \
+    { .name = (n), .help = (h), .label_key = (k), .label_value = (v), .type = (t), \
+      .unit_us = (unit), .bound_scale = (scale) }
+
+/**
+ * @brief Monotonic counter
+ */
+#define METRICS_COUNTER_INIT(name, help, label_key, label_value) \
+    METRICS_INIT_(name, help, label_key, label_value, METRICS_TYPE_COUNTER, 0, 0)
+
+/**
+ * @brief Gauge
+ */
+#define METRICS_GAUGE_INIT(name, help, label_key, label_value) \
+    METRICS_INIT_(name, help, label_key, label_value, METRICS_TYPE_GAUGE, 0, 0)
+
+/**
+ * @brief Histogram in milliseconds, buckets 1 ms .. 10 s
+ */
+#define METRICS_HISTOGRAM_MS_INIT(name, help, label_key, label_value) \
+    METRICS_INIT_(name, help, label_key, label_value, METRICS_TYPE_HISTOGRAM, 1000, 1)
+
+/**
+ * @brief Histogram in microseconds, buckets 10 us .. 100 ms
+ */
+#define METRICS_HISTOGRAM_US_INIT(name, help, label_key, label_value) \
+    METRICS_INIT_(name, help, label_key, label_value, METRICS_TYPE_HISTOGRAM, 1, 10)
+
+/**
+ * @brief Output callback for the exporters
+ *
+ * @return ESP_OK to continue, anything else aborts the export
+ */
+typedef esp_err_t (*metrics_write_fn)(const char *data, size_t len, void *ctx);
+
+/**
+ * @brief Add a metric to the registry
+ *
+ * Updates register implicitly; call this only for metrics that should be
+ * exported before their first update. Safe to call more than once.
+ */
+void metrics_register(metrics_metric_t *metric);
+
+/**
+ * @brief Add to a counter or gauge
+ */
+void metrics_add(metrics_metric_t *metric, int32_t delta);
+
+/**
+ * @brief Increment a counter or gauge
+ */
+static inline void metrics_inc(metrics_metric_t *metric)
+{
+    metrics_add(metric, 1);
+}
+
+/**
+ * @brief Set a gauge, or a counter mirrored from another module's statistics
+ */
+void metrics_set(metrics_metric_t *metric, int32_t value);
+
+/**
+ * @brief Record a histogram observation
+ *
+ * @param metric Histogram
+ * @param value Value in the histogram's unit
+ */
+void metrics_observe(metrics_metric_t *metric, uint32_t value);
+
+/**
+ * @brief Record the time elapsed since a timestamp
+ *
+ * @param metric Histogram
+ * @param start_us esp_timer_get_time() at the start of the interval
+ */
+void metrics_observe_since(metrics_metric_t *metric, int64_t start_us);
+
+/**
+ * @brief Export all metrics in Prometheus text format (version 0.0.4)
+ *
+ * Output is produced in small pieces; no buffer of the full size is needed.
+ *
+ * @param write Output callback
+ * @param ctx Passed to write
+ * @return ESP_OK, or the first error returned by write
+ */
+esp_err_t metrics_write_prometheus(metrics_write_fn write, void *ctx);
+
+/**
+ * @brief Export all metrics as JSON
+ *
+ * One object with a "metrics" array; histograms carry cumulative bucket
+ * counts and p50/p95/p99 estimates (bucket upper bounds).
+ *
+ * @param write Output callback
+ * @param ctx Passed to write
+ * @return ESP_OK, or the first error returned by write
+ */
+esp_err_t metrics_write_json(metrics_write_fn write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
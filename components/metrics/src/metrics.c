@@ -0,0 +1,547 @@
+/**
+ * Metrics Registry
+ *
+ * The registry is an intrusive singly linked list pushed with a CAS and
+ * never unlinked, so exporters can walk it without a lock while other
+ * tasks register and update metrics. Metrics sharing a name form one
+ * Prometheus family and are exported together under a single HELP/TYPE.
+ *
+ * Exporters format into a small buffer that is flushed to the caller's
+ * write callback whenever it fills.
+ */
+
+#include "metrics.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#define WRITER_BUFFER_SIZE 512
+#define LABEL_MAX 24
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+#define METRICS_TASK_STATS 1
+#define TASK_HEADROOM 4                 // Tasks that may be created between counting and the snapshot
+#define TASK_SNAPSHOT_TRIES 3
+#else
+#define METRICS_TASK_STATS 0
+#endif
+
+static const uint32_t s_series[METRICS_HISTOGRAM_BUCKETS] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000,
+};
+
+static metrics_metric_t *_Atomic s_head;
+
+typedef struct {
+    metrics_write_fn write;
+    void *ctx;
+    esp_err_t err;
+    size_t len;
+    char buf[WRITER_BUFFER_SIZE];
+} writer_t;
+
+void metrics_register(metrics_metric_t *metric)
+{
+    if (atomic_exchange_explicit(&metric->registered, true, memory_order_acq_rel)) {
+        return;
+    }
+
+    metrics_metric_t *head = atomic_load_explicit(&s_head, memory_order_acquire);
+    do {
+        atomic_store_explicit(&metric->next, head, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&s_head, &head, metric, memory_order_release,
+                                                    memory_order_acquire));
+}
+
+static inline void ensure_registered(metrics_metric_t *metric)
+{
+    if (!atomic_load_explicit(&metric->registered, memory_order_relaxed)) {
+        metrics_register(metric);
+    }
+}
+
+void metrics_add(metrics_metric_t *metric, int32_t delta)
+{
+    ensure_registered(metric);
+    atomic_fetch_add_explicit(&metric->value, delta, memory_order_relaxed);
+}
+
+void metrics_set(metrics_metric_t *metric, int32_t value)
+{
+    ensure_registered(metric);
+    atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+}
+
+static inline uint32_t bucket_bound(const metrics_metric_t *metric, int i)
+{
+    return s_series[i] * metric->bound_scale;
+}
+
+void metrics_observe(metrics_metric_t *metric, uint32_t value)
+{
+    ensure_registered(metric);
+
+    int i = 0;
+    while (i < METRICS_HISTOGRAM_BUCKETS && value > bucket_bound(metric, i)) {
+        i++;
+    }
+    atomic_fetch_add_explicit(&metric->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metric->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metric->count, 1, memory_order_relaxed);
+}
+
+void metrics_observe_since(metrics_metric_t *metric, int64_t start_us)
+{
+    int64_t elapsed = esp_timer_get_time() - start_us;
+    if (elapsed < 0) {
+        elapsed = 0;
+    }
+    uint64_t value = (uint64_t)elapsed / metric->unit_us;
+    metrics_observe(metric, value > UINT32_MAX ? UINT32_MAX : (uint32_t)value);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Output                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static void flush(writer_t *w)
+{
+    if (w->err == ESP_OK && w->len > 0) {
+        w->err = w->write(w->buf, w->len, w->ctx);
+    }
+    w->len = 0;
+}
+
+static void out(writer_t *w, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void out(writer_t *w, const char *fmt, ...)
+{
+    if (w->err != ESP_OK) {
+        return;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(w->buf + w->len, sizeof(w->buf) - w->len, fmt, args);
+        va_end(args);
+
+        if (n < 0) {
+            return;
+        }
+        if ((size_t)n < sizeof(w->buf) - w->len) {
+            w->len += n;
+            return;
+        }
+        if (w->len == 0) {
+            w->len = sizeof(w->buf) - 1;  // Longer than the buffer, send truncated
+            return;
+        }
+        flush(w);
+    }
+}
+
+/**
+ * Copy a label value, replacing characters that would need escaping
+ */
+static void sanitize_label(char *dst, const char *src)
+{
+    size_t i = 0;
+    for (; src[i] && i < LABEL_MAX - 1; i++) {
+        char c = src[i];
+        dst[i] = (c == '"' || c == '\\' || c < ' ') ? '_' : c;
+    }
+    dst[i] = '\0';
+}
+
+/* ------------------------------------------------------------------------- */
+/* System samples                                                            */
+/* ------------------------------------------------------------------------- */
+
+static const struct {
+    const char *name;
+    uint32_t caps;
+} s_heap_regions[] = {
+    {"internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT},
+    {"psram", MALLOC_CAP_SPIRAM},
+};
+
+#define HEAP_REGIONS (sizeof(s_heap_regions) / sizeof(s_heap_regions[0]))
+
+typedef enum {
+    HEAP_FREE = 0,
+    HEAP_MIN_FREE,
+    HEAP_LARGEST_BLOCK,
+    HEAP_FAMILIES,
+} heap_family_idx_t;
+
+static const struct {
+    const char *name;
+    const char *help;
+} s_heap_families[HEAP_FAMILIES] = {
+    [HEAP_FREE] = {"heap_free_bytes", "Free heap"},
+    [HEAP_MIN_FREE] = {"heap_min_free_bytes", "Lowest free heap since boot (high-water mark of use)"},
+    [HEAP_LARGEST_BLOCK] = {"heap_largest_free_block_bytes", "Largest allocatable block"},
+};
+
+static uint32_t heap_value(heap_family_idx_t family, uint32_t caps)
+{
+    switch (family) {
+        case HEAP_FREE: return heap_caps_get_free_size(caps);
+        case HEAP_MIN_FREE: return heap_caps_get_minimum_free_size(caps);
+        default: return heap_caps_get_largest_free_block(caps);
+    }
+}
+
+#if METRICS_TASK_STATS
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t cpu_permille;          // Of one core, since the previous export
+    uint32_t stack_free;            // Bytes, lowest since the task started
+} task_sample_t;
+
+typedef struct {
+    UBaseType_t number;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} task_prev_t;
+
+static const char *TAG = "metrics";
+
+static task_prev_t *s_prev_tasks;       // Previous snapshot, replaced by each one
+static configRUN_TIME_COUNTER_TYPE s_prev_total;
+static int s_prev_count;
+static portMUX_TYPE s_prev_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * Snapshot all tasks; CPU use is relative to the previous snapshot (boot for the first)
+ *
+ * @return Samples (caller frees), NULL on allocation failure
+ */
+static task_sample_t *sample_tasks(int *ret_count)
+{
+    // uxTaskGetSystemState() returns nothing if the array is too small, so size it from the task count
+    TaskStatus_t *status = NULL;
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    int count = 0;
+    for (int i = 0; i < TASK_SNAPSHOT_TRIES && count == 0; i++) {
+        UBaseType_t capacity = uxTaskGetNumberOfTasks() + TASK_HEADROOM * (i + 1);
+        free(status);
+        status = malloc(capacity * sizeof(TaskStatus_t));
+        if (!status) {
+            return NULL;
+        }
+        count = uxTaskGetSystemState(status, capacity, &total);
+    }
+    if (count == 0) {
+        ESP_LOGW(TAG, "Task snapshot failed, tasks are being created too quickly");
+        free(status);
+        return NULL;
+    }
+
+    task_sample_t *samples = malloc(count * sizeof(task_sample_t));
+    task_prev_t *prev_tasks = malloc(count * sizeof(task_prev_t));
+    if (!samples || !prev_tasks) {
+        free(status);
+        free(samples);
+        free(prev_tasks);
+        return NULL;
+    }
+
+    taskENTER_CRITICAL(&s_prev_lock);
+    configRUN_TIME_COUNTER_TYPE elapsed = total - s_prev_total;
+    for (int i = 0; i < count; i++) {
+        configRUN_TIME_COUNTER_TYPE prev = 0;
+        for (int j = 0; j < s_prev_count; j++) {
+            if (s_prev_tasks[j].number == status[i].xTaskNumber) {
+                prev = s_prev_tasks[j].runtime;
+                break;
+            }
+        }
+        configRUN_TIME_COUNTER_TYPE used = status[i].ulRunTimeCounter - prev;
+        samples[i].cpu_permille = elapsed ? (uint32_t)((uint64_t)used * 1000 / elapsed) : 0;
+    }
+    for (int i = 0; i < count; i++) {
+        prev_tasks[i].number = status[i].xTaskNumber;
+        prev_tasks[i].runtime = status[i].ulRunTimeCounter;
+    }
+    task_prev_t *old = s_prev_tasks;
+    s_prev_tasks = prev_tasks;
+    s_prev_count = count;
+    s_prev_total = total;
+    taskEXIT_CRITICAL(&s_prev_lock);
+    free(old);
+
+    for (int i = 0; i < count; i++) {
+        sanitize_label(samples[i].name, status[i].pcTaskName);
+        samples[i].stack_free = status[i].usStackHighWaterMark * sizeof(StackType_t);
+    }
+    free(status);
+
+    *ret_count = count;
+    return samples;
+}
+
+#endif  // METRICS_TASK_STATS
+
+/* ------------------------------------------------------------------------- */
+/* Prometheus                                                                */
+/* ------------------------------------------------------------------------- */
+
+static const char *type_name(metrics_type_t type)
+{
+    switch (type) {
+        case METRICS_TYPE_COUNTER: return "counter";
+        case METRICS_TYPE_GAUGE: return "gauge";
+        default: return "histogram";
+    }
+}
+
+/**
+ * true if an earlier metric in the list has the same name (family already written)
+ */
+static bool family_seen(const metrics_metric_t *head, const metrics_metric_t *metric)
+{
+    for (const metrics_metric_t *m = head; m != metric; m = atomic_load(&m->next)) {
+        if (strcmp(m->name, metric->name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void prom_header(writer_t *w, const char *name, const char *help, const char *type)
+{
+    out(w, "# HELP %s %s\n# TYPE %s %s\n", name, help ? help : name, name, type);
+}
+
+static void prom_metric(writer_t *w, const metrics_metric_t *m)
+{
+    char labels[2 * LABEL_MAX + 8] = "";
+    char value[LABEL_MAX];
+
+    if (m->label_key) {
+        sanitize_label(value, m->label_value ? m->label_value : "");
+        snprintf(labels, sizeof(labels), "%s=\"%s\"", m->label_key, value);
+    }
+
+    if (m->type != METRICS_TYPE_HISTOGRAM) {
+        int32_t v = atomic_load_explicit(&m->value, memory_order_relaxed);
+        if (m->type == METRICS_TYPE_COUNTER) {
+            out(w, "%s%s%s%s %" PRIu32 "\n", m->name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+                (uint32_t)v);
+        } else {
+            out(w, "%s%s%s%s %" PRId32 "\n", m->name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "", v);
+        }
+        return;
+    }
+
+    const char *sep = labels[0] ? "," : "";
+    uint32_t cumulative = 0;
+    for (int i = 0; i <= METRICS_HISTOGRAM_BUCKETS; i++) {
+        cumulative += atomic_load_explicit(&m->buckets[i], memory_order_relaxed);
+        if (i < METRICS_HISTOGRAM_BUCKETS) {
+            out(w, "%s_bucket{%s%sle=\"%" PRIu32 "\"} %" PRIu32 "\n", m->name, labels, sep, bucket_bound(m, i),
+                cumulative);
+        } else {
+            out(w, "%s_bucket{%s%sle=\"+Inf\"} %" PRIu32 "\n", m->name, labels, sep, cumulative);
+        }
+    }
+    out(w, "%s_sum%s%s%s %" PRIu64 "\n", m->name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+        (uint64_t)atomic_load_explicit(&m->sum, memory_order_relaxed));
+    out(w, "%s_count%s%s%s %" PRIu32 "\n", m->name, labels[0] ? "{" : "", labels, labels[0] ? "}" : "",
+        cumulative);
+}
+
+esp_err_t metrics_write_prometheus(metrics_write_fn write, void *ctx)
+{
+    writer_t *w = malloc(sizeof(writer_t));
+    if (!w) {
+        return ESP_ERR_NO_MEM;
+    }
+    w->write = write;
+    w->ctx = ctx;
+    w->err = ESP_OK;
+    w->len = 0;
+
+    metrics_metric_t *head = atomic_load_explicit(&s_head, memory_order_acquire);
+    for (metrics_metric_t *m = head; m && w->err == ESP_OK; m = atomic_load(&m->next)) {
+        if (family_seen(head, m)) {
+            continue;
+        }
+        prom_header(w, m->name, m->help, type_name(m->type));
+        for (metrics_metric_t *f = m; f; f = atomic_load(&f->next)) {
+            if (strcmp(f->name, m->name) == 0) {
+                prom_metric(w, f);
+            }
+        }
+    }
+
+    for (int f = 0; f < HEAP_FAMILIES; f++) {
+        prom_header(w, s_heap_families[f].name, s_heap_families[f].help, "gauge");
+        for (int r = 0; r < HEAP_REGIONS; r++) {
+            out(w, "%s{region=\"%s\"} %" PRIu32 "\n", s_heap_families[f].name, s_heap_regions[r].name,
+                heap_value(f, s_heap_regions[r].caps));
+        }
+    }
+
+    out(w, "# HELP uptime_seconds Time since boot\n# TYPE uptime_seconds gauge\nuptime_seconds %" PRId64 "\n",
+        esp_timer_get_time() / 1000000);
+
+#if METRICS_TASK_STATS
+    int count = 0;
+    task_sample_t *tasks = sample_tasks(&count);
+    if (tasks) {
+        prom_header(w, "task_cpu_percent", "CPU use of one core since the previous scrape", "gauge");
+        for (int i = 0; i < count; i++) {
+            out(w, "task_cpu_percent{task=\"%s\"} %" PRIu32 ".%" PRIu32 "\n", tasks[i].name,
+                tasks[i].cpu_permille / 10, tasks[i].cpu_permille % 10);
+        }
+        prom_header(w, "task_stack_free_bytes", "Lowest free stack since the task started", "gauge");
+        for (int i = 0; i < count; i++) {
+            out(w, "task_stack_free_bytes{task=\"%s\"} %" PRIu32 "\n", tasks[i].name, tasks[i].stack_free);
+        }
+        free(tasks);
+    }
+#endif
+
+    flush(w);
+    esp_err_t err = w->err;
+    free(w);
+    return err;
+}
+
+/* ------------------------------------------------------------------------- */
+/* JSON                                                                      */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Upper bound of the bucket holding quantile q (percent); -1 if in +Inf
+ */
+static int64_t estimate_quantile(const metrics_metric_t *m, const uint32_t *buckets, uint32_t count, uint32_t q)
+{
+    uint64_t rank = ((uint64_t)count * q + 99) / 100;
+    uint64_t cumulative = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        cumulative += buckets[i];
+        if (cumulative >= rank) {
+            return bucket_bound(m, i);
+        }
+    }
+    return -1;
+}
+
+static void json_labels(writer_t *w, const char *key, const char *value)
+{
+    if (key) {
+        char clean[LABEL_MAX];
+        sanitize_label(clean, value ? value : "");
+        out(w, ",\"labels\":{\"%s\":\"%s\"}", key, clean);
+    }
+}
+
+static void json_metric(writer_t *w, const metrics_metric_t *m, bool first)
+{
+    out(w, "%s{\"name\":\"%s\",\"type\":\"%s\"", first ? "" : ",", m->name, type_name(m->type));
+    json_labels(w, m->label_key, m->label_value);
+
+    if (m->type != METRICS_TYPE_HISTOGRAM) {
+        int32_t v = atomic_load_explicit(&m->value, memory_order_relaxed);
+        if (m->type == METRICS_TYPE_COUNTER) {
+            out(w, ",\"value\":%" PRIu32 "}", (uint32_t)v);
+        } else {
+            out(w, ",\"value\":%" PRId32 "}", v);
+        }
+        return;
+    }
+
+    uint32_t buckets[METRICS_HISTOGRAM_BUCKETS + 1];
+    uint32_t count = 0;
+    for (int i = 0; i <= METRICS_HISTOGRAM_BUCKETS; i++) {
+        buckets[i] = atomic_load_explicit(&m->buckets[i], memory_order_relaxed);
+        count += buckets[i];
+    }
+
+    out(w, ",\"unit\":\"%s\",\"count\":%" PRIu32 ",\"sum\":%" PRIu64, m->unit_us == 1 ? "us" : "ms", count,
+        (uint64_t)atomic_load_explicit(&m->sum, memory_order_relaxed));
+    if (count > 0) {
+        out(w, ",\"p50\":%" PRId64 ",\"p95\":%" PRId64 ",\"p99\":%" PRId64, estimate_quantile(m, buckets, count, 50),
+            estimate_quantile(m, buckets, count, 95), estimate_quantile(m, buckets, count, 99));
+    }
+
+    out(w, ",\"buckets\":{");
+    uint32_t cumulative = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        cumulative += buckets[i];
+        out(w, "%s\"%" PRIu32 "\":%" PRIu32, i ? "," : "", bucket_bound(m, i), cumulative);
+    }
+    out(w, ",\"+Inf\":%" PRIu32 "}}", count);
+}
+
+esp_err_t metrics_write_json(metrics_write_fn write, void *ctx)
+{
+    writer_t *w = malloc(sizeof(writer_t));
+    if (!w) {
+        return ESP_ERR_NO_MEM;
+    }
+    w->write = write;
+    w->ctx = ctx;
+    w->err = ESP_OK;
+    w->len = 0;
+
+    out(w, "{\"uptime_ms\":%" PRId64 ",\"metrics\":[", esp_timer_get_time() / 1000);
+
+    // Families together, as in the Prometheus output
+    bool first = true;
+    metrics_metric_t *head = atomic_load_explicit(&s_head, memory_order_acquire);
+    for (metrics_metric_t *m = head; m && w->err == ESP_OK; m = atomic_load(&m->next)) {
+        if (family_seen(head, m)) {
+            continue;
+        }
+        for (metrics_metric_t *f = m; f; f = atomic_load(&f->next)) {
+            if (strcmp(f->name, m->name) == 0) {
+                json_metric(w, f, first);
+                first = false;
+            }
+        }
+    }
+
+    for (int f = 0; f < HEAP_FAMILIES; f++) {
+        for (int r = 0; r < HEAP_REGIONS; r++) {
+            out(w, "%s{\"name\":\"%s\",\"type\":\"gauge\"", first ? "" : ",", s_heap_families[f].name);
+            json_labels(w, "region", s_heap_regions[r].name);
+            out(w, ",\"value\":%" PRIu32 "}", heap_value(f, s_heap_regions[r].caps));
+            first = false;
+        }
+    }
+    out(w, "]");
+
+#if METRICS_TASK_STATS
+    int count = 0;
+    task_sample_t *tasks = sample_tasks(&count);
+    if (tasks) {
+        out(w, ",\"tasks\":[");
+        for (int i = 0; i < count; i++) {
+            out(w, "%s{\"name\":\"%s\",\"cpu_percent\":%" PRIu32 ".%" PRIu32 ",\"stack_free\":%" PRIu32 "}",
+                i ? "," : "", tasks[i].name, tasks[i].cpu_permille / 10, tasks[i].cpu_permille % 10,
+                tasks[i].stack_free);
+        }
+        out(w, "]");
+        free(tasks);
+    }
+#endif
+
+    out(w, "}");
+    flush(w);
+    esp_err_t err = w->err;
+    free(w);
+    return err;
+}
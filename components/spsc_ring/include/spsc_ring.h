@@ -0,0 +1,151 @@
+/**
+ * Single-Producer / Single-Consumer Ring Buffer
+ *
+ * Lock-free byte ring for streaming audio between exactly one producer task
+ * and one consumer task. Head and tail are atomics, so neither side ever
+ * takes a lock. Blocking waits use FreeRTOS task notifications.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Ring buffer handle
+ */
+typedef struct spsc_ring *spsc_ring_handle_t;
+
+/**
+ * @brief Create a ring buffer
+ *
+ * @param size Capacity in bytes, must be a power of two
+ * @param caps heap_caps flags for the data storage (e.g. MALLOC_CAP_SPIRAM)
+ * @param[out] ret_ring Created ring
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM on failure
+ */
+esp_err_t spsc_ring_create(size_t size, uint32_t caps, spsc_ring_handle_t *ret_ring);
+
+/**
+ * @brief Delete a ring buffer
+ *
+ * @param ring Ring to delete (NULL is ignored)
+ */
+void spsc_ring_delete(spsc_ring_handle_t ring);
+
+/**
+ * @brief Discard all data
+ *
+ * Only call while neither producer nor consumer is using the ring.
+ *
+ * @param ring Ring buffer
+ */
+void spsc_ring_reset(spsc_ring_handle_t ring);
+
+/**
+ * @brief Get ring capacity in bytes
+ */
+size_t spsc_ring_size(spsc_ring_handle_t ring);
+
+/**
+ * @brief Get number of bytes ready to read
+ */
+size_t spsc_ring_available(spsc_ring_handle_t ring);
+
+/**
+ * @brief Get number of bytes that can be written
+ */
+size_t spsc_ring_free_space(spsc_ring_handle_t ring);
+
+/**
+ * @brief Copy data into the ring (producer only)
+ *
+ * @return Bytes written, may be less than len if the ring is full
+ */
+size_t spsc_ring_write(spsc_ring_handle_t ring, const void *data, size_t len);
+
+/**
+ * @brief Copy data out of the ring (consumer only)
+ *
+ * @return Bytes read, may be less than len
+ */
+size_t spsc_ring_read(spsc_ring_handle_t ring, void *data, size_t len);
+
+/**
+ * @brief Get the largest contiguous writable region (producer only)
+ *
+ * Write into the region, then publish it with spsc_ring_commit_write().
+ *
+ * @param ring Ring buffer
+ * @param[out] ptr Start of the region
+ * @return Region length in bytes (0 if full)
+ */
+size_t spsc_ring_peek_write(spsc_ring_handle_t ring, uint8_t **ptr);
+
+/**
+ * @brief Publish bytes written into a peeked region (producer only)
+ */
+void spsc_ring_commit_write(spsc_ring_handle_t ring, size_t len);
+
+/**
+ * @brief Get the largest contiguous readable region (consumer only)
+ *
+ * Process the region in place, then release it with spsc_ring_commit_read().
+ *
+ * @param ring Ring buffer
+ * @param[out] ptr Start of the region
+ * @return Region length in bytes (0 if empty)
+ */
+size_t spsc_ring_peek_read(spsc_ring_handle_t ring, const uint8_t **ptr);
+
+/**
+ * @brief Release bytes consumed from a peeked region (consumer only)
+ */
+void spsc_ring_commit_read(spsc_ring_handle_t ring, size_t len);
+
+/**
+ * @brief Block until at least min_bytes are readable (consumer only)
+ *
+ * Uses the last entry of the calling task's notification array, so
+ * CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES must be at least 2;
+ * notifications on index 0 do not affect it. Returns early only when
+ * spsc_ring_wake() is called, so callers should re-check their own state.
+ *
+ * @param ring Ring buffer
+ * @param min_bytes Bytes required (clamped to ring size)
+ * @param timeout Max time to wait
+ * @return true if the data is available
+ */
+bool spsc_ring_wait_data(spsc_ring_handle_t ring, size_t min_bytes, TickType_t timeout);
+
+/**
+ * @brief Block until at least min_bytes can be written (producer only)
+ *
+ * Same wake-up rules as spsc_ring_wait_data().
+ *
+ * @param ring Ring buffer
+ * @param min_bytes Free bytes required (clamped to ring size)
+ * @param timeout Max time to wait
+ * @return true if the space is available
+ */
+bool spsc_ring_wait_space(spsc_ring_handle_t ring, size_t min_bytes, TickType_t timeout);
+
+/**
+ * @brief Wake any blocked producer and consumer
+ *
+ * Use when the stream ends or is aborted so waiters can see the new state.
+ *
+ * @param ring Ring buffer
+ */
+void spsc_ring_wake(spsc_ring_handle_t ring);
+
+#ifdef __cplusplus
+}
+#endif
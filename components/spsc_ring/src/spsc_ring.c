@@ -0,0 +1,288 @@
+/**
+ * Single-Producer / Single-Consumer Ring Buffer
+ *
+ * head and tail are free-running byte counters; the capacity is a power of
+ * two so the storage offset is a mask and all of the buffer is usable.
+ * Only the producer stores head and only the consumer stores tail.
+ */
+
+#include "spsc_ring.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "freertos/task.h"
+
+#define SPSC_RING_CACHE_LINE 64
+
+// Waiters block on their own notification index so that notifications
+// other code sends to the same task (index 0) cannot end a wait early
+#define SPSC_RING_NOTIFY_INDEX (configTASK_NOTIFICATION_ARRAY_ENTRIES - 1)
+
+_Static_assert(SPSC_RING_NOTIFY_INDEX >= 1, "spsc_ring needs CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES >= 2");
+
+struct spsc_ring {
+    // Producer-owned line
+    _Atomic size_t head __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    _Atomic size_t space_wanted;        // Producer blocked until this much is free (0 = not waiting)
+    TaskHandle_t producer_task;
+
+    // Consumer-owned line
+    _Atomic size_t tail __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    _Atomic size_t data_wanted;         // Consumer blocked until this much is readable (0 = not waiting)
+    TaskHandle_t consumer_task;
+
+    _Atomic uint32_t wakes;             // Bumped by spsc_ring_wake() to end every wait
+
+    // Read-only after create
+    uint8_t *buffer __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    size_t size;
+    size_t mask;
+};
+
+/**
+ * Bytes readable
+ */
+static inline size_t ring_used(spsc_ring_handle_t ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+/**
+ * Bytes writable
+ */
+static inline size_t ring_free(spsc_ring_handle_t ring)
+{
+    return ring->size - ring_used(ring);
+}
+
+/**
+ * Notify a waiter if its threshold is reached
+ */
+static void ring_signal(_Atomic size_t *wanted, TaskHandle_t waiter, size_t level)
+{
+    size_t want = atomic_load(wanted);
+    if (want != 0 && level >= want && atomic_compare_exchange_strong(wanted, &want, 0)) {
+        xTaskNotifyGiveIndexed(waiter, SPSC_RING_NOTIFY_INDEX);
+    }
+}
+
+/**
+ * Block the calling task until level(ring) >= min_bytes
+ *
+ * A notification left over from an earlier wait only costs a loop pass:
+ * the wait ends on the level, on spsc_ring_wake() or at the deadline.
+ */
+static bool ring_wait(spsc_ring_handle_t ring, _Atomic size_t *wanted, TaskHandle_t *waiter,
+                      size_t (*level)(spsc_ring_handle_t), size_t min_bytes, TickType_t timeout)
+{
+    if (min_bytes == 0) {
+        min_bytes = 1;
+    }
+    if (min_bytes > ring->size) {
+        min_bytes = ring->size;
+    }
+
+    if (level(ring) >= min_bytes) {
+        return true;
+    }
+
+    *waiter = xTaskGetCurrentTaskHandle();
+    uint32_t wakes = atomic_load(&ring->wakes);
+    TickType_t start = xTaskGetTickCount();
+    TickType_t waited = 0;
+
+    while (true) {
+        atomic_store(wanted, min_bytes);
+
+        // Re-check after publishing the threshold so a concurrent commit cannot be missed
+        if (level(ring) >= min_bytes || atomic_load(&ring->wakes) != wakes || waited >= timeout) {
+            break;
+        }
+        ulTaskNotifyTakeIndexed(SPSC_RING_NOTIFY_INDEX, pdTRUE, timeout - waited);
+        if (timeout != portMAX_DELAY) {
+            waited = xTaskGetTickCount() - start;
+        }
+    }
+
+    atomic_store(wanted, 0);
+    return level(ring) >= min_bytes;
+}
+
+esp_err_t spsc_ring_create(size_t size, uint32_t caps, spsc_ring_handle_t *ret_ring)
+{
+    if (!ret_ring || size < 2 || (size & (size - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    spsc_ring_handle_t ring = heap_caps_aligned_calloc(SPSC_RING_CACHE_LINE, 1, sizeof(*ring),
+                                                       MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!ring) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring->buffer = heap_caps_aligned_alloc(SPSC_RING_CACHE_LINE, size, caps);
+    if (!ring->buffer) {
+        heap_caps_free(ring);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring->size = size;
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->space_wanted, 0);
+    atomic_init(&ring->data_wanted, 0);
+
+    *ret_ring = ring;
+    return ESP_OK;
+}
+
+void spsc_ring_delete(spsc_ring_handle_t ring)
+{
+    if (!ring) {
+        return;
+    }
+    heap_caps_free(ring->buffer);
+    heap_caps_free(ring);
+}
+
+void spsc_ring_reset(spsc_ring_handle_t ring)
+{
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    atomic_store(&ring->space_wanted, 0);
+    atomic_store(&ring->data_wanted, 0);
+}
+
+size_t spsc_ring_size(spsc_ring_handle_t ring)
+{
+    return ring->size;
+}
+
+size_t spsc_ring_available(spsc_ring_handle_t ring)
+{
+    return ring_used(ring);
+}
+
+size_t spsc_ring_free_space(spsc_ring_handle_t ring)
+{
+    return ring_free(ring);
+}
+
+size_t spsc_ring_peek_write(spsc_ring_handle_t ring, uint8_t **ptr)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t offset = head & ring->mask;
+    size_t free_space = ring->size - (head - tail);
+    size_t to_end = ring->size - offset;
+
+    *ptr = &ring->buffer[offset];
+    return (free_space < to_end) ? free_space : to_end;
+}
+
+void spsc_ring_commit_write(spsc_ring_handle_t ring, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed) + len;
+    atomic_store(&ring->head, head);
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    ring_signal(&ring->data_wanted, ring->consumer_task, head - tail);
+}
+
+size_t spsc_ring_peek_read(spsc_ring_handle_t ring, const uint8_t **ptr)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t offset = tail & ring->mask;
+    size_t used = head - tail;
+    size_t to_end = ring->size - offset;
+
+    *ptr = &ring->buffer[offset];
+    return (used < to_end) ? used : to_end;
+}
+
+void spsc_ring_commit_read(spsc_ring_handle_t ring, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed) + len;
+    atomic_store(&ring->tail, tail);
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    ring_signal(&ring->space_wanted, ring->producer_task, ring->size - (head - tail));
+}
+
+size_t spsc_ring_write(spsc_ring_handle_t ring, const void *data, size_t len)
+{
+    const uint8_t *src = data;
+    size_t written = 0;
+
+    // At most two regions: up to the end of storage, then from the start
+    for (int pass = 0; pass < 2 && written < len; pass++) {
+        uint8_t *dst;
+        size_t chunk = spsc_ring_peek_write(ring, &dst);
+        if (chunk == 0) {
+            break;
+        }
+        if (chunk > len - written) {
+            chunk = len - written;
+        }
+        memcpy(dst, &src[written], chunk);
+        spsc_ring_commit_write(ring, chunk);
+        written += chunk;
+    }
+
+    return written;
+}
+
+size_t spsc_ring_read(spsc_ring_handle_t ring, void *data, size_t len)
+{
+    uint8_t *dst = data;
+    size_t read_count = 0;
+
+    for (int pass = 0; pass < 2 && read_count < len; pass++) {
+        const uint8_t *src;
+        size_t chunk = spsc_ring_peek_read(ring, &src);
+        if (chunk == 0) {
+            break;
+        }
+        if (chunk > len - read_count) {
+            chunk = len - read_count;
+        }
+        memcpy(&dst[read_count], src, chunk);
+        spsc_ring_commit_read(ring, chunk);
+        read_count += chunk;
+    }
+
+    return read_count;
+}
+
+bool spsc_ring_wait_data(spsc_ring_handle_t ring, size_t min_bytes, TickType_t timeout)
+{
+    return ring_wait(ring, &ring->data_wanted, &ring->consumer_task, ring_used, min_bytes, timeout);
+}
+
+bool spsc_ring_wait_space(spsc_ring_handle_t ring, size_t min_bytes, TickType_t timeout)
+{
+    return ring_wait(ring, &ring->space_wanted, &ring->producer_task, ring_free, min_bytes, timeout);
+}
+
+void spsc_ring_wake(spsc_ring_handle_t ring)
+{
+    atomic_fetch_add(&ring->wakes, 1);
+    if (atomic_exchange(&ring->data_wanted, 0) != 0) {
+        xTaskNotifyGiveIndexed(ring->consumer_task, SPSC_RING_NOTIFY_INDEX);
+    }
+    if (atomic_exchange(&ring->space_wanted, 0) != 0) {
+        xTaskNotifyGiveIndexed(ring->producer_task, SPSC_RING_NOTIFY_INDEX);
+    }
+}
@@ -0,0 +1,416 @@
+/**
+ * Network Audio Endpoints
+ *
+ * The capture side reads a dedicated engine capture stream and forwards
+ * it with httpd_resp_send_chunk(); a client that reads too slowly makes
+ * the engine drop periods instead of stalling the microphone for everyone
+ * else. The playback side feeds tts_pcm_write(), whose ring watermarks
+ * push back on the socket when the client sends faster than real time.
+ */
+
+#include "audio_http.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "audio_engine.h"
+#include "audio_pool.h"
+#include "http_workers.h"
+#include "metrics.h"
+#include "tts.h"
+
+static const char *TAG = "audio_http";
+
+#define RATE_MIN 8000
+#define RATE_MAX 48000
+#define DEFAULT_RATE 16000
+#define CAPTURE_BUFFER_MS 500           // Engine-side slack for a slow socket before periods drop
+#define CAPTURE_CHUNK_MS 20             // Audio per HTTP chunk
+#define CAPTURE_READ_TIMEOUT_MS 200
+#define CAPTURE_MAX_STALLS 10           // Consecutive empty reads before giving up on the engine
+#define PLAY_CHUNK_SIZE 4096            // Body bytes received at once, multiple of a stereo frame
+#define PLAY_RECV_RETRIES 3             // Receive timeouts tolerated in a row
+#define WAV_HEADER_SIZE 44
+#define WAV_SIZE_UNKNOWN 0xFFFFFFFF     // Chunk sizes of an open-ended stream
+
+static metrics_metric_t s_m_bytes[2] = {
+    METRICS_COUNTER_INIT("audio_http_bytes_total", "PCM bytes moved by the audio endpoints",
+                         "direction", "capture"),
+    METRICS_COUNTER_INIT("audio_http_bytes_total", "PCM bytes moved by the audio endpoints",
+                         "direction", "playback"),
+};
+
+static bool s_tts_ready = false;
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+/**
+ * Canonical mono 16-bit WAV header
+ */
+static void build_wav_header(uint8_t *hdr, uint32_t rate, uint32_t data_len)
+{
+    memcpy(hdr, "RIFF", 4);
+    put_le32(hdr + 4, data_len == WAV_SIZE_UNKNOWN ? WAV_SIZE_UNKNOWN : data_len + WAV_HEADER_SIZE - 8);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    put_le32(hdr + 16, 16);             // fmt chunk size
+    put_le16(hdr + 20, 1);              // PCM
+    put_le16(hdr + 22, 1);              // Mono
+    put_le32(hdr + 24, rate);
+    put_le32(hdr + 28, rate * 2);       // Byte rate
+    put_le16(hdr + 32, 2);              // Block align
+    put_le16(hdr + 34, 16);             // Bits per sample
+    memcpy(hdr + 36, "data", 4);
+    put_le32(hdr + 40, data_len);
+}
+
+/**
+ * Parse a WAV header at the start of buf
+ *
+ * @param data_len Output declared size of the data chunk
+ * @return Offset of the sample data, 0 if buf is not a WAV file, -1 if it
+ *         is one this endpoint cannot play or a malformed one
+ */
+static int parse_wav_header(const uint8_t *buf, size_t len, uint32_t *rate, uint16_t *channels,
+                            uint32_t *data_len)
+{
+    if (len < 12 || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        return 0;
+    }
+
+    bool have_fmt = false;
+    size_t pos = 12;
+    while (pos + 8 <= len) {
+        const uint8_t *chunk = buf + pos;
+        uint32_t size = get_le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && pos + 8 + 16 <= len) {
+            if (get_le16(chunk + 8) != 1 || get_le16(chunk + 22) != 16) {
+                return -1;              // Not 16-bit integer PCM
+            }
+            *channels = get_le16(chunk + 10);
+            *rate = get_le32(chunk + 12);
+            have_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            *data_len = size;
+            return have_fmt ? (int)(pos + 8) : -1;
+        }
+        // Chunks before the data must fit in the first read; this also keeps pos from wrapping
+        if (size > len - pos - 8) {
+            return -1;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return -1;                          // Header larger than the first read, or truncated
+}
+
+/**
+ * Read a query parameter as an unsigned number
+ */
+static uint32_t query_uint(const char *query, const char *key, uint32_t fallback)
+{
+    char value[12];
+    if (query && httpd_query_key_value(query, key, value, sizeof(value)) == ESP_OK) {
+        return (uint32_t)strtoul(value, NULL, 10);
+    }
+    return fallback;
+}
+
+static esp_err_t send_error(httpd_req_t *req, const char *status, const char *message)
+{
+    char json[96];
+    snprintf(json, sizeof(json), "{\"error\":\"%s\"}", message);
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json, strlen(json));
+}
+
+/* Handler for GET /api/audio/stream - microphone as chunked WAV or raw PCM */
+static esp_err_t stream_get_handler(httpd_req_t *req)
+{
+    if (!http_workers_in_worker()) {
+        return http_workers_submit_stream(req, stream_get_handler);
+    }
+
+    char query[64];
+    bool have_query = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK;
+    uint32_t rate = query_uint(have_query ? query : NULL, "rate", DEFAULT_RATE);
+    uint32_t seconds = query_uint(have_query ? query : NULL, "seconds", 0);
+    char format[8] = "wav";
+    if (have_query) {
+        httpd_query_key_value(query, "format", format, sizeof(format));
+    }
+    bool wav = strcmp(format, "pcm") != 0;
+
+    if (rate < RATE_MIN || rate > RATE_MAX) {
+        return send_error(req, "400 Bad Request", "rate must be 8000-48000");
+    }
+
+    audio_engine_stream_handle_t stream = NULL;
+    esp_err_t err = audio_engine_capture_open(rate, CAPTURE_BUFFER_MS, &stream);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open capture stream: %s", esp_err_to_name(err));
+        return send_error(req, "503 Service Unavailable", "Microphone unavailable");
+    }
+
+    size_t chunk_samples = rate * CAPTURE_CHUNK_MS / 1000;
+    int16_t *buf = audio_pool_alloc(AUDIO_POOL_INTERNAL, chunk_samples * sizeof(int16_t));
+    if (!buf) {
+        audio_engine_stream_close(stream);
+        return send_error(req, "500 Internal Server Error", "Out of memory");
+    }
+
+    uint64_t limit_bytes = (uint64_t)seconds * rate * 2;
+    char rate_str[12];
+    snprintf(rate_str, sizeof(rate_str), "%lu", (unsigned long)rate);
+    httpd_resp_set_type(req, wav ? "audio/wav" : "application/octet-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_hdr(req, "X-Sample-Rate", rate_str);
+
+    ESP_LOGI(TAG, "Streaming microphone (%lu Hz, %s, %lu s)", (unsigned long)rate, wav ? "wav" : "pcm",
+             (unsigned long)seconds);
+
+    err = ESP_OK;
+    if (wav) {
+        uint8_t hdr[WAV_HEADER_SIZE];
+        build_wav_header(hdr, rate, limit_bytes > 0 && limit_bytes < WAV_SIZE_UNKNOWN ?
+                                    (uint32_t)limit_bytes : WAV_SIZE_UNKNOWN);
+        err = httpd_resp_send_chunk(req, (const char *)hdr, sizeof(hdr));
+    }
+
+    uint64_t sent = 0;
+    int stalls = 0;
+    while (err == ESP_OK && (limit_bytes == 0 || sent < limit_bytes)) {
+        size_t want = chunk_samples;
+        if (limit_bytes > 0 && limit_bytes - sent < want * 2) {
+            want = (limit_bytes - sent) / 2;
+        }
+        size_t got = audio_engine_capture_read(stream, buf, want, CAPTURE_READ_TIMEOUT_MS);
+        if (got == 0) {
+            if (++stalls >= CAPTURE_MAX_STALLS) {
+                ESP_LOGW(TAG, "Capture stalled, ending stream");
+                break;
+            }
+            continue;
+        }
+        stalls = 0;
+
+        // Fails once the client has gone away
+        err = httpd_resp_send_chunk(req, (const char *)buf, got * sizeof(int16_t));
+        if (err == ESP_OK) {
+            sent += got * sizeof(int16_t);
+            metrics_add(&s_m_bytes[0], got * sizeof(int16_t));
+        }
+    }
+
+    audio_engine_stream_close(stream);
+    audio_pool_free(buf);
+    ESP_LOGI(TAG, "Microphone stream ended (%llu bytes)", (unsigned long long)sent);
+
+    if (err != ESP_OK) {
+        return ESP_FAIL;                // Client disconnected mid-response; drop the socket
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * Receive up to len body bytes, tolerating short socket timeouts
+ *
+ * @return Bytes received, 0 at the end of the body, -1 if the client is gone
+ */
+static int recv_body(httpd_req_t *req, uint8_t *buf, size_t len)
+{
+    size_t got = 0;
+    int timeouts = 0;
+    while (got < len) {
+        int n = httpd_req_recv(req, (char *)buf + got, len - got);
+        if (n == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < PLAY_RECV_RETRIES) {
+            continue;
+        }
+        if (n <= 0) {
+            return got > 0 ? (int)got : (n == 0 ? 0 : -1);
+        }
+        timeouts = 0;
+        got += n;
+    }
+    return (int)got;
+}
+
+/* Handler for POST /api/audio/play - WAV or raw PCM body into the TTS playback ring */
+static esp_err_t play_post_handler(httpd_req_t *req)
+{
+    if (!http_workers_in_worker()) {
+        return http_workers_submit_stream(req, play_post_handler);
+    }
+
+    if (req->content_len == 0) {
+        return send_error(req, "411 Length Required", "Content-Length required");
+    }
+
+    char query[32];
+    bool have_query = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK;
+    uint32_t rate = query_uint(have_query ? query : NULL, "rate", DEFAULT_RATE);
+    uint16_t channels = 1;
+
+    if (!s_tts_ready) {
+        if (tts_init() != ESP_OK) {
+            return send_error(req, "503 Service Unavailable", "TTS playback unavailable");
+        }
+        s_tts_ready = true;
+    }
+
+    uint8_t *buf = audio_pool_alloc(AUDIO_POOL_INTERNAL, PLAY_CHUNK_SIZE);
+    if (!buf) {
+        return send_error(req, "500 Internal Server Error", "Out of memory");
+    }
+
+    // The first read carries the WAV header, if there is one
+    size_t remaining = req->content_len;
+    int n = recv_body(req, buf, remaining < PLAY_CHUNK_SIZE ? remaining : PLAY_CHUNK_SIZE);
+    if (n <= 0) {
+        audio_pool_free(buf);
+        return ESP_FAIL;
+    }
+    remaining -= n;
+
+    uint32_t data_len = UINT32_MAX;
+    int offset = parse_wav_header(buf, n, &rate, &channels, &data_len);
+    if (offset < 0 || (offset > 0 && channels != 1 && channels != 2)) {
+        audio_pool_free(buf);
+        return send_error(req, "415 Unsupported Media Type", "Only 16-bit PCM WAV, mono or stereo");
+    }
+    if (rate < RATE_MIN || rate > RATE_MAX) {
+        audio_pool_free(buf);
+        return send_error(req, "400 Bad Request", "rate must be 8000-48000");
+    }
+
+    // Anything after the data chunk (LIST, id3) is not audio
+    size_t audio_left = n - offset + remaining;
+    if (audio_left > data_len) {
+        audio_left = data_len;
+    }
+
+    size_t frame = channels * sizeof(int16_t);
+    size_t expected = audio_left / channels;
+    esp_err_t err = tts_pcm_begin(rate, expected);
+    if (err != ESP_OK) {
+        audio_pool_free(buf);
+        return send_error(req, "409 Conflict", "Speaker busy");
+    }
+
+    ESP_LOGI(TAG, "Playing pushed audio (%lu Hz, %u ch, %u bytes)", (unsigned long)rate,
+             channels, (unsigned)req->content_len);
+
+    size_t have = n - offset;
+    if (have > audio_left) {
+        have = audio_left;
+    }
+    audio_left -= have;
+    memmove(buf, buf + offset, have);
+    size_t played = 0;
+    bool client_gone = false;
+
+    while (true) {
+        size_t usable = have - have % frame;
+        size_t out_len = usable;
+        if (channels == 2) {
+            // Downmix in place; each output sample lands before the frame it came from
+            int16_t *pcm = (int16_t *)buf;
+            for (size_t i = 0; i < usable / frame; i++) {
+                pcm[i] = (int16_t)(((int32_t)pcm[2 * i] + pcm[2 * i + 1]) / 2);
+            }
+            out_len = usable / 2;
+        }
+
+        if (out_len > 0) {
+            err = tts_pcm_write(buf, out_len);
+            if (err != ESP_OK) {
+                break;                  // Stopped (tts_stop, barge-in) or playback stalled
+            }
+            played += out_len;
+            metrics_add(&s_m_bytes[1], out_len);
+        }
+
+        size_t carry = have - usable;
+        memmove(buf, buf + usable, carry);
+        if (audio_left == 0) {
+            break;                      // The server discards any body left after the data
+        }
+
+        size_t want = PLAY_CHUNK_SIZE - carry;
+        if (want > audio_left) {
+            want = audio_left;
+        }
+        n = recv_body(req, buf + carry, want);
+        if (n <= 0) {
+            // Closing early ends playback with what was received
+            client_gone = n < 0;
+            break;
+        }
+        audio_left -= n;
+        have = carry + n;
+    }
+
+    audio_pool_free(buf);
+    tts_pcm_end(err != ESP_OK);
+
+    unsigned long played_ms = (unsigned long)((uint64_t)played * 1000 / (rate * 2));
+    ESP_LOGI(TAG, "Pushed audio %s (%lu ms)", err == ESP_OK ? "played" : "stopped", played_ms);
+    if (client_gone) {
+        return ESP_FAIL;
+    }
+
+    char json[64];
+    snprintf(json, sizeof(json), "{\"status\":\"%s\",\"played_ms\":%lu}",
+             err == ESP_OK ? "played" : "stopped", played_ms);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json, strlen(json));
+}
+
+static const httpd_uri_t uri_audio_stream = {
+    .uri       = "/api/audio/stream",
+    .method    = HTTP_GET,
+    .handler   = stream_get_handler,
+    .user_ctx  = NULL
+};
+
+static const httpd_uri_t uri_audio_play = {
+    .uri       = "/api/audio/play",
+    .method    = HTTP_POST,
+    .handler   = play_post_handler,
+    .user_ctx  = NULL
+};
+
+esp_err_t audio_http_register(httpd_handle_t server)
+{
+    esp_err_t err = httpd_register_uri_handler(server, &uri_audio_stream);
+    if (err == ESP_OK) {
+        err = httpd_register_uri_handler(server, &uri_audio_play);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register audio endpoints: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    metrics_register(&s_m_bytes[0]);
+    metrics_register(&s_m_bytes[1]);
+    return ESP_OK;
+}
@@ -0,0 +1,43 @@
+/**
+ * Network Audio Endpoints
+ *
+ * Lets a backend use the device as a network audio endpoint:
+ *
+ *   GET  /api/audio/stream?rate=16000&format=wav&seconds=0
+ *        Microphone as chunked WAV (or raw s16le mono with format=pcm),
+ *        until the client disconnects or `seconds` have been sent.
+ *   POST /api/audio/play?rate=16000
+ *        Body is a 16-bit PCM WAV (mono or stereo) or raw s16le mono at
+ *        `rate`, played through the TTS playback ring as it arrives.
+ *
+ * Both run on the async HTTP workers and stream in small chunks; nothing
+ * is buffered beyond the engine stream and the TTS ring. esp_http_server
+ * does not decode chunked request bodies, so uploads need a
+ * Content-Length (an upper bound is fine; closing early ends playback).
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief URI handlers audio_http_register() adds
+ */
+#define AUDIO_HTTP_URI_HANDLERS 2
+
+/**
+ * @brief Register the audio endpoints on a running server
+ *
+ * @param server HTTP server handle
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t audio_http_register(httpd_handle_t server);
+
+#ifdef __cplusplus
+}
+#endif
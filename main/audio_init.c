@@ -1,5 +1,5 @@
 /**
- * Audio initialization for WiFi connection notification
+ * Audio initialization and the WiFi connection notification
  */
 
 #include "audio_init.h"
@@ -7,6 +7,7 @@
 #include "bsp/esp-bsp.h"
 #include "bsp_board_extra.h"
 #include "audio_player.h"
+#include "audio_dsp.h"
 
 static const char *TAG = "audio_init";
 
@@ -30,7 +31,7 @@ static void audio_player_callback(audio_player_cb_ctx_t *ctx)
     }
 }
 
-esp_err_t audio_play_wifi_connected(void)
+esp_err_t audio_init(void)
 {
     esp_err_t err;
 
@@ -55,6 +56,10 @@ esp_err_t audio_play_wifi_connected(void)
     bsp_extra_codec_volume_set(80, &volume_set);
     ESP_LOGI(TAG, "Volume set to %d", volume_set);
 
+#if CONFIG_AUDIO_DSP_BENCHMARK_ON_BOOT
+    audio_dsp_run_benchmark();
+#endif
+
     // Initialize audio player
     err = bsp_extra_player_init();
     if (err != ESP_OK) {
@@ -65,10 +70,14 @@ esp_err_t audio_play_wifi_connected(void)
 
     // Register callback for playback events
     bsp_extra_player_register_callback(audio_player_callback, NULL);
+    return ESP_OK;
+}
 
+esp_err_t audio_play_wifi_connected(void)
+{
     // Play the notification sound once
     ESP_LOGI(TAG, "Playing %s", WAV_FILE_PATH);
-    err = bsp_extra_player_play_file(WAV_FILE_PATH);
+    esp_err_t err = bsp_extra_player_play_file(WAV_FILE_PATH);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to play file: %s", esp_err_to_name(err));
         ESP_LOGE(TAG, "Make sure '%s' exists on the SD card", WAV_FILE_PATH);
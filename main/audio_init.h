@@ -1,5 +1,5 @@
 /**
- * Audio initialization for WiFi connection notification
+ * Audio initialization and the WiFi connection notification
  */
 
 #pragma once
@@ -11,10 +11,20 @@ extern "C" {
 #endif
 
 /**
- * @brief Initialize and play the WiFi connected notification sound.
+ * @brief Initialize the SD card, audio codec and audio player.
  *
- * This function initializes the SD card, audio codec, and audio player,
- * then plays the notification sound once.
+ * Needs no network, so it runs while WiFi associates.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - Others: Fail
+ */
+esp_err_t audio_init(void);
+
+/**
+ * @brief Play the WiFi connected notification sound once.
+ *
+ * Requires audio_init().
  *
  * @return
  *      - ESP_OK: Success
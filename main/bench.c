@@ -0,0 +1,504 @@
+/**
+ * On-Device Benchmark
+ *
+ * Everything runs in one bench task so the caller's stack does not
+ * matter; the handoff and loopback tests add a producer task each. Cycle
+ * counts come from the CPU counter, latencies from esp_timer.
+ *
+ * The parser figures use the same json_scan lookups, in the same order,
+ * as the parse() callbacks of the Deepgram and OpenAI live STT providers,
+ * on frames recorded from both services.
+ */
+
+#include "bench.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "audio_dsp.h"
+#include "audio_engine.h"
+#include "json_scan.h"
+#include "spsc_ring.h"
+#include "tts.h"
+#include "task_topology.h"
+
+static const char *TAG = "bench";
+
+#define BENCH_TASK_STACK 6144          // Consumer side: runs where TTS playback does
+#define SOURCE_TASK_STACK 3072          // Producer side: runs where the TTS HTTP stream does
+#define BENCH_ROUNDS 64
+#define MAX_LATENCY_SAMPLES 2048
+
+// Ring
+#define RING_SIZE 16384
+#define RING_CHUNK 2048                 // TTS playback chunk
+#define RING_BYTES (1024 * 1024)
+#define HANDOFF_MESSAGES 500
+#define HANDOFF_MESSAGE_SIZE 256
+
+// Conversions and framing
+#define CONV_FRAMES 1024
+#define FRAME_PCM_BYTES 3200            // 100 ms at 16 kHz, as the OpenAI provider sends
+#define FRAME_PREFIX "{\"type\":\"input_audio_buffer.append\",\"audio\":\""
+#define FRAME_SUFFIX "\"}"
+
+// Loopback
+#define LOOPBACK_SAMPLE_RATE 16000
+#define LOOPBACK_BYTES_PER_MS (LOOPBACK_SAMPLE_RATE * 2 / 1000)
+#define LOOPBACK_RING_SIZE (64 * 1024)
+#define LOOPBACK_SOURCE_CHUNK 1400      // About one TCP segment per HTTP_EVENT_ON_DATA
+#define LOOPBACK_SOURCE_SPEEDUP 4       // Mock server delivers audio this much faster than real time
+#define LOOPBACK_STREAM_MS 100
+#define LOOPBACK_WRITE_TIMEOUT_MS 1000
+
+static const char s_deepgram_frame[] =
+    "{\"type\":\"Results\",\"channel_index\":[0,1],\"duration\":1.02,\"start\":3.48,\"is_final\":true,"
+    "\"speech_final\":true,\"channel\":{\"alternatives\":[{\"transcript\":\"what is the weather like "
+    "in amsterdam tomorrow\",\"confidence\":0.9921875,\"words\":[{\"word\":\"what\",\"start\":3.52,"
+    "\"end\":3.68,\"confidence\":0.99},{\"word\":\"is\",\"start\":3.68,\"end\":3.76,\"confidence\":0.99},"
+    "{\"word\":\"the\",\"start\":3.76,\"end\":3.84,\"confidence\":0.98},{\"word\":\"weather\",\"start\":3.84,"
+    "\"end\":4.08,\"confidence\":0.99},{\"word\":\"like\",\"start\":4.08,\"end\":4.24,\"confidence\":0.97},"
+    "{\"word\":\"in\",\"start\":4.24,\"end\":4.32,\"confidence\":0.99},{\"word\":\"amsterdam\",\"start\":4.32,"
+    "\"end\":4.72,\"confidence\":0.96},{\"word\":\"tomorrow\",\"start\":4.72,\"end\":4.98,"
+    "\"confidence\":0.99}]}]},\"metadata\":{\"request_id\":\"6f1c2a9e-4b1d-4f3e-9a51-0c2d7e8b9f10\","
+    "\"model_info\":{\"name\":\"general-nova-2\",\"version\":\"2024-01-09.29447\",\"arch\":\"nova-2\"},"
+    "\"model_uuid\":\"c0d1a568-ce81-4fea-97e7-bd45cb1fdf3c\"},\"from_finalize\":false}";
+
+static const char s_openai_frame[] =
+    "{\"type\":\"conversation.item.input_audio_transcription.completed\","
+    "\"event_id\":\"event_B7hQ2kLmN4pR8sTuVwXy\",\"item_id\":\"item_B7hQ1aBcDeFgHiJkLmNo\","
+    "\"content_index\":0,\"transcript\":\"What is the weather like in Amsterdam tomorrow?\","
+    "\"usage\":{\"type\":\"tokens\",\"total_tokens\":41,\"input_tokens\":29,"
+    "\"input_token_details\":{\"text_tokens\":0,\"audio_tokens\":29},\"output_tokens\":12}}";
+
+static struct {
+    portMUX_TYPE lock;
+    bool running;
+    uint32_t loopback_ms;
+    bench_report_t *report;
+    SemaphoreHandle_t done;
+} s_ctx = {.lock = portMUX_INITIALIZER_UNLOCKED};
+
+/**
+ * Producer side of a two-task test
+ */
+typedef struct {
+    spsc_ring_handle_t ring;
+    uint32_t bytes;                 // Loopback: total to deliver
+    volatile int64_t first_us;      // Loopback: first byte committed
+    volatile bool done;
+} bench_source_t;
+
+static uint32_t cycles_per_byte_x1000(uint32_t cycles, uint64_t bytes)
+{
+    return bytes ? (uint32_t)((uint64_t)cycles * 1000 / bytes) : 0;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Sort samples in place and fill the percentiles
+ */
+static void summarize(uint32_t *samples, uint32_t count, bench_latency_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (count == 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(uint32_t), compare_u32);
+    out->samples = count;
+    out->p50 = samples[(count - 1) * 50 / 100];
+    out->p95 = samples[(count - 1) * 95 / 100];
+    out->p99 = samples[(count - 1) * 99 / 100];
+    out->max = samples[count - 1];
+}
+
+/* ------------------------------------------------------------------------- */
+/* Ring                                                                      */
+/* ------------------------------------------------------------------------- */
+
+static void bench_ring_copy(bench_report_t *report, uint8_t *chunk)
+{
+    spsc_ring_handle_t ring;
+    if (spsc_ring_create(RING_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, &ring) != ESP_OK) {
+        ESP_LOGE(TAG, "Ring allocation failed");
+        return;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t done = 0; done < RING_BYTES; done += RING_CHUNK) {
+        spsc_ring_write(ring, chunk, RING_CHUNK);
+        spsc_ring_read(ring, chunk, RING_CHUNK);
+    }
+    report->ring_copy_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start, RING_BYTES);
+
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t done = 0; done < RING_BYTES; ) {
+        uint8_t *wr;
+        size_t n = spsc_ring_peek_write(ring, &wr);
+        if (n > RING_CHUNK) {
+            n = RING_CHUNK;
+        }
+        spsc_ring_commit_write(ring, n);
+        const uint8_t *rd;
+        n = spsc_ring_peek_read(ring, &rd);
+        spsc_ring_commit_read(ring, n);
+        done += n;
+    }
+    report->ring_zero_copy_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start, RING_BYTES);
+
+    spsc_ring_delete(ring);
+}
+
+/**
+ * Sends timestamped messages spaced by a tick
+ */
+static void handoff_source_task(void *arg)
+{
+    bench_source_t *src = arg;
+    uint8_t message[HANDOFF_MESSAGE_SIZE] = {0};
+
+    for (int i = 0; i < HANDOFF_MESSAGES; i++) {
+        while (spsc_ring_free_space(src->ring) < HANDOFF_MESSAGE_SIZE) {
+            spsc_ring_wait_space(src->ring, HANDOFF_MESSAGE_SIZE, pdMS_TO_TICKS(10));
+        }
+        int64_t now = esp_timer_get_time();
+        memcpy(message, &now, sizeof(now));
+        spsc_ring_write(src->ring, message, sizeof(message));
+        vTaskDelay(1);
+    }
+
+    // The consumer frees the ring once done is seen; nothing may touch it after
+    spsc_ring_wake(src->ring);
+    src->done = true;
+    vTaskDelete(NULL);
+}
+
+static void bench_ring_handoff(bench_report_t *report, uint32_t *samples)
+{
+    bench_source_t src = {0};
+    if (spsc_ring_create(RING_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, &src.ring) != ESP_OK) {
+        ESP_LOGE(TAG, "Ring allocation failed");
+        return;
+    }
+
+    if (xTaskCreatePinnedToCore(handoff_source_task, "bench_src", SOURCE_TASK_STACK, &src,
+                                TASK_TTS_WORKER_PRIORITY, NULL, TASK_TTS_WORKER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create handoff source");
+        spsc_ring_delete(src.ring);
+        return;
+    }
+
+    uint32_t count = 0;
+    uint8_t message[HANDOFF_MESSAGE_SIZE];
+    while (!src.done || spsc_ring_available(src.ring) >= HANDOFF_MESSAGE_SIZE) {
+        if (!spsc_ring_wait_data(src.ring, HANDOFF_MESSAGE_SIZE, pdMS_TO_TICKS(100))) {
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        spsc_ring_read(src.ring, message, sizeof(message));
+        int64_t sent;
+        memcpy(&sent, message, sizeof(sent));
+        if (count < MAX_LATENCY_SAMPLES) {
+            samples[count++] = (uint32_t)(now - sent);
+        }
+    }
+
+    summarize(samples, count, &report->ring_handoff_us);
+    spsc_ring_delete(src.ring);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Conversions, framing and parsing                                          */
+/* ------------------------------------------------------------------------- */
+
+static void bench_conversions(bench_report_t *report, int16_t *stereo, int16_t *mono)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        audio_dsp_deinterleave_left(stereo, mono, CONV_FRAMES);
+    }
+    report->deinterleave_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start,
+                                                           (uint64_t)BENCH_ROUNDS * CONV_FRAMES * 4);
+
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        audio_dsp_mono_to_stereo_gain(mono, stereo, CONV_FRAMES, 2 * AUDIO_DSP_GAIN_UNITY);
+    }
+    report->mono_to_stereo_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start,
+                                                             (uint64_t)BENCH_ROUNDS * CONV_FRAMES * 2);
+}
+
+static void bench_framing(bench_report_t *report, const uint8_t *pcm, char *msg)
+{
+    const size_t prefix_len = sizeof(FRAME_PREFIX) - 1;
+    const size_t suffix_len = sizeof(FRAME_SUFFIX) - 1;
+    char *json = msg + ((4 - (prefix_len & 3)) & 3);  // Base64 output 4-byte aligned, as in live_stt_openai
+    char *b64 = json + prefix_len;
+    volatile size_t sink = 0;
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        memcpy(json, FRAME_PREFIX, prefix_len);
+        size_t b64_len = audio_dsp_base64_encode(pcm, FRAME_PCM_BYTES, b64);
+        memcpy(b64 + b64_len, FRAME_SUFFIX, suffix_len);
+        sink = prefix_len + b64_len + suffix_len;
+    }
+    (void)sink;
+    report->openai_frame_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start,
+                                                           (uint64_t)BENCH_ROUNDS * FRAME_PCM_BYTES);
+}
+
+static void bench_parsers(bench_report_t *report)
+{
+    json_scan_value_t value;
+    json_scan_value_t flag;
+    char text[128];
+    volatile size_t sink = 0;
+
+    size_t len = sizeof(s_deepgram_frame) - 1;
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        if (json_scan_find(s_deepgram_frame, len, "error", &value)) {
+            continue;
+        }
+        bool end_of_turn =
+            (json_scan_find(s_deepgram_frame, len, "speech_final", &flag) && flag.type == JSON_SCAN_TRUE) ||
+            (json_scan_find(s_deepgram_frame, len, "from_finalize", &flag) && flag.type == JSON_SCAN_TRUE);
+        if (json_scan_find_string(s_deepgram_frame, len, "channel.alternatives[0].transcript", &value)) {
+            sink = json_scan_unescape(&value, text, sizeof(text)) + end_of_turn;
+        }
+    }
+    report->deepgram_parse_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start,
+                                                             (uint64_t)BENCH_ROUNDS * len);
+
+    len = sizeof(s_openai_frame) - 1;
+    start = esp_cpu_get_cycle_count();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        json_scan_value_t type;
+        if (!json_scan_find_string(s_openai_frame, len, "type", &type) ||
+            json_scan_equals(&type, "error") ||
+            json_scan_equals(&type, "session.created") || json_scan_equals(&type, "session.updated")) {
+            continue;
+        }
+        if (json_scan_equals(&type, "conversation.item.input_audio_transcription.completed") &&
+            json_scan_find_string(s_openai_frame, len, "transcript", &value)) {
+            sink = json_scan_unescape(&value, text, sizeof(text));
+        }
+    }
+    (void)sink;
+    report->openai_parse_cpb_x1000 = cycles_per_byte_x1000(esp_cpu_get_cycle_count() - start,
+                                                           (uint64_t)BENCH_ROUNDS * len);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Loopback                                                                  */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * Mock HTTP source - delivers PCM in segment-sized pieces with flow control
+ */
+static void loopback_source_task(void *arg)
+{
+    bench_source_t *src = arg;
+    uint8_t chunk[LOOPBACK_SOURCE_CHUNK];
+    uint32_t seed = 0x2545f491;
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        seed = seed * 1664525 + 1013904223;
+        chunk[i] = (uint8_t)(seed >> 24);
+    }
+
+    TickType_t period = pdMS_TO_TICKS(LOOPBACK_SOURCE_CHUNK / (LOOPBACK_BYTES_PER_MS * LOOPBACK_SOURCE_SPEEDUP));
+    if (period == 0) {
+        period = 1;
+    }
+    TickType_t wake = xTaskGetTickCount();
+
+    for (uint32_t sent = 0; sent < src->bytes; ) {
+        size_t len = src->bytes - sent < sizeof(chunk) ? src->bytes - sent : sizeof(chunk);
+        while (spsc_ring_free_space(src->ring) < len) {
+            spsc_ring_wait_space(src->ring, len, pdMS_TO_TICKS(100));
+        }
+        if (src->first_us == 0) {
+            src->first_us = esp_timer_get_time();
+        }
+        spsc_ring_write(src->ring, chunk, len);
+        sent += len;
+        vTaskDelayUntil(&wake, period);
+    }
+
+    // The consumer frees the ring once done is seen; nothing may touch it after
+    spsc_ring_wake(src->ring);
+    src->done = true;
+    vTaskDelete(NULL);
+}
+
+/**
+ * Source -> ring -> engine, consumed the way the TTS playback task does
+ */
+static void bench_loopback(bench_report_t *report, uint32_t loopback_ms, uint32_t *samples)
+{
+    report->loopback_err = ESP_OK;
+    if (tts_is_playing()) {
+        report->loopback_err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+
+    bench_source_t src = {.bytes = loopback_ms * LOOPBACK_BYTES_PER_MS};
+    audio_engine_stream_handle_t stream = NULL;
+    esp_err_t err = spsc_ring_create(LOOPBACK_RING_SIZE, MALLOC_CAP_SPIRAM, &src.ring);
+    if (err == ESP_OK) {
+        // Zero gain: the engine does all of its work but the speaker stays silent
+        err = audio_engine_playback_open(LOOPBACK_SAMPLE_RATE, LOOPBACK_STREAM_MS, 0, &stream);
+    }
+    if (err == ESP_OK &&
+        xTaskCreatePinnedToCore(loopback_source_task, "bench_src", SOURCE_TASK_STACK, &src,
+                                TASK_TTS_WORKER_PRIORITY, NULL, TASK_TTS_WORKER_CORE) != pdPASS) {
+        err = ESP_ERR_NO_MEM;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Loopback setup failed: %s", esp_err_to_name(err));
+        report->loopback_err = err;
+        audio_engine_stream_close(stream);
+        spsc_ring_delete(src.ring);
+        return;
+    }
+
+    uint32_t count = 0;
+    uint32_t queued_bytes = 0;
+    bool starved = false;
+    bool first = true;
+    while (true) {
+        const uint8_t *data;
+        size_t len = spsc_ring_peek_read(src.ring, &data);
+        len &= ~(size_t)(AUDIO_DSP_ALIGN - 1);
+        if (len == 0) {
+            if (src.done && spsc_ring_available(src.ring) < AUDIO_DSP_ALIGN) {
+                break;
+            }
+            if (!starved && !first) {
+                starved = true;
+                report->loopback_underruns++;
+            }
+            spsc_ring_wait_data(src.ring, AUDIO_DSP_ALIGN, pdMS_TO_TICKS(100));
+            continue;
+        }
+        starved = false;
+        if (len > RING_CHUNK) {
+            len = RING_CHUNK;
+        }
+
+        int64_t start = esp_timer_get_time();
+        size_t queued = audio_engine_playback_write(stream, (const int16_t *)data, len / 2,
+                                                    LOOPBACK_WRITE_TIMEOUT_MS);
+        int64_t now = esp_timer_get_time();
+        if (first && queued > 0) {
+            first = false;
+            report->loopback_first_audio_us = (uint32_t)(now - src.first_us);
+        }
+        if (count < MAX_LATENCY_SAMPLES) {
+            samples[count++] = (uint32_t)(now - start);
+        }
+        queued_bytes += queued * 2;
+        spsc_ring_commit_read(src.ring, len);
+    }
+
+    audio_engine_playback_drain(stream, LOOPBACK_WRITE_TIMEOUT_MS);
+    audio_engine_stream_close(stream);
+    spsc_ring_delete(src.ring);
+
+    report->loopback_ms = queued_bytes / LOOPBACK_BYTES_PER_MS;
+    summarize(samples, count, &report->loopback_write_us);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Runner                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static void bench_task(void *arg)
+{
+    bench_report_t *report = s_ctx.report;
+    int16_t *stereo = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, CONV_FRAMES * 2 * sizeof(int16_t),
+                                              MALLOC_CAP_INTERNAL);
+    int16_t *mono = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, CONV_FRAMES * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    char *msg = heap_caps_malloc(AUDIO_DSP_BASE64_LEN(FRAME_PCM_BYTES) + 64, MALLOC_CAP_INTERNAL);
+    uint32_t *samples = heap_caps_malloc(MAX_LATENCY_SAMPLES * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+
+    if (stereo && mono && msg && samples) {
+        uint32_t seed = 0x12345678;
+        for (int i = 0; i < CONV_FRAMES * 2; i++) {
+            seed = seed * 1664525 + 1013904223;
+            stereo[i] = (int16_t)(seed >> 16);
+        }
+
+        bench_ring_copy(report, (uint8_t *)stereo);
+        bench_ring_handoff(report, samples);
+        bench_conversions(report, stereo, mono);
+        bench_framing(report, (const uint8_t *)stereo, msg);
+        bench_parsers(report);
+        if (s_ctx.loopback_ms > 0) {
+            bench_loopback(report, s_ctx.loopback_ms, samples);
+        }
+    } else {
+        ESP_LOGE(TAG, "Benchmark allocation failed");
+        report->loopback_err = ESP_ERR_NO_MEM;
+    }
+
+    heap_caps_free(stereo);
+    heap_caps_free(mono);
+    heap_caps_free(msg);
+    heap_caps_free(samples);
+
+    xSemaphoreGive(s_ctx.done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t bench_run(uint32_t loopback_ms, bench_report_t *report)
+{
+    taskENTER_CRITICAL(&s_ctx.lock);
+    bool busy = s_ctx.running;
+    s_ctx.running = true;
+    taskEXIT_CRITICAL(&s_ctx.lock);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!s_ctx.done) {
+        s_ctx.done = xSemaphoreCreateBinary();
+    }
+
+    memset(report, 0, sizeof(*report));
+    s_ctx.report = report;
+    s_ctx.loopback_ms = loopback_ms;
+
+    esp_err_t ret = ESP_OK;
+    if (!s_ctx.done || xTaskCreatePinnedToCore(bench_task, "bench", BENCH_TASK_STACK, NULL,
+                                                  TASK_TTS_PLAYBACK_PRIORITY, NULL,
+                                                  TASK_TTS_PLAYBACK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create benchmark task");
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        xSemaphoreTake(s_ctx.done, portMAX_DELAY);
+        ESP_LOGI(TAG, "ring %lu/%lu mcyc/B, handoff p50 %lu us p99 %lu us, loopback write p99 %lu us, "
+                 "%lu underruns", (unsigned long)report->ring_copy_cpb_x1000,
+                 (unsigned long)report->ring_zero_copy_cpb_x1000, (unsigned long)report->ring_handoff_us.p50,
+                 (unsigned long)report->ring_handoff_us.p99, (unsigned long)report->loopback_write_us.p99,
+                 (unsigned long)report->loopback_underruns);
+    }
+
+    taskENTER_CRITICAL(&s_ctx.lock);
+    s_ctx.running = false;
+    taskEXIT_CRITICAL(&s_ctx.lock);
+    return ret;
+}
@@ -0,0 +1,71 @@
+/**
+ * On-Device Benchmark
+ *
+ * Repeatable numbers for the hot paths, so a change can be compared
+ * against the previous firmware: ring throughput and cross-task handoff,
+ * the mono/stereo conversions, OpenAI append framing, the JSON lookups of
+ * the live STT parsers on recorded frames, and a TTS-shaped loopback that
+ * feeds a mock HTTP source through a ring into the audio engine.
+ *
+ * Costs are reported in cycles per byte (x1000), latencies in
+ * microseconds as percentiles. Long loopback runs double as a soak test.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Latency distribution in microseconds
+ */
+typedef struct {
+    uint32_t samples;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+} bench_latency_t;
+
+/**
+ * @brief Benchmark results
+ *
+ * *_cpb_x1000 fields are CPU cycles per input byte, times 1000.
+ */
+typedef struct {
+    uint32_t ring_copy_cpb_x1000;       // spsc_ring write + read in one task
+    uint32_t ring_zero_copy_cpb_x1000;  // peek/commit on both sides, no copy
+    bench_latency_t ring_handoff_us;    // Producer commit to consumer wake-up, across tasks
+    uint32_t deinterleave_cpb_x1000;    // Stereo capture to mono, per stereo byte
+    uint32_t mono_to_stereo_cpb_x1000;  // Mono playback to stereo with gain, per mono byte
+    uint32_t openai_frame_cpb_x1000;    // input_audio_buffer.append message, per PCM byte
+    uint32_t deepgram_parse_cpb_x1000;  // Results frame lookups, per JSON byte
+    uint32_t openai_parse_cpb_x1000;    // Transcription event lookups, per JSON byte
+    esp_err_t loopback_err;             // ESP_ERR_INVALID_STATE if TTS was playing
+    uint32_t loopback_ms;               // Audio played by the loopback
+    uint32_t loopback_first_audio_us;   // First source byte to first sample queued in the engine
+    uint32_t loopback_underruns;        // Ring found empty mid-stream
+    bench_latency_t loopback_write_us;  // audio_engine_playback_write() time per chunk
+} bench_report_t;
+
+/**
+ * @brief Run all benchmarks
+ *
+ * Blocks for roughly loopback_ms plus a second. The loopback plays
+ * silence through its own playback stream and is skipped while TTS is
+ * playing. Only one run at a time.
+ *
+ * @param loopback_ms Loopback duration, 0 to skip it
+ * @param report Output results
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a run is in progress,
+ *         ESP_ERR_NO_MEM if buffers or the task cannot be allocated
+ */
+esp_err_t bench_run(uint32_t loopback_ms, bench_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
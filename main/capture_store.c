@@ -0,0 +1,114 @@
+/**
+ * Segmented Capture Store
+ */
+
+#include "capture_store.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "capture_store";
+
+#define SEGMENT_ALIGN 16            // AUDIO_DSP_ALIGN, samples feed the PIE kernels
+
+esp_err_t capture_store_init(capture_store_t *store, size_t segment_size, size_t max_bytes)
+{
+    memset(store, 0, sizeof(*store));
+    store->segment_size = segment_size;
+    store->max_segments = (max_bytes + segment_size - 1) / segment_size;
+    store->segments = heap_caps_calloc(store->max_segments, sizeof(uint8_t *),
+                                       MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!store->segments) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void capture_store_deinit(capture_store_t *store)
+{
+    if (store->segments) {
+        capture_store_release(store);
+        heap_caps_free(store->segments);
+    }
+    memset(store, 0, sizeof(*store));
+}
+
+uint8_t *capture_store_reserve(capture_store_t *store, size_t *avail)
+{
+    size_t size = store->size;  // Only the writer changes it
+    size_t index = size / store->segment_size;
+
+    if (index >= store->count) {
+        if (index >= store->max_segments) {
+            *avail = 0;
+            return NULL;
+        }
+        uint8_t *segment = heap_caps_aligned_alloc(SEGMENT_ALIGN, store->segment_size, MALLOC_CAP_SPIRAM);
+        if (!segment) {
+            ESP_LOGW(TAG, "Out of PSRAM after %d segments", (int)store->count);
+            *avail = 0;
+            return NULL;
+        }
+        store->segments[index] = segment;
+        store->count = index + 1;
+    }
+
+    size_t used = size % store->segment_size;
+    *avail = store->segment_size - used;
+    return store->segments[index] + used;
+}
+
+void capture_store_commit(capture_store_t *store, size_t len)
+{
+    __atomic_store_n(&store->size, store->size + len, __ATOMIC_RELEASE);
+}
+
+esp_err_t capture_store_append(capture_store_t *store, const void *data, size_t len)
+{
+    const uint8_t *src = data;
+
+    while (len > 0) {
+        size_t avail;
+        uint8_t *dst = capture_store_reserve(store, &avail);
+        if (!dst) {
+            return ESP_ERR_NO_MEM;
+        }
+        size_t n = (len < avail) ? len : avail;
+        memcpy(dst, src, n);
+        capture_store_commit(store, n);
+        src += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+size_t capture_store_size(const capture_store_t *store)
+{
+    return __atomic_load_n(&store->size, __ATOMIC_ACQUIRE);
+}
+
+const uint8_t *capture_store_span(const capture_store_t *store, size_t offset, size_t *len)
+{
+    size_t size = capture_store_size(store);
+    if (offset >= size) {
+        *len = 0;
+        return NULL;
+    }
+
+    // The acquire above makes the segment pointer for any published byte visible
+    size_t index = offset / store->segment_size;
+    size_t within = offset % store->segment_size;
+    size_t segment_end = (index + 1) * store->segment_size;
+    *len = ((size < segment_end) ? size : segment_end) - offset;
+    return store->segments[index] + within;
+}
+
+void capture_store_release(capture_store_t *store)
+{
+    for (size_t i = 0; i < store->count; i++) {
+        heap_caps_free(store->segments[i]);
+        store->segments[i] = NULL;
+    }
+    store->count = 0;
+    __atomic_store_n(&store->size, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,99 @@
+/**
+ * Segmented Capture Store
+ *
+ * Append-only byte store for recordings of unknown length. Memory is taken
+ * from PSRAM one fixed-size segment at a time as the recording grows and
+ * handed back in one go once it has been uploaded, so a short command
+ * costs one segment instead of a reservation for the longest recording.
+ *
+ * One writer appends while one reader follows behind: the published size
+ * only advances after the bytes (and any new segment) are in place.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Store state
+ */
+typedef struct {
+    uint8_t **segments;         // Segment table, max_segments entries
+    size_t segment_size;
+    size_t max_segments;
+    size_t count;               // Segments allocated
+    size_t size;                // Published bytes
+} capture_store_t;
+
+/**
+ * @brief Initialize a store (allocates only the segment table)
+ *
+ * @param store Store to initialize
+ * @param segment_size Bytes per segment (multiple of 16)
+ * @param max_bytes Largest size the store may grow to
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on failure
+ */
+esp_err_t capture_store_init(capture_store_t *store, size_t segment_size, size_t max_bytes);
+
+/**
+ * @brief Free all segments and the segment table
+ */
+void capture_store_deinit(capture_store_t *store);
+
+/**
+ * @brief Get contiguous space at the end of the store
+ *
+ * Allocates a segment if the last one is full. The space is 16-byte
+ * aligned whenever the store size is. Nothing is visible to the reader
+ * until capture_store_commit().
+ *
+ * @param store Store
+ * @param[out] avail Bytes writable at the returned pointer
+ * @return Write pointer, or NULL if the store is at its limit or out of memory
+ */
+uint8_t *capture_store_reserve(capture_store_t *store, size_t *avail);
+
+/**
+ * @brief Publish len bytes written at the last reserved pointer
+ */
+void capture_store_commit(capture_store_t *store, size_t len);
+
+/**
+ * @brief Copy data to the end of the store
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if it did not fit (a prefix may have been stored)
+ */
+esp_err_t capture_store_append(capture_store_t *store, const void *data, size_t len);
+
+/**
+ * @brief Get the published size
+ */
+size_t capture_store_size(const capture_store_t *store);
+
+/**
+ * @brief Get the contiguous published bytes starting at an offset
+ *
+ * @param store Store
+ * @param offset Byte offset
+ * @param[out] len Bytes readable at the returned pointer (0 at the end)
+ * @return Read pointer, or NULL at the end
+ */
+const uint8_t *capture_store_span(const capture_store_t *store, size_t offset, size_t *len);
+
+/**
+ * @brief Free all segments and empty the store
+ *
+ * The segment table is kept for the next recording. Neither the writer
+ * nor a reader may be active.
+ */
+void capture_store_release(capture_store_t *store);
+
+#ifdef __cplusplus
+}
+#endif
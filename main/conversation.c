@@ -0,0 +1,814 @@
+/**
+ * Conversation Engine
+ *
+ * Two tasks share the state below. The worker takes finished user turns,
+ * streams the chat completion (server-sent events) over a pooled
+ * api.openai.com connection and queues each completed sentence of the
+ * reply as a TTS job. The monitor polls every 20 ms while a conversation
+ * runs: it notices the first reply sample reaching the audio engine, ends
+ * the reply once its jobs are done, and watches the voice activity
+ * detector for barge-in.
+ *
+ * Without echo cancellation the microphone also hears the reply, so while
+ * it plays (and for a short tail after) transcripts are dropped as echo
+ * and barge-in needs speech well above the noise floor.
+ */
+
+#include "conversation.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+#include "cJSON.h"
+#include "sdkconfig.h"
+#include "json_scan.h"
+#include "http_pool.h"
+#include "audio_engine.h"
+#include "tts.h"
+#include "tts_queue.h"
+#include "tts_segment.h"
+#include "live_stt.h"
+#include "task_topology.h"
+
+static const char *TAG = "conversation";
+
+#define MONITOR_PERIOD_MS 20
+
+#define UTTERANCE_MAX 1024                  // User turn text
+#define REPLY_MAX 4096                      // Reply text; generation past it is not spoken
+#define SSE_LINE_MAX 2048                   // One "data:" line of the event stream
+#define MAX_JOBS (CONFIG_TTS_QUEUE_DEPTH + 1)
+#define HISTORY_TURNS CONFIG_CONVERSATION_HISTORY_TURNS
+#define QUEUE_RETRY_MS 100                  // Retry interval while the TTS queue is full
+
+#define LLM_URL "https://api.openai.com/v1/chat/completions"
+#define SSE_DATA_PREFIX "data: "
+#define REPLY_SPEED 1.0f
+
+static struct {
+    bool initialized;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t turn_sem;         // Given when a user turn ends
+    TaskHandle_t worker_task;
+    TaskHandle_t monitor_task;
+    volatile bool active;
+    volatile bool abort;                // Stop the generation in progress
+    bool reset_history;                 // Cleared by the worker before the next turn
+
+    // User turn being collected
+    char utterance[UTTERANCE_MAX];
+    size_t utterance_len;
+    bool turn_ended;
+    int64_t eos_us;                     // Estimated end of speech
+    int64_t final_us;                   // Final transcript arrived
+
+    // Reply in progress (text and SSE state are worker-only)
+    char reply[REPLY_MAX];
+    size_t reply_len;
+    size_t queued;                      // Reply bytes handed to TTS
+    char line[SSE_LINE_MAX];
+    size_t line_len;
+    bool line_overflow;
+    bool llm_done;
+    uint32_t jobs[MAX_JOBS];            // TTS jobs of the reply not yet finished
+    int job_count;
+
+    // Timing of the turn in progress
+    int64_t turn_eos_us;
+    int64_t turn_final_us;
+    int64_t first_token_us;
+    int64_t first_queued_us;
+    bool audio_seen;
+    uint64_t total_sum_ms;
+
+    // Echo suppression
+    bool barged;                        // Barge-in during this reply: transcripts are the user
+    int64_t echo_until_us;
+
+    char *history_user[HISTORY_TURNS];
+    char *history_reply[HISTORY_TURNS];
+    int history_next;
+
+    conversation_stats_t stats;
+} s_ctx = {0};
+
+static const char *s_state_names[] = {
+    [CONVERSATION_STATE_IDLE] = "idle",
+    [CONVERSATION_STATE_LISTENING] = "listening",
+    [CONVERSATION_STATE_THINKING] = "thinking",
+    [CONVERSATION_STATE_SPEAKING] = "speaking",
+};
+
+/**
+ * Live STT session that produces a transcript source
+ */
+static live_stt_provider_t provider_of(transcript_source_t source)
+{
+    return source == TRANSCRIPT_SOURCE_OPENAI_LIVE ? LIVE_STT_OPENAI : LIVE_STT_DEEPGRAM;
+}
+
+/**
+ * Estimate when the user stopped speaking from the voice activity detector
+ */
+static int64_t end_of_speech_us(int64_t now)
+{
+#if CONFIG_BSP_AUDIO_ENGINE_VAD
+    audio_engine_vad_t vad;
+    audio_engine_vad_get(&vad);
+    if (!vad.speech) {
+        return now - (int64_t)vad.silence_ms * 1000;
+    }
+#endif
+    return now;
+}
+
+void conversation_on_transcript(transcript_source_t source, const char *text, size_t len, bool end_of_turn)
+{
+    if (!s_ctx.active || source != s_ctx.stats.source) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    while (len > 0 && isspace((unsigned char)*text)) {
+        text++;
+        len--;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+
+    // The microphone hears the reply too; only a barge-in makes it the user again
+    if (!s_ctx.barged &&
+        (s_ctx.stats.state == CONVERSATION_STATE_SPEAKING || now < s_ctx.echo_until_us)) {
+        if (len > 0) {
+            s_ctx.stats.echo_dropped++;
+            ESP_LOGD(TAG, "Dropped as echo: %.*s", (int)len, text);
+        }
+        xSemaphoreGive(s_ctx.lock);
+        return;
+    }
+
+    if (len > 0) {
+        if (s_ctx.utterance_len > 0 && s_ctx.utterance_len + 1 < UTTERANCE_MAX) {
+            s_ctx.utterance[s_ctx.utterance_len++] = ' ';
+        }
+        size_t room = UTTERANCE_MAX - 1 - s_ctx.utterance_len;
+        size_t n = (len < room) ? len : room;
+        memcpy(s_ctx.utterance + s_ctx.utterance_len, text, n);
+        s_ctx.utterance_len += n;
+        s_ctx.utterance[s_ctx.utterance_len] = '\0';
+    }
+
+    if (end_of_turn && s_ctx.utterance_len > 0 && !s_ctx.turn_ended) {
+        s_ctx.turn_ended = true;
+        s_ctx.final_us = now;
+        s_ctx.eos_us = end_of_speech_us(now);
+        xSemaphoreGive(s_ctx.turn_sem);
+    }
+
+    xSemaphoreGive(s_ctx.lock);
+}
+
+/**
+ * Check whether a segment that reaches the end of the text so far is a
+ * finished sentence, rather than one still being generated
+ */
+static bool segment_complete(const char *text, size_t n, size_t len)
+{
+    if (n < len) {
+        return true;  // Cut before the end: a boundary, or the length limit
+    }
+
+    // Only a terminator that is already followed by whitespace counts
+    size_t end = n;
+    while (end > 0 && isspace((unsigned char)text[end - 1])) {
+        end--;
+    }
+    if (end == n) {
+        return false;
+    }
+    while (end > 0 && (text[end - 1] == '"' || text[end - 1] == '\'' || text[end - 1] == ')')) {
+        end--;
+    }
+    return end > 0 && (text[end - 1] == '.' || text[end - 1] == '!' || text[end - 1] == '?');
+}
+
+/**
+ * Queue every complete sentence of the reply for TTS
+ *
+ * @param final The reply is complete; the last piece need not end a sentence
+ */
+static void queue_sentences(bool final)
+{
+    while (s_ctx.queued < s_ctx.reply_len && !s_ctx.abort) {
+        char *seg = s_ctx.reply + s_ctx.queued;
+        size_t avail = s_ctx.reply_len - s_ctx.queued;
+        size_t max_chars = s_ctx.first_queued_us ? CONFIG_TTS_SEGMENT_MAX_CHARS
+                                                 : CONFIG_TTS_FIRST_SEGMENT_MAX_CHARS;
+        size_t n = tts_segment_next(seg, max_chars, true);
+        if (n == 0 || (!final && !segment_complete(seg, n, avail))) {
+            return;
+        }
+
+        size_t lead = 0;
+        while (lead < n && isspace((unsigned char)seg[lead])) {
+            lead++;
+        }
+        if (lead == n) {
+            s_ctx.queued += n;
+            continue;
+        }
+        if (s_ctx.job_count >= MAX_JOBS) {
+            return;
+        }
+
+        // tts_queue_submit() copies the text, so terminate it in place
+        char saved = seg[n];
+        seg[n] = '\0';
+        uint32_t id;
+        esp_err_t err = tts_queue_submit(seg + lead, REPLY_SPEED, TTS_PRIORITY_NORMAL, &id);
+        seg[n] = saved;
+
+        if (err == ESP_ERR_NO_MEM) {
+            return;  // Queue full, retried with the next token
+        }
+        s_ctx.queued += n;
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to queue reply sentence: %s", esp_err_to_name(err));
+            continue;
+        }
+
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        s_ctx.jobs[s_ctx.job_count++] = id;
+        if (!s_ctx.first_queued_us) {
+            s_ctx.first_queued_us = esp_timer_get_time();
+            if (s_ctx.active) {
+                s_ctx.stats.state = CONVERSATION_STATE_SPEAKING;
+            }
+        }
+        xSemaphoreGive(s_ctx.lock);
+    }
+}
+
+/**
+ * Handle one line of the event stream
+ */
+static void handle_sse_line(const char *line, size_t len)
+{
+    const size_t prefix = strlen(SSE_DATA_PREFIX);
+    if (len < prefix || memcmp(line, SSE_DATA_PREFIX, prefix) != 0) {
+        return;  // Blank separator, comment or another field
+    }
+
+    const char *data = line + prefix;
+    size_t data_len = len - prefix;
+    json_scan_value_t content;
+    if (!json_scan_find_string(data, data_len, "choices[0].delta.content", &content) || content.len == 0) {
+        return;  // Role-only first chunk, finish chunk or [DONE]
+    }
+
+    if (!s_ctx.first_token_us) {
+        s_ctx.first_token_us = esp_timer_get_time();
+    }
+    if (s_ctx.reply_len + 1 < REPLY_MAX) {
+        s_ctx.reply_len += json_scan_unescape(&content, s_ctx.reply + s_ctx.reply_len,
+                                              REPLY_MAX - s_ctx.reply_len);
+    }
+    queue_sentences(false);
+}
+
+/**
+ * LLM response handler - splits the event stream into lines
+ */
+static esp_err_t llm_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id != HTTP_EVENT_ON_DATA) {
+        return ESP_OK;
+    }
+    if (s_ctx.abort) {
+        return ESP_FAIL;  // Abort request
+    }
+    if (esp_http_client_get_status_code(evt->client) != 200) {
+        ESP_LOGE(TAG, "LLM error body: %.*s", evt->data_len, (const char *)evt->data);
+        return ESP_OK;
+    }
+
+    const char *p = evt->data;
+    const char *end = p + evt->data_len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        size_t n = (nl ? nl : end) - p;
+
+        if (!s_ctx.line_overflow && s_ctx.line_len + n < SSE_LINE_MAX) {
+            memcpy(s_ctx.line + s_ctx.line_len, p, n);
+            s_ctx.line_len += n;
+        } else {
+            s_ctx.line_overflow = true;
+        }
+
+        if (!nl) {
+            break;  // Line continues in the next chunk
+        }
+        if (s_ctx.line_overflow) {
+            ESP_LOGW(TAG, "Event line over %d bytes dropped", SSE_LINE_MAX);
+        } else {
+            size_t line_len = s_ctx.line_len;
+            if (line_len > 0 && s_ctx.line[line_len - 1] == '\r') {
+                line_len--;
+            }
+            handle_sse_line(s_ctx.line, line_len);
+        }
+        s_ctx.line_len = 0;
+        s_ctx.line_overflow = false;
+        p = nl + 1;
+    }
+    return ESP_OK;
+}
+
+static void add_message(cJSON *messages, const char *role, const char *content)
+{
+    cJSON *message = cJSON_CreateObject();
+    if (message) {
+        cJSON_AddStringToObject(message, "role", role);
+        cJSON_AddStringToObject(message, "content", content);
+        cJSON_AddItemToArray(messages, message);
+    }
+}
+
+/**
+ * Build the chat completion request: system prompt, history, new turn
+ */
+static char *build_request(const char *text)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        return NULL;
+    }
+
+    cJSON_AddStringToObject(root, "model", CONFIG_CONVERSATION_LLM_MODEL);
+    cJSON_AddBoolToObject(root, "stream", true);
+    cJSON_AddNumberToObject(root, "max_tokens", CONFIG_CONVERSATION_MAX_TOKENS);
+
+    cJSON *messages = cJSON_CreateArray();
+    if (!messages) {
+        cJSON_Delete(root);
+        return NULL;
+    }
+    add_message(messages, "system", CONFIG_CONVERSATION_SYSTEM_PROMPT);
+    for (int i = 0; i < HISTORY_TURNS; i++) {
+        int slot = (s_ctx.history_next + i) % HISTORY_TURNS;  // Oldest first
+        if (s_ctx.history_user[slot]) {
+            add_message(messages, "user", s_ctx.history_user[slot]);
+            add_message(messages, "assistant", s_ctx.history_reply[slot]);
+        }
+    }
+    add_message(messages, "user", text);
+    cJSON_AddItemToObject(root, "messages", messages);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json_str;
+}
+
+static void clear_history(void)
+{
+    for (int i = 0; i < HISTORY_TURNS; i++) {
+        free(s_ctx.history_user[i]);
+        free(s_ctx.history_reply[i]);
+        s_ctx.history_user[i] = NULL;
+        s_ctx.history_reply[i] = NULL;
+    }
+    s_ctx.history_next = 0;
+}
+
+/**
+ * Remember a turn; the reply is what was queued for speaking
+ */
+static void add_history(const char *text, const char *reply, size_t reply_len)
+{
+    char *user_copy = strdup(text);
+    char *reply_copy = strndup(reply, reply_len);
+    if (!user_copy || !reply_copy) {
+        free(user_copy);
+        free(reply_copy);
+        return;
+    }
+
+    int slot = s_ctx.history_next;
+    free(s_ctx.history_user[slot]);
+    free(s_ctx.history_reply[slot]);
+    s_ctx.history_user[slot] = user_copy;
+    s_ctx.history_reply[slot] = reply_copy;
+    s_ctx.history_next = (slot + 1) % HISTORY_TURNS;
+}
+
+/**
+ * Stream the reply to one user turn into the TTS queue
+ */
+static esp_err_t run_turn(const char *text)
+{
+    char *body = build_request(text);
+    if (!body) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    http_pool_conn_t *conn = http_pool_acquire(HTTP_POOL_HOST_OPENAI, pdMS_TO_TICKS(5000));
+    if (!conn) {
+        ESP_LOGE(TAG, "No HTTP connection available");
+        free(body);
+        return ESP_FAIL;
+    }
+
+    esp_http_client_handle_t client = http_pool_client(conn);
+    esp_http_client_set_url(client, LLM_URL);
+    esp_http_client_set_method(client, HTTP_METHOD_POST);
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    esp_http_client_set_header(client, "Accept", "text/event-stream");
+    esp_http_client_set_post_field(client, body, strlen(body));
+
+    esp_err_t ret = http_pool_perform(conn, llm_event_handler, NULL);
+    if (s_ctx.abort) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "LLM request failed: %s", esp_err_to_name(ret));
+    } else {
+        int status = esp_http_client_get_status_code(client);
+        if (status != 200) {
+            ESP_LOGE(TAG, "LLM API error (HTTP %d)", status);
+            ret = ESP_FAIL;
+        }
+    }
+
+    // The OpenAI client is shared with TTS, whose requests must not ask for an event stream
+    esp_http_client_delete_header(client, "Accept");
+
+    // Keep the socket only if the stream was read to the end
+    http_pool_release(conn, ret == ESP_OK);
+    free(body);
+
+    // Speak the rest, waiting for room in the TTS queue
+    while (ret == ESP_OK && !s_ctx.abort && s_ctx.queued < s_ctx.reply_len) {
+        queue_sentences(true);
+        if (s_ctx.queued < s_ctx.reply_len) {
+            vTaskDelay(pdMS_TO_TICKS(QUEUE_RETRY_MS));
+        }
+    }
+    return ret;
+}
+
+/**
+ * Put an interrupted turn back in front of what the user is saying now (lock held)
+ */
+static void requeue_turn(const char *text)
+{
+    size_t len = strlen(text);
+    size_t sep = (s_ctx.utterance_len > 0) ? 1 : 0;
+    if (len + sep + s_ctx.utterance_len >= UTTERANCE_MAX) {
+        return;
+    }
+
+    memmove(s_ctx.utterance + len + sep, s_ctx.utterance, s_ctx.utterance_len + 1);
+    memcpy(s_ctx.utterance, text, len);
+    if (sep) {
+        s_ctx.utterance[len] = ' ';
+    }
+    s_ctx.utterance_len += len + sep;
+}
+
+/**
+ * Drop reply jobs that have finished (lock held)
+ */
+static void prune_jobs(void)
+{
+    int kept = 0;
+    for (int i = 0; i < s_ctx.job_count; i++) {
+        tts_job_info_t info;
+        if (tts_queue_get_job(s_ctx.jobs[i], &info) == ESP_OK && info.state <= TTS_JOB_SPEAKING) {
+            s_ctx.jobs[kept++] = s_ctx.jobs[i];
+        }
+    }
+    s_ctx.job_count = kept;
+}
+
+/**
+ * Worker task - answers one user turn at a time
+ */
+static void worker_task(void *arg)
+{
+    while (true) {
+        xSemaphoreTake(s_ctx.turn_sem, portMAX_DELAY);
+
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        if (!s_ctx.active || !s_ctx.turn_ended) {
+            xSemaphoreGive(s_ctx.lock);
+            continue;
+        }
+
+        char *text = strndup(s_ctx.utterance, s_ctx.utterance_len);
+        s_ctx.utterance_len = 0;
+        s_ctx.utterance[0] = '\0';
+        s_ctx.turn_ended = false;
+        s_ctx.turn_eos_us = s_ctx.eos_us;
+        s_ctx.turn_final_us = s_ctx.final_us;
+        s_ctx.first_token_us = 0;
+        s_ctx.first_queued_us = 0;
+        s_ctx.audio_seen = false;
+        s_ctx.reply_len = 0;
+        s_ctx.reply[0] = '\0';
+        s_ctx.queued = 0;
+        s_ctx.line_len = 0;
+        s_ctx.line_overflow = false;
+        s_ctx.llm_done = false;
+        s_ctx.abort = false;
+        s_ctx.barged = false;
+        prune_jobs();  // A barge-in leaves the cancelled sentences of the last reply listed
+        s_ctx.stats.state = CONVERSATION_STATE_THINKING;
+        s_ctx.stats.turns++;
+        transcript_source_t source = s_ctx.stats.source;
+        if (s_ctx.reset_history) {
+            s_ctx.reset_history = false;
+            clear_history();
+        }
+        xSemaphoreGive(s_ctx.lock);
+
+        if (!text) {
+            continue;
+        }
+        ESP_LOGI(TAG, "User: %s", text);
+
+        // The streamer's transcript would otherwise fill up over a long conversation
+        live_stt_clear_transcript(provider_of(source));
+
+        esp_err_t ret = run_turn(text);
+
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        s_ctx.llm_done = true;
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            s_ctx.stats.llm_errors++;
+        }
+        if (ret == ESP_ERR_INVALID_STATE && s_ctx.active && !s_ctx.first_queued_us) {
+            requeue_turn(text);  // Interrupted before speaking: the user was not done
+        } else if (s_ctx.queued > 0) {
+            add_history(text, s_ctx.reply, s_ctx.queued);
+            ESP_LOGI(TAG, "Assistant: %.*s", (int)s_ctx.queued, s_ctx.reply);
+        }
+        if (s_ctx.active && s_ctx.stats.state == CONVERSATION_STATE_THINKING) {
+            s_ctx.stats.state = CONVERSATION_STATE_LISTENING;  // Nothing to speak
+        }
+        xSemaphoreGive(s_ctx.lock);
+
+        free(text);
+    }
+}
+
+/**
+ * Record the latency of a turn whose first sample just played (lock held)
+ */
+static void record_first_audio(int64_t audio_us)
+{
+    conversation_stats_t *stats = &s_ctx.stats;
+
+    stats->replies++;
+    stats->stt_ms = (uint32_t)((s_ctx.turn_final_us - s_ctx.turn_eos_us) / 1000);
+    stats->llm_ms = (uint32_t)((s_ctx.first_token_us - s_ctx.turn_final_us) / 1000);
+    stats->tts_ms = (uint32_t)((audio_us - s_ctx.first_queued_us) / 1000);
+    stats->total_ms = (uint32_t)((audio_us - s_ctx.turn_eos_us) / 1000);
+    s_ctx.total_sum_ms += stats->total_ms;
+    stats->total_avg_ms = (uint32_t)(s_ctx.total_sum_ms / stats->replies);
+    if (stats->total_ms > stats->total_max_ms) {
+        stats->total_max_ms = stats->total_ms;
+    }
+
+    ESP_LOGI(TAG, "First audio %lu ms after end of speech (stt %lu, llm %lu, tts %lu)",
+             (unsigned long)stats->total_ms, (unsigned long)stats->stt_ms,
+             (unsigned long)stats->llm_ms, (unsigned long)stats->tts_ms);
+}
+
+/**
+ * Stop the reply: the generation and every queued or speaking sentence
+ *
+ * @return true if a sentence was playing
+ */
+static bool stop_reply(void)
+{
+    uint32_t jobs[MAX_JOBS];
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    s_ctx.abort = true;
+    int count = s_ctx.job_count;
+    memcpy(jobs, s_ctx.jobs, count * sizeof(jobs[0]));
+    xSemaphoreGive(s_ctx.lock);
+
+    // Newest first, so the worker does not start the next sentence once the current one stops
+    for (int i = count - 1; i >= 0; i--) {
+        tts_queue_cancel(jobs[i]);
+    }
+    if (count > 0 && tts_is_playing()) {
+        tts_stop();
+        return true;
+    }
+    return false;
+}
+
+#if CONFIG_CONVERSATION_BARGE_IN
+static void barge_in(int64_t speech_us)
+{
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    s_ctx.barged = true;
+    s_ctx.stats.barge_ins++;
+    xSemaphoreGive(s_ctx.lock);
+
+    bool was_playing = stop_reply();
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - speech_us) / 1000);
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    s_ctx.stats.barge_in_ms = ms;
+    xSemaphoreGive(s_ctx.lock);
+    ESP_LOGI(TAG, "Barge-in, reply stopped %lu ms after speech%s", (unsigned long)ms,
+             was_playing ? "" : " (nothing playing yet)");
+}
+#endif
+
+/**
+ * Monitor task - first audio, end of reply and barge-in
+ */
+static void monitor_task(void *arg)
+{
+    int64_t speech_since = 0;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, s_ctx.active ? pdMS_TO_TICKS(MONITOR_PERIOD_MS) : portMAX_DELAY);
+        if (!s_ctx.active) {
+            speech_since = 0;
+            continue;
+        }
+
+        int64_t now = esp_timer_get_time();
+
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        if (s_ctx.first_queued_us && !s_ctx.audio_seen) {
+            int64_t audio_us = tts_get_audio_start_us();
+            if (audio_us >= s_ctx.first_queued_us) {
+                s_ctx.audio_seen = true;
+                record_first_audio(audio_us);
+            }
+        }
+        if (s_ctx.stats.state == CONVERSATION_STATE_SPEAKING) {
+            prune_jobs();
+            if (s_ctx.llm_done && s_ctx.job_count == 0) {
+                s_ctx.stats.state = CONVERSATION_STATE_LISTENING;
+                s_ctx.echo_until_us = now + (int64_t)CONFIG_CONVERSATION_ECHO_TAIL_MS * 1000;
+            }
+        }
+        conversation_state_t state = s_ctx.stats.state;
+        bool barged = s_ctx.barged;
+        xSemaphoreGive(s_ctx.lock);
+
+#if CONFIG_CONVERSATION_BARGE_IN
+        if (barged || (state != CONVERSATION_STATE_THINKING && state != CONVERSATION_STATE_SPEAKING)) {
+            speech_since = 0;
+            continue;
+        }
+
+        // While the reply plays the detector also hears it; demand a clear margin over that
+        audio_engine_vad_t vad;
+        audio_engine_vad_get(&vad);
+        int32_t margin = (state == CONVERSATION_STATE_SPEAKING) ? CONFIG_CONVERSATION_BARGE_IN_DB : 0;
+        if (!vad.speech || vad.level_db - vad.noise_db < margin) {
+            speech_since = 0;
+            continue;
+        }
+        if (!speech_since) {
+            speech_since = now;
+        } else if (now - speech_since >= (int64_t)CONFIG_CONVERSATION_BARGE_IN_MS * 1000) {
+            barge_in(speech_since);
+            speech_since = 0;
+        }
+#else
+        (void)state;
+        (void)barged;
+#endif
+    }
+}
+
+static esp_err_t conversation_init(void)
+{
+    if (s_ctx.initialized) {
+        return ESP_OK;
+    }
+
+    s_ctx.lock = xSemaphoreCreateMutex();
+    s_ctx.turn_sem = xSemaphoreCreateBinary();
+    if (!s_ctx.lock || !s_ctx.turn_sem) {
+        ESP_LOGE(TAG, "Failed to create semaphores");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreatePinnedToCore(worker_task, "conversation", TASK_CONVERSATION_STACK, NULL,
+                                TASK_CONVERSATION_PRIORITY, &s_ctx.worker_task, TASK_CONVERSATION_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(monitor_task, "conv_monitor", TASK_CONV_MONITOR_STACK, NULL,
+                                TASK_CONV_MONITOR_PRIORITY, &s_ctx.monitor_task, TASK_CONV_MONITOR_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create conversation tasks");
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_ctx.initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t conversation_start(transcript_source_t source)
+{
+    if (source != TRANSCRIPT_SOURCE_LIVE && source != TRANSCRIPT_SOURCE_OPENAI_LIVE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(CONFIG_OPENAI_API_KEY) == 0) {
+        ESP_LOGE(TAG, "OpenAI API key not configured");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = tts_init();
+    if (err == ESP_OK) {
+        err = tts_queue_init();
+    }
+    if (err == ESP_OK) {
+        err = conversation_init();
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    if (s_ctx.active) {
+        bool same = (s_ctx.stats.source == source);
+        xSemaphoreGive(s_ctx.lock);
+        return same ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
+    s_ctx.stats.source = source;
+    s_ctx.stats.state = CONVERSATION_STATE_LISTENING;
+    s_ctx.utterance_len = 0;
+    s_ctx.utterance[0] = '\0';
+    s_ctx.turn_ended = false;
+    s_ctx.barged = false;
+    s_ctx.echo_until_us = 0;
+    s_ctx.reset_history = true;
+    s_ctx.active = true;
+    xSemaphoreGive(s_ctx.lock);
+    xTaskNotifyGive(s_ctx.monitor_task);
+
+    live_stt_provider_t provider = provider_of(source);
+    err = live_stt_is_busy(provider) ? ESP_OK : live_stt_start(provider);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start live STT: %s", esp_err_to_name(err));
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        s_ctx.active = false;
+        s_ctx.stats.state = CONVERSATION_STATE_IDLE;
+        xSemaphoreGive(s_ctx.lock);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Conversation started on %s", live_stt_provider_name(provider));
+    return ESP_OK;
+}
+
+esp_err_t conversation_stop(void)
+{
+    if (!s_ctx.initialized || !s_ctx.active) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    s_ctx.active = false;
+    s_ctx.stats.state = CONVERSATION_STATE_IDLE;
+    transcript_source_t source = s_ctx.stats.source;
+    xSemaphoreGive(s_ctx.lock);
+
+    stop_reply();
+    live_stt_stop(provider_of(source));
+
+    ESP_LOGI(TAG, "Conversation stopped");
+    return ESP_OK;
+}
+
+void conversation_get_stats(conversation_stats_t *stats)
+{
+    if (!s_ctx.initialized) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    *stats = s_ctx.stats;
+    xSemaphoreGive(s_ctx.lock);
+}
+
+const char *conversation_state_name(conversation_state_t state)
+{
+    if (state > CONVERSATION_STATE_SPEAKING) {
+        return "unknown";
+    }
+    return s_state_names[state];
+}
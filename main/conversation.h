@@ -0,0 +1,105 @@
+/**
+ * Conversation Engine
+ *
+ * Voice assistant loop on top of a live STT stream: each finished user
+ * turn is sent to an OpenAI chat model with streaming responses, and the
+ * reply is spoken sentence by sentence through the TTS job queue while it
+ * is still being generated. User speech during the reply (barge-in) stops
+ * playback and the generation at once.
+ *
+ * Every turn is timed from the end of speech to the first reply sample
+ * handed to the audio engine, split into the STT, LLM and TTS stages.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "transcript_push.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Conversation states
+ */
+typedef enum {
+    CONVERSATION_STATE_IDLE = 0,    // Not running
+    CONVERSATION_STATE_LISTENING,   // Waiting for the user to finish a turn
+    CONVERSATION_STATE_THINKING,    // Waiting for the first reply sentence
+    CONVERSATION_STATE_SPEAKING,    // Reply playing (and possibly still generating)
+} conversation_state_t;
+
+/**
+ * @brief Conversation statistics
+ *
+ * Stage latencies are for the last turn that reached audio; 0 until then.
+ */
+typedef struct {
+    conversation_state_t state;
+    transcript_source_t source;     // Live STT stream listened to
+    uint32_t turns;                 // User turns sent to the model
+    uint32_t replies;               // Turns whose reply reached the speaker
+    uint32_t barge_ins;
+    uint32_t llm_errors;
+    uint32_t echo_dropped;          // Transcripts dropped as speaker echo
+    uint32_t stt_ms;                // End of speech to final transcript
+    uint32_t llm_ms;                // Final transcript to first reply token
+    uint32_t tts_ms;                // First sentence queued to first audio sample
+    uint32_t total_ms;              // End of speech to first audio sample
+    uint32_t total_avg_ms;
+    uint32_t total_max_ms;
+    uint32_t barge_in_ms;           // Barge-in speech detected to playback stopped, last barge-in
+} conversation_stats_t;
+
+/**
+ * @brief Start a conversation
+ *
+ * Initializes TTS and its job queue and starts the live STT stream if it
+ * is not already running.
+ *
+ * @param source TRANSCRIPT_SOURCE_LIVE (Deepgram) or TRANSCRIPT_SOURCE_OPENAI_LIVE
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for another source,
+ *         ESP_ERR_INVALID_STATE if no OpenAI API key is configured
+ */
+esp_err_t conversation_start(transcript_source_t source);
+
+/**
+ * @brief Stop the conversation, the reply and the live STT stream
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t conversation_stop(void);
+
+/**
+ * @brief Feed final transcript text from a live STT stream
+ *
+ * Called by the streamers for every final transcript; ignored unless a
+ * conversation is listening to that source. Does not block, so it is safe
+ * with the streamer's lock held.
+ *
+ * @param source Producer
+ * @param text Transcript text (need not be NUL terminated, may be NULL if len is 0)
+ * @param len Bytes of text
+ * @param end_of_turn The provider detected the end of the utterance
+ */
+void conversation_on_transcript(transcript_source_t source, const char *text, size_t len, bool end_of_turn);
+
+/**
+ * @brief Get statistics
+ *
+ * @param stats Output statistics
+ */
+void conversation_get_stats(conversation_stats_t *stats);
+
+/**
+ * @brief Get the name of a state ("idle", "listening", "thinking", "speaking")
+ */
+const char *conversation_state_name(conversation_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
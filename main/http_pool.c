@@ -0,0 +1,557 @@
+/**
+ * HTTP Connection Pool
+ *
+ * Keeps warm keep-alive HTTPS sessions to the TTS providers so consecutive
+ * requests skip DNS + TCP + TLS setup. A background task closes sockets
+ * before the server's idle timeout would and re-opens them (with TLS session
+ * resumption) while the host has been used recently.
+ */
+
+#include "http_pool.h"
+#include <string.h>
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "metrics.h"
+#include "task_topology.h"
+
+static const char *TAG = "http_pool";
+
+#define POOL_CONNS_PER_HOST CONFIG_HTTP_POOL_CONNS_PER_HOST
+#define POOL_IDLE_CLOSE_US ((int64_t)CONFIG_HTTP_POOL_IDLE_CLOSE_S * 1000000)
+#define POOL_WARM_WINDOW_US ((int64_t)CONFIG_HTTP_POOL_WARM_WINDOW_S * 1000000)
+#define POOL_TASK_PERIOD_MS 1000
+
+/**
+ * Pooled connection
+ */
+struct http_pool_conn {
+    http_pool_host_t host;
+    esp_http_client_handle_t client;
+    bool busy;                      // Acquired by a caller or the warm-up task
+    bool open;                      // Socket believed to be alive
+    volatile bool handshake;        // ON_CONNECTED seen during current attempt
+    volatile bool response_started; // Headers or body seen during current attempt
+    int64_t attempt_us;             // Start of the current attempt
+    int64_t last_used_us;
+    http_event_handle_cb handler;   // Per-request event handler
+    void *handler_ctx;
+};
+
+/**
+ * Per-host state
+ */
+typedef struct {
+    const char *name;
+    const char *base_url;
+    const char *warm_url;
+    bool configured;                // API key present
+    http_pool_conn_t conns[POOL_CONNS_PER_HOST];
+    SemaphoreHandle_t avail;        // Counts free connections
+    http_pool_stats_t stats;
+    int64_t last_foreground_us;
+    volatile bool prewarm_requested;
+} http_pool_host_ctx_t;
+
+static http_pool_host_ctx_t s_hosts[HTTP_POOL_HOST_MAX] = {
+    [HTTP_POOL_HOST_ELEVENLABS] = {
+        .name = "ElevenLabs",
+        .base_url = "https://api.elevenlabs.io/",
+        .warm_url = "https://api.elevenlabs.io/v1/models",
+    },
+    [HTTP_POOL_HOST_OPENAI] = {
+        .name = "OpenAI",
+        .base_url = "https://api.openai.com/",
+        .warm_url = "https://api.openai.com/v1/models",
+    },
+};
+
+static metrics_metric_t s_m_connect[HTTP_POOL_HOST_MAX] = {
+    [HTTP_POOL_HOST_ELEVENLABS] = METRICS_HISTOGRAM_MS_INIT("http_connect_ms", "DNS, TCP and TLS setup of a new connection",
+                                                            "host", "elevenlabs"),
+    [HTTP_POOL_HOST_OPENAI] = METRICS_HISTOGRAM_MS_INIT("http_connect_ms", "DNS, TCP and TLS setup of a new connection",
+                                                        "host", "openai"),
+};
+static metrics_metric_t s_m_first_byte[HTTP_POOL_HOST_MAX] = {
+    [HTTP_POOL_HOST_ELEVENLABS] = METRICS_HISTOGRAM_MS_INIT("http_first_byte_ms", "Request start to first response header",
+                                                            "host", "elevenlabs"),
+    [HTTP_POOL_HOST_OPENAI] = METRICS_HISTOGRAM_MS_INIT("http_first_byte_ms", "Request start to first response header",
+                                                        "host", "openai"),
+};
+static metrics_metric_t s_m_requests[HTTP_POOL_HOST_MAX] = {
+    [HTTP_POOL_HOST_ELEVENLABS] = METRICS_COUNTER_INIT("http_requests_total", "Pooled requests, warm-ups excluded",
+                                                       "host", "elevenlabs"),
+    [HTTP_POOL_HOST_OPENAI] = METRICS_COUNTER_INIT("http_requests_total", "Pooled requests, warm-ups excluded",
+                                                   "host", "openai"),
+};
+
+static bool s_initialized = false;
+static SemaphoreHandle_t s_lock = NULL;
+static TaskHandle_t s_pool_task = NULL;
+
+static void pool_task(void *arg);
+
+/**
+ * Check whether the API key for a host is configured
+ */
+static bool host_has_key(http_pool_host_t host)
+{
+    switch (host) {
+        case HTTP_POOL_HOST_ELEVENLABS:
+#ifdef CONFIG_ELEVENLABS_API_KEY
+            return strlen(CONFIG_ELEVENLABS_API_KEY) > 0;
+#else
+            return false;
+#endif
+        case HTTP_POOL_HOST_OPENAI:
+#ifdef CONFIG_OPENAI_API_KEY
+            return strlen(CONFIG_OPENAI_API_KEY) > 0;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * Set the host's authorization header on a client
+ */
+static void set_auth_header(http_pool_host_t host, esp_http_client_handle_t client)
+{
+    if (host == HTTP_POOL_HOST_OPENAI) {
+#ifdef CONFIG_OPENAI_API_KEY
+        char auth_header[256];
+        snprintf(auth_header, sizeof(auth_header), "Bearer %s", CONFIG_OPENAI_API_KEY);
+        esp_http_client_set_header(client, "Authorization", auth_header);
+#endif
+    } else {
+#ifdef CONFIG_ELEVENLABS_API_KEY
+        esp_http_client_set_header(client, "xi-api-key", CONFIG_ELEVENLABS_API_KEY);
+#endif
+    }
+}
+
+/**
+ * Event handler installed on every pooled client
+ *
+ * Tracks connection state, then forwards the event to the handler of the
+ * request currently running on the connection.
+ */
+static esp_err_t pool_event_handler(esp_http_client_event_t *evt)
+{
+    http_pool_conn_t *conn = (http_pool_conn_t *)evt->user_data;
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            conn->handshake = true;
+            metrics_observe_since(&s_m_connect[conn->host], conn->attempt_us);
+            break;
+        case HTTP_EVENT_ON_HEADER:
+        case HTTP_EVENT_ON_DATA:
+            if (!conn->response_started) {
+                conn->response_started = true;
+                metrics_observe_since(&s_m_first_byte[conn->host], conn->attempt_us);
+            }
+            break;
+        case HTTP_EVENT_DISCONNECTED:
+            conn->open = false;
+            break;
+        default:
+            break;
+    }
+
+    if (!conn->handler) {
+        return ESP_OK;
+    }
+
+    evt->user_data = conn->handler_ctx;
+    esp_err_t ret = conn->handler(evt);
+    evt->user_data = conn;
+    return ret;
+}
+
+/**
+ * Run the prepared request, retrying once if a kept-alive socket was stale
+ */
+static esp_err_t pool_perform(http_pool_conn_t *conn, bool warmup)
+{
+    http_pool_host_ctx_t *h = &s_hosts[conn->host];
+    bool handshake = false;
+    esp_err_t err = ESP_FAIL;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool was_open = conn->open;
+        conn->handshake = false;
+        conn->response_started = false;
+        conn->open = true;
+        conn->attempt_us = esp_timer_get_time();
+
+        err = esp_http_client_perform(conn->client);
+        handshake |= conn->handshake;
+
+        if (err == ESP_OK || !was_open || conn->handshake || conn->response_started) {
+            break;
+        }
+
+        // Server closed the idle socket before we noticed; reconnect once
+        ESP_LOGW(TAG, "%s: stale keep-alive connection (%s), reconnecting",
+                 h->name, esp_err_to_name(err));
+        esp_http_client_close(conn->client);
+        conn->open = false;
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        h->stats.retries++;
+        xSemaphoreGive(s_lock);
+    }
+
+    if (err != ESP_OK) {
+        esp_http_client_close(conn->client);
+        conn->open = false;
+    }
+    conn->handshake = handshake;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (handshake) {
+        h->stats.handshakes++;
+    } else if (!warmup && err == ESP_OK) {
+        h->stats.reuses++;
+    }
+    if (warmup) {
+        h->stats.warmups++;
+    } else {
+        h->last_foreground_us = esp_timer_get_time();
+    }
+    xSemaphoreGive(s_lock);
+
+    if (!warmup) {
+        metrics_inc(&s_m_requests[conn->host]);
+    }
+
+    return err;
+}
+
+/**
+ * Open a connection with a cheap request so the next real request reuses it
+ */
+static void pool_warm_conn(http_pool_conn_t *conn)
+{
+    http_pool_host_ctx_t *h = &s_hosts[conn->host];
+
+    esp_http_client_set_url(conn->client, h->warm_url);
+    esp_http_client_set_method(conn->client, HTTP_METHOD_HEAD);
+    esp_http_client_set_post_field(conn->client, NULL, 0);
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = pool_perform(conn, true);
+    int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "%s: connection warm (%s, %lld ms)", h->name,
+                 conn->handshake ? "handshake" : "reused", elapsed_ms);
+    } else {
+        ESP_LOGW(TAG, "%s: warm-up failed: %s", h->name, esp_err_to_name(err));
+    }
+}
+
+/**
+ * Pick a free connection; caller holds one count of h->avail
+ */
+static http_pool_conn_t *take_free_conn(http_pool_host_ctx_t *h)
+{
+    http_pool_conn_t *picked = NULL;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < POOL_CONNS_PER_HOST; i++) {
+        http_pool_conn_t *conn = &h->conns[i];
+        if (conn->busy) {
+            continue;
+        }
+        if (!picked || (conn->open && !picked->open)) {
+            picked = conn;
+        }
+    }
+    if (picked) {
+        picked->busy = true;
+    }
+    xSemaphoreGive(s_lock);
+
+    return picked;
+}
+
+/**
+ * Initialize the connection pool
+ */
+esp_err_t http_pool_init(void)
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int host = 0; host < HTTP_POOL_HOST_MAX; host++) {
+        http_pool_host_ctx_t *h = &s_hosts[host];
+        h->configured = host_has_key((http_pool_host_t)host);
+        if (!h->configured) {
+            continue;
+        }
+
+        h->avail = xSemaphoreCreateCounting(POOL_CONNS_PER_HOST, POOL_CONNS_PER_HOST);
+        if (!h->avail) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        for (int i = 0; i < POOL_CONNS_PER_HOST; i++) {
+            http_pool_conn_t *conn = &h->conns[i];
+            conn->host = (http_pool_host_t)host;
+
+            esp_http_client_config_t config = {
+                .url = h->base_url,
+                .event_handler = pool_event_handler,
+                .user_data = conn,
+                .timeout_ms = 30000,
+                .crt_bundle_attach = esp_crt_bundle_attach,
+                .buffer_size = 4096,
+                .buffer_size_tx = 2048,
+                .keep_alive_enable = true,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+                .save_client_session = true,
+#endif
+            };
+
+            conn->client = esp_http_client_init(&config);
+            if (!conn->client) {
+                ESP_LOGE(TAG, "Failed to init %s client %d", h->name, i);
+                return ESP_FAIL;
+            }
+            set_auth_header((http_pool_host_t)host, conn->client);
+        }
+    }
+
+    BaseType_t task_created = xTaskCreatePinnedToCore(pool_task, "http_pool", TASK_HTTP_POOL_STACK, NULL,
+                                                      TASK_HTTP_POOL_PRIORITY, &s_pool_task, TASK_HTTP_POOL_CORE);
+    if (task_created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create pool task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_initialized = true;
+    ESP_LOGI(TAG, "HTTP pool initialized (%d connections per host)", POOL_CONNS_PER_HOST);
+    return ESP_OK;
+}
+
+/**
+ * Acquire a connection to a host
+ */
+http_pool_conn_t *http_pool_acquire(http_pool_host_t host, TickType_t timeout)
+{
+    if (!s_initialized || host >= HTTP_POOL_HOST_MAX || !s_hosts[host].configured) {
+        return NULL;
+    }
+
+    http_pool_host_ctx_t *h = &s_hosts[host];
+    if (xSemaphoreTake(h->avail, timeout) != pdTRUE) {
+        ESP_LOGW(TAG, "%s: no free connection", h->name);
+        return NULL;
+    }
+
+    http_pool_conn_t *conn = take_free_conn(h);
+    if (!conn) {
+        // Every count is backed by a free slot, so this is a bookkeeping bug; keep the count
+        ESP_LOGE(TAG, "%s: no free slot behind an available count", h->name);
+        xSemaphoreGive(h->avail);
+    }
+    return conn;
+}
+
+/**
+ * Get the HTTP client behind a pooled connection
+ */
+esp_http_client_handle_t http_pool_client(http_pool_conn_t *conn)
+{
+    return conn->client;
+}
+
+/**
+ * Perform the prepared request
+ */
+esp_err_t http_pool_perform(http_pool_conn_t *conn, http_event_handle_cb handler, void *ctx)
+{
+    conn->handler = handler;
+    conn->handler_ctx = ctx;
+    esp_err_t err = pool_perform(conn, false);
+    conn->handler = NULL;
+    conn->handler_ctx = NULL;
+    return err;
+}
+
+/**
+ * Check whether the last request opened a new connection
+ */
+bool http_pool_last_was_handshake(http_pool_conn_t *conn)
+{
+    return conn->handshake;
+}
+
+/**
+ * Return a connection to the pool
+ */
+void http_pool_release(http_pool_conn_t *conn, bool reusable)
+{
+    if (!conn) {
+        return;
+    }
+
+    http_pool_host_ctx_t *h = &s_hosts[conn->host];
+
+    // Drop the caller's body pointer so later warm-ups don't resend it
+    esp_http_client_set_post_field(conn->client, NULL, 0);
+
+    // Headers belong to the request that set them; only the host's auth header stays
+    esp_http_client_delete_header(conn->client, "Accept");
+    esp_http_client_delete_header(conn->client, "Content-Type");
+    set_auth_header(conn->host, conn->client);
+
+    if (!reusable && conn->open) {
+        esp_http_client_close(conn->client);
+        conn->open = false;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    conn->last_used_us = esp_timer_get_time();
+    conn->busy = false;
+    xSemaphoreGive(s_lock);
+
+    xSemaphoreGive(h->avail);
+}
+
+/**
+ * Request background warm-up for a host
+ */
+void http_pool_prewarm(http_pool_host_t host)
+{
+    if (!s_initialized || host >= HTTP_POOL_HOST_MAX || !s_hosts[host].configured) {
+        return;
+    }
+
+    s_hosts[host].prewarm_requested = true;
+    xTaskNotifyGive(s_pool_task);
+}
+
+/**
+ * Get statistics for a host
+ */
+void http_pool_get_stats(http_pool_host_t host, http_pool_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    if (!s_initialized || host >= HTTP_POOL_HOST_MAX) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_hosts[host].stats;
+    xSemaphoreGive(s_lock);
+}
+
+/**
+ * Get the display name of a host
+ */
+const char *http_pool_host_name(http_pool_host_t host)
+{
+    if (host >= HTTP_POOL_HOST_MAX) {
+        return "Unknown";
+    }
+    return s_hosts[host].name;
+}
+
+/**
+ * Background task - closes idle sockets and keeps recently used hosts warm
+ */
+static void pool_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POOL_TASK_PERIOD_MS));
+
+        for (int host = 0; host < HTTP_POOL_HOST_MAX; host++) {
+            http_pool_host_ctx_t *h = &s_hosts[host];
+            if (!h->configured) {
+                continue;
+            }
+
+            int64_t now = esp_timer_get_time();
+            bool any_open = false;
+
+            // Close sockets the server is about to drop, so a request never
+            // lands on a half-closed connection
+            for (int i = 0; i < POOL_CONNS_PER_HOST; i++) {
+                http_pool_conn_t *conn = &h->conns[i];
+
+                xSemaphoreTake(s_lock, portMAX_DELAY);
+                bool idle = !conn->busy && conn->open;
+                bool expired = idle && (now - conn->last_used_us) > POOL_IDLE_CLOSE_US;
+                xSemaphoreGive(s_lock);
+
+                // Claim a count like an acquire would, so a caller never takes a
+                // count whose slot the close is holding; skip if none is free
+                if (expired && xSemaphoreTake(h->avail, 0) == pdTRUE) {
+                    xSemaphoreTake(s_lock, portMAX_DELAY);
+                    expired = !conn->busy && conn->open;
+                    if (expired) {
+                        conn->busy = true;
+                    }
+                    xSemaphoreGive(s_lock);
+                    if (!expired) {
+                        xSemaphoreGive(h->avail);
+                    }
+                } else {
+                    expired = false;
+                }
+
+                if (expired) {
+                    ESP_LOGD(TAG, "%s: closing idle connection %d", h->name, i);
+                    esp_http_client_close(conn->client);
+                    conn->open = false;
+                    xSemaphoreTake(s_lock, portMAX_DELAY);
+                    conn->busy = false;
+                    xSemaphoreGive(s_lock);
+                    xSemaphoreGive(h->avail);
+                } else if (conn->open) {
+                    any_open = true;
+                }
+            }
+
+            bool recently_used = h->last_foreground_us > 0 &&
+                                 (now - h->last_foreground_us) < POOL_WARM_WINDOW_US;
+            bool want_warm = h->prewarm_requested || recently_used;
+            h->prewarm_requested = false;
+
+            if (!want_warm || any_open) {
+                continue;
+            }
+
+            // Only warm a connection nobody is waiting for
+            if (xSemaphoreTake(h->avail, 0) != pdTRUE) {
+                continue;
+            }
+            http_pool_conn_t *conn = take_free_conn(h);
+            if (conn) {
+                pool_warm_conn(conn);
+                http_pool_release(conn, true);
+            } else {
+                xSemaphoreGive(h->avail);
+            }
+        }
+    }
+}
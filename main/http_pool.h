@@ -0,0 +1,131 @@
+/**
+ * HTTP Connection Pool
+ *
+ * Keeps warm keep-alive HTTPS sessions to the TTS providers so consecutive
+ * requests skip DNS + TCP + TLS setup.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Hosts served by the pool
+ */
+typedef enum {
+    HTTP_POOL_HOST_ELEVENLABS = 0,
+    HTTP_POOL_HOST_OPENAI,
+    HTTP_POOL_HOST_MAX,
+} http_pool_host_t;
+
+/**
+ * @brief Per-host connection statistics
+ */
+typedef struct {
+    uint32_t handshakes;    // New TCP + TLS connections (foreground and warm-up)
+    uint32_t reuses;        // Requests served on an already open connection
+    uint32_t warmups;       // Background warm-up requests issued
+    uint32_t retries;       // Requests retried after a stale keep-alive socket
+} http_pool_stats_t;
+
+/**
+ * @brief Opaque pooled connection
+ */
+typedef struct http_pool_conn http_pool_conn_t;
+
+/**
+ * @brief Initialize the connection pool
+ *
+ * Creates one client per connection slot and starts the background
+ * warm-up task. Safe to call more than once.
+ *
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t http_pool_init(void);
+
+/**
+ * @brief Acquire exclusive use of a connection to a host
+ *
+ * Prefers a connection that is already open.
+ *
+ * @param host Host to connect to
+ * @param timeout Max time to wait for a free connection
+ * @return Connection, or NULL if none became free in time
+ */
+http_pool_conn_t *http_pool_acquire(http_pool_host_t host, TickType_t timeout);
+
+/**
+ * @brief Get the HTTP client behind a pooled connection
+ *
+ * Use it to set URL, method, headers and POST body before
+ * http_pool_perform(). Authorization is already set by the pool.
+ *
+ * @param conn Acquired connection
+ * @return HTTP client handle
+ */
+esp_http_client_handle_t http_pool_client(http_pool_conn_t *conn);
+
+/**
+ * @brief Perform the prepared request on a pooled connection
+ *
+ * Events are forwarded to the given handler with evt->user_data set to ctx.
+ * If a kept-alive socket turns out to be stale before any response arrived,
+ * the request is retried once on a fresh connection.
+ *
+ * @param conn Acquired connection
+ * @param handler Event handler for this request
+ * @param ctx User data passed to the handler
+ * @return Result of esp_http_client_perform()
+ */
+esp_err_t http_pool_perform(http_pool_conn_t *conn, http_event_handle_cb handler, void *ctx);
+
+/**
+ * @brief Check whether the last request had to open a new connection
+ *
+ * @param conn Acquired connection
+ * @return true if a handshake happened, false if the connection was reused
+ */
+bool http_pool_last_was_handshake(http_pool_conn_t *conn);
+
+/**
+ * @brief Return a connection to the pool
+ *
+ * @param conn Acquired connection
+ * @param reusable false to close the socket (e.g. after an aborted download)
+ */
+void http_pool_release(http_pool_conn_t *conn, bool reusable);
+
+/**
+ * @brief Ask the background task to open a connection to a host
+ *
+ * @param host Host to warm up
+ */
+void http_pool_prewarm(http_pool_host_t host);
+
+/**
+ * @brief Get connection statistics for a host
+ *
+ * @param host Host to query
+ * @param stats Output statistics
+ */
+void http_pool_get_stats(http_pool_host_t host, http_pool_stats_t *stats);
+
+/**
+ * @brief Get the display name of a pooled host
+ *
+ * @param host Host
+ * @return Host name string
+ */
+const char *http_pool_host_name(http_pool_host_t host);
+
+#ifdef __cplusplus
+}
+#endif
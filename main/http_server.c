@@ -2,14 +2,33 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_http_server.h"
 #include "cJSON.h"
 #include "tts.h"
+#include "tts_queue.h"
 #include "stt.h"
 #include "live_stt.h"
-#include "openai_live_stt.h"
+#include "http_pool.h"
+#include "audio_encoder.h"
 #include "bsp_board_extra.h"
+#include "audio_engine.h"
+#include "tts_cache.h"
+#include "audio_pool.h"
+#include "transcript_push.h"
+#include "wake_word.h"
+#include "conversation.h"
+#include "metrics.h"
+#include "bench.h"
+#include "task_topology.h"
+#include "web_assets.h"
+#include "http_workers.h"
+#include "audio_http.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
@@ -18,812 +37,142 @@ static httpd_handle_t server = NULL;
 static bool tts_initialized = false;
 static bool stt_initialized = false;
 
-/* Common CSS for sidebar layout - must be a macro for string concatenation */
-#define COMMON_CSS \
-    "<style>" \
-    "* { box-sizing: border-box; margin: 0; padding: 0; }" \
-    "body { font-family: Arial, sans-serif; background: #f5f5f5; display: flex; min-height: 100vh; }" \
-    ".sidebar { width: 220px; background: #2c3e50; color: white; position: fixed; height: 100vh; padding: 20px 0; }" \
-    ".sidebar .logo { font-size: 18px; font-weight: bold; padding: 0 20px 20px; border-bottom: 1px solid #34495e; }" \
-    ".sidebar nav { margin-top: 20px; }" \
-    ".sidebar .nav-item { display: flex; align-items: center; padding: 12px 20px; color: #bdc3c7; text-decoration: none; transition: all 0.2s; }" \
-    ".sidebar .nav-item:hover { background: #34495e; color: white; }" \
-    ".sidebar .nav-item.active { background: #3498db; color: white; }" \
-    ".sidebar .nav-item .icon { margin-right: 10px; font-size: 18px; }" \
-    ".main-content { margin-left: 220px; flex: 1; padding: 30px; }" \
-    ".page-header { margin-bottom: 25px; }" \
-    ".page-header h1 { color: #2c3e50; font-size: 28px; margin-bottom: 5px; }" \
-    ".page-header .subtitle { color: #7f8c8d; }" \
-    ".card { background: white; border-radius: 10px; padding: 25px; box-shadow: 0 2px 10px rgba(0,0,0,0.05); margin-bottom: 20px; }" \
-    ".card h2 { color: #2c3e50; font-size: 18px; margin-bottom: 15px; }" \
-    ".status-bar { padding: 12px 15px; background: #e8f5e9; border-radius: 5px; margin-bottom: 20px; }" \
-    ".status-bar.warning { background: #fff3e0; }" \
-    ".status-bar.error { background: #ffebee; }" \
-    "textarea { width: 100%; height: 100px; padding: 12px; font-size: 15px; border: 1px solid #ddd; border-radius: 5px; resize: vertical; }" \
-    "select { width: 100%; padding: 10px; font-size: 15px; border: 1px solid #ddd; border-radius: 5px; }" \
-    "button { background: #3498db; color: white; padding: 12px 24px; border: none; border-radius: 5px; cursor: pointer; font-size: 15px; transition: background 0.2s; }" \
-    "button:hover { background: #2980b9; }" \
-    "button:disabled { background: #bdc3c7; cursor: not-allowed; }" \
-    "button.success { background: #27ae60; }" \
-    "button.success:hover { background: #219a52; }" \
-    "button.danger { background: #e74c3c; }" \
-    "button.danger:hover { background: #c0392b; }" \
-    "button.secondary { background: #95a5a6; }" \
-    "button.secondary:hover { background: #7f8c8d; }" \
-    ".control-group { margin-bottom: 15px; }" \
-    ".control-group label { display: block; margin-bottom: 5px; font-weight: 600; color: #34495e; }" \
-    ".slider-row { display: flex; align-items: center; gap: 10px; }" \
-    ".slider-row input[type=range] { flex: 1; }" \
-    ".slider-row span { min-width: 50px; text-align: right; color: #7f8c8d; }" \
-    ".result { padding: 15px; border-radius: 5px; margin-top: 15px; }" \
-    ".result.success { background: #e8f5e9; color: #2e7d32; }" \
-    ".result.error { background: #ffebee; color: #c62828; }" \
-    ".result.info { background: #e3f2fd; color: #1565c0; }" \
-    ".result.warning { background: #fff3e0; color: #e65100; }" \
-    ".timer { font-size: 48px; font-weight: bold; text-align: center; font-family: monospace; color: #2c3e50; margin: 20px 0; }" \
-    ".transcript-box { min-height: 150px; max-height: 400px; overflow-y: auto; padding: 15px; background: #fafafa; border: 1px solid #eee; border-radius: 5px; white-space: pre-wrap; word-wrap: break-word; }" \
-    ".settings-row { display: flex; justify-content: space-between; align-items: center; padding: 12px 0; border-bottom: 1px solid #eee; }" \
-    ".settings-row:last-child { border-bottom: none; }" \
-    ".settings-row .label { color: #34495e; font-weight: 500; }" \
-    ".settings-row .value { color: #7f8c8d; }" \
-    ".settings-row .value.configured { color: #27ae60; }" \
-    ".settings-row .value.not-configured { color: #e74c3c; }" \
-    "@media (max-width: 768px) { .sidebar { width: 60px; } .sidebar .logo, .sidebar .nav-text { display: none; } .sidebar .nav-item { justify-content: center; padding: 15px; } .sidebar .nav-item .icon { margin: 0; } .main-content { margin-left: 60px; } }" \
-    "</style>"
-
-/* Sidebar HTML component */
-#define SIDEBAR_HTML(active_page) \
-    "<div class=\"sidebar\">" \
-    "<div class=\"logo\">ESP32-P4 Audio</div>" \
-    "<nav>" \
-    "<a href=\"/\" class=\"nav-item" active_page##_TTS "\"><span class=\"icon\">&#128266;</span><span class=\"nav-text\">Text-to-Speech</span></a>" \
-    "<a href=\"/stt\" class=\"nav-item" active_page##_STT "\"><span class=\"icon\">&#128221;</span><span class=\"nav-text\">Batch STT</span></a>" \
-    "<a href=\"/live\" class=\"nav-item" active_page##_LIVE "\"><span class=\"icon\">&#127908;</span><span class=\"nav-text\">Live STT (DG)</span></a>" \
-    "<a href=\"/openai-live\" class=\"nav-item" active_page##_OPENAI "\"><span class=\"icon\">&#127897;</span><span class=\"nav-text\">Live STT (OpenAI)</span></a>" \
-    "<a href=\"/settings\" class=\"nav-item" active_page##_SETTINGS "\"><span class=\"icon\">&#9881;</span><span class=\"nav-text\">Settings</span></a>" \
-    "</nav>" \
-    "</div>"
-
-#define ACTIVE_TTS_TTS " active"
-#define ACTIVE_TTS_STT ""
-#define ACTIVE_TTS_LIVE ""
-#define ACTIVE_TTS_OPENAI ""
-#define ACTIVE_TTS_SETTINGS ""
-
-#define ACTIVE_STT_TTS ""
-#define ACTIVE_STT_STT " active"
-#define ACTIVE_STT_LIVE ""
-#define ACTIVE_STT_OPENAI ""
-#define ACTIVE_STT_SETTINGS ""
-
-#define ACTIVE_LIVE_TTS ""
-#define ACTIVE_LIVE_STT ""
-#define ACTIVE_LIVE_LIVE " active"
-#define ACTIVE_LIVE_OPENAI ""
-#define ACTIVE_LIVE_SETTINGS ""
-
-#define ACTIVE_OPENAI_TTS ""
-#define ACTIVE_OPENAI_STT ""
-#define ACTIVE_OPENAI_LIVE ""
-#define ACTIVE_OPENAI_OPENAI " active"
-#define ACTIVE_OPENAI_SETTINGS ""
-
-#define ACTIVE_SETTINGS_TTS ""
-#define ACTIVE_SETTINGS_STT ""
-#define ACTIVE_SETTINGS_LIVE ""
-#define ACTIVE_SETTINGS_OPENAI ""
-#define ACTIVE_SETTINGS_SETTINGS " active"
-
-/* TTS Page HTML */
-static const char *TTS_HTML =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<title>Text-to-Speech - ESP32-P4</title>"
-    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-    COMMON_CSS
-    "</head>"
-    "<body>"
-    SIDEBAR_HTML(ACTIVE_TTS)
-    "<div class=\"main-content\">"
-    "<div class=\"page-header\">"
-    "<h1>Text-to-Speech</h1>"
-    "<p class=\"subtitle\">Convert text to spoken audio</p>"
-    "</div>"
-    "<div class=\"card\">"
-    "<div class=\"status-bar\">"
-    "<strong>Provider:</strong> <span id=\"currentProvider\">Loading...</span>"
-    "</div>"
-    "<form id=\"ttsForm\">"
-    "<div class=\"control-group\">"
-    "<label for=\"text\">Enter text to speak:</label>"
-    "<textarea id=\"text\" name=\"text\" placeholder=\"Type something here...\"></textarea>"
-    "</div>"
-    "<div class=\"control-group\">"
-    "<label for=\"provider\">TTS Provider:</label>"
-    "<select id=\"provider\" name=\"provider\">"
-    "<option value=\"0\">Loading...</option>"
-    "</select>"
-    "</div>"
-    "<div class=\"control-group\">"
-    "<label for=\"speed\">Speech Speed:</label>"
-    "<div class=\"slider-row\">"
-    "<input type=\"range\" id=\"speed\" name=\"speed\" min=\"0.5\" max=\"2.0\" step=\"0.1\" value=\"1.0\">"
-    "<span id=\"speedVal\">1.0x</span>"
-    "</div>"
-    "</div>"
-    "<div class=\"control-group\">"
-    "<label for=\"volume\">Volume:</label>"
-    "<div class=\"slider-row\">"
-    "<input type=\"range\" id=\"volume\" name=\"volume\" min=\"0\" max=\"100\" step=\"5\" value=\"80\">"
-    "<span id=\"volumeVal\">80%</span>"
-    "</div>"
-    "</div>"
-    "<button type=\"submit\" id=\"speakBtn\" class=\"success\">Speak</button>"
-    "</form>"
-    "<div id=\"result\" class=\"result\" style=\"display:none\"></div>"
-    "</div>"
-    "</div>"
-    "<script>"
-    "const speedSlider = document.getElementById('speed');"
-    "const speedVal = document.getElementById('speedVal');"
-    "const volumeSlider = document.getElementById('volume');"
-    "const volumeVal = document.getElementById('volumeVal');"
-    "const providerSelect = document.getElementById('provider');"
-    "const currentProviderSpan = document.getElementById('currentProvider');"
-    "let currentProvider = 0;"
-    "function updateSpeedRange() {"
-    "  if (currentProvider === 1) {"
-    "    speedSlider.min = '0.25';"
-    "    speedSlider.max = '4.0';"
-    "  } else {"
-    "    speedSlider.min = '0.5';"
-    "    speedSlider.max = '2.0';"
-    "    if (parseFloat(speedSlider.value) > 2.0) speedSlider.value = '2.0';"
-    "    if (parseFloat(speedSlider.value) < 0.5) speedSlider.value = '0.5';"
-    "  }"
-    "  speedVal.textContent = speedSlider.value + 'x';"
-    "}"
-    "async function loadProviders() {"
-    "  try {"
-    "    const response = await fetch('/api/provider');"
-    "    const data = await response.json();"
-    "    providerSelect.innerHTML = '';"
-    "    data.providers.forEach(p => {"
-    "      const opt = document.createElement('option');"
-    "      opt.value = p.id;"
-    "      opt.textContent = p.name + (p.available ? '' : ' (not configured)');"
-    "      opt.disabled = !p.available;"
-    "      if (p.id === data.current) opt.selected = true;"
-    "      providerSelect.appendChild(opt);"
-    "    });"
-    "    currentProvider = data.current;"
-    "    currentProviderSpan.textContent = data.providers.find(p => p.id === data.current)?.name || 'Unknown';"
-    "    updateSpeedRange();"
-    "  } catch (err) { console.error('Failed to load providers:', err); }"
-    "}"
-    "providerSelect.addEventListener('change', async function() {"
-    "  try {"
-    "    const response = await fetch('/api/provider', {"
-    "      method: 'POST',"
-    "      headers: { 'Content-Type': 'application/json' },"
-    "      body: JSON.stringify({ provider: parseInt(this.value) })"
-    "    });"
-    "    const data = await response.json();"
-    "    if (response.ok) {"
-    "      currentProvider = data.provider;"
-    "      currentProviderSpan.textContent = data.name;"
-    "      updateSpeedRange();"
-    "    } else {"
-    "      alert('Failed to change provider: ' + data.error);"
-    "      loadProviders();"
-    "    }"
-    "  } catch (err) { console.error('Provider change error:', err); }"
-    "});"
-    "speedSlider.addEventListener('input', function() {"
-    "  speedVal.textContent = this.value + 'x';"
-    "});"
-    "volumeSlider.addEventListener('input', function() {"
-    "  volumeVal.textContent = this.value + '%';"
-    "});"
-    "volumeSlider.addEventListener('change', async function() {"
-    "  try {"
-    "    await fetch('/api/volume', {"
-    "      method: 'POST',"
-    "      headers: { 'Content-Type': 'application/json' },"
-    "      body: JSON.stringify({ volume: parseInt(this.value) })"
-    "    });"
-    "  } catch (err) { console.error('Volume error:', err); }"
-    "});"
-    "document.getElementById('ttsForm').addEventListener('submit', async function(e) {"
-    "  e.preventDefault();"
-    "  const text = document.getElementById('text').value.trim();"
-    "  if (!text) { alert('Please enter some text'); return; }"
-    "  const speed = parseFloat(document.getElementById('speed').value);"
-    "  const btn = document.getElementById('speakBtn');"
-    "  const result = document.getElementById('result');"
-    "  btn.disabled = true;"
-    "  btn.textContent = 'Speaking...';"
-    "  result.className = 'result warning';"
-    "  result.style.display = 'block';"
-    "  result.textContent = 'Generating speech...';"
-    "  try {"
-    "    const response = await fetch('/api/tts', {"
-    "      method: 'POST',"
-    "      headers: { 'Content-Type': 'application/json' },"
-    "      body: JSON.stringify({ text: text, speed: speed })"
-    "    });"
-    "    const data = await response.json();"
-    "    if (response.ok) {"
-    "      result.className = 'result success';"
-    "      result.textContent = 'Speech completed!';"
-    "    } else {"
-    "      result.className = 'result error';"
-    "      result.textContent = 'Error: ' + (data.error || 'Unknown error');"
-    "    }"
-    "  } catch (err) {"
-    "    result.className = 'result error';"
-    "    result.textContent = 'Network error: ' + err.message;"
-    "  }"
-    "  btn.disabled = false;"
-    "  btn.textContent = 'Speak';"
-    "});"
-    "loadProviders();"
-    "</script>"
-    "</body>"
-    "</html>";
-
-/* STT (Batch) HTML page content */
-static const char *STT_HTML =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<title>Batch STT - ESP32-P4</title>"
-    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-    COMMON_CSS
-    "<style>"
-    ".record-btn { width: 100%; }"
-    ".record-btn.recording { background: #27ae60; animation: pulse 1s infinite; }"
-    "@keyframes pulse { 0%, 100% { opacity: 1; } 50% { opacity: 0.7; } }"
-    "</style>"
-    "</head>"
-    "<body>"
-    SIDEBAR_HTML(ACTIVE_STT)
-    "<div class=\"main-content\">"
-    "<div class=\"page-header\">"
-    "<h1>Batch Speech-to-Text</h1>"
-    "<p class=\"subtitle\">Record audio, then transcribe via OpenAI Whisper</p>"
-    "</div>"
-    "<div class=\"card\">"
-    "<div class=\"status-bar\">"
-    "<strong>Status:</strong> <span id=\"stateText\">Idle</span> | <strong>Max Recording:</strong> 5 minutes"
-    "</div>"
-    "<div class=\"timer\" id=\"timer\">00:00</div>"
-    "<button id=\"recordBtn\" class=\"record-btn danger\">Start Recording</button>"
-    "<button id=\"resetBtn\" class=\"secondary\" style=\"display:none;width:100%;margin-top:10px\">New Recording</button>"
-    "<div id=\"result\" class=\"transcript-box\" style=\"margin-top:20px\">Press the button to start recording. Speak clearly into the microphone.</div>"
-    "</div>"
-    "</div>"
-    "<script>"
-    "let isRecording = false;"
-    "let timerInterval = null;"
-    "let startTime = 0;"
-    "let pollInterval = null;"
-    "const recordBtn = document.getElementById('recordBtn');"
-    "const resetBtn = document.getElementById('resetBtn');"
-    "const result = document.getElementById('result');"
-    "const stateText = document.getElementById('stateText');"
-    "const timer = document.getElementById('timer');"
-    "function updateTimer() {"
-    "  const elapsed = Math.floor((Date.now() - startTime) / 1000);"
-    "  const mins = Math.floor(elapsed / 60).toString().padStart(2, '0');"
-    "  const secs = (elapsed % 60).toString().padStart(2, '0');"
-    "  timer.textContent = mins + ':' + secs;"
-    "}"
-    "async function startRecording() {"
-    "  try {"
-    "    const resp = await fetch('/api/stt/start', { method: 'POST' });"
-    "    const data = await resp.json();"
-    "    if (resp.ok) {"
-    "      isRecording = true;"
-    "      recordBtn.textContent = 'Stop Recording';"
-    "      recordBtn.classList.add('recording');"
-    "      result.style.background = '#fff3e0';"
-    "      result.textContent = 'Recording... Speak now!';"
-    "      stateText.textContent = 'Recording';"
-    "      resetBtn.style.display = 'none';"
-    "      startTime = Date.now();"
-    "      timerInterval = setInterval(updateTimer, 100);"
-    "    } else {"
-    "      result.style.background = '#ffebee';"
-    "      result.textContent = 'Error: ' + (data.error || 'Failed to start recording');"
-    "    }"
-    "  } catch (err) {"
-    "    result.style.background = '#ffebee';"
-    "    result.textContent = 'Network error: ' + err.message;"
-    "  }"
-    "}"
-    "async function stopRecording() {"
-    "  clearInterval(timerInterval);"
-    "  isRecording = false;"
-    "  recordBtn.disabled = true;"
-    "  recordBtn.textContent = 'Processing...';"
-    "  recordBtn.classList.remove('recording');"
-    "  result.style.background = '#e3f2fd';"
-    "  result.textContent = 'Uploading and transcribing audio...';"
-    "  stateText.textContent = 'Transcribing';"
-    "  try {"
-    "    await fetch('/api/stt/stop', { method: 'POST' });"
-    "    pollInterval = setInterval(pollStatus, 500);"
-    "  } catch (err) {"
-    "    recordBtn.disabled = false;"
-    "    recordBtn.textContent = 'Start Recording';"
-    "    result.style.background = '#ffebee';"
-    "    result.textContent = 'Network error: ' + err.message;"
-    "  }"
-    "}"
-    "async function pollStatus() {"
-    "  try {"
-    "    const resp = await fetch('/api/stt/status');"
-    "    const data = await resp.json();"
-    "    if (data.state === 'done') {"
-    "      clearInterval(pollInterval);"
-    "      recordBtn.style.display = 'none';"
-    "      resetBtn.style.display = 'block';"
-    "      result.style.background = '#e8f5e9';"
-    "      result.textContent = data.transcription || '(No speech detected)';"
-    "      stateText.textContent = 'Done';"
-    "    } else if (data.state === 'error') {"
-    "      clearInterval(pollInterval);"
-    "      recordBtn.disabled = false;"
-    "      recordBtn.textContent = 'Start Recording';"
-    "      result.style.background = '#ffebee';"
-    "      result.textContent = 'Error: ' + (data.error || 'Unknown error');"
-    "      stateText.textContent = 'Error';"
-    "    } else if (data.state === 'transcribing') {"
-    "      result.textContent = 'Uploading and transcribing audio... (' + Math.round(data.audio_bytes/1024) + ' KB)';"
-    "    }"
-    "  } catch (err) { console.error('Poll error:', err); }"
-    "}"
-    "async function resetSTT() {"
-    "  try {"
-    "    await fetch('/api/stt/reset', { method: 'POST' });"
-    "  } catch (err) { console.error('Reset error:', err); }"
-    "  recordBtn.style.display = 'block';"
-    "  recordBtn.disabled = false;"
-    "  recordBtn.textContent = 'Start Recording';"
-    "  resetBtn.style.display = 'none';"
-    "  result.style.background = '#fafafa';"
-    "  result.textContent = 'Press the button to start recording. Speak clearly into the microphone.';"
-    "  stateText.textContent = 'Idle';"
-    "  timer.textContent = '00:00';"
-    "}"
-    "recordBtn.addEventListener('click', function() {"
-    "  if (isRecording) { stopRecording(); }"
-    "  else { startRecording(); }"
-    "});"
-    "resetBtn.addEventListener('click', resetSTT);"
-    "async function checkInitialState() {"
-    "  try {"
-    "    const resp = await fetch('/api/stt/status');"
-    "    const data = await resp.json();"
-    "    if (data.state === 'recording') {"
-    "      isRecording = true;"
-    "      recordBtn.textContent = 'Stop Recording';"
-    "      recordBtn.classList.add('recording');"
-    "      result.style.background = '#fff3e0';"
-    "      result.textContent = 'Recording in progress...';"
-    "      stateText.textContent = 'Recording';"
-    "      startTime = Date.now() - data.recording_ms;"
-    "      timerInterval = setInterval(updateTimer, 100);"
-    "    } else if (data.state === 'transcribing') {"
-    "      recordBtn.disabled = true;"
-    "      recordBtn.textContent = 'Processing...';"
-    "      result.style.background = '#e3f2fd';"
-    "      result.textContent = 'Transcribing audio...';"
-    "      stateText.textContent = 'Transcribing';"
-    "      pollInterval = setInterval(pollStatus, 500);"
-    "    } else if (data.state === 'done') {"
-    "      recordBtn.style.display = 'none';"
-    "      resetBtn.style.display = 'block';"
-    "      result.style.background = '#e8f5e9';"
-    "      result.textContent = data.transcription || '(No speech detected)';"
-    "      stateText.textContent = 'Done';"
-    "    } else if (data.state === 'error') {"
-    "      result.style.background = '#ffebee';"
-    "      result.textContent = 'Error: ' + (data.error || 'Unknown error');"
-    "      stateText.textContent = 'Error';"
-    "    }"
-    "  } catch (err) { console.error('Initial state check error:', err); }"
-    "}"
-    "checkInitialState();"
-    "</script>"
-    "</body>"
-    "</html>";
-
-/* Live STT HTML page content */
-static const char *LIVE_STT_HTML =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<title>Live STT - ESP32-P4</title>"
-    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-    COMMON_CSS
-    "<style>"
-    ".stream-btn { width: 100%; }"
-    ".stream-btn.streaming { background: #27ae60; animation: pulse 1s infinite; }"
-    "@keyframes pulse { 0%, 100% { opacity: 1; } 50% { opacity: 0.7; } }"
-    ".connection-status { display: inline-block; width: 10px; height: 10px; border-radius: 50%; margin-right: 8px; }"
-    ".connection-status.disconnected { background: #bdc3c7; }"
-    ".connection-status.connecting { background: #f39c12; animation: blink 1s infinite; }"
-    ".connection-status.connected { background: #27ae60; }"
-    "@keyframes blink { 0%, 100% { opacity: 1; } 50% { opacity: 0.3; } }"
-    "</style>"
-    "</head>"
-    "<body>"
-    SIDEBAR_HTML(ACTIVE_LIVE)
-    "<div class=\"main-content\">"
-    "<div class=\"page-header\">"
-    "<h1>Live Speech-to-Text</h1>"
-    "<p class=\"subtitle\">Real-time transcription via Deepgram</p>"
-    "</div>"
-    "<div class=\"card\">"
-    "<div class=\"status-bar\">"
-    "<span class=\"connection-status disconnected\" id=\"connStatus\"></span>"
-    "<strong>Status:</strong> <span id=\"stateText\">Idle</span>"
-    "</div>"
-    "<button id=\"streamBtn\" class=\"stream-btn success\">Start Streaming</button>"
-    "<div style=\"margin-top:15px\">"
-    "<button id=\"clearBtn\" class=\"secondary\" style=\"width:100%\">Clear Transcript</button>"
-    "</div>"
-    "<h3 style=\"margin-top:20px;margin-bottom:10px;color:#34495e\">Transcript</h3>"
-    "<div id=\"transcript\" class=\"transcript-box\">Transcription will appear here in real-time...</div>"
-    "</div>"
-    "</div>"
-    "<script>"
-    "let isStreaming = false;"
-    "let pollInterval = null;"
-    "const streamBtn = document.getElementById('streamBtn');"
-    "const clearBtn = document.getElementById('clearBtn');"
-    "const transcript = document.getElementById('transcript');"
-    "const stateText = document.getElementById('stateText');"
-    "const connStatus = document.getElementById('connStatus');"
-    "function updateUI(state, text) {"
-    "  stateText.textContent = state;"
-    "  connStatus.className = 'connection-status ' + (state === 'Streaming' ? 'connected' : state === 'Connecting' ? 'connecting' : 'disconnected');"
-    "  if (text !== undefined) transcript.textContent = text || 'Transcription will appear here in real-time...';"
-    "}"
-    "async function startStreaming() {"
-    "  try {"
-    "    streamBtn.disabled = true;"
-    "    updateUI('Connecting');"
-    "    const resp = await fetch('/api/live/start', { method: 'POST' });"
-    "    const data = await resp.json();"
-    "    if (resp.ok) {"
-    "      isStreaming = true;"
-    "      streamBtn.textContent = 'Stop Streaming';"
-    "      streamBtn.classList.remove('success');"
-    "      streamBtn.classList.add('streaming', 'danger');"
-    "      streamBtn.disabled = false;"
-    "      updateUI('Streaming');"
-    "      pollInterval = setInterval(pollTranscript, 300);"
-    "    } else {"
-    "      updateUI('Error');"
-    "      transcript.textContent = 'Error: ' + (data.error || 'Failed to start');"
-    "      streamBtn.disabled = false;"
-    "    }"
-    "  } catch (err) {"
-    "    updateUI('Error');"
-    "    transcript.textContent = 'Network error: ' + err.message;"
-    "    streamBtn.disabled = false;"
-    "  }"
-    "}"
-    "async function stopStreaming() {"
-    "  clearInterval(pollInterval);"
-    "  try {"
-    "    await fetch('/api/live/stop', { method: 'POST' });"
-    "  } catch (err) { console.error('Stop error:', err); }"
-    "  isStreaming = false;"
-    "  streamBtn.textContent = 'Start Streaming';"
-    "  streamBtn.classList.remove('streaming', 'danger');"
-    "  streamBtn.classList.add('success');"
-    "  streamBtn.disabled = false;"
-    "  updateUI('Idle');"
-    "}"
-    "async function pollTranscript() {"
-    "  try {"
-    "    const resp = await fetch('/api/live/status');"
-    "    const data = await resp.json();"
-    "    if (data.state === 'streaming') {"
-    "      if (data.transcript) transcript.textContent = data.transcript;"
-    "      transcript.scrollTop = transcript.scrollHeight;"
-    "    } else if (data.state === 'error') {"
-    "      clearInterval(pollInterval);"
-    "      isStreaming = false;"
-    "      streamBtn.textContent = 'Start Streaming';"
-    "      streamBtn.classList.remove('streaming', 'danger');"
-    "      streamBtn.classList.add('success');"
-    "      streamBtn.disabled = false;"
-    "      updateUI('Error');"
-    "      transcript.textContent = 'Error: ' + (data.error || 'Connection lost');"
-    "    } else if (data.state === 'idle') {"
-    "      clearInterval(pollInterval);"
-    "      isStreaming = false;"
-    "      streamBtn.textContent = 'Start Streaming';"
-    "      streamBtn.classList.remove('streaming', 'danger');"
-    "      streamBtn.classList.add('success');"
-    "      streamBtn.disabled = false;"
-    "      updateUI('Idle');"
-    "    }"
-    "  } catch (err) { console.error('Poll error:', err); }"
-    "}"
-    "async function clearTranscript() {"
-    "  try {"
-    "    await fetch('/api/live/clear', { method: 'POST' });"
-    "    transcript.textContent = 'Transcription will appear here in real-time...';"
-    "  } catch (err) { console.error('Clear error:', err); }"
-    "}"
-    "streamBtn.addEventListener('click', function() {"
-    "  if (isStreaming) { stopStreaming(); }"
-    "  else { startStreaming(); }"
-    "});"
-    "clearBtn.addEventListener('click', clearTranscript);"
-    "async function checkInitialState() {"
-    "  try {"
-    "    const resp = await fetch('/api/live/status');"
-    "    const data = await resp.json();"
-    "    if (data.state === 'streaming' || data.state === 'connecting') {"
-    "      isStreaming = true;"
-    "      streamBtn.textContent = 'Stop Streaming';"
-    "      streamBtn.classList.remove('success');"
-    "      streamBtn.classList.add('streaming', 'danger');"
-    "      updateUI(data.state === 'streaming' ? 'Streaming' : 'Connecting', data.transcript);"
-    "      pollInterval = setInterval(pollTranscript, 300);"
-    "    } else if (data.transcript) {"
-    "      transcript.textContent = data.transcript;"
-    "    }"
-    "  } catch (err) { console.error('Initial state check error:', err); }"
-    "}"
-    "checkInitialState();"
-    "</script>"
-    "</body>"
-    "</html>";
-
-/* OpenAI Live STT HTML page content */
-static const char *OPENAI_LIVE_STT_HTML =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<title>OpenAI Live STT - ESP32-P4</title>"
-    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-    COMMON_CSS
-    "<style>"
-    ".stream-btn { width: 100%; }"
-    ".stream-btn.streaming { background: #27ae60; animation: pulse 1s infinite; }"
-    "@keyframes pulse { 0%, 100% { opacity: 1; } 50% { opacity: 0.7; } }"
-    ".connection-status { display: inline-block; width: 10px; height: 10px; border-radius: 50%; margin-right: 8px; }"
-    ".connection-status.disconnected { background: #bdc3c7; }"
-    ".connection-status.connecting { background: #f39c12; animation: blink 1s infinite; }"
-    ".connection-status.connected { background: #27ae60; }"
-    "@keyframes blink { 0%, 100% { opacity: 1; } 50% { opacity: 0.3; } }"
-    "</style>"
-    "</head>"
-    "<body>"
-    SIDEBAR_HTML(ACTIVE_OPENAI)
-    "<div class=\"main-content\">"
-    "<div class=\"page-header\">"
-    "<h1>Live Speech-to-Text (OpenAI)</h1>"
-    "<p class=\"subtitle\">Real-time transcription via OpenAI Realtime API with Whisper</p>"
-    "</div>"
-    "<div class=\"card\">"
-    "<div class=\"status-bar\">"
-    "<span class=\"connection-status disconnected\" id=\"connStatus\"></span>"
-    "<strong>Status:</strong> <span id=\"stateText\">Idle</span>"
-    "</div>"
-    "<button id=\"streamBtn\" class=\"stream-btn success\">Start Streaming</button>"
-    "<div style=\"margin-top:15px\">"
-    "<button id=\"clearBtn\" class=\"secondary\" style=\"width:100%\">Clear Transcript</button>"
-    "</div>"
-    "<h3 style=\"margin-top:20px;margin-bottom:10px;color:#34495e\">Transcript</h3>"
-    "<div id=\"transcript\" class=\"transcript-box\">Transcription will appear here in real-time...</div>"
-    "</div>"
-    "</div>"
-    "<script>"
-    "let isStreaming = false;"
-    "let pollInterval = null;"
-    "const streamBtn = document.getElementById('streamBtn');"
-    "const clearBtn = document.getElementById('clearBtn');"
-    "const transcript = document.getElementById('transcript');"
-    "const stateText = document.getElementById('stateText');"
-    "const connStatus = document.getElementById('connStatus');"
-    "function updateUI(state, text) {"
-    "  stateText.textContent = state;"
-    "  connStatus.className = 'connection-status ' + (state === 'Streaming' ? 'connected' : state === 'Connecting' ? 'connecting' : 'disconnected');"
-    "  if (text !== undefined) transcript.textContent = text || 'Transcription will appear here in real-time...';"
-    "}"
-    "async function startStreaming() {"
-    "  try {"
-    "    streamBtn.disabled = true;"
-    "    updateUI('Connecting');"
-    "    const resp = await fetch('/api/openai-live/start', { method: 'POST' });"
-    "    const data = await resp.json();"
-    "    if (resp.ok) {"
-    "      isStreaming = true;"
-    "      streamBtn.textContent = 'Stop Streaming';"
-    "      streamBtn.classList.remove('success');"
-    "      streamBtn.classList.add('streaming', 'danger');"
-    "      streamBtn.disabled = false;"
-    "      updateUI('Streaming');"
-    "      pollInterval = setInterval(pollTranscript, 300);"
-    "    } else {"
-    "      updateUI('Error');"
-    "      transcript.textContent = 'Error: ' + (data.error || 'Failed to start');"
-    "      streamBtn.disabled = false;"
-    "    }"
-    "  } catch (err) {"
-    "    updateUI('Error');"
-    "    transcript.textContent = 'Network error: ' + err.message;"
-    "    streamBtn.disabled = false;"
-    "  }"
-    "}"
-    "async function stopStreaming() {"
-    "  clearInterval(pollInterval);"
-    "  try {"
-    "    await fetch('/api/openai-live/stop', { method: 'POST' });"
-    "  } catch (err) { console.error('Stop error:', err); }"
-    "  isStreaming = false;"
-    "  streamBtn.textContent = 'Start Streaming';"
-    "  streamBtn.classList.remove('streaming', 'danger');"
-    "  streamBtn.classList.add('success');"
-    "  streamBtn.disabled = false;"
-    "  updateUI('Idle');"
-    "}"
-    "async function pollTranscript() {"
-    "  try {"
-    "    const resp = await fetch('/api/openai-live/status');"
-    "    const data = await resp.json();"
-    "    if (data.state === 'streaming') {"
-    "      if (data.transcript) transcript.textContent = data.transcript;"
-    "      transcript.scrollTop = transcript.scrollHeight;"
-    "    } else if (data.state === 'error') {"
-    "      clearInterval(pollInterval);"
-    "      isStreaming = false;"
-    "      streamBtn.textContent = 'Start Streaming';"
-    "      streamBtn.classList.remove('streaming', 'danger');"
-    "      streamBtn.classList.add('success');"
-    "      streamBtn.disabled = false;"
-    "      updateUI('Error');"
-    "      transcript.textContent = 'Error: ' + (data.error || 'Connection lost');"
-    "    } else if (data.state === 'idle') {"
-    "      clearInterval(pollInterval);"
-    "      isStreaming = false;"
-    "      streamBtn.textContent = 'Start Streaming';"
-    "      streamBtn.classList.remove('streaming', 'danger');"
-    "      streamBtn.classList.add('success');"
-    "      streamBtn.disabled = false;"
-    "      updateUI('Idle');"
-    "    }"
-    "  } catch (err) { console.error('Poll error:', err); }"
-    "}"
-    "async function clearTranscript() {"
-    "  try {"
-    "    await fetch('/api/openai-live/clear', { method: 'POST' });"
-    "    transcript.textContent = 'Transcription will appear here in real-time...';"
-    "  } catch (err) { console.error('Clear error:', err); }"
-    "}"
-    "streamBtn.addEventListener('click', function() {"
-    "  if (isStreaming) { stopStreaming(); }"
-    "  else { startStreaming(); }"
-    "});"
-    "clearBtn.addEventListener('click', clearTranscript);"
-    "async function checkInitialState() {"
-    "  try {"
-    "    const resp = await fetch('/api/openai-live/status');"
-    "    const data = await resp.json();"
-    "    if (data.state === 'streaming' || data.state === 'connecting') {"
-    "      isStreaming = true;"
-    "      streamBtn.textContent = 'Stop Streaming';"
-    "      streamBtn.classList.remove('success');"
-    "      streamBtn.classList.add('streaming', 'danger');"
-    "      updateUI(data.state === 'streaming' ? 'Streaming' : 'Connecting', data.transcript);"
-    "      pollInterval = setInterval(pollTranscript, 300);"
-    "    } else if (data.transcript) {"
-    "      transcript.textContent = data.transcript;"
-    "    }"
-    "  } catch (err) { console.error('Initial state check error:', err); }"
-    "}"
-    "checkInitialState();"
-    "</script>"
-    "</body>"
-    "</html>";
-
-/* Settings HTML page content */
-static const char *SETTINGS_HTML =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<title>Settings - ESP32-P4</title>"
-    "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-    COMMON_CSS
-    "</head>"
-    "<body>"
-    SIDEBAR_HTML(ACTIVE_SETTINGS)
-    "<div class=\"main-content\">"
-    "<div class=\"page-header\">"
-    "<h1>Settings</h1>"
-    "<p class=\"subtitle\">System configuration and API status</p>"
-    "</div>"
-    "<div class=\"card\">"
-    "<h2>Audio Settings</h2>"
-    "<div class=\"control-group\">"
-    "<label for=\"volume\">Volume:</label>"
-    "<div class=\"slider-row\">"
-    "<input type=\"range\" id=\"volume\" name=\"volume\" min=\"0\" max=\"100\" step=\"5\" value=\"80\">"
-    "<span id=\"volumeVal\">80%</span>"
-    "</div>"
-    "</div>"
-    "</div>"
-    "<div class=\"card\">"
-    "<h2>API Configuration Status</h2>"
-    "<div id=\"apiStatus\">Loading...</div>"
-    "</div>"
-    "<div class=\"card\">"
-    "<h2>System Information</h2>"
-    "<div class=\"settings-row\">"
-    "<span class=\"label\">Board</span>"
-    "<span class=\"value\">Waveshare ESP32-P4-WIFI6-M</span>"
-    "</div>"
-    "<div class=\"settings-row\">"
-    "<span class=\"label\">Processor</span>"
-    "<span class=\"value\">ESP32-P4 + ESP32-C6 (WiFi)</span>"
-    "</div>"
-    "</div>"
-    "</div>"
-    "<script>"
-    "const volumeSlider = document.getElementById('volume');"
-    "const volumeVal = document.getElementById('volumeVal');"
-    "volumeSlider.addEventListener('input', function() {"
-    "  volumeVal.textContent = this.value + '%';"
-    "});"
-    "volumeSlider.addEventListener('change', async function() {"
-    "  try {"
-    "    await fetch('/api/volume', {"
-    "      method: 'POST',"
-    "      headers: { 'Content-Type': 'application/json' },"
-    "      body: JSON.stringify({ volume: parseInt(this.value) })"
-    "    });"
-    "  } catch (err) { console.error('Volume error:', err); }"
-    "});"
-    "async function loadSettings() {"
-    "  try {"
-    "    const resp = await fetch('/api/settings');"
-    "    const data = await resp.json();"
-    "    let html = '';"
-    "    data.apis.forEach(api => {"
-    "      const statusClass = api.configured ? 'configured' : 'not-configured';"
-    "      const statusText = api.configured ? 'Configured' : 'Not Configured';"
-    "      html += '<div class=\"settings-row\">';"
-    "      html += '<span class=\"label\">' + api.name + '</span>';"
-    "      html += '<span class=\"value ' + statusClass + '\">' + statusText + '</span>';"
-    "      html += '</div>';"
-    "    });"
-    "    document.getElementById('apiStatus').innerHTML = html;"
-    "  } catch (err) {"
-    "    document.getElementById('apiStatus').innerHTML = '<span class=\"value not-configured\">Failed to load</span>';"
-    "  }"
-    "}"
-    "loadSettings();"
-    "</script>"
-    "</body>"
-    "</html>";
-
-/* Handler for root path "/" - TTS page */
-static esp_err_t root_get_handler(httpd_req_t *req)
+#define TTS_JOBS_LIST_MAX 24    // Jobs reported by /api/tts/jobs
+#define URI_HANDLERS_SPARE 8    // Unused handler slots
+#define STATUS_JSON_SIZE 1536   // On the stack; a larger status is formatted again on the heap
+
+// httpd reserves three sockets of its own; outgoing TLS needs the rest
+_Static_assert(CONFIG_HTTP_SERVER_MAX_SOCKETS + 3 <= CONFIG_LWIP_MAX_SOCKETS,
+               "HTTP_SERVER_MAX_SOCKETS does not fit in LWIP_MAX_SOCKETS");
+
+static metrics_metric_t s_m_sessions_open = METRICS_GAUGE_INIT(
+    "httpd_sessions_open", "Open HTTP server sockets", NULL, NULL);
+static metrics_metric_t s_m_sessions = METRICS_COUNTER_INIT(
+    "httpd_sessions_total", "Accepted HTTP server sockets", NULL, NULL);
+
+// Engine statistics are mirrored into the registry on every scrape
+static metrics_metric_t s_m_capture_overruns = METRICS_COUNTER_INIT(
+    "audio_capture_overruns_total", "Capture periods dropped because a client did not read in time", NULL, NULL);
+static metrics_metric_t s_m_playback_underruns = METRICS_COUNTER_INIT(
+    "audio_playback_underruns_total", "Playback periods padded with silence mid-stream", NULL, NULL);
+static metrics_metric_t s_m_io_errors = METRICS_COUNTER_INIT(
+    "audio_io_errors_total", "Codec read/write failures", NULL, NULL);
+static metrics_metric_t s_m_capture_streams = METRICS_GAUGE_INIT(
+    "audio_streams_open", "Open engine streams", "direction", "capture");
+static metrics_metric_t s_m_playback_streams = METRICS_GAUGE_INIT(
+    "audio_streams_open", "Open engine streams", "direction", "playback");
+
+/* Handler for the web UI pages and /static/ assets; user_ctx is the asset name */
+static esp_err_t web_asset_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Serving TTS page");
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, TTS_HTML, strlen(TTS_HTML));
-    return ESP_OK;
+    const web_asset_t *asset = web_asset_find((const char *)req->user_ctx);
+    if (asset == NULL) {
+        ESP_LOGE(TAG, "Asset %s not embedded", (const char *)req->user_ctx);
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+    }
+
+    // Pages revalidate on every load so a firmware update shows up at once;
+    // the stylesheet and scripts they reference are cached for an hour
+    bool page = strncmp(req->uri, "/static/", 8) != 0;
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", page ? "no-cache" : "public, max-age=3600");
+
+    char if_none_match[48];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        strstr(if_none_match, asset->etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    // Every browser accepts gzip; there is no uncompressed copy to fall back to
+    ESP_LOGD(TAG, "Serving %s (%u bytes, %u uncompressed)", asset->name,
+             (unsigned)asset->len, (unsigned)asset->raw_len);
+    httpd_resp_set_type(req, asset->content_type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char *)asset->data, asset->len);
+}
+
+/* Status JSON output; counts the full length even when the buffer is too small */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} status_out_t;
+
+static void status_printf(status_out_t *out, const char *fmt, ...)
+{
+    size_t room = out->len < out->size ? out->size - out->len : 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(room ? out->buf + out->len : NULL, room, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        out->len += n;
+    }
+}
+
+static void status_format(status_out_t *out)
+{
+    out->len = 0;
+    status_printf(out, "{\"status\":\"ok\",\"board\":\"ESP32-P4-WIFI6-M\",\"tts_provider\":\"%s\",\"http_pool\":{",
+                  tts_get_provider_name(tts_get_provider()));
+
+    for (int host = 0; host < HTTP_POOL_HOST_MAX; host++) {
+        http_pool_stats_t stats;
+        http_pool_get_stats((http_pool_host_t)host, &stats);
+        status_printf(out, "%s\"%s\":{\"handshakes\":%lu,\"reuses\":%lu,\"warmups\":%lu,\"retries\":%lu}",
+                      host > 0 ? "," : "", http_pool_host_name((http_pool_host_t)host),
+                      (unsigned long)stats.handshakes, (unsigned long)stats.reuses,
+                      (unsigned long)stats.warmups, (unsigned long)stats.retries);
+    }
+
+    audio_engine_stats_t engine;
+    audio_engine_get_stats(&engine);
+    audio_engine_vad_t vad;
+    audio_engine_vad_get(&vad);
+    status_printf(out, "},\"audio_engine\":{\"sample_rate\":%lu,\"capture_streams\":%lu,"
+                  "\"playback_streams\":%lu,\"capture_overruns\":%lu,\"playback_underruns\":%lu,"
+                  "\"io_errors\":%lu,\"vad\":{\"speech\":%s,\"level_db\":%ld,\"noise_db\":%ld}}",
+                  (unsigned long)engine.sample_rate, (unsigned long)engine.capture_streams,
+                  (unsigned long)engine.playback_streams, (unsigned long)engine.capture_overruns,
+                  (unsigned long)engine.playback_underruns, (unsigned long)engine.io_errors,
+                  vad.speech ? "true" : "false", (long)vad.level_db, (long)vad.noise_db);
+
+    tts_cache_stats_t cache;
+    tts_cache_get_stats(&cache);
+    status_printf(out, ",\"tts_cache\":{\"hits\":%lu,\"disk_hits\":%lu,\"misses\":%lu,\"inserts\":%lu,"
+                  "\"evictions\":%lu,\"spills\":%lu,\"entries\":%lu,\"bytes\":%lu,\"budget\":%lu}",
+                  (unsigned long)cache.hits, (unsigned long)cache.disk_hits,
+                  (unsigned long)cache.misses, (unsigned long)cache.inserts,
+                  (unsigned long)cache.evictions, (unsigned long)cache.spills,
+                  (unsigned long)cache.entries, (unsigned long)cache.bytes,
+                  (unsigned long)cache.budget);
+
+    status_printf(out, ",\"audio_pool\":{");
+    for (int arena = 0; arena < AUDIO_POOL_MAX; arena++) {
+        audio_pool_stats_t pool;
+        audio_pool_get_stats((audio_pool_arena_t)arena, &pool);
+        status_printf(out, "%s\"%s\":{\"block_size\":%lu,\"blocks\":%lu,\"used\":%lu,\"high_water\":%lu,"
+                      "\"allocs\":%lu,\"fallbacks\":%lu,\"failures\":%lu}",
+                      arena > 0 ? "," : "", audio_pool_arena_name((audio_pool_arena_t)arena),
+                      (unsigned long)pool.block_size, (unsigned long)pool.blocks,
+                      (unsigned long)pool.used, (unsigned long)pool.high_water,
+                      (unsigned long)pool.allocs, (unsigned long)pool.fallbacks,
+                      (unsigned long)pool.failures);
+    }
+
+    wake_word_stats_t wake;
+    wake_word_get_stats(&wake);
+    status_printf(out, "},\"wake_word\":{\"running\":%s,\"word\":\"%s\",\"action\":\"%s\",\"detections\":%lu,"
+                  "\"ignored\":%lu,\"start_failures\":%lu,\"load_pct\":%lu,\"detect_us\":%lu,"
+                  "\"detect_max_us\":%lu,\"frame_ms\":%lu,\"latency_ms\":%lu,\"latency_max_ms\":%lu",
+                  wake.running ? "true" : "false", wake.word ? wake.word : "",
+                  wake.action ? wake.action : "", (unsigned long)wake.detections,
+                  (unsigned long)wake.ignored, (unsigned long)wake.start_failures,
+                  (unsigned long)wake.load_pct, (unsigned long)wake.detect_us,
+                  (unsigned long)wake.detect_max_us, (unsigned long)wake.frame_ms,
+                  (unsigned long)wake.latency_ms, (unsigned long)wake.latency_max_ms);
+    status_printf(out, "}}");
 }
 
 /* Handler for "/api/status" */
@@ -832,14 +181,91 @@ static esp_err_t status_get_handler(httpd_req_t *req)
     ESP_LOGI(TAG, "Serving status API");
     httpd_resp_set_type(req, "application/json");
 
-    char json[256];
-    snprintf(json, sizeof(json),
-             "{\"status\":\"ok\",\"board\":\"ESP32-P4-WIFI6-M\",\"tts_provider\":\"%s\"}",
-             tts_get_provider_name(tts_get_provider()));
-    httpd_resp_send(req, json, strlen(json));
+    // Counters can grow between passes, so retry until the whole object fits
+    char json[STATUS_JSON_SIZE];
+    status_out_t out = { .buf = json, .size = sizeof(json) };
+    status_format(&out);
+    char *heap = NULL;
+    while (out.len >= out.size) {
+        free(heap);
+        out.size = out.len + 64;
+        heap = malloc(out.size);
+        if (!heap) {
+            return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        }
+        out.buf = heap;
+        status_format(&out);
+    }
+
+    httpd_resp_send(req, out.buf, out.len);
+    free(heap);
+    return ESP_OK;
+}
+
+/* Write callback for the metrics exporters */
+static esp_err_t metrics_send_chunk(const char *data, size_t len, void *ctx)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+/* Handler for "/api/metrics" - JSON, or Prometheus text with ?format=prometheus or a text Accept header */
+static esp_err_t metrics_get_handler(httpd_req_t *req)
+{
+    // Streaming the export takes a while over slow WiFi
+    if (!http_workers_in_worker()) {
+        return http_workers_submit(req, metrics_get_handler);
+    }
+
+    bool prometheus = false;
+    char query[32];
+    char format[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", format, sizeof(format)) == ESP_OK) {
+        prometheus = strcmp(format, "prometheus") == 0;
+    } else {
+        char accept[96];
+        if (httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)) != ESP_ERR_NOT_FOUND) {
+            prometheus = strstr(accept, "text/plain") || strstr(accept, "openmetrics");
+        }
+    }
+
+    audio_engine_stats_t engine;
+    audio_engine_get_stats(&engine);
+    metrics_set(&s_m_capture_overruns, engine.capture_overruns);
+    metrics_set(&s_m_playback_underruns, engine.playback_underruns);
+    metrics_set(&s_m_io_errors, engine.io_errors);
+    metrics_set(&s_m_capture_streams, engine.capture_streams);
+    metrics_set(&s_m_playback_streams, engine.playback_streams);
+
+    esp_err_t err;
+    if (prometheus) {
+        httpd_resp_set_type(req, "text/plain; version=0.0.4");
+        err = metrics_write_prometheus(metrics_send_chunk, req);
+    } else {
+        httpd_resp_set_type(req, "application/json");
+        err = metrics_write_json(metrics_send_chunk, req);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Metrics export failed: %s", esp_err_to_name(err));
+        return ESP_FAIL;  // Response is half sent; drop the connection
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* Session hooks, for the connection metrics */
+static esp_err_t session_open(httpd_handle_t hd, int sockfd)
+{
+    metrics_inc(&s_m_sessions);
+    metrics_inc(&s_m_sessions_open);
     return ESP_OK;
 }
 
+static void session_close(httpd_handle_t hd, int sockfd)
+{
+    metrics_add(&s_m_sessions_open, -1);
+    close(sockfd);  // A close_fn replaces the server's own close
+}
+
 /* Handler for "/api/provider" GET - returns available providers */
 static esp_err_t provider_get_handler(httpd_req_t *req)
 {
@@ -966,40 +392,12 @@ static esp_err_t provider_post_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* TTS task - runs TTS with sufficient stack, signals completion */
-typedef struct {
-    char *text;
-    float speed;
-    SemaphoreHandle_t done_sem;
-    esp_err_t result;
-} tts_task_params_t;
-
-static void tts_background_task(void *arg)
-{
-    tts_task_params_t *params = (tts_task_params_t *)arg;
-
-    ESP_LOGI(TAG, "TTS background task: speaking '%.*s%s' at speed %.1fx",
-             50, params->text, strlen(params->text) > 50 ? "..." : "", params->speed);
-
-    params->result = tts_speak_with_speed(params->text, params->speed);
-    if (params->result != ESP_OK) {
-        ESP_LOGE(TAG, "TTS speak failed: %s", esp_err_to_name(params->result));
-    }
-
-    free(params->text);
-    params->text = NULL;
-
-    // Signal completion
-    xSemaphoreGive(params->done_sem);
-    vTaskDelete(NULL);
-}
-
 /* Handler for "/api/tts" POST */
 static esp_err_t tts_post_handler(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "TTS API called");
 
-    // Initialize TTS on first call
+    // Initialize TTS and its worker on first call
     if (!tts_initialized) {
         esp_err_t err = tts_init();
         if (err != ESP_OK) {
@@ -1012,12 +410,10 @@ static esp_err_t tts_post_handler(httpd_req_t *req)
         }
         tts_initialized = true;
     }
-
-    // Check if TTS is already playing
-    if (tts_is_playing()) {
+    if (tts_queue_init() != ESP_OK) {
         httpd_resp_set_type(req, "application/json");
-        httpd_resp_set_status(req, "409 Conflict");
-        const char *error = "{\"error\":\"TTS is already speaking\"}";
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        const char *error = "{\"error\":\"TTS queue unavailable\"}";
         httpd_resp_send(req, error, strlen(error));
         return ESP_OK;
     }
@@ -1082,106 +478,195 @@ static esp_err_t tts_post_handler(httpd_req_t *req)
         // Speed clamping is done in tts_speak_with_speed based on provider
     }
 
-    // Copy text for background task
-    char *text_copy = strdup(text_item->valuestring);
-    cJSON_Delete(root);
-
-    if (!text_copy) {
+    // Get optional priority ("low", "normal", "alert")
+    tts_priority_t priority = TTS_PRIORITY_NORMAL;
+    cJSON *priority_item = cJSON_GetObjectItem(root, "priority");
+    if (priority_item && cJSON_IsString(priority_item) &&
+        !tts_queue_parse_priority(priority_item->valuestring, &priority)) {
+        cJSON_Delete(root);
         httpd_resp_set_type(req, "application/json");
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        const char *error = "{\"error\":\"Memory allocation failed\"}";
+        httpd_resp_set_status(req, "400 Bad Request");
+        const char *error = "{\"error\":\"Invalid 'priority' (low, normal, alert)\"}";
         httpd_resp_send(req, error, strlen(error));
         return ESP_OK;
     }
 
-    // Create semaphore for completion notification
-    SemaphoreHandle_t done_sem = xSemaphoreCreateBinary();
-    if (!done_sem) {
-        free(text_copy);
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        const char *error = "{\"error\":\"Memory allocation failed\"}";
+    // The queue copies the text; speaking happens on its worker
+    uint32_t job_id = 0;
+    esp_err_t err = tts_queue_submit(text_item->valuestring, speed, priority, &job_id);
+    cJSON_Delete(root);
+
+    httpd_resp_set_type(req, "application/json");
+    if (err != ESP_OK) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        const char *error = "{\"error\":\"TTS queue is full\"}";
         httpd_resp_send(req, error, strlen(error));
         return ESP_OK;
     }
 
-    // Create task params
-    tts_task_params_t *params = malloc(sizeof(tts_task_params_t));
-    if (!params) {
-        free(text_copy);
-        vSemaphoreDelete(done_sem);
+    tts_job_info_t info = {0};
+    tts_queue_get_job(job_id, &info);
+
+    char response[128];
+    snprintf(response, sizeof(response),
+             "{\"job_id\":%lu,\"status\":\"%s\",\"priority\":\"%s\",\"position\":%lu}",
+             (unsigned long)job_id, tts_queue_state_name(info.state),
+             tts_queue_priority_name(priority), (unsigned long)info.position);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_send(req, response, strlen(response));
+    return ESP_OK;
+}
+
+/**
+ * Add one job snapshot to a JSON object
+ */
+static void add_job_json(cJSON *obj, const tts_job_info_t *job, int64_t now_us)
+{
+    cJSON_AddNumberToObject(obj, "id", job->id);
+    cJSON_AddStringToObject(obj, "state", tts_queue_state_name(job->state));
+    cJSON_AddStringToObject(obj, "priority", tts_queue_priority_name(job->priority));
+    cJSON_AddStringToObject(obj, "text", job->preview);
+    if (job->state == TTS_JOB_QUEUED) {
+        cJSON_AddNumberToObject(obj, "position", job->position);
+    }
+    cJSON_AddNumberToObject(obj, "age_ms", (double)((now_us - job->queued_us) / 1000));
+    if (job->started_us) {
+        cJSON_AddNumberToObject(obj, "wait_ms", (double)((job->started_us - job->queued_us) / 1000));
+    }
+    if (job->finished_us && job->started_us) {
+        cJSON_AddNumberToObject(obj, "duration_ms", (double)((job->finished_us - job->started_us) / 1000));
+    }
+    if (job->state == TTS_JOB_FAILED) {
+        cJSON_AddStringToObject(obj, "error", esp_err_to_name(job->result));
+    }
+}
+
+/* Handler for "/api/tts/jobs" GET (optional ?id=N for one job) */
+static esp_err_t tts_jobs_handler(httpd_req_t *req)
+{
+    int64_t now_us = esp_timer_get_time();
+    httpd_resp_set_type(req, "application/json");
+
+    char query[32];
+    char id_str[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "id", id_str, sizeof(id_str)) == ESP_OK) {
+        tts_job_info_t job;
+        if (tts_queue_get_job((uint32_t)strtoul(id_str, NULL, 10), &job) != ESP_OK) {
+            httpd_resp_set_status(req, "404 Not Found");
+            const char *error = "{\"error\":\"Unknown job\"}";
+            httpd_resp_send(req, error, strlen(error));
+            return ESP_OK;
+        }
+        cJSON *obj = cJSON_CreateObject();
+        add_job_json(obj, &job, now_us);
+        char *json_str = cJSON_PrintUnformatted(obj);
+        cJSON_Delete(obj);
+        httpd_resp_send(req, json_str, json_str ? strlen(json_str) : 0);
+        free(json_str);
+        return ESP_OK;
+    }
+
+    tts_queue_stats_t stats;
+    tts_queue_get_stats(&stats);
+
+    cJSON *root = cJSON_CreateObject();
+    if (stats.current_id) {
+        cJSON_AddNumberToObject(root, "current", stats.current_id);
+    } else {
+        cJSON_AddNullToObject(root, "current");
+    }
+
+    cJSON *st = cJSON_AddObjectToObject(root, "queue");
+    cJSON_AddNumberToObject(st, "depth", stats.depth);
+    cJSON_AddNumberToObject(st, "max_depth", stats.max_depth);
+    cJSON_AddNumberToObject(st, "capacity", stats.capacity);
+    cJSON_AddNumberToObject(st, "submitted", stats.submitted);
+    cJSON_AddNumberToObject(st, "completed", stats.completed);
+    cJSON_AddNumberToObject(st, "failed", stats.failed);
+    cJSON_AddNumberToObject(st, "cancelled", stats.cancelled);
+    cJSON_AddNumberToObject(st, "preempted", stats.preempted);
+    cJSON_AddNumberToObject(st, "rejected", stats.rejected);
+
+    tts_job_info_t *jobs = malloc(TTS_JOBS_LIST_MAX * sizeof(tts_job_info_t));
+    cJSON *arr = cJSON_AddArrayToObject(root, "jobs");
+    if (jobs) {
+        size_t count = tts_queue_list(jobs, TTS_JOBS_LIST_MAX);
+        for (size_t i = 0; i < count; i++) {
+            cJSON *obj = cJSON_CreateObject();
+            add_job_json(obj, &jobs[i], now_us);
+            cJSON_AddItemToArray(arr, obj);
+        }
+        free(jobs);
+    }
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    httpd_resp_send(req, json_str, json_str ? strlen(json_str) : 0);
+    free(json_str);
+    return ESP_OK;
+}
+
+/* Handler for POST /api/settings - Update runtime settings */
+static esp_err_t settings_post_handler(httpd_req_t *req)
+{
+    ESP_LOGI(TAG, "Settings update called");
+
+    // Read request body
+    int content_len = req->content_len;
+    if (content_len <= 0 || content_len > 256) {
         httpd_resp_set_type(req, "application/json");
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        const char *error = "{\"error\":\"Memory allocation failed\"}";
+        httpd_resp_set_status(req, "400 Bad Request");
+        const char *error = "{\"error\":\"Invalid content length\"}";
         httpd_resp_send(req, error, strlen(error));
         return ESP_OK;
     }
-    params->text = text_copy;
-    params->speed = speed;
-    params->done_sem = done_sem;
-    params->result = ESP_OK;
-
-    // Calculate dynamic timeout based on text length and speed
-    // ~12 chars/second at 1.0x speed, adjust for speed setting
-    // Add 60 seconds buffer for download and processing overhead
-    size_t text_len = strlen(text_copy);
-    float effective_speed = (speed > 0.25f) ? speed : 1.0f;
-    float chars_per_second = 12.0f * effective_speed;
-    uint32_t estimated_duration_ms = (uint32_t)((text_len / chars_per_second) * 1000);
-    uint32_t timeout_ms = estimated_duration_ms + 60000;  // Add 60s buffer
-    if (timeout_ms < 30000) timeout_ms = 30000;  // Minimum 30 seconds
-    ESP_LOGI(TAG, "TTS timeout set to %lu ms for %d chars at %.2fx speed",
-             (unsigned long)timeout_ms, text_len, speed);
-
-    // Start TTS in background task (needs large stack for HTTPS)
-    BaseType_t task_created = xTaskCreate(
-        tts_background_task,
-        "tts_bg",
-        16384,
-        params,
-        5,
-        NULL
-    );
-
-    if (task_created != pdPASS) {
-        free(text_copy);
-        free(params);
-        vSemaphoreDelete(done_sem);
+
+    char buf[257];
+    int received = httpd_req_recv(req, buf, content_len);
+    if (received <= 0) {
         httpd_resp_set_type(req, "application/json");
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        const char *error = "{\"error\":\"Failed to start TTS task\"}";
+        httpd_resp_set_status(req, "400 Bad Request");
+        const char *error = "{\"error\":\"Failed to read request body\"}";
         httpd_resp_send(req, error, strlen(error));
         return ESP_OK;
     }
+    buf[received] = '\0';
 
-    // Wait for TTS to complete with dynamic timeout
-    if (xSemaphoreTake(done_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
-        ESP_LOGE(TAG, "TTS timeout");
-        tts_stop();
-        vSemaphoreDelete(done_sem);
-        free(params);
+    cJSON *root = cJSON_Parse(buf);
+    if (!root) {
         httpd_resp_set_type(req, "application/json");
-        httpd_resp_set_status(req, "504 Gateway Timeout");
-        const char *error = "{\"error\":\"TTS timeout\"}";
+        httpd_resp_set_status(req, "400 Bad Request");
+        const char *error = "{\"error\":\"Invalid JSON\"}";
         httpd_resp_send(req, error, strlen(error));
         return ESP_OK;
     }
 
-    // Get result and clean up
-    esp_err_t tts_result = params->result;
-    vSemaphoreDelete(done_sem);
-    free(params);
+    cJSON *bitrate_item = cJSON_GetObjectItem(root, "opus_bitrate");
+    if (bitrate_item) {
+        if (!cJSON_IsNumber(bitrate_item) || audio_encoder_set_bitrate(bitrate_item->valueint) != ESP_OK) {
+            cJSON_Delete(root);
+            httpd_resp_set_type(req, "application/json");
+            httpd_resp_set_status(req, "400 Bad Request");
+            const char *error = "{\"error\":\"'opus_bitrate' must be 6000-64000\"}";
+            httpd_resp_send(req, error, strlen(error));
+            return ESP_OK;
+        }
+    }
 
-    // Send response based on result
-    httpd_resp_set_type(req, "application/json");
-    if (tts_result == ESP_OK) {
-        const char *success = "{\"status\":\"completed\"}";
-        httpd_resp_send(req, success, strlen(success));
-    } else {
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        const char *error = "{\"error\":\"TTS playback failed\"}";
-        httpd_resp_send(req, error, strlen(error));
+    cJSON *enabled_item = cJSON_GetObjectItem(root, "opus_enabled");
+    if (enabled_item && cJSON_IsBool(enabled_item)) {
+        audio_encoder_set_opus_enabled(cJSON_IsTrue(enabled_item));
     }
+    cJSON_Delete(root);
+
+    // Changes apply to the next recording or live session
+    httpd_resp_set_type(req, "application/json");
+    char response[96];
+    snprintf(response, sizeof(response), "{\"opus_enabled\":%s,\"opus_bitrate\":%lu}",
+             audio_encoder_opus_enabled() ? "true" : "false",
+             (unsigned long)audio_encoder_get_bitrate());
+    httpd_resp_send(req, response, strlen(response));
     return ESP_OK;
 }
 
@@ -1260,15 +745,6 @@ static esp_err_t volume_post_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for GET /stt - STT page */
-static esp_err_t stt_page_handler(httpd_req_t *req)
-{
-    ESP_LOGI(TAG, "Serving STT page");
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, STT_HTML, strlen(STT_HTML));
-    return ESP_OK;
-}
-
 /* Handler for POST /api/stt/start */
 static esp_err_t stt_start_handler(httpd_req_t *req)
 {
@@ -1288,11 +764,33 @@ static esp_err_t stt_start_handler(httpd_req_t *req)
         stt_initialized = true;
     }
 
-    esp_err_t err = stt_start_recording();
+    // Optional body: {"mode":"batch"|"pipelined"}
+    stt_mode_t mode = STT_MODE_BATCH;
+    int content_len = req->content_len;
+    if (content_len > 0 && content_len <= 256) {
+        char buf[257];
+        int received = httpd_req_recv(req, buf, content_len);
+        if (received > 0) {
+            buf[received] = '\0';
+            cJSON *root = cJSON_Parse(buf);
+            if (root) {
+                cJSON *mode_item = cJSON_GetObjectItem(root, "mode");
+                if (mode_item && cJSON_IsString(mode_item) &&
+                    strcmp(mode_item->valuestring, "pipelined") == 0) {
+                    mode = STT_MODE_PIPELINED;
+                }
+                cJSON_Delete(root);
+            }
+        }
+    }
+
+    esp_err_t err = stt_start_recording_mode(mode);
 
     httpd_resp_set_type(req, "application/json");
     if (err == ESP_OK) {
-        const char *response = "{\"status\":\"recording\"}";
+        const char *response = (mode == STT_MODE_PIPELINED) ?
+                               "{\"status\":\"recording\",\"mode\":\"pipelined\"}" :
+                               "{\"status\":\"recording\",\"mode\":\"batch\"}";
         httpd_resp_send(req, response, strlen(response));
     } else {
         httpd_resp_set_status(req, "400 Bad Request");
@@ -1333,16 +831,8 @@ static esp_err_t stt_status_handler(httpd_req_t *req)
 
     cJSON *root = cJSON_CreateObject();
 
-    const char *state_str;
-    switch (status.state) {
-        case STT_STATE_IDLE: state_str = "idle"; break;
-        case STT_STATE_RECORDING: state_str = "recording"; break;
-        case STT_STATE_TRANSCRIBING: state_str = "transcribing"; break;
-        case STT_STATE_DONE: state_str = "done"; break;
-        case STT_STATE_ERROR: state_str = "error"; break;
-        default: state_str = "unknown"; break;
-    }
-    cJSON_AddStringToObject(root, "state", state_str);
+    cJSON_AddStringToObject(root, "state", stt_state_name(status.state));
+    cJSON_AddStringToObject(root, "mode", status.mode == STT_MODE_PIPELINED ? "pipelined" : "batch");
 
     if (status.transcription) {
         cJSON_AddStringToObject(root, "transcription", status.transcription);
@@ -1384,24 +874,6 @@ static esp_err_t stt_reset_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for GET /live - Live STT page */
-static esp_err_t live_page_handler(httpd_req_t *req)
-{
-    ESP_LOGI(TAG, "Serving Live STT page");
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, LIVE_STT_HTML, strlen(LIVE_STT_HTML));
-    return ESP_OK;
-}
-
-/* Handler for GET /settings - Settings page */
-static esp_err_t settings_page_handler(httpd_req_t *req)
-{
-    ESP_LOGI(TAG, "Serving Settings page");
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, SETTINGS_HTML, strlen(SETTINGS_HTML));
-    return ESP_OK;
-}
-
 /* Handler for GET /api/settings - Get API configuration status */
 static esp_err_t settings_api_handler(httpd_req_t *req)
 {
@@ -1440,6 +912,17 @@ static esp_err_t settings_api_handler(httpd_req_t *req)
 
     cJSON_AddItemToObject(root, "apis", apis);
 
+    // Upload compression
+    cJSON *opus = cJSON_CreateObject();
+#ifdef CONFIG_AUDIO_ENCODER_OPUS
+    cJSON_AddBoolToObject(opus, "available", true);
+#else
+    cJSON_AddBoolToObject(opus, "available", false);
+#endif
+    cJSON_AddBoolToObject(opus, "enabled", audio_encoder_opus_enabled());
+    cJSON_AddNumberToObject(opus, "bitrate", audio_encoder_get_bitrate());
+    cJSON_AddItemToObject(root, "opus", opus);
+
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
 
@@ -1450,24 +933,34 @@ static esp_err_t settings_api_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for POST /api/live/start */
+/**
+ * Live STT provider of a /api/live or /api/openai-live route
+ */
+static live_stt_provider_t live_provider(httpd_req_t *req)
+{
+    return (live_stt_provider_t)(intptr_t)req->user_ctx;
+}
+
+/* Handler for POST /api/live/start and /api/openai-live/start */
 static esp_err_t live_start_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Live STT start API called");
+    live_stt_provider_t provider = live_provider(req);
+    ESP_LOGI(TAG, "%s live STT start API called", live_stt_provider_name(provider));
 
-    esp_err_t err = live_stt_start();
+    esp_err_t err = live_stt_start(provider);
 
     httpd_resp_set_type(req, "application/json");
     if (err == ESP_OK) {
         const char *response = "{\"status\":\"starting\"}";
         httpd_resp_send(req, response, strlen(response));
     } else if (err == ESP_ERR_INVALID_STATE) {
-        // Check if it's because API key is not configured
-        live_stt_status_t status;
-        live_stt_get_status(&status);
-        if (status.error_message && strstr(status.error_message, "API key")) {
+        if (!live_stt_is_busy(provider)) {
+            // Not streaming, so the API key is missing
             httpd_resp_set_status(req, "400 Bad Request");
-            const char *response = "{\"error\":\"Deepgram API key not configured. Use 'idf.py menuconfig' to set it.\"}";
+            char response[128];
+            snprintf(response, sizeof(response),
+                     "{\"error\":\"%s API key not configured. Use 'idf.py menuconfig' to set it.\"}",
+                     live_stt_provider_name(provider));
             httpd_resp_send(req, response, strlen(response));
         } else {
             httpd_resp_set_status(req, "409 Conflict");
@@ -1478,7 +971,7 @@ static esp_err_t live_start_handler(httpd_req_t *req)
         httpd_resp_set_status(req, "500 Internal Server Error");
         char response[256];
         live_stt_status_t status;
-        live_stt_get_status(&status);
+        live_stt_get_status(provider, &status);
         snprintf(response, sizeof(response),
                  "{\"error\":\"%s\"}", status.error_message ? status.error_message : "Failed to start streaming");
         httpd_resp_send(req, response, strlen(response));
@@ -1486,12 +979,18 @@ static esp_err_t live_start_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for POST /api/live/stop */
+/* Handler for POST /api/live/stop and /api/openai-live/stop */
 static esp_err_t live_stop_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Live STT stop API called");
+    // Waits up to 5 s for the streaming task to close its socket
+    if (!http_workers_in_worker()) {
+        return http_workers_submit(req, live_stop_handler);
+    }
+
+    live_stt_provider_t provider = live_provider(req);
+    ESP_LOGI(TAG, "%s live STT stop API called", live_stt_provider_name(provider));
 
-    live_stt_stop();
+    live_stt_stop(provider);
 
     httpd_resp_set_type(req, "application/json");
     const char *response = "{\"status\":\"stopped\"}";
@@ -1499,23 +998,15 @@ static esp_err_t live_stop_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for GET /api/live/status */
+/* Handler for GET /api/live/status and /api/openai-live/status */
 static esp_err_t live_status_handler(httpd_req_t *req)
 {
     live_stt_status_t status;
-    live_stt_get_status(&status);
+    live_stt_get_status(live_provider(req), &status);
 
     cJSON *root = cJSON_CreateObject();
 
-    const char *state_str;
-    switch (status.state) {
-        case LIVE_STT_STATE_IDLE: state_str = "idle"; break;
-        case LIVE_STT_STATE_CONNECTING: state_str = "connecting"; break;
-        case LIVE_STT_STATE_STREAMING: state_str = "streaming"; break;
-        case LIVE_STT_STATE_ERROR: state_str = "error"; break;
-        default: state_str = "unknown"; break;
-    }
-    cJSON_AddStringToObject(root, "state", state_str);
+    cJSON_AddStringToObject(root, "state", live_stt_state_name(status.state));
 
     if (status.transcript) {
         cJSON_AddStringToObject(root, "transcript", status.transcript);
@@ -1537,12 +1028,13 @@ static esp_err_t live_status_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for POST /api/live/clear */
+/* Handler for POST /api/live/clear and /api/openai-live/clear */
 static esp_err_t live_clear_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Live STT clear API called");
+    live_stt_provider_t provider = live_provider(req);
+    ESP_LOGI(TAG, "%s live STT clear API called", live_stt_provider_name(provider));
 
-    live_stt_clear_transcript();
+    live_stt_clear_transcript(provider);
 
     httpd_resp_set_type(req, "application/json");
     const char *response = "{\"status\":\"cleared\"}";
@@ -1550,56 +1042,57 @@ static esp_err_t live_clear_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for GET /openai-live - OpenAI Live STT page */
-static esp_err_t openai_live_page_handler(httpd_req_t *req)
+/* Handler for POST /api/conversation/start */
+static esp_err_t conversation_start_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Serving OpenAI Live STT page");
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, OPENAI_LIVE_STT_HTML, strlen(OPENAI_LIVE_STT_HTML));
-    return ESP_OK;
-}
+    ESP_LOGI(TAG, "Conversation start API called");
 
-/* Handler for POST /api/openai-live/start */
-static esp_err_t openai_live_start_handler(httpd_req_t *req)
-{
-    ESP_LOGI(TAG, "OpenAI Live STT start API called");
+    // Optional body: {"provider":"deepgram"|"openai"}
+    transcript_source_t source = TRANSCRIPT_SOURCE_LIVE;
+    int content_len = req->content_len;
+    if (content_len > 0 && content_len <= 256) {
+        char buf[257];
+        int received = httpd_req_recv(req, buf, content_len);
+        if (received > 0) {
+            buf[received] = '\0';
+            cJSON *root = cJSON_Parse(buf);
+            if (root) {
+                cJSON *provider = cJSON_GetObjectItem(root, "provider");
+                if (provider && cJSON_IsString(provider) && strcmp(provider->valuestring, "openai") == 0) {
+                    source = TRANSCRIPT_SOURCE_OPENAI_LIVE;
+                }
+                cJSON_Delete(root);
+            }
+        }
+    }
 
-    esp_err_t err = openai_live_stt_start();
+    esp_err_t err = conversation_start(source);
 
     httpd_resp_set_type(req, "application/json");
     if (err == ESP_OK) {
-        const char *response = "{\"status\":\"starting\"}";
+        const char *response = "{\"status\":\"started\"}";
         httpd_resp_send(req, response, strlen(response));
-    } else if (err == ESP_ERR_INVALID_STATE) {
-        openai_live_stt_status_t status;
-        openai_live_stt_get_status(&status);
-        if (status.error_message && strstr(status.error_message, "API key")) {
-            httpd_resp_set_status(req, "400 Bad Request");
-            const char *response = "{\"error\":\"OpenAI API key not configured. Use 'idf.py menuconfig' to set it.\"}";
-            httpd_resp_send(req, response, strlen(response));
-        } else {
-            httpd_resp_set_status(req, "409 Conflict");
-            const char *response = "{\"error\":\"Already streaming\"}";
-            httpd_resp_send(req, response, strlen(response));
-        }
     } else {
+        char response[128];
+        snprintf(response, sizeof(response), "{\"error\":\"Failed to start conversation: %s\"}",
+                 esp_err_to_name(err));
         httpd_resp_set_status(req, "500 Internal Server Error");
-        char response[256];
-        openai_live_stt_status_t status;
-        openai_live_stt_get_status(&status);
-        snprintf(response, sizeof(response),
-                 "{\"error\":\"%s\"}", status.error_message ? status.error_message : "Failed to start streaming");
         httpd_resp_send(req, response, strlen(response));
     }
     return ESP_OK;
 }
 
-/* Handler for POST /api/openai-live/stop */
-static esp_err_t openai_live_stop_handler(httpd_req_t *req)
+/* Handler for POST /api/conversation/stop */
+static esp_err_t conversation_stop_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "OpenAI Live STT stop API called");
+    // Stops the live stream underneath, which can take seconds
+    if (!http_workers_in_worker()) {
+        return http_workers_submit(req, conversation_stop_handler);
+    }
+
+    ESP_LOGI(TAG, "Conversation stop API called");
 
-    openai_live_stt_stop();
+    conversation_stop();
 
     httpd_resp_set_type(req, "application/json");
     const char *response = "{\"status\":\"stopped\"}";
@@ -1607,33 +1100,30 @@ static esp_err_t openai_live_stop_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for GET /api/openai-live/status */
-static esp_err_t openai_live_status_handler(httpd_req_t *req)
+/* Handler for GET /api/conversation/status */
+static esp_err_t conversation_status_handler(httpd_req_t *req)
 {
-    openai_live_stt_status_t status;
-    openai_live_stt_get_status(&status);
+    conversation_stats_t stats;
+    conversation_get_stats(&stats);
 
     cJSON *root = cJSON_CreateObject();
-
-    const char *state_str;
-    switch (status.state) {
-        case OPENAI_LIVE_STT_STATE_IDLE: state_str = "idle"; break;
-        case OPENAI_LIVE_STT_STATE_CONNECTING: state_str = "connecting"; break;
-        case OPENAI_LIVE_STT_STATE_STREAMING: state_str = "streaming"; break;
-        case OPENAI_LIVE_STT_STATE_ERROR: state_str = "error"; break;
-        default: state_str = "unknown"; break;
-    }
-    cJSON_AddStringToObject(root, "state", state_str);
-
-    if (status.transcript) {
-        cJSON_AddStringToObject(root, "transcript", status.transcript);
-    } else {
-        cJSON_AddStringToObject(root, "transcript", "");
-    }
-
-    if (status.error_message) {
-        cJSON_AddStringToObject(root, "error", status.error_message);
-    }
+    cJSON_AddStringToObject(root, "state", conversation_state_name(stats.state));
+    cJSON_AddStringToObject(root, "provider", stats.source == TRANSCRIPT_SOURCE_OPENAI_LIVE ? "openai" : "deepgram");
+    cJSON_AddNumberToObject(root, "turns", stats.turns);
+    cJSON_AddNumberToObject(root, "replies", stats.replies);
+    cJSON_AddNumberToObject(root, "barge_ins", stats.barge_ins);
+    cJSON_AddNumberToObject(root, "llm_errors", stats.llm_errors);
+    cJSON_AddNumberToObject(root, "echo_dropped", stats.echo_dropped);
+
+    cJSON *latency = cJSON_CreateObject();
+    cJSON_AddNumberToObject(latency, "stt_ms", stats.stt_ms);
+    cJSON_AddNumberToObject(latency, "llm_ms", stats.llm_ms);
+    cJSON_AddNumberToObject(latency, "tts_ms", stats.tts_ms);
+    cJSON_AddNumberToObject(latency, "total_ms", stats.total_ms);
+    cJSON_AddNumberToObject(latency, "total_avg_ms", stats.total_avg_ms);
+    cJSON_AddNumberToObject(latency, "total_max_ms", stats.total_max_ms);
+    cJSON_AddNumberToObject(latency, "barge_in_ms", stats.barge_in_ms);
+    cJSON_AddItemToObject(root, "latency", latency);
 
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -1645,25 +1135,97 @@ static esp_err_t openai_live_status_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-/* Handler for POST /api/openai-live/clear */
-static esp_err_t openai_live_clear_handler(httpd_req_t *req)
+static void add_latency_json(cJSON *parent, const char *name, const bench_latency_t *latency)
 {
-    ESP_LOGI(TAG, "OpenAI Live STT clear API called");
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "samples", latency->samples);
+    cJSON_AddNumberToObject(obj, "p50", latency->p50);
+    cJSON_AddNumberToObject(obj, "p95", latency->p95);
+    cJSON_AddNumberToObject(obj, "p99", latency->p99);
+    cJSON_AddNumberToObject(obj, "max", latency->max);
+    cJSON_AddItemToObject(parent, name, obj);
+}
 
-    openai_live_stt_clear_transcript();
+/* Handler for POST /api/bench (optional ?loopback_ms=N) - runs the benchmark on a worker, replies when done */
+static esp_err_t bench_post_handler(httpd_req_t *req)
+{
+    if (!http_workers_in_worker()) {
+        return http_workers_submit(req, bench_post_handler);
+    }
 
     httpd_resp_set_type(req, "application/json");
-    const char *response = "{\"status\":\"cleared\"}";
-    httpd_resp_send(req, response, strlen(response));
+
+    uint32_t loopback_ms = CONFIG_BENCH_LOOPBACK_MS;
+    char query[32];
+    char value[12];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "loopback_ms", value, sizeof(value)) == ESP_OK) {
+        loopback_ms = (uint32_t)strtoul(value, NULL, 10);
+        if (loopback_ms > 600000) {
+            loopback_ms = 600000;
+        }
+    }
+
+    bench_report_t report;
+    esp_err_t err = bench_run(loopback_ms, &report);
+    if (err != ESP_OK) {
+        httpd_resp_set_status(req, err == ESP_ERR_INVALID_STATE ? "409 Conflict" : "500 Internal Server Error");
+        const char *error = err == ESP_ERR_INVALID_STATE ? "{\"error\":\"Benchmark already running\"}"
+                                                         : "{\"error\":\"Benchmark failed to start\"}";
+        httpd_resp_send(req, error, strlen(error));
+        return ESP_OK;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *cpb = cJSON_CreateObject();
+    cJSON_AddNumberToObject(cpb, "ring_copy", report.ring_copy_cpb_x1000 / 1000.0);
+    cJSON_AddNumberToObject(cpb, "ring_zero_copy", report.ring_zero_copy_cpb_x1000 / 1000.0);
+    cJSON_AddNumberToObject(cpb, "deinterleave", report.deinterleave_cpb_x1000 / 1000.0);
+    cJSON_AddNumberToObject(cpb, "mono_to_stereo", report.mono_to_stereo_cpb_x1000 / 1000.0);
+    cJSON_AddNumberToObject(cpb, "openai_frame", report.openai_frame_cpb_x1000 / 1000.0);
+    cJSON_AddNumberToObject(cpb, "deepgram_parse", report.deepgram_parse_cpb_x1000 / 1000.0);
+    cJSON_AddNumberToObject(cpb, "openai_parse", report.openai_parse_cpb_x1000 / 1000.0);
+    cJSON_AddItemToObject(root, "cycles_per_byte", cpb);
+    add_latency_json(root, "ring_handoff_us", &report.ring_handoff_us);
+
+    cJSON *loopback = cJSON_CreateObject();
+    if (report.loopback_err != ESP_OK) {
+        cJSON_AddStringToObject(loopback, "error", esp_err_to_name(report.loopback_err));
+    } else if (loopback_ms > 0) {
+        cJSON_AddNumberToObject(loopback, "audio_ms", report.loopback_ms);
+        cJSON_AddNumberToObject(loopback, "first_audio_us", report.loopback_first_audio_us);
+        cJSON_AddNumberToObject(loopback, "underruns", report.loopback_underruns);
+        add_latency_json(loopback, "write_us", &report.loopback_write_us);
+    }
+    cJSON_AddItemToObject(root, "loopback", loopback);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    httpd_resp_send(req, json_str, json_str ? strlen(json_str) : 0);
+    free(json_str);
     return ESP_OK;
 }
 
 /* URI handlers */
+static const httpd_uri_t uri_static_css = {
+    .uri       = "/static/common.css",
+    .method    = HTTP_GET,
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"common.css"
+};
+
+static const httpd_uri_t uri_static_js = {
+    .uri       = "/static/transcript.js",
+    .method    = HTTP_GET,
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"transcript.js"
+};
+
 static const httpd_uri_t uri_root = {
     .uri       = "/",
     .method    = HTTP_GET,
-    .handler   = root_get_handler,
-    .user_ctx  = NULL
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"tts.html"
 };
 
 static const httpd_uri_t uri_status = {
@@ -1673,6 +1235,20 @@ static const httpd_uri_t uri_status = {
     .user_ctx  = NULL
 };
 
+static const httpd_uri_t uri_metrics = {
+    .uri       = "/api/metrics",
+    .method    = HTTP_GET,
+    .handler   = metrics_get_handler,
+    .user_ctx  = NULL
+};
+
+static const httpd_uri_t uri_bench = {
+    .uri       = "/api/bench",
+    .method    = HTTP_POST,
+    .handler   = bench_post_handler,
+    .user_ctx  = NULL
+};
+
 static const httpd_uri_t uri_provider_get = {
     .uri       = "/api/provider",
     .method    = HTTP_GET,
@@ -1694,6 +1270,13 @@ static const httpd_uri_t uri_tts = {
     .user_ctx  = NULL
 };
 
+static const httpd_uri_t uri_tts_jobs = {
+    .uri       = "/api/tts/jobs",
+    .method    = HTTP_GET,
+    .handler   = tts_jobs_handler,
+    .user_ctx  = NULL
+};
+
 static const httpd_uri_t uri_volume = {
     .uri       = "/api/volume",
     .method    = HTTP_POST,
@@ -1704,8 +1287,8 @@ static const httpd_uri_t uri_volume = {
 static const httpd_uri_t uri_stt_page = {
     .uri       = "/stt",
     .method    = HTTP_GET,
-    .handler   = stt_page_handler,
-    .user_ctx  = NULL
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"stt.html"
 };
 
 static const httpd_uri_t uri_stt_start = {
@@ -1739,15 +1322,15 @@ static const httpd_uri_t uri_stt_reset = {
 static const httpd_uri_t uri_live_page = {
     .uri       = "/live",
     .method    = HTTP_GET,
-    .handler   = live_page_handler,
-    .user_ctx  = NULL
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"live.html"
 };
 
 static const httpd_uri_t uri_settings_page = {
     .uri       = "/settings",
     .method    = HTTP_GET,
-    .handler   = settings_page_handler,
-    .user_ctx  = NULL
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"settings.html"
 };
 
 static const httpd_uri_t uri_settings_api = {
@@ -1757,69 +1340,136 @@ static const httpd_uri_t uri_settings_api = {
     .user_ctx  = NULL
 };
 
+static const httpd_uri_t uri_settings_post = {
+    .uri       = "/api/settings",
+    .method    = HTTP_POST,
+    .handler   = settings_post_handler,
+    .user_ctx  = NULL
+};
+
 static const httpd_uri_t uri_live_start = {
     .uri       = "/api/live/start",
     .method    = HTTP_POST,
     .handler   = live_start_handler,
-    .user_ctx  = NULL
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_DEEPGRAM
 };
 
 static const httpd_uri_t uri_live_stop = {
     .uri       = "/api/live/stop",
     .method    = HTTP_POST,
     .handler   = live_stop_handler,
-    .user_ctx  = NULL
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_DEEPGRAM
 };
 
 static const httpd_uri_t uri_live_status = {
     .uri       = "/api/live/status",
     .method    = HTTP_GET,
     .handler   = live_status_handler,
-    .user_ctx  = NULL
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_DEEPGRAM
 };
 
 static const httpd_uri_t uri_live_clear = {
     .uri       = "/api/live/clear",
     .method    = HTTP_POST,
     .handler   = live_clear_handler,
-    .user_ctx  = NULL
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_DEEPGRAM
 };
 
 static const httpd_uri_t uri_openai_live_page = {
     .uri       = "/openai-live",
     .method    = HTTP_GET,
-    .handler   = openai_live_page_handler,
-    .user_ctx  = NULL
+    .handler   = web_asset_handler,
+    .user_ctx  = (void *)"openai_live.html"
 };
 
 static const httpd_uri_t uri_openai_live_start = {
     .uri       = "/api/openai-live/start",
     .method    = HTTP_POST,
-    .handler   = openai_live_start_handler,
-    .user_ctx  = NULL
+    .handler   = live_start_handler,
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_OPENAI
 };
 
 static const httpd_uri_t uri_openai_live_stop = {
     .uri       = "/api/openai-live/stop",
     .method    = HTTP_POST,
-    .handler   = openai_live_stop_handler,
-    .user_ctx  = NULL
+    .handler   = live_stop_handler,
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_OPENAI
 };
 
 static const httpd_uri_t uri_openai_live_status = {
     .uri       = "/api/openai-live/status",
     .method    = HTTP_GET,
-    .handler   = openai_live_status_handler,
-    .user_ctx  = NULL
+    .handler   = live_status_handler,
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_OPENAI
 };
 
 static const httpd_uri_t uri_openai_live_clear = {
     .uri       = "/api/openai-live/clear",
     .method    = HTTP_POST,
-    .handler   = openai_live_clear_handler,
+    .handler   = live_clear_handler,
+    .user_ctx  = (void *)(intptr_t)LIVE_STT_OPENAI
+};
+
+static const httpd_uri_t uri_conversation_start = {
+    .uri       = "/api/conversation/start",
+    .method    = HTTP_POST,
+    .handler   = conversation_start_handler,
     .user_ctx  = NULL
 };
 
+static const httpd_uri_t uri_conversation_stop = {
+    .uri       = "/api/conversation/stop",
+    .method    = HTTP_POST,
+    .handler   = conversation_stop_handler,
+    .user_ctx  = NULL
+};
+
+static const httpd_uri_t uri_conversation_status = {
+    .uri       = "/api/conversation/status",
+    .method    = HTTP_GET,
+    .handler   = conversation_status_handler,
+    .user_ctx  = NULL
+};
+
+static const httpd_uri_t *const s_uris[] = {
+    &uri_root,
+    &uri_static_css,
+    &uri_static_js,
+    &uri_status,
+    &uri_metrics,
+    &uri_bench,
+    &uri_provider_get,
+    &uri_provider_post,
+    &uri_tts,
+    &uri_tts_jobs,
+    &uri_volume,
+    &uri_stt_page,
+    &uri_stt_start,
+    &uri_stt_stop,
+    &uri_stt_status,
+    &uri_stt_reset,
+    &uri_live_page,
+    &uri_settings_page,
+    &uri_settings_api,
+    &uri_settings_post,
+    &uri_live_start,
+    &uri_live_stop,
+    &uri_live_status,
+    &uri_live_clear,
+    &uri_openai_live_page,
+    &uri_openai_live_start,
+    &uri_openai_live_stop,
+    &uri_openai_live_status,
+    &uri_openai_live_clear,
+    &uri_conversation_start,
+    &uri_conversation_stop,
+    &uri_conversation_status,
+};
+
+// The table, the endpoints other modules register, and room for a few more
+#define URI_HANDLERS_MAX (sizeof(s_uris) / sizeof(s_uris[0]) + TRANSCRIPT_PUSH_URI_HANDLERS + \
+                          AUDIO_HTTP_URI_HANDLERS + URI_HANDLERS_SPARE)
+
 esp_err_t http_server_start(void)
 {
     if (server != NULL) {
@@ -1827,42 +1477,37 @@ esp_err_t http_server_start(void)
         return ESP_OK;
     }
 
+    esp_err_t ret = http_workers_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.lru_purge_enable = true;
-    config.max_uri_handlers = 25;
+    config.max_open_sockets = CONFIG_HTTP_SERVER_MAX_SOCKETS;
+    config.max_uri_handlers = URI_HANDLERS_MAX;
+    config.core_id = TASK_HTTPD_CORE;
+    config.task_priority = TASK_HTTPD_PRIORITY;
+    config.stack_size = TASK_HTTPD_STACK;
+    config.open_fn = session_open;
+    config.close_fn = session_close;
 
     ESP_LOGI(TAG, "Starting HTTP server on port %d", config.server_port);
 
-    esp_err_t ret = httpd_start(&server, &config);
+    ret = httpd_start(&server, &config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start server: %s", esp_err_to_name(ret));
         return ret;
     }
 
     /* Register URI handlers */
-    httpd_register_uri_handler(server, &uri_root);
-    httpd_register_uri_handler(server, &uri_status);
-    httpd_register_uri_handler(server, &uri_provider_get);
-    httpd_register_uri_handler(server, &uri_provider_post);
-    httpd_register_uri_handler(server, &uri_tts);
-    httpd_register_uri_handler(server, &uri_volume);
-    httpd_register_uri_handler(server, &uri_stt_page);
-    httpd_register_uri_handler(server, &uri_stt_start);
-    httpd_register_uri_handler(server, &uri_stt_stop);
-    httpd_register_uri_handler(server, &uri_stt_status);
-    httpd_register_uri_handler(server, &uri_stt_reset);
-    httpd_register_uri_handler(server, &uri_live_page);
-    httpd_register_uri_handler(server, &uri_settings_page);
-    httpd_register_uri_handler(server, &uri_settings_api);
-    httpd_register_uri_handler(server, &uri_live_start);
-    httpd_register_uri_handler(server, &uri_live_stop);
-    httpd_register_uri_handler(server, &uri_live_status);
-    httpd_register_uri_handler(server, &uri_live_clear);
-    httpd_register_uri_handler(server, &uri_openai_live_page);
-    httpd_register_uri_handler(server, &uri_openai_live_start);
-    httpd_register_uri_handler(server, &uri_openai_live_stop);
-    httpd_register_uri_handler(server, &uri_openai_live_status);
-    httpd_register_uri_handler(server, &uri_openai_live_clear);
+    for (size_t i = 0; i < sizeof(s_uris) / sizeof(s_uris[0]); i++) {
+        if (httpd_register_uri_handler(server, s_uris[i]) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register %s", s_uris[i]->uri);
+        }
+    }
+    transcript_push_register(server);
+    audio_http_register(server);
 
     ESP_LOGI(TAG, "HTTP server started successfully");
     return ESP_OK;
@@ -1875,6 +1520,7 @@ esp_err_t http_server_stop(void)
         return ESP_OK;
     }
 
+    transcript_push_unregister();
     esp_err_t ret = httpd_stop(server);
     if (ret == ESP_OK) {
         server = NULL;
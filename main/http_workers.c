@@ -0,0 +1,185 @@
+/**
+ * HTTP Async Workers
+ *
+ * Workers block on a queue of detached requests. A counting semaphore
+ * tracks idle workers so the server task never queues a request behind a
+ * busy one: it either hands it to a worker that is known to be free or
+ * rejects it immediately. A second semaphore caps the streaming handlers
+ * one short of the worker count, so a worker is always left for requests
+ * such as stopping the session that is streaming.
+ */
+
+#include "http_workers.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "metrics.h"
+#include "task_topology.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "http_workers";
+
+#define WORKER_COUNT CONFIG_HTTP_SERVER_ASYNC_WORKERS
+#define STREAM_SLOTS (WORKER_COUNT - 1)
+
+_Static_assert(STREAM_SLOTS >= 1, "HTTP_SERVER_ASYNC_WORKERS must leave a worker for short handlers");
+
+typedef struct {
+    httpd_req_t *req;                   // Detached copy from httpd_req_async_handler_begin()
+    http_workers_handler_t handler;
+    bool stream;                        // Holds a stream slot until it returns
+} work_item_t;
+
+static struct {
+    QueueHandle_t queue;
+    SemaphoreHandle_t idle;             // Counts workers not running a handler
+    SemaphoreHandle_t streams;          // Counts stream slots not in use
+    TaskHandle_t tasks[WORKER_COUNT];
+} s_ctx;
+
+static metrics_metric_t s_m_deferred = METRICS_COUNTER_INIT(
+    "httpd_async_requests_total", "Requests handed to an async worker", NULL, NULL);
+static metrics_metric_t s_m_rejected = METRICS_COUNTER_INIT(
+    "httpd_async_rejected_total", "Requests answered with 503 because every worker was busy", NULL, NULL);
+static metrics_metric_t s_m_streams_rejected = METRICS_COUNTER_INIT(
+    "httpd_async_streams_rejected_total", "Streaming requests answered with 503 because every stream slot was in use",
+    NULL, NULL);
+static metrics_metric_t s_m_handler_ms = METRICS_HISTOGRAM_MS_INIT(
+    "httpd_async_handler_ms", "Time an async worker spent on a request", NULL, NULL);
+
+/**
+ * Worker task: run detached requests until the end of time
+ */
+static void worker_task(void *arg)
+{
+    (void)arg;
+    work_item_t item;
+
+    while (true) {
+        if (xQueueReceive(s_ctx.queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        esp_err_t err = item.handler(item.req);
+        metrics_observe_since(&s_m_handler_ms, start_us);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Handler for %s failed, closing connection", item.req->uri);
+            httpd_sess_trigger_close(item.req->handle, httpd_req_to_sockfd(item.req));
+        }
+
+        httpd_req_async_handler_complete(item.req);
+        if (item.stream) {
+            xSemaphoreGive(s_ctx.streams);
+        }
+        xSemaphoreGive(s_ctx.idle);
+    }
+}
+
+esp_err_t http_workers_start(void)
+{
+    if (s_ctx.queue != NULL) {
+        return ESP_OK;
+    }
+
+    s_ctx.queue = xQueueCreate(WORKER_COUNT, sizeof(work_item_t));
+    s_ctx.idle = xSemaphoreCreateCounting(WORKER_COUNT, WORKER_COUNT);
+    s_ctx.streams = xSemaphoreCreateCounting(STREAM_SLOTS, STREAM_SLOTS);
+    if (s_ctx.queue == NULL || s_ctx.idle == NULL || s_ctx.streams == NULL) {
+        ESP_LOGE(TAG, "Failed to create worker queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "httpd_async%d", i);
+        if (xTaskCreatePinnedToCore(worker_task, name, TASK_HTTP_WORKER_STACK, NULL,
+                                    TASK_HTTP_WORKER_PRIORITY, &s_ctx.tasks[i],
+                                    TASK_HTTP_WORKER_CORE) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    metrics_register(&s_m_deferred);
+    metrics_register(&s_m_rejected);
+    metrics_register(&s_m_streams_rejected);
+    ESP_LOGI(TAG, "%d async HTTP workers started, %d for streams", WORKER_COUNT, STREAM_SLOTS);
+    return ESP_OK;
+}
+
+/**
+ * Answer a request that cannot get a worker right now
+ */
+static esp_err_t send_busy(httpd_req_t *req, const char *message)
+{
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Retry-After", "1");
+    char json[64];
+    int len = snprintf(json, sizeof(json), "{\"error\":\"%s\"}", message);
+    return httpd_resp_send(req, json, len);
+}
+
+static esp_err_t submit(httpd_req_t *req, http_workers_handler_t handler, bool stream)
+{
+    if (s_ctx.queue == NULL) {
+        metrics_inc(&s_m_rejected);
+        return send_busy(req, "Server busy");
+    }
+    if (stream && xSemaphoreTake(s_ctx.streams, 0) != pdTRUE) {
+        metrics_inc(&s_m_streams_rejected);
+        ESP_LOGW(TAG, "Stream limit reached, rejecting %s", req->uri);
+        return send_busy(req, "Too many streams");
+    }
+    if (xSemaphoreTake(s_ctx.idle, 0) != pdTRUE) {
+        if (stream) {
+            xSemaphoreGive(s_ctx.streams);
+        }
+        metrics_inc(&s_m_rejected);
+        ESP_LOGW(TAG, "No idle worker for %s", req->uri);
+        return send_busy(req, "Server busy");
+    }
+
+    work_item_t item = {.handler = handler, .stream = stream};
+    esp_err_t err = httpd_req_async_handler_begin(req, &item.req);
+    if (err != ESP_OK) {
+        if (stream) {
+            xSemaphoreGive(s_ctx.streams);
+        }
+        xSemaphoreGive(s_ctx.idle);
+        ESP_LOGE(TAG, "Failed to detach %s: %s", req->uri, esp_err_to_name(err));
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to detach request");
+    }
+
+    // Cannot fail: the queue holds one item per worker and one is idle
+    xQueueSend(s_ctx.queue, &item, 0);
+    metrics_inc(&s_m_deferred);
+    return ESP_OK;
+}
+
+esp_err_t http_workers_submit(httpd_req_t *req, http_workers_handler_t handler)
+{
+    return submit(req, handler, false);
+}
+
+esp_err_t http_workers_submit_stream(httpd_req_t *req, http_workers_handler_t handler)
+{
+    return submit(req, handler, true);
+}
+
+bool http_workers_in_worker(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        if (s_ctx.tasks[i] == self) {
+            return true;
+        }
+    }
+    return false;
+}
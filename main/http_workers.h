@@ -0,0 +1,80 @@
+/**
+ * HTTP Async Workers
+ *
+ * A small pool of tasks that run slow HTTP handlers (benchmark, metrics
+ * export, stopping a live stream) off the server task. The handler detaches
+ * its request with httpd_req_async_handler_begin() and a worker finishes
+ * it, so the server keeps accepting and answering status polls meanwhile.
+ *
+ * A deferring handler starts with:
+ *
+ *   if (!http_workers_in_worker()) {
+ *       return http_workers_submit(req, my_handler);
+ *   }
+ *
+ * Handlers that hold their worker for as long as a client streams use
+ * http_workers_submit_stream() instead, which keeps one worker free for
+ * everything else.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handler run on a worker
+ *
+ * Returning anything but ESP_OK closes the connection, as for a regular
+ * handler.
+ */
+typedef esp_err_t (*http_workers_handler_t)(httpd_req_t *req);
+
+/**
+ * @brief Create the worker tasks
+ *
+ * Workers outlive the server; calling this again is a no-op.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if a task cannot be created
+ */
+esp_err_t http_workers_start(void);
+
+/**
+ * @brief Hand a request to an idle worker
+ *
+ * Call from the server task only. When every worker is busy the request
+ * is answered with 503 and Retry-After instead of queuing behind a
+ * long-running one.
+ *
+ * @param req Request, owned by the worker on success
+ * @param handler Handler to run on the worker
+ * @return ESP_OK if the request was handed over or answered with 503
+ */
+esp_err_t http_workers_submit(httpd_req_t *req, http_workers_handler_t handler);
+
+/**
+ * @brief Hand a streaming request to an idle worker
+ *
+ * As http_workers_submit(), but at most CONFIG_HTTP_SERVER_ASYNC_WORKERS - 1
+ * streaming requests run at once; another one is answered with 503 so
+ * that stop, metrics and benchmark requests always find a worker.
+ *
+ * @param req Request, owned by the worker on success
+ * @param handler Handler to run on the worker
+ * @return ESP_OK if the request was handed over or answered with 503
+ */
+esp_err_t http_workers_submit_stream(httpd_req_t *req, http_workers_handler_t handler);
+
+/**
+ * @brief Whether the calling task is one of the workers
+ */
+bool http_workers_in_worker(void);
+
+#ifdef __cplusplus
+}
+#endif
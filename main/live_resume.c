@@ -0,0 +1,176 @@
+/**
+ * Live STT Session Resume
+ *
+ * The backlog is a byte ring of length-prefixed records. Only the
+ * streaming task touches it, so it needs no locking.
+ */
+
+#include "live_resume.h"
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+static const char *TAG = "live_resume";
+
+#define RECORD_HEADER 2                     // Little-endian record length
+#define BACKOFF_MIN_MS 1000
+#if LIVE_RESUME_ENABLED
+#define BACKOFF_MAX_MS CONFIG_LIVE_STT_RECONNECT_MAX_BACKOFF_MS
+#define GIVE_UP_MS ((int64_t)CONFIG_LIVE_STT_RECONNECT_GIVE_UP_S * 1000)
+#else
+#define BACKOFF_MAX_MS BACKOFF_MIN_MS
+#define GIVE_UP_MS 0
+#endif
+#define ATTEMPT_TIMEOUT_MS 15000            // Retry an attempt that never connected nor failed
+
+void live_resume_init(live_resume_t *resume, size_t backlog_bytes)
+{
+    memset(resume, 0, sizeof(*resume));
+    resume->capacity = backlog_bytes;
+}
+
+void live_resume_free(live_resume_t *resume)
+{
+    heap_caps_free(resume->buf);
+    resume->buf = NULL;
+    resume->head = 0;
+    resume->used = 0;
+}
+
+void live_resume_lost(live_resume_t *resume)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (resume->down_us == 0) {
+        resume->down_us = now;
+        resume->attempts = 0;
+        if (!resume->buf && resume->capacity > 0) {
+            resume->buf = heap_caps_malloc(resume->capacity, MALLOC_CAP_SPIRAM);
+            if (!resume->buf) {
+                ESP_LOGW(TAG, "No PSRAM for a %u KB backlog, audio is lost until reconnected",
+                         (unsigned)(resume->capacity / 1024));
+            }
+        }
+    }
+
+    // 1, 2, 4 ... s up to the cap, plus up to 25% jitter so clients do not retry in step
+    uint32_t backoff_ms = BACKOFF_MIN_MS;
+    for (uint32_t i = 0; i < resume->attempts && backoff_ms < BACKOFF_MAX_MS; i++) {
+        backoff_ms *= 2;
+    }
+    if (backoff_ms > BACKOFF_MAX_MS) {
+        backoff_ms = BACKOFF_MAX_MS;
+    }
+    backoff_ms += esp_random() % (backoff_ms / 4 + 1);
+
+    resume->next_attempt_us = now + (int64_t)backoff_ms * 1000;
+    ESP_LOGI(TAG, "Reconnect attempt %lu in %lu ms", (unsigned long)resume->attempts + 1,
+             (unsigned long)backoff_ms);
+}
+
+bool live_resume_due(live_resume_t *resume)
+{
+    int64_t now = esp_timer_get_time();
+    if (resume->down_us == 0 || now < resume->next_attempt_us) {
+        return false;
+    }
+    resume->attempts++;
+    resume->next_attempt_us = now + (int64_t)ATTEMPT_TIMEOUT_MS * 1000;
+    return true;
+}
+
+bool live_resume_expired(const live_resume_t *resume)
+{
+    return resume->down_us != 0 && esp_timer_get_time() - resume->down_us > GIVE_UP_MS;
+}
+
+uint32_t live_resume_restored(live_resume_t *resume)
+{
+    uint32_t outage_ms = resume->down_us ? (uint32_t)((esp_timer_get_time() - resume->down_us) / 1000) : 0;
+    ESP_LOGI(TAG, "Reconnected after %lu ms and %lu attempts, %u bytes to replay",
+             (unsigned long)outage_ms, (unsigned long)resume->attempts, (unsigned)resume->used);
+    resume->down_us = 0;
+    resume->attempts = 0;
+    return outage_ms;
+}
+
+/**
+ * Copy into the ring at an offset from the head, wrapping
+ */
+static void ring_put(live_resume_t *resume, size_t offset, const uint8_t *data, size_t len)
+{
+    size_t pos = (resume->head + offset) % resume->capacity;
+    size_t first = resume->capacity - pos < len ? resume->capacity - pos : len;
+    memcpy(resume->buf + pos, data, first);
+    memcpy(resume->buf, data + first, len - first);
+}
+
+/**
+ * Copy out of the ring from the head, wrapping
+ */
+static void ring_get(const live_resume_t *resume, uint8_t *out, size_t len)
+{
+    size_t first = resume->capacity - resume->head < len ? resume->capacity - resume->head : len;
+    memcpy(out, resume->buf + resume->head, first);
+    memcpy(out + first, resume->buf, len - first);
+}
+
+/**
+ * Drop the oldest record
+ */
+static size_t drop_oldest(live_resume_t *resume)
+{
+    uint8_t hdr[RECORD_HEADER];
+    ring_get(resume, hdr, RECORD_HEADER);
+    size_t len = hdr[0] | (hdr[1] << 8);
+    resume->head = (resume->head + RECORD_HEADER + len) % resume->capacity;
+    resume->used -= RECORD_HEADER + len;
+    return len;
+}
+
+size_t live_resume_push(live_resume_t *resume, const uint8_t *data, size_t len)
+{
+    size_t record = RECORD_HEADER + len;
+    if (!resume->buf || record > resume->capacity || len > UINT16_MAX) {
+        return len;
+    }
+
+    size_t dropped = 0;
+    while (resume->used + record > resume->capacity) {
+        dropped += drop_oldest(resume);
+    }
+
+    uint8_t hdr[RECORD_HEADER] = {len & 0xFF, len >> 8};
+    ring_put(resume, resume->used, hdr, RECORD_HEADER);
+    if (len > 0) {
+        ring_put(resume, resume->used + RECORD_HEADER, data, len);
+    }
+    resume->used += record;
+    return dropped;
+}
+
+bool live_resume_pop(live_resume_t *resume, uint8_t *out, size_t max, size_t *len)
+{
+    while (resume->used > 0) {
+        uint8_t hdr[RECORD_HEADER];
+        ring_get(resume, hdr, RECORD_HEADER);
+        size_t record_len = hdr[0] | (hdr[1] << 8);
+        resume->head = (resume->head + RECORD_HEADER) % resume->capacity;
+        resume->used -= RECORD_HEADER;
+
+        // A record larger than the caller's buffer is skipped rather than truncated
+        bool fits = record_len <= max;
+        if (fits) {
+            ring_get(resume, out, record_len);
+        }
+        resume->head = (resume->head + record_len) % resume->capacity;
+        resume->used -= record_len;
+        if (fits) {
+            *len = record_len;
+            return true;
+        }
+    }
+    return false;
+}
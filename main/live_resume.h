@@ -0,0 +1,119 @@
+/**
+ * Live STT Session Resume
+ *
+ * Keeps a live STT session going across WebSocket drops. While the link is
+ * down the streaming task keeps capturing into a bounded PSRAM backlog and
+ * reconnects on an exponential backoff; once the provider accepts audio
+ * again the backlog is replayed ahead of live audio, faster than real
+ * time, so the transcript continues where it stopped.
+ *
+ * Records are the chunks the streaming task would have sent. A zero-length
+ * record marks the end of an utterance (the silence gate closed). When the
+ * backlog is full the oldest records are dropped.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_LIVE_STT_RECONNECT
+#define LIVE_RESUME_ENABLED 1
+#define LIVE_RESUME_BACKLOG_MS (CONFIG_LIVE_STT_BACKLOG_S * 1000)
+#else
+#define LIVE_RESUME_ENABLED 0
+#define LIVE_RESUME_BACKLOG_MS 0
+#endif
+
+/**
+ * @brief Resume state, owned by one streaming task
+ */
+typedef struct {
+    uint8_t *buf;               // Backlog ring (PSRAM), allocated on the first drop
+    size_t capacity;
+    size_t head;                // Offset of the oldest record
+    size_t used;
+    uint32_t attempts;          // Reconnects tried in this outage
+    int64_t down_us;            // Start of the outage, 0 while connected
+    int64_t next_attempt_us;
+} live_resume_t;
+
+/**
+ * @brief Initialize resume state
+ *
+ * @param resume State
+ * @param backlog_bytes Backlog size; 0 reconnects without keeping audio
+ */
+void live_resume_init(live_resume_t *resume, size_t backlog_bytes);
+
+/**
+ * @brief Free the backlog
+ */
+void live_resume_free(live_resume_t *resume);
+
+/**
+ * @brief The link went down, or a reconnect attempt failed
+ *
+ * Starts the outage on the first call and schedules the next attempt
+ * after a doubling, jittered backoff.
+ */
+void live_resume_lost(live_resume_t *resume);
+
+/**
+ * @brief Check whether a reconnect attempt is due
+ *
+ * Returns true once per scheduled attempt; an attempt that never reports
+ * back is retried after a connect timeout.
+ */
+bool live_resume_due(live_resume_t *resume);
+
+/**
+ * @brief Check whether the outage has lasted longer than the give-up time
+ */
+bool live_resume_expired(const live_resume_t *resume);
+
+/**
+ * @brief The link is back
+ *
+ * @return Outage duration in milliseconds
+ */
+uint32_t live_resume_restored(live_resume_t *resume);
+
+/**
+ * @brief Append a record to the backlog
+ *
+ * @param resume State
+ * @param data Chunk (NULL with len 0 for an end-of-utterance marker)
+ * @param len Chunk length
+ * @return Bytes of older audio dropped to make room
+ */
+size_t live_resume_push(live_resume_t *resume, const uint8_t *data, size_t len);
+
+/**
+ * @brief Take the oldest record from the backlog
+ *
+ * @param resume State
+ * @param out Output buffer
+ * @param max Output buffer size, at least the largest record pushed
+ * @param len Record length (0 for an end-of-utterance marker)
+ * @return false if the backlog is empty
+ */
+bool live_resume_pop(live_resume_t *resume, uint8_t *out, size_t max, size_t *len);
+
+/**
+ * @brief Check whether backlog records are waiting to be replayed
+ */
+static inline bool live_resume_pending(const live_resume_t *resume)
+{
+    return resume->used > 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,259 +1,420 @@
 /**
  * Live Speech-to-Text Module
  *
- * Real-time audio streaming and transcription via Deepgram WebSocket API.
+ * Provider-independent engine: session state, the WebSocket client, the
+ * capture task with its silence gate, the streaming task that batches
+ * audio into sends sized to the link and keeps the reconnect backlog, and
+ * the transcript. Protocol code lives in live_stt_deepgram.c and
+ * live_stt_openai.c.
  */
 
 #include "live_stt.h"
+#include "live_stt_provider.h"
 #include <string.h>
 #include <stdio.h>
 #include "esp_log.h"
 #include "esp_websocket_client.h"
 #include "esp_heap_caps.h"
 #include "esp_crt_bundle.h"
-#include "cJSON.h"
-#include "bsp_board_extra.h"
-#include "driver/i2s_std.h"
+#include "ws_message.h"
+#include "vad_gate.h"
+#include "transcript_push.h"
+#include "conversation.h"
+#include "audio_engine.h"
+#include "audio_pool.h"
+#include "metrics.h"
+#include "live_resume.h"
+#include "spsc_ring.h"
+#include "task_topology.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
 static const char *TAG = "live_stt";
 
-// Audio configuration (matches batch STT)
-#define LIVE_STT_SAMPLE_RATE 16000
-#define LIVE_STT_BITS_PER_SAMPLE 16
+// Engine-side capture buffering; it only covers the capture task's scheduling,
+// the send queue behind it covers the network
+#define CAPTURE_BUFFER_MS 200
 
-// Streaming chunk configuration
-// 200ms chunks at 16kHz, 16-bit mono = 6400 bytes
-#define CHUNK_DURATION_MS 200
-#define CHUNK_SIZE_BYTES ((LIVE_STT_SAMPLE_RATE * 2 * CHUNK_DURATION_MS) / 1000)
+// Capture frame; sends are whole frames batched up to the adaptive chunk size
+#define FRAME_MS 20
+#define RECORD_HEADER 4
+#define CHUNK_MIN_MS CONFIG_LIVE_STT_CHUNK_MIN_MS
+#define CHUNK_MAX_MS (CONFIG_LIVE_STT_CHUNK_MAX_MS > CHUNK_MIN_MS ? CONFIG_LIVE_STT_CHUNK_MAX_MS : CHUNK_MIN_MS)
+#define QUEUE_MS CONFIG_LIVE_STT_QUEUE_MS
+#define CALM_SENDS 8                    // Relaxed sends before the chunk shrinks by a frame
 
 // Transcript buffer size (32KB in PSRAM)
 #define TRANSCRIPT_BUFFER_SIZE (32 * 1024)
 
-// Deepgram WebSocket URL with query parameters
-#define DEEPGRAM_WS_URL "wss://api.deepgram.com/v1/listen?encoding=linear16&sample_rate=16000&channels=1&punctuate=true&interim_results=false"
+// Reassembly of messages split across WebSocket events (PSRAM)
+#define MESSAGE_BUFFER_SIZE (16 * 1024)
+
+#define WS_URL_SIZE 256
+#define WS_TASK_STACK 8192
+#define STOP_WAIT_MS 5000               // Task exit after a stop request, before warning
 
 /**
- * Module state
+ * Session state, one per provider
  */
-typedef struct {
+struct live_stt_session {
+    const live_stt_provider_ops_t *ops;
+    bool initialized;
     live_stt_state_t state;
     char *transcript;               // Accumulated transcript (PSRAM)
     size_t transcript_len;          // Current transcript length
     size_t transcript_capacity;     // Buffer capacity
     char *error_message;            // Error message (heap allocated)
+    ws_message_t message;           // Incoming message reassembly
     SemaphoreHandle_t mutex;        // Protect state access
+    live_stt_state_t published_state;  // Last state pushed to transcript clients
+    const char *published_error;
     esp_websocket_client_handle_t ws_client;  // WebSocket client
     TaskHandle_t streaming_task;    // Audio streaming task handle
+    bool task_running;              // Streaming task started and not yet exited (mutex)
+    SemaphoreHandle_t task_done;    // Given by the streaming task as it exits
+    TaskHandle_t capture_task;      // Microphone reader feeding the queue
+    SemaphoreHandle_t capture_done; // Given by the capture task as it exits
+    volatile bool capture_run;
+    audio_engine_stream_handle_t capture;
+    uint8_t *capture_record;        // Record being built by the capture task (internal RAM)
+    spsc_ring_handle_t queue;       // Captured records waiting to be sent (PSRAM)
     volatile bool stop_requested;   // Signal to stop streaming
-} live_stt_context_t;
+    volatile bool linked;           // Connected and accepting audio (set by the event handler)
+    volatile uint32_t drops;        // Disconnects seen, including failed reconnects
+    metrics_metric_t m_send;
+    metrics_metric_t m_send_bytes;
+    metrics_metric_t m_send_failures;
+    metrics_metric_t m_reconnects;
+    metrics_metric_t m_backlog_dropped;
+    metrics_metric_t m_outage;
+    metrics_metric_t m_chunk_ms;
+    metrics_metric_t m_queue_ms;
+    metrics_metric_t m_queue_dropped;
+};
+
+#define SESSION_INIT(provider_ops, label) { \
+    .ops = (provider_ops), \
+    .m_send = METRICS_HISTOGRAM_US_INIT( \
+        "ws_send_us", "Latency of one audio frame send", "provider", label), \
+    .m_send_bytes = METRICS_COUNTER_INIT( \
+        "ws_sent_bytes_total", "Audio bytes sent", "provider", label), \
+    .m_send_failures = METRICS_COUNTER_INIT( \
+        "ws_send_failures_total", "Frame sends that failed or timed out", "provider", label), \
+    .m_reconnects = METRICS_COUNTER_INIT( \
+        "live_reconnects_total", "Sessions resumed after a dropped connection", "provider", label), \
+    .m_backlog_dropped = METRICS_COUNTER_INIT( \
+        "live_backlog_dropped_bytes_total", "Audio lost while disconnected because the backlog was full", \
+        "provider", label), \
+    .m_outage = METRICS_HISTOGRAM_MS_INIT( \
+        "live_outage_ms", "Time from a dropped connection to the resumed session", "provider", label), \
+    .m_chunk_ms = METRICS_GAUGE_INIT( \
+        "live_chunk_ms", "Audio per send chosen by the adaptive sender", "provider", label), \
+    .m_queue_ms = METRICS_GAUGE_INIT( \
+        "live_queue_ms", "Captured audio waiting to be sent", "provider", label), \
+    .m_queue_dropped = METRICS_COUNTER_INIT( \
+        "live_queue_dropped_bytes_total", "Captured audio dropped because the send queue was full", \
+        "provider", label), \
+}
 
-static live_stt_context_t s_ctx = {0};
-static bool s_initialized = false;
+static live_stt_session_t s_sessions[LIVE_STT_PROVIDER_MAX] = {
+    [LIVE_STT_DEEPGRAM] = SESSION_INIT(&live_stt_deepgram, "deepgram"),
+    [LIVE_STT_OPENAI] = SESSION_INIT(&live_stt_openai, "openai"),
+};
 
 // Forward declarations
 static void streaming_task(void *arg);
 static void websocket_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data);
-static void parse_deepgram_response(const char *data, int len);
 
 /**
- * Check if Deepgram API key is configured
+ * Release the state mutex, pushing the state to transcript clients if it changed
+ */
+static void unlock_and_publish(live_stt_session_t *s)
+{
+    if (s->state != s->published_state || s->error_message != s->published_error) {
+        s->published_state = s->state;
+        s->published_error = s->error_message;
+        transcript_push_state(s->ops->source, live_stt_state_name(s->state), s->error_message, NULL);
+    }
+    xSemaphoreGive(s->mutex);
+}
+
+/**
+ * Enter the error state, keeping the first error message (mutex held)
+ */
+static void fail_locked(live_stt_session_t *s, const char *message)
+{
+    s->state = LIVE_STT_STATE_ERROR;
+    if (!s->error_message) {
+        s->error_message = strdup(message);
+    }
+}
+
+/**
+ * Create the WebSocket client and start connecting
+ *
+ * Used for the first connection and for every reconnect. The client's own
+ * reconnect is disabled: a new connection must also restart the provider's
+ * audio stream and replay the backlog, which only the streaming task can
+ * do.
+ */
+static esp_err_t open_client(live_stt_session_t *s, const char **error)
+{
+    char ws_url[WS_URL_SIZE];
+    s->ops->url(ws_url, sizeof(ws_url));
+
+    // Configure WebSocket client with SSL certificate bundle
+    esp_websocket_client_config_t ws_cfg = {
+        .uri = ws_url,
+        .buffer_size = s->ops->ws_buffer_size,
+        .task_stack = WS_TASK_STACK,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .disable_auto_reconnect = true,
+    };
+
+    s->ws_client = esp_websocket_client_init(&ws_cfg);
+    if (!s->ws_client) {
+        ESP_LOGE(TAG, "%s: failed to create WebSocket client", s->ops->name);
+        *error = "Failed to create WebSocket client";
+        return ESP_FAIL;
+    }
+
+    s->ops->headers(s->ws_client);
+    esp_websocket_register_events(s->ws_client, WEBSOCKET_EVENT_ANY, websocket_event_handler, s);
+
+    // Start WebSocket connection
+    esp_err_t err = esp_websocket_client_start(s->ws_client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%s: failed to start WebSocket client: %s", s->ops->name, esp_err_to_name(err));
+        esp_websocket_client_destroy(s->ws_client);
+        s->ws_client = NULL;
+        *error = "Failed to connect";
+        return err;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Delete the session's mutex and task exit semaphores
+ */
+static void delete_sync(live_stt_session_t *s)
+{
+    if (s->mutex) {
+        vSemaphoreDelete(s->mutex);
+        s->mutex = NULL;
+    }
+    if (s->task_done) {
+        vSemaphoreDelete(s->task_done);
+        s->task_done = NULL;
+    }
+    if (s->capture_done) {
+        vSemaphoreDelete(s->capture_done);
+        s->capture_done = NULL;
+    }
+}
+
+/**
+ * Wait for a session task to give its exit semaphore
+ *
+ * The task shares the session's client and buffers, so there is no
+ * giving up: a late exit is only reported. The semaphore is left given
+ * so that every caller joining the same task wakes; it is cleared as
+ * the next task is created.
  */
-static bool is_deepgram_configured(void)
+static void join_task(live_stt_session_t *s, SemaphoreHandle_t done, const char *what)
 {
-#ifdef CONFIG_DEEPGRAM_API_KEY
-    return strlen(CONFIG_DEEPGRAM_API_KEY) > 0;
-#else
-    return false;
-#endif
+    if (xSemaphoreTake(done, pdMS_TO_TICKS(STOP_WAIT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "%s %s task still running after %d ms", s->ops->name, what, STOP_WAIT_MS);
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    xSemaphoreGive(done);
 }
 
 /**
- * Initialize Live STT module
+ * Initialize a provider session
  */
-esp_err_t live_stt_init(void)
+esp_err_t live_stt_init(live_stt_provider_t provider)
 {
-    if (s_initialized) {
+    if (provider >= LIVE_STT_PROVIDER_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    live_stt_session_t *s = &s_sessions[provider];
+    if (s->initialized) {
         return ESP_OK;
     }
 
-    if (!is_deepgram_configured()) {
-        ESP_LOGE(TAG, "Deepgram API key not configured. Use 'idf.py menuconfig' to set it.");
+    if (!s->ops->is_configured()) {
+        ESP_LOGE(TAG, "%s API key not configured. Use 'idf.py menuconfig' to set it.", s->ops->name);
         return ESP_ERR_INVALID_STATE;
     }
 
     // Create mutex
-    s_ctx.mutex = xSemaphoreCreateMutex();
-    if (!s_ctx.mutex) {
+    s->mutex = xSemaphoreCreateMutex();
+    s->task_done = xSemaphoreCreateBinary();
+    s->capture_done = xSemaphoreCreateBinary();
+    if (!s->mutex || !s->task_done || !s->capture_done) {
         ESP_LOGE(TAG, "Failed to create mutex");
+        delete_sync(s);
         return ESP_ERR_NO_MEM;
     }
 
     // Allocate transcript buffer in PSRAM
-    s_ctx.transcript = heap_caps_calloc(1, TRANSCRIPT_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
-    if (!s_ctx.transcript) {
+    s->transcript = heap_caps_calloc(1, TRANSCRIPT_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+    if (!s->transcript) {
         ESP_LOGE(TAG, "Failed to allocate transcript buffer in PSRAM");
-        vSemaphoreDelete(s_ctx.mutex);
+        delete_sync(s);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (ws_message_init(&s->message, MESSAGE_BUFFER_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate message buffer in PSRAM");
+        heap_caps_free(s->transcript);
+        s->transcript = NULL;
+        delete_sync(s);
         return ESP_ERR_NO_MEM;
     }
-    s_ctx.transcript_capacity = TRANSCRIPT_BUFFER_SIZE;
-    s_ctx.transcript_len = 0;
+    s->transcript_capacity = TRANSCRIPT_BUFFER_SIZE;
+    s->transcript_len = 0;
 
-    s_ctx.state = LIVE_STT_STATE_IDLE;
-    s_initialized = true;
+    s->state = LIVE_STT_STATE_IDLE;
+    s->initialized = true;
 
-    ESP_LOGI(TAG, "Live STT initialized (transcript buffer: %d KB)", TRANSCRIPT_BUFFER_SIZE / 1024);
+    ESP_LOGI(TAG, "%s live STT initialized (transcript buffer: %d KB)", s->ops->name,
+             TRANSCRIPT_BUFFER_SIZE / 1024);
     return ESP_OK;
 }
 
 /**
  * Start live transcription
  */
-esp_err_t live_stt_start(void)
+esp_err_t live_stt_start(live_stt_provider_t provider)
 {
-    if (!s_initialized) {
-        esp_err_t err = live_stt_init();
-        if (err != ESP_OK) {
-            return err;
-        }
+    esp_err_t err = live_stt_init(provider);
+    if (err != ESP_OK) {
+        return err;
     }
+    live_stt_session_t *s = &s_sessions[provider];
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
 
-    if (s_ctx.state == LIVE_STT_STATE_STREAMING || s_ctx.state == LIVE_STT_STATE_CONNECTING) {
-        xSemaphoreGive(s_ctx.mutex);
+    if (s->state == LIVE_STT_STATE_STREAMING || s->state == LIVE_STT_STATE_CONNECTING) {
+        xSemaphoreGive(s->mutex);
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Clear previous error
-    if (s_ctx.error_message) {
-        free(s_ctx.error_message);
-        s_ctx.error_message = NULL;
+    // After an error the last streaming task may still be winding down on the old client
+    if (s->task_running) {
+        s->stop_requested = true;
+        xSemaphoreGive(s->mutex);
+        join_task(s, s->task_done, "streaming");
+        xSemaphoreTake(s->mutex, portMAX_DELAY);
+        if (s->state == LIVE_STT_STATE_STREAMING || s->state == LIVE_STT_STATE_CONNECTING) {
+            xSemaphoreGive(s->mutex);
+            return ESP_ERR_INVALID_STATE;  // Another caller restarted it meanwhile
+        }
     }
 
-    s_ctx.state = LIVE_STT_STATE_CONNECTING;
-    s_ctx.stop_requested = false;
+    // Clear previous error
+    if (s->error_message) {
+        free(s->error_message);
+        s->error_message = NULL;
+    }
 
-    xSemaphoreGive(s_ctx.mutex);
+    s->state = LIVE_STT_STATE_CONNECTING;
+    s->stop_requested = false;
+    s->linked = false;
 
-#ifdef CONFIG_DEEPGRAM_API_KEY
-    // Build authorization header
-    char auth_header[256];
-    snprintf(auth_header, sizeof(auth_header), "Token %s", CONFIG_DEEPGRAM_API_KEY);
+    unlock_and_publish(s);
 
-    // Configure WebSocket client with SSL certificate bundle
-    esp_websocket_client_config_t ws_cfg = {
-        .uri = DEEPGRAM_WS_URL,
-        .buffer_size = 8192,
-        .task_stack = 8192,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-    };
-
-    s_ctx.ws_client = esp_websocket_client_init(&ws_cfg);
-    if (!s_ctx.ws_client) {
-        ESP_LOGE(TAG, "Failed to create WebSocket client");
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = LIVE_STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Failed to create WebSocket client");
-        xSemaphoreGive(s_ctx.mutex);
-        return ESP_FAIL;
+    // A session that ended in an error leaves its client behind
+    if (s->ws_client) {
+        esp_websocket_client_destroy(s->ws_client);
+        s->ws_client = NULL;
     }
 
-    // Set authorization header
-    esp_websocket_client_append_header(s_ctx.ws_client, "Authorization", auth_header);
-
-    // Register event handler
-    esp_websocket_register_events(s_ctx.ws_client, WEBSOCKET_EVENT_ANY, websocket_event_handler, NULL);
+    // Settings such as the encoding are fixed for the session, reconnects included
+    if (s->ops->begin) {
+        s->ops->begin();
+    }
 
-    // Start WebSocket connection
-    esp_err_t err = esp_websocket_client_start(s_ctx.ws_client);
+    const char *error = NULL;
+    err = open_client(s, &error);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start WebSocket client: %s", esp_err_to_name(err));
-        esp_websocket_client_destroy(s_ctx.ws_client);
-        s_ctx.ws_client = NULL;
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = LIVE_STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Failed to connect to Deepgram");
-        xSemaphoreGive(s_ctx.mutex);
+        xSemaphoreTake(s->mutex, portMAX_DELAY);
+        fail_locked(s, error);
+        unlock_and_publish(s);
         return err;
     }
 
-    ESP_LOGI(TAG, "Connecting to Deepgram...");
+    ESP_LOGI(TAG, "Connecting to %s...", s->ops->name);
     return ESP_OK;
-#else
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    s_ctx.state = LIVE_STT_STATE_ERROR;
-    s_ctx.error_message = strdup("Deepgram API key not configured");
-    xSemaphoreGive(s_ctx.mutex);
-    return ESP_ERR_INVALID_STATE;
-#endif
 }
 
 /**
  * Stop live transcription
  */
-esp_err_t live_stt_stop(void)
+esp_err_t live_stt_stop(live_stt_provider_t provider)
 {
-    if (!s_initialized) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized) {
         return ESP_OK;
     }
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
 
-    if (s_ctx.state != LIVE_STT_STATE_STREAMING && s_ctx.state != LIVE_STT_STATE_CONNECTING) {
-        xSemaphoreGive(s_ctx.mutex);
+    if (s->state != LIVE_STT_STATE_STREAMING && s->state != LIVE_STT_STATE_CONNECTING) {
+        xSemaphoreGive(s->mutex);
         return ESP_OK;
     }
 
-    s_ctx.stop_requested = true;
-    xSemaphoreGive(s_ctx.mutex);
+    // No streaming task starts once the stop is requested, so a running one is the last
+    s->stop_requested = true;
+    bool task_running = s->task_running;
+    unlock_and_publish(s);
 
-    // Wait for streaming task to finish
-    if (s_ctx.streaming_task) {
-        for (int i = 0; i < 50; i++) {  // Wait up to 5 seconds
-            if (s_ctx.streaming_task == NULL) break;
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
+    // Join the streaming task: it may be replacing the client in a reconnect
+    if (task_running) {
+        join_task(s, s->task_done, "streaming");
     }
 
     // Close WebSocket
-    if (s_ctx.ws_client) {
-        esp_websocket_client_stop(s_ctx.ws_client);
-        esp_websocket_client_destroy(s_ctx.ws_client);
-        s_ctx.ws_client = NULL;
+    if (s->ws_client) {
+        esp_websocket_client_stop(s->ws_client);
+        esp_websocket_client_destroy(s->ws_client);
+        s->ws_client = NULL;
     }
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    s_ctx.state = LIVE_STT_STATE_IDLE;
-    xSemaphoreGive(s_ctx.mutex);
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    s->state = LIVE_STT_STATE_IDLE;
+    unlock_and_publish(s);
 
-    ESP_LOGI(TAG, "Live STT stopped");
+    ESP_LOGI(TAG, "%s live STT stopped", s->ops->name);
     return ESP_OK;
 }
 
 /**
  * Get current status
  */
-esp_err_t live_stt_get_status(live_stt_status_t *status)
+esp_err_t live_stt_get_status(live_stt_provider_t provider, live_stt_status_t *status)
 {
-    if (!status) {
+    if (!status || provider >= LIVE_STT_PROVIDER_MAX) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (!s_initialized) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized) {
         status->state = LIVE_STT_STATE_IDLE;
         status->transcript = NULL;
         status->error_message = NULL;
         return ESP_OK;
     }
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    status->state = s_ctx.state;
-    status->transcript = (s_ctx.transcript_len > 0) ? s_ctx.transcript : NULL;
-    status->error_message = s_ctx.error_message;
-    xSemaphoreGive(s_ctx.mutex);
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    status->state = s->state;
+    status->transcript = (s->transcript_len > 0) ? s->transcript : NULL;
+    status->error_message = s->error_message;
+    xSemaphoreGive(s->mutex);
 
     return ESP_OK;
 }
@@ -261,81 +422,107 @@ esp_err_t live_stt_get_status(live_stt_status_t *status)
 /**
  * Get current state
  */
-live_stt_state_t live_stt_get_state(void)
+live_stt_state_t live_stt_get_state(live_stt_provider_t provider)
 {
-    if (!s_initialized) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized) {
         return LIVE_STT_STATE_IDLE;
     }
-    return s_ctx.state;
+    return s->state;
+}
+
+/**
+ * Get the name of a state
+ */
+const char *live_stt_state_name(live_stt_state_t state)
+{
+    switch (state) {
+        case LIVE_STT_STATE_IDLE: return "idle";
+        case LIVE_STT_STATE_CONNECTING: return "connecting";
+        case LIVE_STT_STATE_STREAMING: return "streaming";
+        case LIVE_STT_STATE_ERROR: return "error";
+        default: return "unknown";
+    }
+}
+
+/**
+ * Get the display name of a provider
+ */
+const char *live_stt_provider_name(live_stt_provider_t provider)
+{
+    return provider < LIVE_STT_PROVIDER_MAX ? s_sessions[provider].ops->name : "unknown";
 }
 
 /**
  * Get accumulated transcript
  */
-const char *live_stt_get_transcript(void)
+const char *live_stt_get_transcript(live_stt_provider_t provider)
 {
-    if (!s_initialized || s_ctx.transcript_len == 0) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized || s->transcript_len == 0) {
         return NULL;
     }
-    return s_ctx.transcript;
+    return s->transcript;
 }
 
 /**
  * Clear accumulated transcript
  */
-void live_stt_clear_transcript(void)
+void live_stt_clear_transcript(live_stt_provider_t provider)
 {
-    if (!s_initialized) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized) {
         return;
     }
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    if (s_ctx.transcript) {
-        s_ctx.transcript[0] = '\0';
-        s_ctx.transcript_len = 0;
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    if (s->transcript) {
+        s->transcript[0] = '\0';
+        s->transcript_len = 0;
     }
-    xSemaphoreGive(s_ctx.mutex);
+    transcript_push_clear(s->ops->source);
+    unlock_and_publish(s);
 }
 
 /**
  * Check if busy
  */
-bool live_stt_is_busy(void)
+bool live_stt_is_busy(live_stt_provider_t provider)
 {
-    if (!s_initialized) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized) {
         return false;
     }
-    return s_ctx.state == LIVE_STT_STATE_STREAMING || s_ctx.state == LIVE_STT_STATE_CONNECTING;
+    return s->state == LIVE_STT_STATE_STREAMING || s->state == LIVE_STT_STATE_CONNECTING;
 }
 
 /**
  * Cleanup
  */
-void live_stt_cleanup(void)
+void live_stt_cleanup(live_stt_provider_t provider)
 {
-    if (!s_initialized) {
+    live_stt_session_t *s = &s_sessions[provider];
+    if (!s->initialized) {
         return;
     }
 
-    live_stt_stop();
+    live_stt_stop(provider);
 
-    if (s_ctx.transcript) {
-        heap_caps_free(s_ctx.transcript);
-        s_ctx.transcript = NULL;
+    if (s->transcript) {
+        heap_caps_free(s->transcript);
+        s->transcript = NULL;
     }
+    ws_message_free(&s->message);
 
-    if (s_ctx.error_message) {
-        free(s_ctx.error_message);
-        s_ctx.error_message = NULL;
+    if (s->error_message) {
+        free(s->error_message);
+        s->error_message = NULL;
     }
 
-    if (s_ctx.mutex) {
-        vSemaphoreDelete(s_ctx.mutex);
-        s_ctx.mutex = NULL;
-    }
+    delete_sync(s);
 
-    s_initialized = false;
-    ESP_LOGI(TAG, "Live STT cleaned up");
+    s->initialized = false;
+    ESP_LOGI(TAG, "%s live STT cleaned up", s->ops->name);
 }
 
 /**
@@ -343,58 +530,99 @@ void live_stt_cleanup(void)
  */
 static void websocket_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
+    live_stt_session_t *s = handler_args;
     esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
 
     switch (event_id) {
-        case WEBSOCKET_EVENT_CONNECTED:
-            ESP_LOGI(TAG, "WebSocket connected to Deepgram");
-            xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-            s_ctx.state = LIVE_STT_STATE_STREAMING;
-            xSemaphoreGive(s_ctx.mutex);
+        case WEBSOCKET_EVENT_CONNECTED: {
+            ESP_LOGI(TAG, "WebSocket connected to %s", s->ops->name);
+
+            // Every connection is a new provider session
+            bool ready = !s->ops->on_connected || s->ops->on_connected(s) == ESP_OK;
+
+            xSemaphoreTake(s->mutex, portMAX_DELAY);
+            bool resumed = s->task_running;
+            if (s->stop_requested) {
+                unlock_and_publish(s);  // live_stt_stop() closes this client
+                break;
+            }
+            if (!ready) {
+                if (resumed) {
+                    s->drops++;  // Retried like a failed reconnect
+                } else {
+                    fail_locked(s, "Session configuration failed");
+                }
+                unlock_and_publish(s);
+                break;
+            }
+            s->state = LIVE_STT_STATE_STREAMING;
+            s->linked = true;
+            if (!resumed) {
+                xSemaphoreTake(s->task_done, 0);  // Still given from the last task's exit
+            }
+            s->task_running = true;
+            unlock_and_publish(s);
+            if (resumed) {
+                break;  // The streaming task restarts its stream and replays the backlog
+            }
 
             // Start audio streaming task
-            BaseType_t ret = xTaskCreate(streaming_task, "live_stt_stream", 8192, NULL, 5, &s_ctx.streaming_task);
+            BaseType_t ret = xTaskCreatePinnedToCore(streaming_task, s->ops->task_name, s->ops->task_stack, s,
+                                                     s->ops->task_priority, &s->streaming_task, s->ops->task_core);
             if (ret != pdPASS) {
                 ESP_LOGE(TAG, "Failed to create streaming task");
-                xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-                s_ctx.state = LIVE_STT_STATE_ERROR;
-                s_ctx.error_message = strdup("Failed to start audio streaming");
-                xSemaphoreGive(s_ctx.mutex);
+                xSemaphoreTake(s->mutex, portMAX_DELAY);
+                s->task_running = false;
+                s->streaming_task = NULL;
+                fail_locked(s, "Failed to start audio streaming");
+                unlock_and_publish(s);
+                xSemaphoreGive(s->task_done);
             }
             break;
+        }
 
         case WEBSOCKET_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "WebSocket disconnected");
-            xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-            if (s_ctx.state == LIVE_STT_STATE_STREAMING) {
-                s_ctx.stop_requested = true;
+            ESP_LOGI(TAG, "WebSocket to %s disconnected", s->ops->name);
+            xSemaphoreTake(s->mutex, portMAX_DELAY);
+            s->linked = false;
+            s->drops++;
+            if (LIVE_RESUME_ENABLED && s->task_running && !s->stop_requested &&
+                s->state != LIVE_STT_STATE_ERROR) {
+                // The streaming task keeps capturing and reconnects; clients see "connecting"
+                s->state = LIVE_STT_STATE_CONNECTING;
+                unlock_and_publish(s);
+                break;
             }
-            if (!s_ctx.stop_requested) {
-                s_ctx.state = LIVE_STT_STATE_ERROR;
-                if (!s_ctx.error_message) {
-                    s_ctx.error_message = strdup("Connection lost");
-                }
+            if (s->state == LIVE_STT_STATE_STREAMING) {
+                s->stop_requested = true;
+            }
+            if (!s->stop_requested) {
+                fail_locked(s, "Connection lost");
             } else {
-                s_ctx.state = LIVE_STT_STATE_IDLE;
+                s->state = LIVE_STT_STATE_IDLE;
             }
-            xSemaphoreGive(s_ctx.mutex);
+            unlock_and_publish(s);
             break;
 
-        case WEBSOCKET_EVENT_DATA:
-            if (data->op_code == 0x01) {  // Text frame
-                ESP_LOGD(TAG, "Received: %.*s", data->data_len, (char *)data->data_ptr);
-                parse_deepgram_response((const char *)data->data_ptr, data->data_len);
+        case WEBSOCKET_EVENT_DATA: {
+            const char *text;
+            size_t text_len;
+            if (ws_message_feed(&s->message, data, &text, &text_len)) {
+                ESP_LOGD(TAG, "Received: %.*s", (int)text_len, text);
+                s->ops->parse(s, text, text_len);
             }
             break;
+        }
 
         case WEBSOCKET_EVENT_ERROR:
-            ESP_LOGE(TAG, "WebSocket error");
-            xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-            s_ctx.state = LIVE_STT_STATE_ERROR;
-            if (!s_ctx.error_message) {
-                s_ctx.error_message = strdup("WebSocket error");
+            ESP_LOGE(TAG, "WebSocket error (%s)", s->ops->name);
+            xSemaphoreTake(s->mutex, portMAX_DELAY);
+            if (LIVE_RESUME_ENABLED && s->task_running && !s->stop_requested) {
+                xSemaphoreGive(s->mutex);  // Transport errors mid-session end in a reconnect
+                break;
             }
-            xSemaphoreGive(s_ctx.mutex);
+            fail_locked(s, "WebSocket error");
+            unlock_and_publish(s);
             break;
 
         default:
@@ -403,180 +631,541 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base, i
 }
 
 /**
- * Parse Deepgram JSON response and append transcript
+ * Decode a transcript string onto the accumulated transcript (mutex held)
  */
-static void parse_deepgram_response(const char *data, int len)
+static void append_transcript(live_stt_session_t *s, const json_scan_value_t *text)
 {
-    // Make a null-terminated copy
-    char *json_str = malloc(len + 1);
-    if (!json_str) {
-        return;
-    }
-    memcpy(json_str, data, len);
-    json_str[len] = '\0';
+    size_t start = s->transcript_len;
 
-    cJSON *root = cJSON_Parse(json_str);
-    free(json_str);
+    // Add space before new text if not at start
+    if (s->transcript_len > 0 && s->transcript_len + 1 < s->transcript_capacity) {
+        s->transcript[s->transcript_len] = ' ';
+        s->transcript_len++;
+    }
 
-    if (!root) {
-        ESP_LOGW(TAG, "Failed to parse Deepgram response");
+    // Decode straight into the buffer; truncates once it is full
+    size_t added = json_scan_unescape(text, s->transcript + s->transcript_len,
+                                      s->transcript_capacity - s->transcript_len);
+    if (added == 0) {
+        s->transcript_len = start;
+        s->transcript[start] = '\0';
         return;
     }
 
-    // Check for error
-    cJSON *error = cJSON_GetObjectItem(root, "error");
-    if (error) {
-        cJSON *message = cJSON_GetObjectItem(error, "message");
-        if (message && cJSON_IsString(message)) {
-            ESP_LOGE(TAG, "Deepgram error: %s", message->valuestring);
-            xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-            if (s_ctx.error_message) free(s_ctx.error_message);
-            s_ctx.error_message = strdup(message->valuestring);
-            s_ctx.state = LIVE_STT_STATE_ERROR;
-            xSemaphoreGive(s_ctx.mutex);
+    ESP_LOGI(TAG, "Transcript: %s", s->transcript + s->transcript_len);
+    s->transcript_len += added;
+    transcript_push_delta(s->ops->source, start, s->transcript + start, s->transcript_len - start);
+}
+
+void live_stt_on_transcript(live_stt_session_t *s, const json_scan_value_t *text, bool end_of_turn)
+{
+    if (!text || text->len == 0) {
+        if (end_of_turn) {
+            conversation_on_transcript(s->ops->source, NULL, 0, true);
         }
-        cJSON_Delete(root);
         return;
     }
 
-    // Extract transcript from channel.alternatives[0].transcript
-    cJSON *channel = cJSON_GetObjectItem(root, "channel");
-    if (!channel) {
-        cJSON_Delete(root);
-        return;
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    size_t start = s->transcript_len;
+    append_transcript(s, text);
+    conversation_on_transcript(s->ops->source, s->transcript + start, s->transcript_len - start, end_of_turn);
+    unlock_and_publish(s);
+}
+
+void live_stt_on_error(live_stt_session_t *s, const char *message)
+{
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    if (s->error_message) {
+        free(s->error_message);
     }
+    s->error_message = strdup(message);
+    s->state = LIVE_STT_STATE_ERROR;
+    unlock_and_publish(s);
+}
 
-    cJSON *alternatives = cJSON_GetObjectItem(channel, "alternatives");
-    if (!alternatives || !cJSON_IsArray(alternatives) || cJSON_GetArraySize(alternatives) == 0) {
-        cJSON_Delete(root);
-        return;
+int live_stt_send_audio(live_stt_session_t *s, const void *data, size_t len, bool text)
+{
+    int64_t start_us = esp_timer_get_time();
+    int sent = text ? esp_websocket_client_send_text(s->ws_client, data, len, pdMS_TO_TICKS(1000)) :
+                      esp_websocket_client_send_bin(s->ws_client, data, len, pdMS_TO_TICKS(1000));
+    metrics_observe_since(&s->m_send, start_us);
+    if (sent < 0) {
+        metrics_inc(&s->m_send_failures);
+        ESP_LOGW(TAG, "WebSocket send failed");
+    } else {
+        metrics_add(&s->m_send_bytes, sent);
     }
+    return sent;
+}
 
-    cJSON *first_alt = cJSON_GetArrayItem(alternatives, 0);
-    if (!first_alt) {
-        cJSON_Delete(root);
-        return;
+esp_err_t live_stt_send_control(live_stt_session_t *s, const char *text, uint32_t timeout_ms)
+{
+    if (esp_websocket_client_send_text(s->ws_client, text, strlen(text), pdMS_TO_TICKS(timeout_ms)) < 0) {
+        ESP_LOGW(TAG, "WebSocket send failed");
+        return ESP_FAIL;
     }
+    return ESP_OK;
+}
 
-    cJSON *transcript = cJSON_GetObjectItem(first_alt, "transcript");
-    if (!transcript || !cJSON_IsString(transcript) || strlen(transcript->valuestring) == 0) {
-        cJSON_Delete(root);
-        return;
+bool live_stt_connected(live_stt_session_t *s)
+{
+    return s->ws_client && esp_websocket_client_is_connected(s->ws_client);
+}
+
+/**
+ * Replace the dropped client with a new connection attempt
+ *
+ * Runs on the streaming task; the old client's events have all been
+ * delivered once destroy returns.
+ *
+ * @return ESP_OK if the attempt is under way, an error if it could not start
+ */
+static esp_err_t reconnect(live_stt_session_t *s)
+{
+    ESP_LOGI(TAG, "Reconnecting to %s...", s->ops->name);
+    if (s->ws_client) {
+        esp_websocket_client_destroy(s->ws_client);
+        s->ws_client = NULL;
+    }
+    const char *error = NULL;
+    esp_err_t err = open_client(s, &error);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Reconnect failed: %s", error);
     }
+    return err;
+}
 
-    // Append to accumulated transcript
-    const char *text = transcript->valuestring;
-    size_t text_len = strlen(text);
+/**
+ * Capture task - reads the microphone in short frames and queues them
+ *
+ * Never waits on the network, so a slow send cannot make the engine drop
+ * audio, and the gate decides on each frame as it is captured rather
+ * than when it is sent. Records are a 4-byte header (gate action,
+ * reserved, little-endian length) and the frame.
+ */
+static void capture_task(void *arg)
+{
+    live_stt_session_t *s = arg;
+    const size_t frame_bytes = s->ops->sample_rate * 2 * FRAME_MS / 1000;
+    uint8_t *record = s->capture_record;
+    uint8_t *pcm = record + RECORD_HEADER;
+
+    vad_gate_t gate;
+    vad_gate_init(&gate, s->ops->keepalive_ms);
+
+    while (s->capture_run) {
+        size_t num_samples = audio_engine_capture_read(s->capture, (int16_t *)pcm, frame_bytes / 2,
+                                                       FRAME_MS + 50);
+        if (num_samples == 0) {
+            continue;
+        }
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+        // Silence is not queued; the sender may turn a close or keepalive into a provider message
+        vad_gate_action_t action = vad_gate_check(&gate);
+        if (action == VAD_GATE_DROP) {
+            continue;
+        }
 
-    // Add space before new text if not at start
-    if (s_ctx.transcript_len > 0 && s_ctx.transcript_len + 1 < s_ctx.transcript_capacity) {
-        s_ctx.transcript[s_ctx.transcript_len] = ' ';
-        s_ctx.transcript_len++;
+        size_t len = (action == VAD_GATE_SEND) ? num_samples * 2 : 0;
+        record[0] = action;
+        record[1] = 0;
+        record[2] = len & 0xFF;
+        record[3] = len >> 8;
+        if (spsc_ring_free_space(s->queue) < RECORD_HEADER + len) {
+            metrics_add(&s->m_queue_dropped, len);  // The sender has stalled for the whole queue
+            continue;
+        }
+        spsc_ring_write(s->queue, record, RECORD_HEADER + len);
+    }
+
+    ESP_LOGI(TAG, "Capture stopped (%lu silent frames not sent)", (unsigned long)gate.dropped);
+    s->capture_task = NULL;
+    xSemaphoreGive(s->capture_done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Streaming task state
+ */
+typedef struct {
+    live_stt_session_t *s;
+    uint8_t *batch;                 // Frames waiting to go out in one send (internal RAM)
+    size_t batch_len;
+    uint8_t *scratch;               // Queue records and backlog replay (PSRAM)
+    size_t bytes_per_ms;
+    uint32_t chunk_ms;              // Current send size
+    int64_t send_ewma_us;           // Smoothed time per send
+    uint32_t calm;                  // Consecutive sends with time and queue to spare
+    uint32_t sends;
+    uint32_t sent_ms;               // Audio sent
+    bool linked;
+    bool stream_open;               // Provider stream of the current connection
+    uint32_t drops;                 // s->drops last acted on
+    live_resume_t resume;
+} sender_t;
+
+/**
+ * Size the next sends from the last one
+ *
+ * A send that takes half the audio it carries, or audio piling up in the
+ * queue, means the link cannot keep up with small frames: double the
+ * frame so per-message overhead and round trips drop. While sends finish
+ * in an eighth of their audio and the queue is near empty, shrink one
+ * capture frame at a time for lower latency.
+ */
+static void adapt_chunk(sender_t *tx, int64_t send_us)
+{
+    live_stt_session_t *s = tx->s;
+    tx->send_ewma_us += (send_us - tx->send_ewma_us) / 4;
+    uint32_t queued_ms = spsc_ring_available(s->queue) / tx->bytes_per_ms;
+    int64_t budget_us = (int64_t)tx->chunk_ms * 1000;
+
+    if (tx->send_ewma_us > budget_us / 2 || queued_ms > 2 * tx->chunk_ms) {
+        tx->chunk_ms = tx->chunk_ms * 2 < CHUNK_MAX_MS ? tx->chunk_ms * 2 : CHUNK_MAX_MS;
+        tx->calm = 0;
+    } else if (tx->send_ewma_us < budget_us / 8 && queued_ms < tx->chunk_ms) {
+        if (++tx->calm >= CALM_SENDS && tx->chunk_ms > CHUNK_MIN_MS) {
+            tx->chunk_ms = tx->chunk_ms - FRAME_MS > CHUNK_MIN_MS ? tx->chunk_ms - FRAME_MS : CHUNK_MIN_MS;
+            tx->calm = 0;
+        }
+    } else {
+        tx->calm = 0;
+    }
+
+    metrics_set(&s->m_chunk_ms, tx->chunk_ms);
+    metrics_set(&s->m_queue_ms, queued_ms);
+}
+
+static void check_link(sender_t *tx);
+
+/**
+ * Send the batched audio, or keep it in the backlog while disconnected
+ */
+static void send_batch(sender_t *tx, bool live)
+{
+    live_stt_session_t *s = tx->s;
+    if (tx->batch_len == 0) {
+        return;
     }
 
-    // Append text
-    size_t copy_len = text_len;
-    if (s_ctx.transcript_len + copy_len >= s_ctx.transcript_capacity) {
-        copy_len = s_ctx.transcript_capacity - s_ctx.transcript_len - 1;
+    // A batch holds up to CHUNK_MAX_MS of audio; never hand it to a client that has dropped
+    check_link(tx);
+    if (!tx->linked) {
+        metrics_add(&s->m_backlog_dropped, live_resume_push(&tx->resume, tx->batch, tx->batch_len));
+        tx->batch_len = 0;
+        return;
     }
 
-    if (copy_len > 0) {
-        memcpy(s_ctx.transcript + s_ctx.transcript_len, text, copy_len);
-        s_ctx.transcript_len += copy_len;
-        s_ctx.transcript[s_ctx.transcript_len] = '\0';
-        ESP_LOGI(TAG, "Transcript: %s", text);
+    int64_t start_us = esp_timer_get_time();
+    s->ops->stream_audio(s, tx->batch, tx->batch_len);
+    if (live) {
+        adapt_chunk(tx, esp_timer_get_time() - start_us);
     }
 
-    xSemaphoreGive(s_ctx.mutex);
-    cJSON_Delete(root);
+    uint32_t before_s = tx->sent_ms / 5000;
+    tx->sends++;
+    tx->sent_ms += tx->batch_len / tx->bytes_per_ms;
+    tx->batch_len = 0;
+    if (tx->sent_ms / 5000 != before_s) {  // Log every 5 seconds of audio
+        ESP_LOGI(TAG, "Streamed %.1f seconds in %lu sends, now %lu ms per send",
+                 tx->sent_ms / 1000.0f, (unsigned long)tx->sends, (unsigned long)tx->chunk_ms);
+    }
 }
 
 /**
- * Audio streaming task - reads from microphone and sends to WebSocket
+ * Add audio to the batch, sending whenever it reaches limit bytes
  */
-static void streaming_task(void *arg)
+static void batch_audio(sender_t *tx, const uint8_t *data, size_t len, size_t limit, bool live)
 {
-    ESP_LOGI(TAG, "Streaming task started");
+    while (len > 0) {
+        size_t n = limit - tx->batch_len < len ? limit - tx->batch_len : len;
+        memcpy(tx->batch + tx->batch_len, data, n);
+        tx->batch_len += n;
+        data += n;
+        len -= n;
+        if (tx->batch_len >= limit) {
+            send_batch(tx, live);
+        }
+    }
+}
 
-    // Configure codec for recording (16kHz, 16-bit, stereo I2S but we extract mono)
-    esp_err_t err = bsp_extra_codec_set_fs(LIVE_STT_SAMPLE_RATE, LIVE_STT_BITS_PER_SAMPLE, I2S_SLOT_MODE_STEREO);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure codec: %s", esp_err_to_name(err));
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = LIVE_STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Failed to configure audio codec");
-        s_ctx.streaming_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
-        vTaskDelete(NULL);
+/**
+ * Act on drops the event handler has seen: a lost link, or a reconnect
+ * attempt that failed; either backs off before the next attempt
+ *
+ * Checked for every record as well as every pass, so audio dequeued after
+ * the disconnect goes to the backlog instead of the dead client.
+ */
+static void check_link(sender_t *tx)
+{
+    live_stt_session_t *s = tx->s;
+    if (s->drops == tx->drops) {
         return;
     }
+    tx->drops = s->drops;
+
+    // Starts the outage, and allocates the backlog on the first drop
+    bool was_linked = tx->linked;
+    tx->linked = false;
+    live_resume_lost(&tx->resume);
+
+    if (was_linked) {
+        ESP_LOGW(TAG, "Connection to %s lost, buffering audio", s->ops->name);
+        send_batch(tx, false);  // Into the backlog
+        if (tx->stream_open && s->ops->stream_close) {
+            s->ops->stream_close(s, false);  // The stream ended with the connection
+        }
+        tx->stream_open = false;
+    }
+}
 
-    // Allocate chunk buffers (stereo input = 2x mono size)
-    uint8_t *stereo_chunk = heap_caps_malloc(CHUNK_SIZE_BYTES * 2, MALLOC_CAP_INTERNAL);
-    uint8_t *mono_chunk = heap_caps_malloc(CHUNK_SIZE_BYTES, MALLOC_CAP_INTERNAL);
-
-    if (!stereo_chunk || !mono_chunk) {
-        ESP_LOGE(TAG, "Failed to allocate chunk buffers");
-        if (stereo_chunk) heap_caps_free(stereo_chunk);
-        if (mono_chunk) heap_caps_free(mono_chunk);
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = LIVE_STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Memory allocation failed");
-        s_ctx.streaming_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
-        vTaskDelete(NULL);
+/**
+ * Handle one captured record
+ */
+static void handle_record(sender_t *tx, vad_gate_action_t action, const uint8_t *pcm, size_t len)
+{
+    live_stt_session_t *s = tx->s;
+    const live_stt_provider_ops_t *ops = s->ops;
+
+    // Disconnected, or still replaying: live audio queues behind the backlog
+    check_link(tx);
+    bool behind = !tx->linked || live_resume_pending(&tx->resume);
+
+    if (action == VAD_GATE_SEND) {
+        if (behind) {
+            metrics_add(&s->m_backlog_dropped, live_resume_push(&tx->resume, pcm, len));
+        } else {
+            batch_audio(tx, pcm, len, tx->chunk_ms * tx->bytes_per_ms, true);
+        }
         return;
     }
 
-    uint32_t chunk_count = 0;
+    // Gated silence: whatever is batched goes now
+    send_batch(tx, true);
+    if (action == VAD_GATE_CLOSE && ops->stream_end_of_utterance) {
+        if (behind) {
+            metrics_add(&s->m_backlog_dropped, live_resume_push(&tx->resume, NULL, 0));
+        } else {
+            ops->stream_end_of_utterance(s);
+        }
+    } else if (action == VAD_GATE_KEEPALIVE && ops->stream_keepalive && !behind) {
+        ops->stream_keepalive(s);
+    }
+}
+
+/**
+ * Replay the backlog ahead of live audio, for half a frame of wall time
+ * per pass so the queue never falls behind; replay goes out in the
+ * largest sends (the provider catches up faster than real time)
+ */
+static void replay_backlog(sender_t *tx, size_t max_bytes)
+{
+    live_stt_session_t *s = tx->s;
+    int64_t deadline_us = esp_timer_get_time() + FRAME_MS * 1000 / 2;
+    size_t len;
+
+    while (esp_timer_get_time() < deadline_us &&
+           live_resume_pop(&tx->resume, tx->scratch, max_bytes, &len)) {
+        if (len == 0) {
+            send_batch(tx, false);
+            s->ops->stream_end_of_utterance(s);
+        } else {
+            batch_audio(tx, tx->scratch, len, max_bytes, false);
+        }
+    }
+
+    if (!live_resume_pending(&tx->resume)) {
+        send_batch(tx, false);
+        ESP_LOGI(TAG, "Backlog replayed, streaming live audio");
+        live_resume_free(&tx->resume);
+    }
+}
+
+/**
+ * Send loop of the streaming task; returns when the session ends
+ */
+static void stream_audio_loop(sender_t *tx, size_t max_bytes)
+{
+    live_stt_session_t *s = tx->s;
+    const live_stt_provider_ops_t *ops = s->ops;
+
+    while (!s->stop_requested && s->state != LIVE_STT_STATE_ERROR) {
+        // Without resume a drop ends the session
+        if (!LIVE_RESUME_ENABLED && !s->linked) {
+            break;
+        }
+
+        spsc_ring_wait_data(s->queue, RECORD_HEADER, pdMS_TO_TICKS(FRAME_MS * 5));
 
-    while (!s_ctx.stop_requested && s_ctx.ws_client && esp_websocket_client_is_connected(s_ctx.ws_client)) {
-        // Read from microphone (stereo I2S data)
-        size_t bytes_read = 0;
-        err = bsp_extra_i2s_read(stereo_chunk, CHUNK_SIZE_BYTES * 2, &bytes_read, CHUNK_DURATION_MS + 50);
+        check_link(tx);
 
-        if (err != ESP_OK || bytes_read == 0) {
-            if (err != ESP_OK) {
-                ESP_LOGW(TAG, "I2S read error: %s", esp_err_to_name(err));
+        if (!tx->linked && s->linked) {
+            tx->linked = true;
+            metrics_inc(&s->m_reconnects);
+            metrics_observe(&s->m_outage, live_resume_restored(&tx->resume));
+            if (ops->stream_open && ops->stream_open(s, max_bytes) != ESP_OK) {
+                xSemaphoreTake(s->mutex, portMAX_DELAY);
+                fail_locked(s, "Failed to start audio stream");
+                unlock_and_publish(s);
+                return;
             }
-            vTaskDelay(pdMS_TO_TICKS(10));
-            continue;
+            tx->stream_open = true;
         }
 
-        // Convert stereo to mono (take left channel only)
-        int16_t *stereo_samples = (int16_t *)stereo_chunk;
-        int16_t *mono_samples = (int16_t *)mono_chunk;
-        size_t num_stereo_samples = bytes_read / 4;  // 4 bytes per stereo sample pair
+        if (!tx->linked) {
+            if (live_resume_expired(&tx->resume)) {
+                ESP_LOGE(TAG, "Could not reconnect to %s, giving up", ops->name);
+                xSemaphoreTake(s->mutex, portMAX_DELAY);
+                fail_locked(s, "Connection lost");
+                unlock_and_publish(s);
+                return;
+            }
+            if (live_resume_due(&tx->resume) && reconnect(s) != ESP_OK) {
+                live_resume_lost(&tx->resume);  // Back to the backoff, not the attempt timeout
+            }
+        }
 
-        for (size_t i = 0; i < num_stereo_samples; i++) {
-            mono_samples[i] = stereo_samples[i * 2];  // Left channel
+        // Everything captured since the last pass
+        uint8_t hdr[RECORD_HEADER];
+        while (spsc_ring_available(s->queue) >= RECORD_HEADER) {
+            spsc_ring_read(s->queue, hdr, RECORD_HEADER);
+            size_t len = hdr[2] | (hdr[3] << 8);
+            // The capture task checked for space before writing, so the rest of the record is moments away
+            spsc_ring_wait_data(s->queue, len, portMAX_DELAY);
+            spsc_ring_read(s->queue, tx->scratch, len);
+            handle_record(tx, (vad_gate_action_t)hdr[0], tx->scratch, len);
         }
 
-        size_t mono_size = num_stereo_samples * 2;
+        if (tx->linked && live_resume_pending(&tx->resume)) {
+            replay_backlog(tx, max_bytes);
+        }
+    }
 
-        // Send via WebSocket
-        int sent = esp_websocket_client_send_bin(s_ctx.ws_client, (const char *)mono_chunk, mono_size, pdMS_TO_TICKS(1000));
-        if (sent < 0) {
-            ESP_LOGW(TAG, "WebSocket send failed");
-        } else {
-            chunk_count++;
-            if ((chunk_count % 25) == 0) {  // Log every 5 seconds
-                ESP_LOGI(TAG, "Streamed %lu chunks (%.1f seconds)",
-                         (unsigned long)chunk_count, chunk_count * CHUNK_DURATION_MS / 1000.0f);
-            }
+    if (tx->stream_open) {
+        if (s->linked) {
+            send_batch(tx, false);
+        }
+        if (ops->stream_close) {
+            ops->stream_close(s, s->linked);
         }
     }
+}
 
-    ESP_LOGI(TAG, "Streaming task stopped after %lu chunks", (unsigned long)chunk_count);
+/**
+ * Round a queue size up to the power of two the ring needs
+ */
+static size_t queue_size(size_t bytes)
+{
+    size_t size = 4096;
+    while (size < bytes) {
+        size <<= 1;
+    }
+    return size;
+}
 
-    heap_caps_free(stereo_chunk);
-    heap_caps_free(mono_chunk);
+/**
+ * Audio streaming task - sends queued microphone audio to the WebSocket
+ *
+ * Owns the session from the first connection to the end. The capture task
+ * feeds it frames through a queue; it batches them into sends sized to
+ * the link, keeps them in the resume backlog while the link is down,
+ * schedules reconnects, and replays the backlog once the link is back.
+ */
+static void streaming_task(void *arg)
+{
+    live_stt_session_t *s = arg;
+    const live_stt_provider_ops_t *ops = s->ops;
+    const size_t bytes_per_ms = ops->sample_rate * 2 / 1000;
+    const size_t max_bytes = bytes_per_ms * CHUNK_MAX_MS;
+    const char *failure = NULL;
+
+    ESP_LOGI(TAG, "Streaming task started (%s)", ops->name);
+
+    sender_t tx = {
+        .s = s,
+        .bytes_per_ms = bytes_per_ms,
+        .chunk_ms = ops->chunk_ms < CHUNK_MIN_MS ? CHUNK_MIN_MS :
+                    ops->chunk_ms > CHUNK_MAX_MS ? CHUNK_MAX_MS : ops->chunk_ms,
+        .linked = true,             // Started from WEBSOCKET_EVENT_CONNECTED
+        .drops = s->drops,
+    };
+    live_resume_init(&tx.resume, bytes_per_ms * LIVE_RESUME_BACKLOG_MS);
+
+    // Mono microphone stream at the provider rate from the audio engine
+    esp_err_t err = audio_engine_capture_open(ops->sample_rate, CAPTURE_BUFFER_MS, &s->capture);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open capture stream: %s", esp_err_to_name(err));
+        failure = "Failed to open microphone";
+    }
 
-    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    s_ctx.streaming_task = NULL;
-    xSemaphoreGive(s_ctx.mutex);
+    if (!failure) {
+        s->capture_record = audio_pool_alloc(AUDIO_POOL_INTERNAL, RECORD_HEADER + bytes_per_ms * FRAME_MS);
+        tx.batch = audio_pool_alloc(AUDIO_POOL_INTERNAL, max_bytes);
+        tx.scratch = audio_pool_alloc(AUDIO_POOL_PSRAM, max_bytes);
+        if (!s->capture_record || !tx.batch || !tx.scratch ||
+            spsc_ring_create(queue_size(bytes_per_ms * QUEUE_MS), MALLOC_CAP_SPIRAM, &s->queue) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to allocate streaming buffers");
+            failure = "Memory allocation failed";
+        }
+    }
+
+    if (!failure && ops->stream_open && ops->stream_open(s, max_bytes) != ESP_OK) {
+        failure = "Failed to start audio stream";
+    }
+    tx.stream_open = !failure;
+
+    bool capturing = false;
+    if (!failure) {
+        s->capture_run = true;
+        xSemaphoreTake(s->capture_done, 0);  // Still given from the last capture task's exit
+        capturing = xTaskCreatePinnedToCore(capture_task, "live_capture", TASK_LIVE_CAPTURE_STACK, s,
+                                            TASK_LIVE_CAPTURE_PRIORITY, &s->capture_task,
+                                            TASK_LIVE_CAPTURE_CORE) == pdPASS;
+        if (!capturing) {
+            ESP_LOGE(TAG, "Failed to create capture task");
+            s->capture_task = NULL;
+            failure = "Failed to start audio capture";
+        }
+    }
+
+    if (!failure) {
+        metrics_set(&s->m_chunk_ms, tx.chunk_ms);
+        stream_audio_loop(&tx, max_bytes);
+    } else if (tx.stream_open && ops->stream_close) {
+        ops->stream_close(s, false);
+    }
+
+    // The capture task exits within a frame read; it writes the queue until then
+    s->capture_run = false;
+    if (capturing) {
+        join_task(s, s->capture_done, "capture");
+    }
+
+    ESP_LOGI(TAG, "Streaming task stopped after %.1f seconds in %lu sends",
+             tx.sent_ms / 1000.0f, (unsigned long)tx.sends);
+
+    live_resume_free(&tx.resume);
+    spsc_ring_delete(s->queue);
+    s->queue = NULL;
+    if (s->capture) {
+        audio_engine_stream_close(s->capture);
+        s->capture = NULL;
+    }
+    audio_pool_free(s->capture_record);
+    s->capture_record = NULL;
+    audio_pool_free(tx.batch);
+    audio_pool_free(tx.scratch);
+    metrics_set(&s->m_queue_ms, 0);
+
+    xSemaphoreTake(s->mutex, portMAX_DELAY);
+    if (failure) {
+        fail_locked(s, failure);
+    }
+    s->streaming_task = NULL;
+    s->task_running = false;
+    unlock_and_publish(s);
+    xSemaphoreGive(s->task_done);
 
     vTaskDelete(NULL);
 }
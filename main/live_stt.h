@@ -1,7 +1,12 @@
 /**
  * Live Speech-to-Text Module
  *
- * Real-time audio streaming and transcription via Deepgram WebSocket API.
+ * Real-time audio streaming and transcription over a provider WebSocket
+ * API (Deepgram, OpenAI Realtime). One engine does capture, silence
+ * gating, reconnection and transcript storage for every provider; the
+ * providers only speak their protocol (live_stt_provider.h).
+ *
+ * Each provider has its own session, so both can stream at once.
  */
 
 #pragma once
@@ -14,12 +19,21 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Streaming providers
+ */
+typedef enum {
+    LIVE_STT_DEEPGRAM = 0,        // Deepgram listen API (/live)
+    LIVE_STT_OPENAI,              // OpenAI Realtime API (/openai-live)
+    LIVE_STT_PROVIDER_MAX,
+} live_stt_provider_t;
+
 /**
  * @brief Live STT state machine states
  */
 typedef enum {
     LIVE_STT_STATE_IDLE = 0,      // Ready to stream
-    LIVE_STT_STATE_CONNECTING,    // Connecting to Deepgram
+    LIVE_STT_STATE_CONNECTING,    // Connecting, or reconnecting after a drop
     LIVE_STT_STATE_STREAMING,     // Actively streaming audio
     LIVE_STT_STATE_ERROR,         // Error occurred
 } live_stt_state_t;
@@ -34,73 +48,102 @@ typedef struct {
 } live_stt_status_t;
 
 /**
- * @brief Initialize Live STT module
+ * @brief Initialize a provider session
  *
- * Allocates transcript buffer in PSRAM and initializes state.
+ * Allocates the transcript buffer in PSRAM and initializes state.
  *
- * @return ESP_OK on success, error code on failure
+ * @param provider Provider
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the provider's API key
+ *         is not configured, ESP_ERR_NO_MEM on allocation failure
  */
-esp_err_t live_stt_init(void);
+esp_err_t live_stt_init(live_stt_provider_t provider);
 
 /**
  * @brief Start live transcription
  *
- * Connects to Deepgram WebSocket API and begins streaming
- * audio from the microphone in real-time.
+ * Connects to the provider and begins streaming audio from the
+ * microphone in real-time.
  *
- * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already streaming
+ * @param provider Provider
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already streaming or
+ *         the API key is not configured
  */
-esp_err_t live_stt_start(void);
+esp_err_t live_stt_start(live_stt_provider_t provider);
 
 /**
  * @brief Stop live transcription
  *
- * Stops audio streaming and closes WebSocket connection.
+ * Stops audio streaming and closes the WebSocket connection.
  *
+ * @param provider Provider
  * @return ESP_OK on success
  */
-esp_err_t live_stt_stop(void);
+esp_err_t live_stt_stop(live_stt_provider_t provider);
 
 /**
  * @brief Get current Live STT status
  *
+ * @param provider Provider
  * @param status Pointer to status structure to fill
  * @return ESP_OK on success
  */
-esp_err_t live_stt_get_status(live_stt_status_t *status);
+esp_err_t live_stt_get_status(live_stt_provider_t provider, live_stt_status_t *status);
 
 /**
  * @brief Get current state
  *
+ * @param provider Provider
  * @return Current Live STT state
  */
-live_stt_state_t live_stt_get_state(void);
+live_stt_state_t live_stt_get_state(live_stt_provider_t provider);
+
+/**
+ * @brief Get the name of a state ("idle", "connecting", "streaming", "error")
+ *
+ * @param state State
+ * @return Name as used by the status API
+ */
+const char *live_stt_state_name(live_stt_state_t state);
+
+/**
+ * @brief Get the display name of a provider ("Deepgram", "OpenAI")
+ *
+ * @param provider Provider
+ * @return Name for logs and error messages
+ */
+const char *live_stt_provider_name(live_stt_provider_t provider);
 
 /**
  * @brief Get accumulated transcript
  *
+ * @param provider Provider
  * @return Pointer to transcript string, or NULL if empty
  */
-const char *live_stt_get_transcript(void);
+const char *live_stt_get_transcript(live_stt_provider_t provider);
 
 /**
  * @brief Clear accumulated transcript
+ *
+ * @param provider Provider
  */
-void live_stt_clear_transcript(void);
+void live_stt_clear_transcript(live_stt_provider_t provider);
 
 /**
- * @brief Check if Live STT is busy
+ * @brief Check if a provider session is busy
  *
+ * @param provider Provider
  * @return true if connecting or streaming, false otherwise
  */
-bool live_stt_is_busy(void);
+bool live_stt_is_busy(live_stt_provider_t provider);
 
 /**
- * @brief Cleanup Live STT resources
+ * @brief Cleanup a provider session
+ *
+ * Frees the transcript buffer and stops any ongoing operations.
  *
- * Frees transcript buffer and stops any ongoing operations.
+ * @param provider Provider
  */
-void live_stt_cleanup(void);
+void live_stt_cleanup(live_stt_provider_t provider);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,191 @@
+/**
+ * Live STT Provider: Deepgram
+ *
+ * Deepgram listen API over WebSocket: binary linear16 or Ogg Opus audio,
+ * Finalize at the end of each utterance, KeepAlive through gated silence,
+ * and one Results message per final transcript.
+ */
+
+#include "live_stt_provider.h"
+#include <string.h>
+#include <stdio.h>
+#include "esp_log.h"
+#include "json_scan.h"
+#include "audio_encoder.h"
+#include "task_topology.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "live_stt_deepgram";
+
+// Deepgram WebSocket URL; encoding is filled in at connect time
+#define DEEPGRAM_WS_URL_FMT "wss://api.deepgram.com/v1/listen?encoding=%s&sample_rate=16000&channels=1&punctuate=true&interim_results=false"
+
+// Deepgram closes a stream after 10s without audio; KeepAlive holds it open while silence is gated
+#define DEEPGRAM_KEEPALIVE_MS 5000
+#define DEEPGRAM_KEEPALIVE_MSG "{\"type\":\"KeepAlive\"}"
+#define DEEPGRAM_FINALIZE_MSG "{\"type\":\"Finalize\"}"  // Flush the transcript of the utterance
+
+// Audio configuration (matches batch STT)
+#define DEEPGRAM_SAMPLE_RATE 16000
+
+// Sends start at 200ms (6400 bytes at 16kHz, 16-bit mono); the engine adapts them
+#define CHUNK_DURATION_MS 200
+
+// Opus streaming: 5 x 20ms frames per Ogg page keeps latency at 100ms
+#define OPUS_FRAMES_PER_PAGE 5
+#define ENCODER_FINISH_TIMEOUT_MS 1000
+
+static struct {
+    bool use_opus;                  // Stream Ogg Opus instead of linear16, fixed per session
+    audio_encoder_handle_t encoder; // Ogg stream of the current connection
+} s_dg;
+
+static bool is_configured(void)
+{
+#ifdef CONFIG_DEEPGRAM_API_KEY
+    return strlen(CONFIG_DEEPGRAM_API_KEY) > 0;
+#else
+    return false;
+#endif
+}
+
+static void begin(void)
+{
+    s_dg.use_opus = audio_encoder_opus_enabled();
+}
+
+static void url(char *url, size_t len)
+{
+    snprintf(url, len, DEEPGRAM_WS_URL_FMT, s_dg.use_opus ? "opus" : "linear16");
+}
+
+static void headers(esp_websocket_client_handle_t client)
+{
+#ifdef CONFIG_DEEPGRAM_API_KEY
+    char auth_header[256];
+    snprintf(auth_header, sizeof(auth_header), "Token %s", CONFIG_DEEPGRAM_API_KEY);
+    esp_websocket_client_append_header(client, "Authorization", auth_header);
+#endif
+}
+
+/**
+ * Encoder output - send each Ogg page as one binary frame
+ */
+static esp_err_t opus_page_cb(const uint8_t *data, size_t len, void *user_ctx)
+{
+    live_stt_session_t *session = user_ctx;
+    if (!live_stt_connected(session)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    live_stt_send_audio(session, data, len, false);
+    return ESP_OK;
+}
+
+/**
+ * Start an Opus encoder for a new connection; each connection is one Ogg stream
+ */
+static esp_err_t stream_open(live_stt_session_t *session, size_t max_len)
+{
+    if (!s_dg.use_opus) {
+        return ESP_OK;
+    }
+
+    audio_encoder_config_t enc_config = {
+        .sample_rate = DEEPGRAM_SAMPLE_RATE,
+        .frames_per_page = OPUS_FRAMES_PER_PAGE,
+        .output_cb = opus_page_cb,
+        .user_ctx = session,
+    };
+    esp_err_t err = audio_encoder_create(&enc_config, &s_dg.encoder);
+    if (err != ESP_OK) {
+        // The connection was opened for Ogg Opus, so PCM is not an option here
+        ESP_LOGE(TAG, "Failed to start Opus encoder: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+static void stream_audio(live_stt_session_t *session, const uint8_t *pcm, size_t len)
+{
+    if (s_dg.encoder) {
+        audio_encoder_write(s_dg.encoder, (const int16_t *)pcm, len / 2);
+    } else {
+        live_stt_send_audio(session, pcm, len, false);
+    }
+}
+
+static void stream_end_of_utterance(live_stt_session_t *session)
+{
+    live_stt_send_control(session, DEEPGRAM_FINALIZE_MSG, 1000);
+}
+
+static void stream_keepalive(live_stt_session_t *session)
+{
+    live_stt_send_control(session, DEEPGRAM_KEEPALIVE_MSG, 1000);
+}
+
+static void stream_close(live_stt_session_t *session, bool flush)
+{
+    if (!s_dg.encoder) {
+        return;
+    }
+    if (flush) {
+        audio_encoder_finish(s_dg.encoder, pdMS_TO_TICKS(ENCODER_FINISH_TIMEOUT_MS));
+    }
+    ESP_LOGI(TAG, "Opus stream: %d bytes", audio_encoder_bytes_out(s_dg.encoder));
+    audio_encoder_destroy(s_dg.encoder);
+    s_dg.encoder = NULL;
+}
+
+/**
+ * Parse Deepgram JSON response and append transcript
+ *
+ * Scans the message in place for the two fields used; nothing is allocated
+ * per message.
+ */
+static void parse(live_stt_session_t *session, const char *data, size_t len)
+{
+    json_scan_value_t value;
+
+    // Check for error
+    if (json_scan_find(data, len, "error", &value)) {
+        if (json_scan_find_string(data, len, "error.message", &value)) {
+            char message[256];
+            json_scan_unescape(&value, message, sizeof(message));
+            ESP_LOGE(TAG, "Deepgram error: %s", message);
+            live_stt_on_error(session, message);
+        }
+        return;
+    }
+
+    // Results are final (no interim results); speech_final or from_finalize ends the utterance
+    json_scan_value_t flag;
+    bool end_of_turn = (json_scan_find(data, len, "speech_final", &flag) && flag.type == JSON_SCAN_TRUE) ||
+                       (json_scan_find(data, len, "from_finalize", &flag) && flag.type == JSON_SCAN_TRUE);
+
+    // Extract transcript from channel.alternatives[0].transcript
+    bool found = json_scan_find_string(data, len, "channel.alternatives[0].transcript", &value);
+    live_stt_on_transcript(session, found ? &value : NULL, end_of_turn);
+}
+
+const live_stt_provider_ops_t live_stt_deepgram = {
+    .name = "Deepgram",
+    .source = TRANSCRIPT_SOURCE_LIVE,
+    .sample_rate = DEEPGRAM_SAMPLE_RATE,
+    .chunk_ms = CHUNK_DURATION_MS,
+    .keepalive_ms = DEEPGRAM_KEEPALIVE_MS,
+    .ws_buffer_size = 8192,
+    .task_name = "live_stt_stream",
+    .task_stack = TASK_LIVE_STT_STACK,
+    .task_priority = TASK_LIVE_STT_PRIORITY,
+    .task_core = TASK_LIVE_STT_CORE,
+    .is_configured = is_configured,
+    .begin = begin,
+    .url = url,
+    .headers = headers,
+    .stream_open = stream_open,
+    .stream_audio = stream_audio,
+    .stream_end_of_utterance = stream_end_of_utterance,
+    .stream_keepalive = stream_keepalive,
+    .stream_close = stream_close,
+    .parse = parse,
+};
@@ -0,0 +1,216 @@
+/**
+ * Live STT Provider: OpenAI Realtime
+ *
+ * OpenAI Realtime API over WebSocket: a session.update per connection,
+ * then base64 PCM in input_audio_buffer.append text messages. Server VAD
+ * finds the utterances, so the gate's closes need no message.
+ */
+
+#include "live_stt_provider.h"
+#include <string.h>
+#include <stdio.h>
+#include "esp_log.h"
+#include "json_scan.h"
+#include "audio_dsp.h"
+#include "audio_pool.h"
+#include "task_topology.h"
+#include "esp_cpu.h"
+
+static const char *TAG = "live_stt_openai";
+
+// OpenAI Realtime API WebSocket URL
+#define OPENAI_WS_URL "wss://api.openai.com/v1/realtime?model=gpt-4o-realtime-preview-2024-12-17"
+
+// OpenAI expects 24kHz, 16-bit, mono PCM
+#define OPENAI_SAMPLE_RATE 24000
+
+// Sends start at 100ms (4800 bytes at 24kHz, 16-bit mono); the engine adapts them
+#define CHUNK_DURATION_MS 100
+
+// input_audio_buffer.append framing around the base64 audio
+#define APPEND_PREFIX "{\"type\":\"input_audio_buffer.append\",\"audio\":\""
+#define APPEND_SUFFIX "\"}"
+#define APPEND_PREFIX_LEN (sizeof(APPEND_PREFIX) - 1)
+#define APPEND_SUFFIX_LEN (sizeof(APPEND_SUFFIX) - 1)
+
+#define SESSION_UPDATE_TIMEOUT_MS 5000
+
+static struct {
+    char *msg_buffer;               // Append message (internal RAM), one per connection
+    char *json_msg;                 // Constant prefix, then the base64 body
+    char *audio_b64;
+    uint64_t frame_cycles;          // Cycles spent encoding and framing
+    uint64_t frame_bytes;           // PCM bytes framed
+} s_oa;
+
+static bool is_configured(void)
+{
+#ifdef CONFIG_OPENAI_API_KEY
+    return strlen(CONFIG_OPENAI_API_KEY) > 0;
+#else
+    return false;
+#endif
+}
+
+static void url(char *url, size_t len)
+{
+    snprintf(url, len, "%s", OPENAI_WS_URL);
+}
+
+static void headers(esp_websocket_client_handle_t client)
+{
+#ifdef CONFIG_OPENAI_API_KEY
+    char auth_header[256];
+    snprintf(auth_header, sizeof(auth_header), "Bearer %s", CONFIG_OPENAI_API_KEY);
+    esp_websocket_client_append_header(client, "Authorization", auth_header);
+#endif
+    esp_websocket_client_append_header(client, "OpenAI-Beta", "realtime=v1");
+}
+
+/**
+ * Send session.update to configure transcription
+ */
+static esp_err_t on_connected(live_stt_session_t *session)
+{
+    // Configure session for audio input with transcription
+    const char *session_update = "{"
+        "\"type\": \"session.update\","
+        "\"session\": {"
+            "\"modalities\": [\"text\"],"
+            "\"input_audio_format\": \"pcm16\","
+            "\"input_audio_transcription\": {"
+                "\"model\": \"whisper-1\""
+            "},"
+            "\"turn_detection\": {"
+                "\"type\": \"server_vad\","
+                "\"threshold\": 0.5,"
+                "\"prefix_padding_ms\": 300,"
+                "\"silence_duration_ms\": 500"
+            "}"
+        "}"
+    "}";
+
+    if (live_stt_send_control(session, session_update, SESSION_UPDATE_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send session.update");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Sent session.update");
+    return ESP_OK;
+}
+
+static esp_err_t stream_open(live_stt_session_t *session, size_t max_len)
+{
+    // One message buffer in internal RAM, sized for the largest chunk: the constant
+    // prefix is written once and placed so the base64 body starts 4-byte aligned
+    size_t prefix_pad = (4 - (APPEND_PREFIX_LEN & 3)) & 3;
+    size_t msg_capacity = prefix_pad + APPEND_PREFIX_LEN + AUDIO_DSP_BASE64_LEN(max_len) + APPEND_SUFFIX_LEN;
+    s_oa.msg_buffer = audio_pool_alloc(AUDIO_POOL_INTERNAL, msg_capacity);
+    if (!s_oa.msg_buffer) {
+        ESP_LOGE(TAG, "Failed to allocate message buffer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_oa.json_msg = s_oa.msg_buffer + prefix_pad;
+    s_oa.audio_b64 = s_oa.json_msg + APPEND_PREFIX_LEN;
+    memcpy(s_oa.json_msg, APPEND_PREFIX, APPEND_PREFIX_LEN);
+    s_oa.frame_cycles = 0;
+    s_oa.frame_bytes = 0;
+    return ESP_OK;
+}
+
+/**
+ * Frame one chunk of PCM as an append message and send it
+ */
+static void stream_audio(live_stt_session_t *session, const uint8_t *pcm, size_t len)
+{
+    // Encode straight into the message body and close the JSON object
+    uint32_t start = esp_cpu_get_cycle_count();
+    size_t b64_len = audio_dsp_base64_encode(pcm, len, s_oa.audio_b64);
+    memcpy(s_oa.audio_b64 + b64_len, APPEND_SUFFIX, APPEND_SUFFIX_LEN);
+    size_t msg_len = APPEND_PREFIX_LEN + b64_len + APPEND_SUFFIX_LEN;
+    s_oa.frame_cycles += esp_cpu_get_cycle_count() - start;
+    s_oa.frame_bytes += len;
+
+    live_stt_send_audio(session, s_oa.json_msg, msg_len, true);
+}
+
+static void stream_close(live_stt_session_t *session, bool flush)
+{
+    ESP_LOGI(TAG, "Framing %.3f bytes/cycle over %llu bytes",
+             s_oa.frame_cycles ? (double)s_oa.frame_bytes / s_oa.frame_cycles : 0.0,
+             (unsigned long long)s_oa.frame_bytes);
+    audio_pool_free(s_oa.msg_buffer);
+    s_oa.msg_buffer = NULL;
+}
+
+/**
+ * Parse OpenAI Realtime API JSON response
+ *
+ * Scans the message in place; audio and delta events that are not used
+ * cost one pass over the text and no allocation.
+ */
+static void parse(live_stt_session_t *session, const char *data, size_t len)
+{
+    // Get event type
+    json_scan_value_t type;
+    if (!json_scan_find_string(data, len, "type", &type)) {
+        return;
+    }
+
+    json_scan_value_t value;
+
+    // Handle error events
+    if (json_scan_equals(&type, "error")) {
+        if (json_scan_find_string(data, len, "error.message", &value)) {
+            char message[256];
+            json_scan_unescape(&value, message, sizeof(message));
+            ESP_LOGE(TAG, "OpenAI error: %s", message);
+            live_stt_on_error(session, message);
+        }
+        return;
+    }
+
+    // Handle session events
+    if (json_scan_equals(&type, "session.created") || json_scan_equals(&type, "session.updated")) {
+        ESP_LOGI(TAG, "Session event: %.*s", (int)type.len, type.ptr);
+        return;
+    }
+
+    // Handle transcription events
+    // conversation.item.input_audio_transcription.completed contains final transcription
+    if (json_scan_equals(&type, "conversation.item.input_audio_transcription.completed")) {
+        if (json_scan_find_string(data, len, "transcript", &value) && value.len > 0) {
+            // Server VAD commits one item per utterance, so each completion ends a turn
+            live_stt_on_transcript(session, &value, true);
+        }
+        return;
+    }
+
+    // Handle input audio buffer speech events for logging
+    if (json_scan_equals(&type, "input_audio_buffer.speech_started")) {
+        ESP_LOGI(TAG, "Speech detected");
+    } else if (json_scan_equals(&type, "input_audio_buffer.speech_stopped")) {
+        ESP_LOGI(TAG, "Speech ended");
+    }
+}
+
+const live_stt_provider_ops_t live_stt_openai = {
+    .name = "OpenAI",
+    .source = TRANSCRIPT_SOURCE_OPENAI_LIVE,
+    .sample_rate = OPENAI_SAMPLE_RATE,
+    .chunk_ms = CHUNK_DURATION_MS,
+    .keepalive_ms = 0,              // The gate's hold covers server_vad's silence_duration_ms
+    .ws_buffer_size = 16384,        // Larger buffer for base64 audio
+    .task_name = "openai_live_stream",
+    .task_stack = TASK_OPENAI_LIVE_STACK,
+    .task_priority = TASK_OPENAI_LIVE_PRIORITY,
+    .task_core = TASK_OPENAI_LIVE_CORE,
+    .is_configured = is_configured,
+    .url = url,
+    .headers = headers,
+    .on_connected = on_connected,
+    .stream_open = stream_open,
+    .stream_audio = stream_audio,
+    .stream_close = stream_close,
+    .parse = parse,
+};
@@ -0,0 +1,170 @@
+/**
+ * Live STT Provider Interface
+ *
+ * Protocol side of a streaming STT provider. The engine (live_stt.c) owns
+ * the session: the WebSocket client and its lifecycle, the capture task and
+ * its send queue, the silence gate, the batching of audio into sends,
+ * reconnects with the audio backlog, and the transcript.
+ * A provider describes its connection, frames audio for the wire and
+ * parses the messages that come back.
+ *
+ * Stream callbacks run on the session's streaming task, once per
+ * connection between stream_open and stream_close. on_connected and parse
+ * run on the WebSocket client task.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_websocket_client.h"
+#include "json_scan.h"
+#include "transcript_push.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Engine session, passed back to the provider callbacks
+ */
+typedef struct live_stt_session live_stt_session_t;
+
+/**
+ * @brief Streaming STT provider
+ *
+ * Optional callbacks may be NULL.
+ */
+typedef struct {
+    const char *name;               // Display name for logs and errors ("Deepgram")
+    transcript_source_t source;     // Transcript push and conversation source
+    uint32_t sample_rate;           // Mono 16-bit PCM rate the provider expects
+    uint32_t chunk_ms;              // Initial audio per stream_audio() call, adapted to the link
+    uint32_t keepalive_ms;          // Gated silence after which stream_keepalive runs (0: never)
+    int ws_buffer_size;             // WebSocket client buffer
+    const char *task_name;          // Streaming task
+    uint32_t task_stack;
+    uint32_t task_priority;
+    int task_core;
+
+    /**
+     * @brief Check whether the API key is configured
+     */
+    bool (*is_configured)(void);
+
+    /**
+     * @brief Session start, before the first connection (optional)
+     *
+     * Settings fixed for the session are read here.
+     */
+    void (*begin)(void);
+
+    /**
+     * @brief Build the WebSocket URL of a new connection
+     */
+    void (*url)(char *url, size_t len);
+
+    /**
+     * @brief Set the headers of a new connection
+     */
+    void (*headers)(esp_websocket_client_handle_t client);
+
+    /**
+     * @brief Connection established, before audio flows (optional)
+     *
+     * @return ESP_OK once the provider accepts audio on this connection
+     */
+    esp_err_t (*on_connected)(live_stt_session_t *session);
+
+    /**
+     * @brief Start the audio stream of a connection (optional)
+     *
+     * @param max_len Largest chunk stream_audio() will be given
+     */
+    esp_err_t (*stream_open)(live_stt_session_t *session, size_t max_len);
+
+    /**
+     * @brief Send one chunk of PCM
+     *
+     * Chunk sizes vary from send to send, in whole samples.
+     */
+    void (*stream_audio)(live_stt_session_t *session, const uint8_t *pcm, size_t len);
+
+    /**
+     * @brief The silence gate closed after speech (optional)
+     *
+     * Providers without it rely on server-side endpointing; closes are then
+     * not kept in the reconnect backlog either.
+     */
+    void (*stream_end_of_utterance)(live_stt_session_t *session);
+
+    /**
+     * @brief Hold the stream open through gated silence (optional)
+     */
+    void (*stream_keepalive)(live_stt_session_t *session);
+
+    /**
+     * @brief End the audio stream of a connection (optional)
+     *
+     * @param flush true if the connection is still up and buffered audio
+     *        should still be sent
+     */
+    void (*stream_close)(live_stt_session_t *session, bool flush);
+
+    /**
+     * @brief Handle one complete text message from the provider
+     */
+    void (*parse)(live_stt_session_t *session, const char *data, size_t len);
+} live_stt_provider_ops_t;
+
+extern const live_stt_provider_ops_t live_stt_deepgram;
+extern const live_stt_provider_ops_t live_stt_openai;
+
+/**
+ * @brief Send one audio message, recorded in the ws_send metrics
+ *
+ * @param session Session
+ * @param data Message
+ * @param len Message length
+ * @param text true for a text frame, false for binary
+ * @return Bytes sent, negative on failure
+ */
+int live_stt_send_audio(live_stt_session_t *session, const void *data, size_t len, bool text);
+
+/**
+ * @brief Send a control text message
+ *
+ * @param session Session
+ * @param text NUL-terminated JSON
+ * @param timeout_ms Send timeout
+ * @return ESP_OK on success, ESP_FAIL if the send failed
+ */
+esp_err_t live_stt_send_control(live_stt_session_t *session, const char *text, uint32_t timeout_ms);
+
+/**
+ * @brief Check whether the session's connection is up
+ */
+bool live_stt_connected(live_stt_session_t *session);
+
+/**
+ * @brief Append transcribed text and hand it to the conversation
+ *
+ * @param session Session
+ * @param text JSON string value, or NULL for an end of turn without text
+ * @param end_of_turn true if the text ends the user's turn
+ */
+void live_stt_on_transcript(live_stt_session_t *session, const json_scan_value_t *text, bool end_of_turn);
+
+/**
+ * @brief End the session with an error reported by the provider
+ *
+ * @param session Session
+ * @param message Error message, replacing any earlier one
+ */
+void live_stt_on_error(live_stt_session_t *session, const char *message);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,19 +2,147 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
+#include "lwip/netdb.h"
 
 #include "nvs_flash.h"
 
 #include "http_server.h"
+#include "http_pool.h"
 #include "audio_init.h"
+#include "audio_pool.h"
+#include "tts.h"
+#include "stt.h"
+#include "wake_word.h"
+#include "metrics.h"
+#include "task_topology.h"
 
 static const char *TAG = "P4_WIFI";
 
+/* ---------- Boot stages ---------- */
+
+// Nothing that can run without an IP waits for one: the codec comes up on
+// the audio core while WiFi associates and the TTS buffers are allocated,
+// then STT and the HTTP server are ready before the first request can
+// arrive, and GOT_IP only has to warm the provider connections.
+
+#define BOOT_AUDIO_DONE BIT0
+#define BOOT_GOT_IP     BIT1
+
+typedef enum {
+    BOOT_PHASE_NVS = 0,
+    BOOT_PHASE_AUDIO_POOL,
+    BOOT_PHASE_WIFI_START,
+    BOOT_PHASE_TTS,
+    BOOT_PHASE_AUDIO,
+    BOOT_PHASE_STT,
+    BOOT_PHASE_HTTP_SERVER,
+    BOOT_PHASE_WIFI_CONNECT,
+    BOOT_PHASE_PREWARM,
+    BOOT_PHASE_MAX,
+} boot_phase_t;
+
+#define PHASE_INIT(label) METRICS_GAUGE_INIT("boot_phase_ms", "Duration of a startup phase", "phase", label)
+
+static metrics_metric_t s_m_phase[BOOT_PHASE_MAX] = {
+    [BOOT_PHASE_NVS] = PHASE_INIT("nvs"),
+    [BOOT_PHASE_AUDIO_POOL] = PHASE_INIT("audio_pool"),
+    [BOOT_PHASE_WIFI_START] = PHASE_INIT("wifi_start"),
+    [BOOT_PHASE_TTS] = PHASE_INIT("tts"),
+    [BOOT_PHASE_AUDIO] = PHASE_INIT("audio"),           // SD card, codec and player, overlaps tts
+    [BOOT_PHASE_STT] = PHASE_INIT("stt"),
+    [BOOT_PHASE_HTTP_SERVER] = PHASE_INIT("http_server"),
+    [BOOT_PHASE_WIFI_CONNECT] = PHASE_INIT("wifi_connect"),  // WiFi start to GOT_IP
+    [BOOT_PHASE_PREWARM] = PHASE_INIT("prewarm"),
+};
+static metrics_metric_t s_m_ready = METRICS_GAUGE_INIT(
+    "boot_ready_ms", "Time from boot to connected with every service up", NULL, NULL);
+
+static EventGroupHandle_t s_boot_events;
+static esp_err_t s_audio_err = ESP_OK;
+static volatile bool s_booted;      // First GOT_IP handled by app_main
+
+/**
+ * Record a finished boot phase and return the time it ended
+ */
+static int64_t phase_done(boot_phase_t phase, int64_t start_us)
+{
+    int64_t now_us = esp_timer_get_time();
+    uint32_t ms = (uint32_t)((now_us - start_us) / 1000);
+    metrics_set(&s_m_phase[phase], ms);
+    ESP_LOGI(TAG, "Boot: %s took %lu ms", s_m_phase[phase].label_value, (unsigned long)ms);
+    return now_us;
+}
+
+static void audio_boot(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    s_audio_err = audio_init();
+    phase_done(BOOT_PHASE_AUDIO, start_us);
+    xEventGroupSetBits(s_boot_events, BOOT_AUDIO_DONE);
+}
+
+static void audio_boot_task(void *arg)
+{
+    audio_boot();
+    vTaskDelete(NULL);
+}
+
+#if CONFIG_BOOT_PREWARM
+/**
+ * Ask the pool to open its provider connections; unconfigured hosts and
+ * a pool that was never started are skipped
+ */
+static void prewarm_pool(void)
+{
+    for (int host = 0; host < HTTP_POOL_HOST_MAX; host++) {
+        http_pool_prewarm((http_pool_host_t)host);
+    }
+}
+
+/**
+ * Resolve a host so its answer is in the lwIP DNS cache
+ */
+static void resolve_host(const char *host)
+{
+    struct addrinfo hints = {
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res = NULL;
+    int err = getaddrinfo(host, "443", &hints, &res);
+    if (err != 0 || !res) {
+        ESP_LOGW(TAG, "DNS lookup of %s failed (%d)", host, err);
+        return;
+    }
+    freeaddrinfo(res);
+}
+
+/**
+ * Warm the live STT providers: their WebSocket connects fresh per
+ * session, so only the DNS answer can be prepared
+ */
+static void resolve_live_hosts(void)
+{
+#ifdef CONFIG_DEEPGRAM_API_KEY
+    if (strlen(CONFIG_DEEPGRAM_API_KEY) > 0) {
+        resolve_host("api.deepgram.com");
+    }
+#endif
+#ifdef CONFIG_OPENAI_API_KEY
+    if (strlen(CONFIG_OPENAI_API_KEY) > 0) {
+        resolve_host("api.openai.com");
+    }
+#endif
+}
+#endif
+
 /* ---------- Wi-Fi event handler ---------- */
 static void wifi_event_handler(void *arg,
                                esp_event_base_t event_base,
@@ -35,14 +163,15 @@ static void wifi_event_handler(void *arg,
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
 
-        // Play WiFi connected notification sound
-        esp_err_t err = audio_play_wifi_connected();
-        if (err != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to play audio notification");
-        }
+        // The first one finishes the boot in app_main
+        xEventGroupSetBits(s_boot_events, BOOT_GOT_IP);
 
-        // Start HTTP server (TTS available via web interface)
-        http_server_start();
+#if CONFIG_BOOT_PREWARM
+        if (s_booted) {
+            // Pooled connections died with the last association
+            prewarm_pool();
+        }
+#endif
     }
 }
 
@@ -91,8 +220,15 @@ static void wifi_init_sta(void)
 /* ---------- app_main ---------- */
 void app_main(void)
 {
+    int64_t t_us = esp_timer_get_time();
     ESP_LOGI(TAG, "Booting...");
 
+    s_boot_events = xEventGroupCreate();
+    if (!s_boot_events) {
+        ESP_LOGE(TAG, "Failed to create boot event group");
+        return;
+    }
+
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
         ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -101,6 +237,76 @@ void app_main(void)
     }
 
     ESP_LOGI(TAG, "NVS initialized");
+    t_us = phase_done(BOOT_PHASE_NVS, t_us);
+
+    // Reserve the audio arenas before WiFi and HTTP fragment the heap
+    if (audio_pool_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Audio pool incomplete, sessions will use the heap");
+    }
+    t_us = phase_done(BOOT_PHASE_AUDIO_POOL, t_us);
 
+    // Association runs in the background from here
     wifi_init_sta();
+    int64_t wifi_start_us = t_us = phase_done(BOOT_PHASE_WIFI_START, t_us);
+
+    // SD card, codec and player on the audio core while WiFi associates
+    if (xTaskCreatePinnedToCore(audio_boot_task, "boot_audio", TASK_BOOT_AUDIO_STACK, NULL,
+                                TASK_BOOT_AUDIO_PRIORITY, NULL, TASK_BOOT_AUDIO_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create audio boot task, initializing audio inline");
+        audio_boot();
+    }
+
+#if CONFIG_BOOT_EAGER_INIT
+    // TTS rings, prefetch lane and connection pool, so the first request does not pay for them
+    if (tts_init() != ESP_OK) {
+        ESP_LOGW(TAG, "TTS not available");
+    }
+    t_us = phase_done(BOOT_PHASE_TTS, t_us);
+#endif
+
+    xEventGroupWaitBits(s_boot_events, BOOT_AUDIO_DONE, pdFALSE, pdTRUE, portMAX_DELAY);
+
+#if CONFIG_BOOT_EAGER_INIT
+    // Recording store and pre-roll; the pre-roll captures, so it follows the codec
+    t_us = esp_timer_get_time();
+    if (s_audio_err != ESP_OK || stt_init() != ESP_OK) {
+        ESP_LOGW(TAG, "STT not available");
+    }
+    t_us = phase_done(BOOT_PHASE_STT, t_us);
+#endif
+
+    // The server listens on any address, so it is up before the IP arrives. It starts
+    // after the module init above: its handlers' lazy init must not race the boot's
+    t_us = esp_timer_get_time();
+    if (http_server_start() != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP server not available");
+    }
+    phase_done(BOOT_PHASE_HTTP_SERVER, t_us);
+
+    xEventGroupWaitBits(s_boot_events, BOOT_GOT_IP, pdFALSE, pdTRUE, portMAX_DELAY);
+    phase_done(BOOT_PHASE_WIFI_CONNECT, wifi_start_us);
+
+    // Play WiFi connected notification sound
+    if (s_audio_err != ESP_OK || audio_play_wifi_connected() != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to play audio notification");
+    }
+
+#if CONFIG_BOOT_PREWARM
+    t_us = esp_timer_get_time();
+    prewarm_pool();
+    resolve_live_hosts();
+    phase_done(BOOT_PHASE_PREWARM, t_us);
+#endif
+    s_booted = true;
+
+#if CONFIG_WAKE_WORD_ENABLE
+    // Keyword-started sessions need the network, like the web UI ones
+    if (wake_word_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Wake word not available");
+    }
+#endif
+
+    int64_t ready_ms = esp_timer_get_time() / 1000;
+    metrics_set(&s_m_ready, (int32_t)ready_ms);
+    ESP_LOGI(TAG, "Ready %lld ms after boot", (long long)ready_ms);
 }
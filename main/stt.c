@@ -12,8 +12,16 @@
 #include "esp_crt_bundle.h"
 #include "esp_heap_caps.h"
 #include "cJSON.h"
-#include "bsp_board_extra.h"
-#include "driver/i2s_std.h"
+#include "transcript_push.h"
+#include "audio_dsp.h"
+#include "audio_encoder.h"
+#include "audio_engine.h"
+#include "audio_pool.h"
+#include "capture_store.h"
+#include "metrics.h"
+#include "task_topology.h"
+#include <stdint.h>
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -31,8 +39,26 @@ static const char *TAG = "stt";
 
 // Recording limits
 #define MAX_RECORDING_SECONDS 300  // 5 minutes
-#define MAX_AUDIO_BUFFER_SIZE (STT_SAMPLE_RATE * 2 * MAX_RECORDING_SECONDS)  // ~9.4MB
-#define RECORDING_CHUNK_SIZE 1024  // Bytes per I2S read
+#define MAX_AUDIO_SIZE (STT_SAMPLE_RATE * 2 * MAX_RECORDING_SECONDS)  // ~9.4MB limit, allocated as it grows
+#define SEGMENT_SIZE (CONFIG_STT_SEGMENT_KB * 1024)
+#define RECORDING_CHUNK_SIZE 1024  // Bytes per capture read
+#define CAPTURE_BUFFER_MS 500      // Engine-side capture buffering
+
+// Pre-roll: the microphone stays open while idle so a recording starts with the speech before it
+#define PREROLL_SAMPLES (STT_SAMPLE_RATE * CONFIG_STT_PREROLL_MS / 1000)
+#define PREROLL_READ_SAMPLES 256   // 16ms per read
+#define PREROLL_RETRY_MS 1000      // Between attempts to open the microphone
+
+// Voice activity: stop after trailing silence and upload only the speech (audio engine VAD)
+#ifdef CONFIG_STT_VAD_AUTOSTOP_MS
+#define VAD_AUTOSTOP_MS CONFIG_STT_VAD_AUTOSTOP_MS
+#else
+#define VAD_AUTOSTOP_MS 0
+#endif
+#ifdef CONFIG_STT_VAD_TRIM
+#define VAD_TRIM_MARGIN_BYTES (STT_SAMPLE_RATE * 2 * CONFIG_STT_VAD_TRIM_MARGIN_MS / 1000)
+#endif
+#define TRIM_UNKNOWN SIZE_MAX      // trim_start before the first speech
 
 // WAV header size
 #define WAV_HEADER_SIZE 44
@@ -40,6 +66,24 @@ static const char *TAG = "stt";
 // Multipart boundary
 #define MULTIPART_BOUNDARY "----ESP32P4AudioBoundary"
 
+// Upload configuration
+#define UPLOAD_CHUNK_SIZE 16384      // Max bytes per esp_http_client_write()
+#define RESPONSE_BUFFER_SIZE 8192    // 8KB should be enough for transcription JSON
+
+// Pipelined upload configuration
+#define WAV_SIZE_STREAMING 0xFFFFFFFFu  // WAV size placeholder for unknown length
+#define PIPELINE_MIN_CHUNK 8192        // ~250ms of audio per transfer chunk
+#define PIPELINE_MIN_CHUNK_OGG 1024    // ~330ms of Opus at 24 kbps
+#define PIPELINE_POLL_MS 100           // Upper bound between checks for new audio
+
+// Opus upload configuration
+#define OGG_MAX_BITRATE 64000          // Highest selectable Opus bitrate
+#define OGG_MAX_SIZE ((OGG_MAX_BITRATE / 8) * MAX_RECORDING_SECONDS * 5 / 4)  // VBR headroom
+#define OGG_SEGMENT_SIZE (SEGMENT_SIZE / 4)  // Opus is ~20x smaller than PCM
+#define OGG_FRAMES_PER_PAGE 10         // 200ms of audio per Ogg page
+#define ENCODER_FINISH_TIMEOUT_MS 2000
+#define ENCODER_CATCHUP_BYTES (RECORDING_CHUNK_SIZE * 3)  // Per read, so a backlog cannot overrun the encoder ring
+
 /**
  * WAV file header (44 bytes)
  */
@@ -64,35 +108,98 @@ typedef struct __attribute__((packed)) {
  */
 typedef struct {
     stt_state_t state;
-    uint8_t *audio_buffer;        // PSRAM buffer for recording
-    size_t audio_size;            // Current size of recorded data
-    size_t audio_capacity;        // Buffer capacity
+    capture_store_t audio;        // PCM recording, PSRAM segments
+    size_t audio_bytes;           // Size of the last recording (kept after the store is released)
+    size_t preroll_bytes;         // Leading bytes of the recording taken from the pre-roll
+    size_t trim_start;            // First PCM byte to upload, TRIM_UNKNOWN until speech is heard
+    size_t trim_end;              // End of the PCM to upload (batch), set when recording stops
     uint32_t recording_start_ms;  // Timestamp when recording started
     uint32_t recording_duration_ms;
+    int64_t stopped_us;           // Capture loop exit of the last recording
     char *transcription;          // Result text (heap allocated)
     char *error_message;          // Error message (heap allocated)
     SemaphoreHandle_t mutex;      // Protect state access
+    stt_state_t published_state;  // Last state pushed to transcript clients
+    const char *published_error;
     TaskHandle_t recording_task;  // Recording task handle
     TaskHandle_t transcribe_task; // Transcription task handle
+    TaskHandle_t upload_task;     // Pipelined upload task handle
     volatile bool stop_requested; // Signal to stop recording
+    stt_mode_t mode;              // Mode of the current recording
+    volatile bool recording_done; // Pipelined: capture finished, the stores are final
+    volatile bool upload_abort;   // Pipelined: discard the upload (error during capture)
+    volatile bool use_opus;       // Upload the Ogg Opus stream instead of WAV
+    capture_store_t ogg;          // Encoded stream, PSRAM segments
 } stt_context_t;
 
 static stt_context_t s_ctx = {0};
 static bool s_initialized = false;
 
-// HTTP response buffer for capturing Whisper API response
+static metrics_metric_t s_m_stop_to_text[2] = {
+    [STT_MODE_BATCH] = METRICS_HISTOGRAM_MS_INIT("stt_stop_to_text_ms", "Recording stopped to transcription received",
+                                                 "mode", "batch"),
+    [STT_MODE_PIPELINED] = METRICS_HISTOGRAM_MS_INIT("stt_stop_to_text_ms",
+                                                     "Recording stopped to transcription received",
+                                                     "mode", "pipelined"),
+};
+static metrics_metric_t s_m_response = METRICS_HISTOGRAM_MS_INIT(
+    "stt_response_ms", "Upload complete to Whisper response headers", NULL, NULL);
+static metrics_metric_t s_m_write = METRICS_HISTOGRAM_US_INIT(
+    "stt_upload_write_us", "Latency of one upload write", NULL, NULL);
+static metrics_metric_t s_m_errors = METRICS_COUNTER_INIT("stt_errors_total", "Recordings that ended in an error",
+                                                          NULL, NULL);
+
+/**
+ * Pre-roll state
+ *
+ * While idle the pre-roll task keeps the last PREROLL_SAMPLES in a ring.
+ * A recording takes the lock, copies the ring and reads the same stream
+ * until it stops, so there is no gap between the history and the capture.
+ */
+typedef struct {
+    audio_engine_stream_handle_t stream;
+    int16_t *ring;                // PSRAM, PREROLL_SAMPLES
+    size_t head;                  // Next write position
+    bool full;                    // Ring has wrapped at least once
+    SemaphoreHandle_t lock;       // Held by whoever reads the stream
+    TaskHandle_t task;
+    volatile bool stop;
+} stt_preroll_t;
+
+static stt_preroll_t s_preroll = {0};
+
+/**
+ * Multipart framing written around the audio payload
+ */
 typedef struct {
-    char *buffer;
-    size_t size;
-    size_t capacity;
-} http_response_t;
+    uint8_t preamble[512 + WAV_HEADER_SIZE];  // Form fields, file part header, WAV header (PCM only)
+    size_t preamble_len;
+    char trailer[64];
+    size_t trailer_len;
+} multipart_frame_t;
 
 // Forward declarations
 static void recording_task(void *arg);
 static void transcribe_task(void *arg);
+static void pipeline_upload_task(void *arg);
 static void build_wav_header(wav_header_t *header, size_t pcm_data_size);
-static size_t build_multipart_body(uint8_t **body_out, const uint8_t *audio_data, size_t audio_size);
-static esp_err_t whisper_http_event_handler(esp_http_client_event_t *evt);
+static void build_multipart_frame(multipart_frame_t *frame, size_t audio_size, bool ogg);
+
+/**
+ * Release the state mutex, pushing the state to transcript clients if it changed
+ *
+ * The whole transcription arrives at once, so it rides on the "done" state.
+ */
+static void unlock_and_publish(void)
+{
+    if (s_ctx.state != s_ctx.published_state || s_ctx.error_message != s_ctx.published_error) {
+        s_ctx.published_state = s_ctx.state;
+        s_ctx.published_error = s_ctx.error_message;
+        transcript_push_state(TRANSCRIPT_SOURCE_STT, stt_state_name(s_ctx.state), s_ctx.error_message,
+                              s_ctx.state == STT_STATE_DONE ? s_ctx.transcription : NULL);
+    }
+    xSemaphoreGive(s_ctx.mutex);
+}
 
 /**
  * Build WAV header for PCM audio
@@ -100,7 +207,8 @@ static esp_err_t whisper_http_event_handler(esp_http_client_event_t *evt);
 static void build_wav_header(wav_header_t *header, size_t pcm_data_size)
 {
     memcpy(header->riff_tag, "RIFF", 4);
-    header->file_size = pcm_data_size + WAV_HEADER_SIZE - 8;
+    header->file_size = (pcm_data_size == WAV_SIZE_STREAMING) ?
+                        WAV_SIZE_STREAMING : pcm_data_size + WAV_HEADER_SIZE - 8;
     memcpy(header->wave_tag, "WAVE", 4);
 
     memcpy(header->fmt_tag, "fmt ", 4);
@@ -117,100 +225,365 @@ static void build_wav_header(wav_header_t *header, size_t pcm_data_size)
 }
 
 /**
- * Build multipart/form-data body for Whisper API
+ * Build multipart/form-data framing for Whisper API
+ *
+ * The audio itself is not copied; it is written between preamble and trailer.
+ * Ogg streams are self-describing, so only PCM gets a WAV header.
  */
-static size_t build_multipart_body(uint8_t **body_out, const uint8_t *audio_data, size_t audio_size)
+static void build_multipart_frame(multipart_frame_t *frame, size_t audio_size, bool ogg)
 {
-    wav_header_t wav_header;
-    build_wav_header(&wav_header, audio_size);
-
-    // Part 1: model field
-    char part1[256];
-    int part1_len = snprintf(part1, sizeof(part1),
+    // Part 1: model field, Part 2: file field header
+    int len = snprintf((char *)frame->preamble, sizeof(frame->preamble) - WAV_HEADER_SIZE,
         "--%s\r\n"
         "Content-Disposition: form-data; name=\"model\"\r\n\r\n"
-        "%s\r\n",
-        MULTIPART_BOUNDARY, WHISPER_MODEL);
-
-    // Part 2: file field header
-    char part2_header[256];
-    int part2_header_len = snprintf(part2_header, sizeof(part2_header),
+        "%s\r\n"
         "--%s\r\n"
-        "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n"
-        "Content-Type: audio/wav\r\n\r\n",
-        MULTIPART_BOUNDARY);
+        "Content-Disposition: form-data; name=\"file\"; filename=\"%s\"\r\n"
+        "Content-Type: %s\r\n\r\n",
+        MULTIPART_BOUNDARY, WHISPER_MODEL, MULTIPART_BOUNDARY,
+        ogg ? "audio.ogg" : "audio.wav", ogg ? "audio/ogg" : "audio/wav");
+    frame->preamble_len = len;
+
+    // WAV header starts the file content
+    if (!ogg) {
+        wav_header_t wav_header;
+        build_wav_header(&wav_header, audio_size);
+        memcpy(frame->preamble + len, &wav_header, WAV_HEADER_SIZE);
+        frame->preamble_len += WAV_HEADER_SIZE;
+    }
 
     // Trailer
-    char trailer[128];
-    int trailer_len = snprintf(trailer, sizeof(trailer),
+    frame->trailer_len = snprintf(frame->trailer, sizeof(frame->trailer),
         "\r\n--%s--\r\n",
         MULTIPART_BOUNDARY);
+}
+
+/**
+ * Record an error message and enter the error state
+ */
+static void set_error(const char *message)
+{
+    metrics_inc(&s_m_errors);
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    s_ctx.state = STT_STATE_ERROR;
+    if (s_ctx.error_message) {
+        free(s_ctx.error_message);
+    }
+    s_ctx.error_message = strdup(message);
+    unlock_and_publish();
+}
 
-    // Total size
-    size_t total_size = part1_len + part2_header_len + WAV_HEADER_SIZE + audio_size + trailer_len;
+/**
+ * Tell a pipelined upload that the recording failed
+ */
+static void pipeline_abort(void)
+{
+    if (s_ctx.mode == STT_MODE_PIPELINED && s_ctx.upload_task) {
+        s_ctx.upload_abort = true;
+        xTaskNotifyGive(s_ctx.upload_task);
+    }
+}
 
-    ESP_LOGI(TAG, "Building multipart body: %d bytes total", total_size);
+/**
+ * Store that gets uploaded (Ogg stream or raw PCM)
+ */
+static const capture_store_t *upload_store(bool ogg)
+{
+    return ogg ? &s_ctx.ogg : &s_ctx.audio;
+}
 
-    // Allocate in PSRAM
-    uint8_t *body = heap_caps_malloc(total_size, MALLOC_CAP_SPIRAM);
-    if (!body) {
-        ESP_LOGE(TAG, "Failed to allocate multipart body (%d bytes)", total_size);
-        return 0;
+/**
+ * Hand the recording's segments back once nothing will read them again
+ */
+static void release_recording(void)
+{
+    capture_store_release(&s_ctx.audio);
+    capture_store_release(&s_ctx.ogg);
+}
+
+/**
+ * Encoder output - append an Ogg page to the upload store
+ */
+static esp_err_t ogg_page_cb(const uint8_t *data, size_t len, void *user_ctx)
+{
+    if (capture_store_append(&s_ctx.ogg, data, len) != ESP_OK) {
+        ESP_LOGE(TAG, "Ogg store full (%d bytes)", (int)capture_store_size(&s_ctx.ogg));
+        return ESP_ERR_NO_MEM;
     }
 
-    // Assemble body
-    size_t offset = 0;
+    if (s_ctx.mode == STT_MODE_PIPELINED) {
+        xTaskNotifyGive(s_ctx.upload_task);
+    }
+    return ESP_OK;
+}
 
-    memcpy(body + offset, part1, part1_len);
-    offset += part1_len;
+/**
+ * Create an HTTP client for the Whisper API with auth and content type set
+ */
+static esp_http_client_handle_t whisper_client_create(void)
+{
+#ifndef CONFIG_OPENAI_API_KEY
+    ESP_LOGE(TAG, "OpenAI API key not configured");
+    return NULL;
+#else
+    esp_http_client_config_t config = {
+        .url = WHISPER_API_URL,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = 120000,  // 2 minute timeout for large uploads
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .buffer_size = 4096,
+        .buffer_size_tx = 4096,
+    };
 
-    memcpy(body + offset, part2_header, part2_header_len);
-    offset += part2_header_len;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (!client) {
+        return NULL;
+    }
 
-    memcpy(body + offset, &wav_header, WAV_HEADER_SIZE);
-    offset += WAV_HEADER_SIZE;
+    // Set headers
+    char content_type[128];
+    snprintf(content_type, sizeof(content_type),
+             "multipart/form-data; boundary=%s", MULTIPART_BOUNDARY);
+    esp_http_client_set_header(client, "Content-Type", content_type);
 
-    memcpy(body + offset, audio_data, audio_size);
-    offset += audio_size;
+    char auth_header[256];
+    snprintf(auth_header, sizeof(auth_header), "Bearer %s", CONFIG_OPENAI_API_KEY);
+    esp_http_client_set_header(client, "Authorization", auth_header);
 
-    memcpy(body + offset, trailer, trailer_len);
-    offset += trailer_len;
+    return client;
+#endif
+}
 
-    *body_out = body;
-    return total_size;
+/**
+ * Write a buffer completely to an open request
+ */
+static esp_err_t whisper_write_all(esp_http_client_handle_t client, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        int chunk = (len > UPLOAD_CHUNK_SIZE) ? UPLOAD_CHUNK_SIZE : (int)len;
+        int64_t start_us = esp_timer_get_time();
+        int written = esp_http_client_write(client, (const char *)data, chunk);
+        metrics_observe_since(&s_m_write, start_us);
+        if (written <= 0) {
+            ESP_LOGE(TAG, "Upload write failed (%d)", written);
+            return ESP_FAIL;
+        }
+        data += written;
+        len -= written;
+    }
+    return ESP_OK;
 }
 
 /**
- * HTTP event handler to capture Whisper API response
+ * Write len bytes of a store, starting at offset, to an open request
  */
-static esp_err_t whisper_http_event_handler(esp_http_client_event_t *evt)
+static esp_err_t whisper_write_store(esp_http_client_handle_t client, const capture_store_t *store,
+                                     size_t offset, size_t len)
 {
-    http_response_t *resp = (http_response_t *)evt->user_data;
+    while (len > 0) {
+        size_t span;
+        const uint8_t *data = capture_store_span(store, offset, &span);
+        if (!data) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (span > len) {
+            span = len;
+        }
+        if (whisper_write_all(client, data, span) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        offset += span;
+        len -= span;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Read the Whisper API response of a fully written request and publish the result
+ */
+static void whisper_finish_request(esp_http_client_handle_t client)
+{
+    int64_t sent_us = esp_timer_get_time();
+    if (esp_http_client_fetch_headers(client) < 0) {
+        ESP_LOGE(TAG, "HTTP request failed: no response headers");
+        set_error("Network request failed");
+        return;
+    }
+    metrics_observe_since(&s_m_response, sent_us);
+
+    char *response = audio_pool_alloc(AUDIO_POOL_PSRAM, RESPONSE_BUFFER_SIZE);
+    if (!response) {
+        ESP_LOGE(TAG, "Failed to allocate response buffer");
+        set_error("Memory allocation failed");
+        return;
+    }
+
+    int status = esp_http_client_get_status_code(client);
+    int response_size = esp_http_client_read_response(client, response, RESPONSE_BUFFER_SIZE - 1);
+    if (response_size < 0) {
+        response_size = 0;
+    }
+    response[response_size] = '\0';
+
+    ESP_LOGI(TAG, "HTTP status: %d, response size: %d", status, response_size);
+
+    if (status == 200 && response_size > 0) {
+        ESP_LOGI(TAG, "Response: %s", response);
 
-    switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            if (resp && resp->buffer) {
-                // Append data to response buffer
-                size_t new_size = resp->size + evt->data_len;
-                if (new_size < resp->capacity) {
-                    memcpy(resp->buffer + resp->size, evt->data, evt->data_len);
-                    resp->size = new_size;
-                    resp->buffer[resp->size] = '\0';  // Null terminate
-                } else {
-                    ESP_LOGW(TAG, "Response buffer full, truncating");
+        // Parse JSON response
+        cJSON *root = cJSON_Parse(response);
+        if (root) {
+            cJSON *text = cJSON_GetObjectItem(root, "text");
+            if (text && cJSON_IsString(text)) {
+                xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+                if (s_ctx.transcription) {
+                    free(s_ctx.transcription);
                 }
+                s_ctx.transcription = strdup(text->valuestring);
+                s_ctx.state = STT_STATE_DONE;
+                unlock_and_publish();
+                metrics_observe_since(&s_m_stop_to_text[s_ctx.mode], s_ctx.stopped_us);
+                ESP_LOGI(TAG, "Transcription: %.100s%s",
+                         s_ctx.transcription,
+                         strlen(s_ctx.transcription) > 100 ? "..." : "");
+            } else {
+                ESP_LOGE(TAG, "No 'text' field in response");
+                set_error("Invalid API response format");
             }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP response received: %d bytes", resp ? resp->size : 0);
-            break;
-        case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP error event");
-            break;
-        default:
-            break;
+            cJSON_Delete(root);
+        } else {
+            ESP_LOGE(TAG, "Failed to parse JSON: %s", response);
+            set_error("Failed to parse API response");
+        }
+    } else if (status != 200) {
+        ESP_LOGE(TAG, "API error (HTTP %d): %s", status, response);
+        char error_msg[256];
+        snprintf(error_msg, sizeof(error_msg), "API error: HTTP %d", status);
+        set_error(error_msg);
+    } else {
+        ESP_LOGE(TAG, "Empty response from API");
+        set_error("Empty response from API");
+    }
+
+    audio_pool_free(response);
+}
+
+/**
+ * Pre-roll task - keeps the most recent audio while no recording runs
+ */
+static void preroll_task(void *arg)
+{
+    ESP_LOGI(TAG, "Pre-roll started (%d ms)", CONFIG_STT_PREROLL_MS);
+
+    while (!s_preroll.stop) {
+        xSemaphoreTake(s_preroll.lock, portMAX_DELAY);
+
+        if (!s_preroll.stream &&
+            audio_engine_capture_open(STT_SAMPLE_RATE, CAPTURE_BUFFER_MS, &s_preroll.stream) != ESP_OK) {
+            s_preroll.stream = NULL;
+            xSemaphoreGive(s_preroll.lock);
+            vTaskDelay(pdMS_TO_TICKS(PREROLL_RETRY_MS));
+            continue;
+        }
+
+        size_t room = PREROLL_SAMPLES - s_preroll.head;
+        size_t n = audio_engine_capture_read(s_preroll.stream, s_preroll.ring + s_preroll.head,
+                                             room < PREROLL_READ_SAMPLES ? room : PREROLL_READ_SAMPLES, 100);
+        s_preroll.head += n;
+        if (s_preroll.head == PREROLL_SAMPLES) {
+            s_preroll.head = 0;
+            s_preroll.full = true;
+        }
+
+        // A waiting recording task has the higher priority and takes over here
+        xSemaphoreGive(s_preroll.lock);
+    }
+
+    if (s_preroll.stream) {
+        audio_engine_stream_close(s_preroll.stream);
+        s_preroll.stream = NULL;
+    }
+    s_preroll.task = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * Take the pre-roll stream over, copying its history into the recording
+ *
+ * @return The open stream (lock held until preroll_return()), or NULL if there is no pre-roll
+ */
+static audio_engine_stream_handle_t preroll_claim(void)
+{
+    if (!s_preroll.task) {
+        return NULL;
+    }
+
+    xSemaphoreTake(s_preroll.lock, portMAX_DELAY);
+    if (!s_preroll.stream) {
+        xSemaphoreGive(s_preroll.lock);  // Microphone not open yet
+        return NULL;
+    }
+
+    // Oldest samples first
+    if (s_preroll.full) {
+        capture_store_append(&s_ctx.audio, s_preroll.ring + s_preroll.head,
+                             (PREROLL_SAMPLES - s_preroll.head) * sizeof(int16_t));
+    }
+    capture_store_append(&s_ctx.audio, s_preroll.ring, s_preroll.head * sizeof(int16_t));
+    return s_preroll.stream;
+}
+
+/**
+ * Give the stream back to the pre-roll task with an empty history
+ */
+static void preroll_return(void)
+{
+    s_preroll.head = 0;
+    s_preroll.full = false;
+    xSemaphoreGive(s_preroll.lock);
+}
+
+/**
+ * Pass recorded PCM from the store to the encoder, at most max bytes
+ *
+ * @return true if anything was accepted
+ */
+static bool feed_encoder(audio_encoder_handle_t encoder, size_t *fed, size_t end, size_t max)
+{
+    bool progress = false;
+
+    while (*fed < end && max > 0) {
+        size_t span;
+        const int16_t *pcm = (const int16_t *)capture_store_span(&s_ctx.audio, *fed, &span);
+        size_t n = end - *fed;
+        n = (n < span) ? n : span;
+        n = (n < max) ? n : max;
+
+        size_t written = audio_encoder_write(encoder, pcm, n / sizeof(int16_t)) * sizeof(int16_t);
+        *fed += written;
+        max -= written;
+        progress |= written > 0;
+        if (written < n) {
+            break;  // Ring full, the rest goes with the next read
+        }
+    }
+    return progress;
+}
+
+/**
+ * Start of the PCM upload, TRIM_UNKNOWN until the recording has found speech
+ */
+static size_t trim_start_get(void)
+{
+    return __atomic_load_n(&s_ctx.trim_start, __ATOMIC_ACQUIRE);
+}
+
+static void trim_start_set(size_t start)
+{
+    __atomic_store_n(&s_ctx.trim_start, start, __ATOMIC_RELEASE);
+    if (s_ctx.mode == STT_MODE_PIPELINED) {
+        xTaskNotifyGive(s_ctx.upload_task);
     }
-    return ESP_OK;
 }
 
 /**
@@ -220,34 +593,53 @@ static void recording_task(void *arg)
 {
     ESP_LOGI(TAG, "Recording task started");
 
-    // Configure codec for recording (16kHz, 16-bit, stereo I2S but we extract mono)
-    esp_err_t err = bsp_extra_codec_set_fs(STT_SAMPLE_RATE, STT_BITS_PER_SAMPLE, I2S_SLOT_MODE_STEREO);
+    // Mono 16kHz microphone stream: the pre-roll's if it runs, else a new one
+    esp_err_t err = ESP_OK;
+    audio_engine_stream_handle_t capture = preroll_claim();
+    bool preroll = capture != NULL;
+    if (!preroll) {
+        err = audio_engine_capture_open(STT_SAMPLE_RATE, CAPTURE_BUFFER_MS, &capture);
+    }
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure codec: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "Failed to open capture stream: %s", esp_err_to_name(err));
         xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
         s_ctx.state = STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Failed to configure audio codec");
+        s_ctx.error_message = strdup("Failed to open microphone");
         s_ctx.recording_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
+        unlock_and_publish();
+        pipeline_abort();
         vTaskDelete(NULL);
         return;
     }
 
-    // Allocate chunk buffer (stereo input = 2x mono size)
-    uint8_t *chunk_buffer = heap_caps_malloc(RECORDING_CHUNK_SIZE * 2, MALLOC_CAP_INTERNAL);
-    if (!chunk_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate chunk buffer");
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Memory allocation failed");
-        s_ctx.recording_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
-        vTaskDelete(NULL);
-        return;
+    // Encode alongside capture so the upload is ready when recording stops
+    audio_encoder_handle_t encoder = NULL;
+    if (s_ctx.use_opus) {
+        audio_encoder_config_t enc_config = {
+            .sample_rate = STT_SAMPLE_RATE,
+            .frames_per_page = OGG_FRAMES_PER_PAGE,
+            .output_cb = ogg_page_cb,
+        };
+        if (audio_encoder_create(&enc_config, &encoder) != ESP_OK) {
+            ESP_LOGW(TAG, "Opus encoder unavailable, uploading WAV");
+            s_ctx.use_opus = false;
+        }
+    }
+
+    // The pre-roll history leads the recording
+    s_ctx.preroll_bytes = capture_store_size(&s_ctx.audio);
+    if (s_ctx.preroll_bytes > 0) {
+        ESP_LOGI(TAG, "Pre-roll: %d ms", (int)(s_ctx.preroll_bytes * 1000 / (STT_SAMPLE_RATE * 2)));
+        if (s_ctx.mode == STT_MODE_PIPELINED) {
+            xTaskNotifyGive(s_ctx.upload_task);
+        }
     }
 
     s_ctx.recording_start_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    s_ctx.audio_size = 0;
+    size_t audio_size = s_ctx.preroll_bytes;
+    size_t encoded = 0;             // PCM bytes passed to the encoder, from trim_start on
+    size_t speech_end = 0;          // End of the last read that had speech
+    bool heard_speech = false;
 
     while (!s_ctx.stop_requested) {
         // Check recording duration limit
@@ -257,55 +649,125 @@ static void recording_task(void *arg)
             break;
         }
 
-        // Check buffer capacity
-        if (s_ctx.audio_size + RECORDING_CHUNK_SIZE > s_ctx.audio_capacity) {
-            ESP_LOGW(TAG, "Audio buffer full (%d bytes)", s_ctx.audio_size);
+        // Next free space in the store; a new segment is allocated when the last one fills
+        size_t avail;
+        int16_t *mono_dest = (int16_t *)capture_store_reserve(&s_ctx.audio, &avail);
+        if (!mono_dest) {
+            ESP_LOGW(TAG, "Recording store full (%d bytes)", audio_size);
             break;
         }
 
-        // Read from microphone (stereo I2S data)
-        size_t bytes_read = 0;
-        err = bsp_extra_i2s_read(chunk_buffer, RECORDING_CHUNK_SIZE * 2, &bytes_read, 100);
-        if (err != ESP_OK) {
-            ESP_LOGW(TAG, "I2S read error: %s", esp_err_to_name(err));
-            vTaskDelay(pdMS_TO_TICKS(10));
+        // Mono samples go straight into the store
+        size_t want = (avail < RECORDING_CHUNK_SIZE) ? avail : RECORDING_CHUNK_SIZE;
+        size_t num_samples = audio_engine_capture_read(capture, mono_dest, want / 2, 100);
+        if (num_samples == 0) {
             continue;
         }
 
-        // Convert stereo to mono (take left channel only)
-        // Stereo format: L0_lo L0_hi R0_lo R0_hi L1_lo L1_hi R1_lo R1_hi ...
-        int16_t *stereo_samples = (int16_t *)chunk_buffer;
-        int16_t *mono_dest = (int16_t *)(s_ctx.audio_buffer + s_ctx.audio_size);
-        size_t num_stereo_samples = bytes_read / 4;  // 4 bytes per stereo sample pair
+        // Publish the new size only after the samples are in place (read by pipelined upload)
+        capture_store_commit(&s_ctx.audio, num_samples * 2);
+        size_t chunk_start = audio_size;
+        audio_size += num_samples * 2;
+        if (s_ctx.mode == STT_MODE_PIPELINED) {
+            xTaskNotifyGive(s_ctx.upload_task);
+        }
 
-        for (size_t i = 0; i < num_stereo_samples; i++) {
-            mono_dest[i] = stereo_samples[i * 2];  // Left channel
+        // The engine has classified every sample just read
+        audio_engine_vad_t vad;
+        audio_engine_vad_get(&vad);
+        if (vad.speech) {
+            if (!heard_speech) {
+                heard_speech = true;
+                ESP_LOGI(TAG, "Speech at %lu ms", (unsigned long)elapsed);
+            }
+            if (trim_start_get() == TRIM_UNKNOWN) {
+#ifdef CONFIG_STT_VAD_TRIM
+                // Speech already active on the first read may have begun in the pre-roll
+                bool first_read = chunk_start == s_ctx.preroll_bytes;
+                trim_start_set((first_read || chunk_start < VAD_TRIM_MARGIN_BYTES) ? 0
+                               : chunk_start - VAD_TRIM_MARGIN_BYTES);
+#endif
+            }
+            speech_end = audio_size;
+        } else if (VAD_AUTOSTOP_MS > 0 && heard_speech && vad.silence_ms >= VAD_AUTOSTOP_MS) {
+            ESP_LOGI(TAG, "Stopping after %lu ms of silence", (unsigned long)vad.silence_ms);
+            break;
         }
 
-        s_ctx.audio_size += num_stereo_samples * 2;  // 2 bytes per mono sample
+        // Opus gets the audio from the start of speech on
+        if (encoder && trim_start_get() != TRIM_UNKNOWN) {
+            if (encoded < s_ctx.trim_start) {
+                encoded = s_ctx.trim_start;
+            }
+            feed_encoder(encoder, &encoded, audio_size, ENCODER_CATCHUP_BYTES);
+        }
 
         // Periodic logging
-        if ((s_ctx.audio_size % 65536) < RECORDING_CHUNK_SIZE) {
+        if ((audio_size % 65536) < num_samples * 2) {
             ESP_LOGI(TAG, "Recording: %d KB, %lu ms",
-                     s_ctx.audio_size / 1024, (unsigned long)elapsed);
+                     audio_size / 1024, (unsigned long)elapsed);
         }
     }
 
     s_ctx.recording_duration_ms = (xTaskGetTickCount() * portTICK_PERIOD_MS) - s_ctx.recording_start_ms;
-    ESP_LOGI(TAG, "Recording stopped: %d bytes (%.1f KB), %lu ms",
-             s_ctx.audio_size, s_ctx.audio_size / 1024.0f,
-             (unsigned long)s_ctx.recording_duration_ms);
+    s_ctx.stopped_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Recording stopped: %d bytes (%.1f KB), %lu ms, %d segments",
+             audio_size, audio_size / 1024.0f,
+             (unsigned long)s_ctx.recording_duration_ms, (int)s_ctx.audio.count);
+
+    if (preroll) {
+        preroll_return();
+    } else {
+        audio_engine_stream_close(capture);
+    }
+
+    // Settle the upload range; without any speech everything is sent
+    if (trim_start_get() == TRIM_UNKNOWN) {
+        trim_start_set(0);
+    }
+    s_ctx.trim_end = audio_size;
+#ifdef CONFIG_STT_VAD_TRIM
+    if (heard_speech && speech_end + VAD_TRIM_MARGIN_BYTES < audio_size) {
+        s_ctx.trim_end = speech_end + VAD_TRIM_MARGIN_BYTES;
+    }
+#endif
 
-    heap_caps_free(chunk_buffer);
+    // Drain the encoder; on failure the PCM recording is uploaded instead
+    if (encoder) {
+        if (encoded < s_ctx.trim_start) {
+            encoded = s_ctx.trim_start;
+        }
+        for (int stalls = 0; encoded < audio_size && stalls < ENCODER_FINISH_TIMEOUT_MS / 10; ) {
+            if (!feed_encoder(encoder, &encoded, audio_size, ENCODER_CATCHUP_BYTES)) {
+                stalls++;
+                vTaskDelay(pdMS_TO_TICKS(10));
+            }
+        }
+        err = audio_encoder_finish(encoder, pdMS_TO_TICKS(ENCODER_FINISH_TIMEOUT_MS));
+        audio_encoder_destroy(encoder);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Opus encoding failed (%s), uploading WAV", esp_err_to_name(err));
+            s_ctx.use_opus = false;
+        } else {
+            size_t ogg_size = capture_store_size(&s_ctx.ogg);
+            ESP_LOGI(TAG, "Opus: %d bytes (%.1fx smaller than PCM)",
+                     ogg_size, ogg_size ? (float)audio_size / ogg_size : 0.0f);
+        }
+    }
 
-    // Check minimum recording length
-    if (s_ctx.audio_size < STT_SAMPLE_RATE) {  // Less than 0.5 seconds
+    // Check minimum recording length (the pre-roll does not count)
+    if (audio_size - s_ctx.preroll_bytes < STT_SAMPLE_RATE) {  // Less than 0.5 seconds
         ESP_LOGE(TAG, "Recording too short");
+        if (s_ctx.mode != STT_MODE_PIPELINED) {
+            release_recording();  // A pipelined upload may still be reading; the next start frees it
+        }
         xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
         s_ctx.state = STT_STATE_ERROR;
         s_ctx.error_message = strdup("Recording too short (minimum 0.5 seconds)");
         s_ctx.recording_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
+        s_ctx.audio_bytes = audio_size;
+        unlock_and_publish();
+        pipeline_abort();
         vTaskDelete(NULL);
         return;
     }
@@ -314,16 +776,26 @@ static void recording_task(void *arg)
     xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
     s_ctx.state = STT_STATE_TRANSCRIBING;
     s_ctx.recording_task = NULL;
-    xSemaphoreGive(s_ctx.mutex);
+    s_ctx.audio_bytes = audio_size;
+    unlock_and_publish();
+
+    // Pipelined: most audio is already uploaded, let the upload task finish the request
+    if (s_ctx.mode == STT_MODE_PIPELINED) {
+        s_ctx.recording_done = true;
+        xTaskNotifyGive(s_ctx.upload_task);
+        vTaskDelete(NULL);
+        return;
+    }
 
     // Start transcription task
-    BaseType_t task_created = xTaskCreate(
+    BaseType_t task_created = xTaskCreatePinnedToCore(
         transcribe_task,
         "stt_transcribe",
-        16384,  // Large stack for HTTPS
+        TASK_STT_UPLOAD_STACK,
         NULL,
-        5,
-        &s_ctx.transcribe_task
+        TASK_STT_UPLOAD_PRIORITY,
+        &s_ctx.transcribe_task,
+        TASK_STT_UPLOAD_CORE
     );
 
     if (task_created != pdPASS) {
@@ -331,175 +803,209 @@ static void recording_task(void *arg)
         xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
         s_ctx.state = STT_STATE_ERROR;
         s_ctx.error_message = strdup("Failed to start transcription");
-        xSemaphoreGive(s_ctx.mutex);
+        unlock_and_publish();
     }
 
     vTaskDelete(NULL);
 }
 
 /**
- * Transcription task - uploads audio to Whisper API
+ * Upload the complete recording to Whisper API and publish the result
  */
-static void transcribe_task(void *arg)
+static void transcribe_batch(void)
 {
-    ESP_LOGI(TAG, "Transcription task started (%d bytes audio)", s_ctx.audio_size);
-
-    // Build multipart request body
-    uint8_t *body = NULL;
-    size_t body_size = build_multipart_body(&body, s_ctx.audio_buffer, s_ctx.audio_size);
-    if (body_size == 0 || !body) {
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Failed to build request body");
-        s_ctx.transcribe_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
-        vTaskDelete(NULL);
-        return;
+    bool ogg = s_ctx.use_opus;
+    const capture_store_t *store = upload_store(ogg);
+
+    // PCM is cut to the speech; Opus was only fed from its start
+    size_t start = ogg ? 0 : s_ctx.trim_start;
+    size_t data_size = (ogg ? capture_store_size(store) : s_ctx.trim_end) - start;
+    if (!ogg && data_size < s_ctx.audio_bytes) {
+        ESP_LOGI(TAG, "Trimmed %d ms of silence", (int)((s_ctx.audio_bytes - data_size) * 1000 / (STT_SAMPLE_RATE * 2)));
     }
 
-    // Allocate response buffer
-    http_response_t response = {0};
-    response.capacity = 8192;  // 8KB should be enough for transcription JSON
-    response.buffer = heap_caps_malloc(response.capacity, MALLOC_CAP_SPIRAM);
-    if (!response.buffer) {
-        ESP_LOGE(TAG, "Failed to allocate response buffer");
-        heap_caps_free(body);
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Memory allocation failed");
-        s_ctx.transcribe_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
-        vTaskDelete(NULL);
+    // Multipart framing around the recording; audio is sent straight from its segments
+    multipart_frame_t frame;
+    build_multipart_frame(&frame, data_size, ogg);
+    size_t content_length = frame.preamble_len + data_size + frame.trailer_len;
+
+    esp_http_client_handle_t client = whisper_client_create();
+    if (!client) {
+        release_recording();
+        set_error("HTTP client init failed");
         return;
     }
-    response.size = 0;
-    response.buffer[0] = '\0';
 
-    // Configure HTTP client with event handler
-    esp_http_client_config_t config = {
-        .url = WHISPER_API_URL,
-        .method = HTTP_METHOD_POST,
-        .timeout_ms = 120000,  // 2 minute timeout for large uploads
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .buffer_size = 4096,
-        .buffer_size_tx = 4096,
-        .event_handler = whisper_http_event_handler,
-        .user_data = &response,
-    };
+    ESP_LOGI(TAG, "Uploading %d bytes (%s) to Whisper API...", content_length, ogg ? "ogg" : "wav");
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (!client) {
-        heap_caps_free(body);
-        heap_caps_free(response.buffer);
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = STT_STATE_ERROR;
-        s_ctx.error_message = strdup("HTTP client init failed");
-        s_ctx.transcribe_task = NULL;
-        xSemaphoreGive(s_ctx.mutex);
-        vTaskDelete(NULL);
-        return;
+    esp_err_t err = esp_http_client_open(client, content_length);
+    if (err == ESP_OK) {
+        err = whisper_write_all(client, frame.preamble, frame.preamble_len);
+    }
+    if (err == ESP_OK) {
+        err = whisper_write_store(client, store, start, data_size);
+    }
+    if (err == ESP_OK) {
+        err = whisper_write_all(client, (const uint8_t *)frame.trailer, frame.trailer_len);
     }
 
-    // Set headers
-    char content_type[128];
-    snprintf(content_type, sizeof(content_type),
-             "multipart/form-data; boundary=%s", MULTIPART_BOUNDARY);
-    esp_http_client_set_header(client, "Content-Type", content_type);
+    // Everything is sent; free the segments while Whisper works
+    release_recording();
 
-#ifdef CONFIG_OPENAI_API_KEY
-    char auth_header[256];
-    snprintf(auth_header, sizeof(auth_header), "Bearer %s", CONFIG_OPENAI_API_KEY);
-    esp_http_client_set_header(client, "Authorization", auth_header);
-#else
-    ESP_LOGE(TAG, "OpenAI API key not configured");
-    heap_caps_free(body);
-    heap_caps_free(response.buffer);
+    if (err == ESP_OK) {
+        whisper_finish_request(client);
+    } else {
+        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        set_error("Network request failed");
+    }
+
+    // Cleanup
     esp_http_client_cleanup(client);
+}
+
+/**
+ * Transcription task - streams recorded audio to Whisper API
+ */
+static void transcribe_task(void *arg)
+{
+    ESP_LOGI(TAG, "Transcription task started (%d bytes audio)", s_ctx.audio_bytes);
+
+    transcribe_batch();
+
     xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    s_ctx.state = STT_STATE_ERROR;
-    s_ctx.error_message = strdup("OpenAI API key not configured");
     s_ctx.transcribe_task = NULL;
     xSemaphoreGive(s_ctx.mutex);
+
     vTaskDelete(NULL);
-    return;
-#endif
+}
 
-    // Set POST body
-    esp_http_client_set_post_field(client, (const char *)body, body_size);
+/**
+ * Write one HTTP/1.1 transfer chunk
+ */
+static esp_err_t pipeline_write_chunk(esp_http_client_handle_t client, const uint8_t *data, size_t len)
+{
+    char size_line[16];
+    int size_len = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned int)len);
 
-    ESP_LOGI(TAG, "Uploading %d bytes to Whisper API...", body_size);
+    if (whisper_write_all(client, (const uint8_t *)size_line, size_len) != ESP_OK ||
+        whisper_write_all(client, data, len) != ESP_OK ||
+        whisper_write_all(client, (const uint8_t *)"\r\n", 2) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Write len bytes of a store, starting at offset, as one transfer chunk
+ */
+static esp_err_t pipeline_write_store_chunk(esp_http_client_handle_t client, const capture_store_t *store,
+                                            size_t offset, size_t len)
+{
+    char size_line[16];
+    int size_len = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned int)len);
+
+    if (whisper_write_all(client, (const uint8_t *)size_line, size_len) != ESP_OK ||
+        whisper_write_store(client, store, offset, len) != ESP_OK ||
+        whisper_write_all(client, (const uint8_t *)"\r\n", 2) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Pipelined upload task - streams audio with chunked transfer while recording
+ *
+ * The WAV header carries a streaming-size placeholder (Ogg needs none), so
+ * only the audio captured since the last chunk is left to send when
+ * recording stops. If the upload fails mid-way, the recording is sent as a
+ * batch upload instead.
+ */
+static void pipeline_upload_task(void *arg)
+{
+    ESP_LOGI(TAG, "Pipelined upload task started");
 
-    // Perform request (response captured via event handler)
-    esp_err_t err = esp_http_client_perform(client);
+    bool ogg = s_ctx.use_opus;
+    const capture_store_t *store = upload_store(ogg);
+    size_t min_chunk = ogg ? PIPELINE_MIN_CHUNK_OGG : PIPELINE_MIN_CHUNK;
 
+    multipart_frame_t frame;
+    build_multipart_frame(&frame, WAV_SIZE_STREAMING, ogg);
+
+    size_t sent = 0;
+    esp_err_t err = ESP_FAIL;
+    esp_http_client_handle_t client = whisper_client_create();
+    if (client) {
+        err = esp_http_client_open(client, -1);  // -1: chunked transfer encoding
+    }
     if (err == ESP_OK) {
-        int status = esp_http_client_get_status_code(client);
-
-        ESP_LOGI(TAG, "HTTP status: %d, response size: %d", status, response.size);
-
-        if (status == 200 && response.size > 0) {
-            ESP_LOGI(TAG, "Response: %s", response.buffer);
-
-            // Parse JSON response
-            cJSON *root = cJSON_Parse(response.buffer);
-            if (root) {
-                cJSON *text = cJSON_GetObjectItem(root, "text");
-                if (text && cJSON_IsString(text)) {
-                    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-                    if (s_ctx.transcription) {
-                        free(s_ctx.transcription);
-                    }
-                    s_ctx.transcription = strdup(text->valuestring);
-                    s_ctx.state = STT_STATE_DONE;
-                    xSemaphoreGive(s_ctx.mutex);
-                    ESP_LOGI(TAG, "Transcription: %.100s%s",
-                             s_ctx.transcription,
-                             strlen(s_ctx.transcription) > 100 ? "..." : "");
-                } else {
-                    ESP_LOGE(TAG, "No 'text' field in response");
-                    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-                    s_ctx.state = STT_STATE_ERROR;
-                    s_ctx.error_message = strdup("Invalid API response format");
-                    xSemaphoreGive(s_ctx.mutex);
-                }
-                cJSON_Delete(root);
-            } else {
-                ESP_LOGE(TAG, "Failed to parse JSON: %s", response.buffer);
-                xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-                s_ctx.state = STT_STATE_ERROR;
-                s_ctx.error_message = strdup("Failed to parse API response");
-                xSemaphoreGive(s_ctx.mutex);
-            }
-        } else if (status != 200) {
-            ESP_LOGE(TAG, "API error (HTTP %d): %s", status, response.buffer);
-            char error_msg[256];
-            snprintf(error_msg, sizeof(error_msg), "API error: HTTP %d", status);
-            xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-            s_ctx.state = STT_STATE_ERROR;
-            s_ctx.error_message = strdup(error_msg);
-            xSemaphoreGive(s_ctx.mutex);
-        } else {
-            ESP_LOGE(TAG, "Empty response from API");
-            xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-            s_ctx.state = STT_STATE_ERROR;
-            s_ctx.error_message = strdup("Empty response from API");
-            xSemaphoreGive(s_ctx.mutex);
+        err = pipeline_write_chunk(client, frame.preamble, frame.preamble_len);
+    }
+
+    // Forward audio as the recording task publishes it
+    while (err == ESP_OK && !s_ctx.upload_abort) {
+        // Encoder failed during capture: the Ogg stream is unusable, resend as WAV
+        if (ogg && !s_ctx.use_opus) {
+            err = ESP_FAIL;
+            break;
         }
-    } else {
-        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
-        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-        s_ctx.state = STT_STATE_ERROR;
-        s_ctx.error_message = strdup("Network request failed");
-        xSemaphoreGive(s_ctx.mutex);
+
+        bool done = s_ctx.recording_done;
+
+        // PCM waits for the recording to find speech, then starts there
+        size_t start = ogg ? 0 : trim_start_get();
+        if (start == TRIM_UNKNOWN) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPELINE_POLL_MS));
+            continue;
+        }
+        if (sent < start) {
+            sent = start;
+        }
+
+        size_t available = capture_store_size(store);
+        size_t pending = available - sent;
+
+        if (pending >= min_chunk || (done && pending > 0)) {
+            err = pipeline_write_store_chunk(client, store, sent, pending);
+            sent = available;
+        }
+
+        if (done && sent == available) {
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPELINE_POLL_MS));
     }
 
-    // Cleanup
-    esp_http_client_cleanup(client);
-    heap_caps_free(body);
-    heap_caps_free(response.buffer);
+    if (s_ctx.upload_abort) {
+        ESP_LOGI(TAG, "Pipelined upload discarded");
+    } else if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Recording stopped, finishing upload (%d bytes %s)", sent, ogg ? "ogg" : "audio");
+        err = pipeline_write_chunk(client, (const uint8_t *)frame.trailer, frame.trailer_len);
+        if (err == ESP_OK) {
+            err = whisper_write_all(client, (const uint8_t *)"0\r\n\r\n", 5);
+        }
+        if (err == ESP_OK) {
+            release_recording();  // Only the batch fallback would need it again
+            whisper_finish_request(client);
+        }
+    }
+
+    if (client) {
+        esp_http_client_cleanup(client);
+    }
+
+    // Upload broke during capture: wait for the recording, then send it in one go
+    if (err != ESP_OK && !s_ctx.upload_abort) {
+        ESP_LOGW(TAG, "Pipelined upload failed after %d bytes, falling back to batch upload", sent);
+        while (!s_ctx.recording_done && !s_ctx.upload_abort) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPELINE_POLL_MS));
+        }
+        if (!s_ctx.upload_abort) {
+            transcribe_batch();
+        }
+    }
 
     xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
-    s_ctx.transcribe_task = NULL;
+    s_ctx.upload_task = NULL;
     xSemaphoreGive(s_ctx.mutex);
 
     vTaskDelete(NULL);
@@ -511,7 +1017,7 @@ static void transcribe_task(void *arg)
 esp_err_t stt_init(void)
 {
     if (s_initialized) {
-        ESP_LOGW(TAG, "STT already initialized");
+        ESP_LOGD(TAG, "STT already initialized");
         return ESP_OK;
     }
 
@@ -532,18 +1038,35 @@ esp_err_t stt_init(void)
         return ESP_ERR_NO_MEM;
     }
 
-    // Allocate audio buffer in PSRAM
-    s_ctx.audio_capacity = MAX_AUDIO_BUFFER_SIZE;
-    s_ctx.audio_buffer = heap_caps_malloc(s_ctx.audio_capacity, MALLOC_CAP_SPIRAM);
-    if (!s_ctx.audio_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate audio buffer (%d bytes)", s_ctx.audio_capacity);
+    // Recording store; segments are allocated while recording
+    if (capture_store_init(&s_ctx.audio, SEGMENT_SIZE, MAX_AUDIO_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate recording store");
         vSemaphoreDelete(s_ctx.mutex);
         s_ctx.mutex = NULL;
         return ESP_ERR_NO_MEM;
     }
 
+#ifdef CONFIG_AUDIO_ENCODER_OPUS
+    // Encoded stream store; without it uploads stay WAV
+    if (capture_store_init(&s_ctx.ogg, OGG_SEGMENT_SIZE, OGG_MAX_SIZE) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to allocate Ogg store, Opus uploads disabled");
+    }
+#endif
+
+#if CONFIG_STT_PREROLL_MS > 0
+    s_preroll.ring = heap_caps_malloc(PREROLL_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    s_preroll.lock = xSemaphoreCreateMutex();
+    s_preroll.stop = false;
+    if (!s_preroll.ring || !s_preroll.lock ||
+        xTaskCreatePinnedToCore(preroll_task, "stt_preroll", TASK_STT_PREROLL_STACK, NULL,
+                                TASK_STT_PREROLL_PRIORITY, &s_preroll.task, TASK_STT_PREROLL_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to start pre-roll, recordings start at the button press");
+        s_preroll.task = NULL;
+    }
+#endif
+
     s_ctx.state = STT_STATE_IDLE;
-    s_ctx.audio_size = 0;
+    s_ctx.audio_bytes = 0;
     s_ctx.transcription = NULL;
     s_ctx.error_message = NULL;
     s_ctx.recording_task = NULL;
@@ -551,8 +1074,8 @@ esp_err_t stt_init(void)
     s_ctx.stop_requested = false;
 
     s_initialized = true;
-    ESP_LOGI(TAG, "STT initialized (buffer: %.1f MB, max: %d seconds)",
-             s_ctx.audio_capacity / (1024.0f * 1024.0f), MAX_RECORDING_SECONDS);
+    ESP_LOGI(TAG, "STT initialized (segments: %d KB, max: %d seconds, pre-roll: %d ms)",
+             SEGMENT_SIZE / 1024, MAX_RECORDING_SECONDS, s_preroll.task ? CONFIG_STT_PREROLL_MS : 0);
 
     return ESP_OK;
 }
@@ -561,6 +1084,14 @@ esp_err_t stt_init(void)
  * Start recording
  */
 esp_err_t stt_start_recording(void)
+{
+    return stt_start_recording_mode(STT_MODE_BATCH);
+}
+
+/**
+ * Start recording in the given mode
+ */
+esp_err_t stt_start_recording_mode(stt_mode_t mode)
 {
     if (!s_initialized) {
         ESP_LOGE(TAG, "STT not initialized");
@@ -575,6 +1106,13 @@ esp_err_t stt_start_recording(void)
         return ESP_ERR_INVALID_STATE;
     }
 
+    // The result is published just before the upload task exits; wait for it to let go of the stores
+    if (s_ctx.upload_task || s_ctx.transcribe_task) {
+        ESP_LOGW(TAG, "Previous upload still finishing");
+        xSemaphoreGive(s_ctx.mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
     // Clear previous results
     if (s_ctx.transcription) {
         free(s_ctx.transcription);
@@ -587,18 +1125,48 @@ esp_err_t stt_start_recording(void)
 
     s_ctx.state = STT_STATE_RECORDING;
     s_ctx.stop_requested = false;
-    s_ctx.audio_size = 0;
-
-    xSemaphoreGive(s_ctx.mutex);
+    s_ctx.audio_bytes = 0;
+    s_ctx.preroll_bytes = 0;
+#ifdef CONFIG_STT_VAD_TRIM
+    s_ctx.trim_start = TRIM_UNKNOWN;
+#else
+    s_ctx.trim_start = 0;
+#endif
+    s_ctx.trim_end = 0;
+    s_ctx.mode = mode;
+    s_ctx.recording_done = false;
+    s_ctx.upload_abort = false;
+    s_ctx.use_opus = s_ctx.ogg.segments && audio_encoder_opus_enabled();
+    release_recording();  // Left over from a failed recording
+
+    unlock_and_publish();
+
+    // Pipelined mode: start the upload first so it is ready for the first chunk
+    if (mode == STT_MODE_PIPELINED) {
+        BaseType_t upload_created = xTaskCreatePinnedToCore(
+            pipeline_upload_task,
+            "stt_upload",
+            TASK_STT_UPLOAD_STACK,
+            NULL,
+            TASK_STT_UPLOAD_PRIORITY,
+            &s_ctx.upload_task,
+            TASK_STT_UPLOAD_CORE
+        );
+        if (upload_created != pdPASS) {
+            ESP_LOGW(TAG, "Failed to create upload task, using batch mode");
+            s_ctx.mode = STT_MODE_BATCH;
+        }
+    }
 
     // Create recording task
-    BaseType_t task_created = xTaskCreate(
+    BaseType_t task_created = xTaskCreatePinnedToCore(
         recording_task,
         "stt_record",
-        4096,
+        TASK_STT_RECORD_STACK,
         NULL,
-        5,
-        &s_ctx.recording_task
+        TASK_STT_RECORD_PRIORITY,
+        &s_ctx.recording_task,
+        TASK_STT_RECORD_CORE
     );
 
     if (task_created != pdPASS) {
@@ -606,11 +1174,13 @@ esp_err_t stt_start_recording(void)
         xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
         s_ctx.state = STT_STATE_ERROR;
         s_ctx.error_message = strdup("Failed to start recording task");
-        xSemaphoreGive(s_ctx.mutex);
+        unlock_and_publish();
+        pipeline_abort();
         return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "Recording started");
+    ESP_LOGI(TAG, "Recording started (%s, %s)", s_ctx.mode == STT_MODE_PIPELINED ? "pipelined" : "batch",
+             s_ctx.use_opus ? "opus" : "wav");
     return ESP_OK;
 }
 
@@ -633,7 +1203,7 @@ esp_err_t stt_stop_recording(void)
     }
 
     s_ctx.stop_requested = true;
-    xSemaphoreGive(s_ctx.mutex);
+    unlock_and_publish();
 
     ESP_LOGI(TAG, "Stop requested");
     return ESP_OK;
@@ -650,6 +1220,7 @@ esp_err_t stt_get_status(stt_status_t *status)
 
     if (!s_initialized) {
         status->state = STT_STATE_IDLE;
+        status->mode = STT_MODE_BATCH;
         status->transcription = NULL;
         status->error_message = NULL;
         status->recording_ms = 0;
@@ -660,13 +1231,14 @@ esp_err_t stt_get_status(stt_status_t *status)
     xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
 
     status->state = s_ctx.state;
+    status->mode = s_ctx.mode;
     status->transcription = s_ctx.transcription;
     status->error_message = s_ctx.error_message;
-    status->audio_bytes = s_ctx.audio_size;
-
     if (s_ctx.state == STT_STATE_RECORDING) {
+        status->audio_bytes = capture_store_size(&s_ctx.audio);
         status->recording_ms = (xTaskGetTickCount() * portTICK_PERIOD_MS) - s_ctx.recording_start_ms;
     } else {
+        status->audio_bytes = s_ctx.audio_bytes;
         status->recording_ms = s_ctx.recording_duration_ms;
     }
 
@@ -691,6 +1263,21 @@ stt_state_t stt_get_state(void)
     return state;
 }
 
+/**
+ * Get the name of a state
+ */
+const char *stt_state_name(stt_state_t state)
+{
+    switch (state) {
+        case STT_STATE_IDLE: return "idle";
+        case STT_STATE_RECORDING: return "recording";
+        case STT_STATE_TRANSCRIBING: return "transcribing";
+        case STT_STATE_DONE: return "done";
+        case STT_STATE_ERROR: return "error";
+        default: return "unknown";
+    }
+}
+
 /**
  * Reset to idle state
  */
@@ -718,10 +1305,10 @@ esp_err_t stt_reset(void)
     }
 
     s_ctx.state = STT_STATE_IDLE;
-    s_ctx.audio_size = 0;
+    s_ctx.audio_bytes = 0;
     s_ctx.recording_duration_ms = 0;
 
-    xSemaphoreGive(s_ctx.mutex);
+    unlock_and_publish();
 
     ESP_LOGI(TAG, "Reset to idle");
     return ESP_OK;
@@ -738,7 +1325,7 @@ bool stt_is_busy(void)
 
     xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
     bool busy = (s_ctx.state == STT_STATE_RECORDING || s_ctx.state == STT_STATE_TRANSCRIBING);
-    xSemaphoreGive(s_ctx.mutex);
+    unlock_and_publish();
 
     return busy;
 }
@@ -757,7 +1344,11 @@ void stt_cleanup(void)
 
     // Wait for tasks to finish
     int wait_count = 0;
-    while ((s_ctx.recording_task || s_ctx.transcribe_task) && wait_count < 100) {
+    s_ctx.upload_abort = true;
+    if (s_ctx.upload_task) {
+        xTaskNotifyGive(s_ctx.upload_task);
+    }
+    while ((s_ctx.recording_task || s_ctx.transcribe_task || s_ctx.upload_task) && wait_count < 100) {
         vTaskDelay(pdMS_TO_TICKS(100));
         wait_count++;
     }
@@ -771,12 +1362,32 @@ void stt_cleanup(void)
         vTaskDelete(s_ctx.transcribe_task);
         s_ctx.transcribe_task = NULL;
     }
+    if (s_ctx.upload_task) {
+        vTaskDelete(s_ctx.upload_task);
+        s_ctx.upload_task = NULL;
+    }
 
-    // Free resources
-    if (s_ctx.audio_buffer) {
-        heap_caps_free(s_ctx.audio_buffer);
-        s_ctx.audio_buffer = NULL;
+    // Stop the pre-roll; it exits within one read
+    s_preroll.stop = true;
+    wait_count = 0;
+    while (s_preroll.task && wait_count < 10) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        wait_count++;
+    }
+    if (s_preroll.task) {
+        vTaskDelete(s_preroll.task);
+        s_preroll.task = NULL;
+    }
+    if (s_preroll.lock) {
+        vSemaphoreDelete(s_preroll.lock);
+        s_preroll.lock = NULL;
     }
+    heap_caps_free(s_preroll.ring);
+    s_preroll.ring = NULL;
+
+    // Free resources
+    capture_store_deinit(&s_ctx.audio);
+    capture_store_deinit(&s_ctx.ogg);
     if (s_ctx.transcription) {
         free(s_ctx.transcription);
         s_ctx.transcription = NULL;
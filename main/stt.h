@@ -25,11 +25,20 @@ typedef enum {
     STT_STATE_ERROR,          // Error occurred
 } stt_state_t;
 
+/**
+ * @brief STT upload mode
+ */
+typedef enum {
+    STT_MODE_BATCH = 0,       // Upload the whole recording after stop
+    STT_MODE_PIPELINED,       // Upload while recording (chunked transfer)
+} stt_mode_t;
+
 /**
  * @brief STT status structure (for API responses)
  */
 typedef struct {
     stt_state_t state;
+    stt_mode_t mode;            // Mode of the current/last recording
     const char *transcription;  // NULL if not available
     const char *error_message;  // NULL if no error
     uint32_t recording_ms;      // Duration of recording in ms
@@ -39,7 +48,8 @@ typedef struct {
 /**
  * @brief Initialize STT module
  *
- * Allocates audio buffer in PSRAM and initializes state.
+ * Sets up the recording store (PSRAM segments are allocated while
+ * recording) and starts the pre-roll if CONFIG_STT_PREROLL_MS is set.
  *
  * @return ESP_OK on success, error code on failure
  */
@@ -48,14 +58,28 @@ esp_err_t stt_init(void);
 /**
  * @brief Start recording audio from microphone
  *
- * Begins capturing audio into the internal buffer.
- * Recording continues until stt_stop_recording() is called
- * or max duration (5 minutes) is reached.
+ * Begins capturing audio into the internal store, led by the
+ * pre-roll history if enabled. Recording continues until
+ * stt_stop_recording() is called, speech is followed by
+ * CONFIG_STT_VAD_AUTOSTOP_MS of silence, max duration (5 minutes)
+ * is reached, or PSRAM runs out.
  *
  * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already recording
  */
 esp_err_t stt_start_recording(void);
 
+/**
+ * @brief Start recording audio in the given upload mode
+ *
+ * In pipelined mode the upload to Whisper runs while recording, so after
+ * stt_stop_recording() only the last few hundred milliseconds remain to
+ * be sent. Falls back to a batch upload if the streaming request fails.
+ *
+ * @param mode STT_MODE_BATCH or STT_MODE_PIPELINED
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already recording
+ */
+esp_err_t stt_start_recording_mode(stt_mode_t mode);
+
 /**
  * @brief Stop recording and start transcription
  *
@@ -82,6 +106,14 @@ esp_err_t stt_get_status(stt_status_t *status);
  */
 stt_state_t stt_get_state(void);
 
+/**
+ * @brief Get the name of a state ("idle", "recording", "transcribing", "done", "error")
+ *
+ * @param state State
+ * @return Name as used by the status API
+ */
+const char *stt_state_name(stt_state_t state);
+
 /**
  * @brief Reset STT to idle state
  *
@@ -102,7 +134,7 @@ bool stt_is_busy(void);
 /**
  * @brief Cleanup STT resources
  *
- * Frees audio buffer and stops any ongoing operations.
+ * Stops any ongoing operations and the pre-roll, and frees the store.
  */
 void stt_cleanup(void);
 
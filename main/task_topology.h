@@ -0,0 +1,115 @@
+/**
+ * Task Topology
+ *
+ * Core, priority and stack of every task the application creates, in one
+ * place. Real-time audio runs on the audio core, anything that waits on
+ * sockets or spends its time in TLS on the network core, so a slow
+ * handshake or a burst of WebSocket traffic cannot delay a codec period.
+ *
+ * Audio core (CONFIG_TASK_AUDIO_CORE):
+ *   audio_engine      8   codec DMA, set in the BSP menu (BSP_AUDIO_ENGINE_CORE)
+ *   conv_monitor      7   barge-in detection, must preempt playback
+ *   tts_playback      6   ring -> engine; paced by blocking engine writes
+ *   stt_record        6   engine -> recording store
+ *   audio_enc         5   Opus, set in the encoder menu (AUDIO_ENCODER_CORE)
+ *   live_capture      5   mic frames -> live STT send queue
+ *   stt_preroll       4   below the recording, which takes its stream over
+ *   boot_audio        5   SD card, codec and player at startup, then exits
+ *   wake_word         3   core set in the Wake Word menu
+ *
+ * Network core (CONFIG_TASK_NET_CORE):
+ *   tcpip (lwIP)     18   IDF default, pinned in sdkconfig.defaults
+ *   httpd             5   HTTP server
+ *   httpd_async*      5   slow HTTP handlers (bench, metrics, audio streams)
+ *   live_stt_stream   5   Deepgram WebSocket
+ *   openai_live_stream 5  OpenAI Realtime WebSocket (large base64 frames)
+ *   stt_transcribe    5   Whisper batch upload
+ *   stt_upload        5   Whisper pipelined upload
+ *   tts_worker        5   TTS job queue; the HTTPS stream runs on this task
+ *   tts_prefetch      5   next segment on the second pooled connection
+ *   conversation      4   LLM streaming request
+ *   http_pool         3   keep-alive maintenance
+ *
+ * With pinning disabled every task keeps its priority but may run on
+ * either core.
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#if CONFIG_TASK_PINNING
+#define TASK_CORE_AUDIO CONFIG_TASK_AUDIO_CORE
+#define TASK_CORE_NET CONFIG_TASK_NET_CORE
+#else
+#define TASK_CORE_AUDIO tskNO_AFFINITY
+#define TASK_CORE_NET tskNO_AFFINITY
+#endif
+
+// Audio core
+
+#define TASK_CONV_MONITOR_CORE TASK_CORE_AUDIO
+#define TASK_CONV_MONITOR_PRIORITY 7
+#define TASK_CONV_MONITOR_STACK 3072
+
+#define TASK_TTS_PLAYBACK_CORE TASK_CORE_AUDIO
+#define TASK_TTS_PLAYBACK_PRIORITY 6
+#define TASK_TTS_PLAYBACK_STACK 4096
+
+#define TASK_STT_RECORD_CORE TASK_CORE_AUDIO
+#define TASK_STT_RECORD_PRIORITY 6
+#define TASK_STT_RECORD_STACK 4096
+
+#define TASK_LIVE_CAPTURE_CORE TASK_CORE_AUDIO
+#define TASK_LIVE_CAPTURE_PRIORITY 5
+#define TASK_LIVE_CAPTURE_STACK 3072
+
+#define TASK_STT_PREROLL_CORE TASK_CORE_AUDIO
+#define TASK_STT_PREROLL_PRIORITY 4
+#define TASK_STT_PREROLL_STACK 3072
+
+#define TASK_BOOT_AUDIO_CORE TASK_CORE_AUDIO
+#define TASK_BOOT_AUDIO_PRIORITY 5
+#define TASK_BOOT_AUDIO_STACK 6144     // FAT mount and the optional DSP benchmark
+
+#define TASK_WAKE_WORD_PRIORITY 3
+#define TASK_WAKE_WORD_STACK 6144
+
+// Network core
+
+#define TASK_HTTPD_CORE TASK_CORE_NET
+#define TASK_HTTPD_PRIORITY 5
+#define TASK_HTTPD_STACK 6144          // cJSON status replies and the metrics exporter
+
+#define TASK_HTTP_WORKER_CORE TASK_CORE_NET
+#define TASK_HTTP_WORKER_PRIORITY 5
+#define TASK_HTTP_WORKER_STACK 6144    // Same handlers as the server task
+
+#define TASK_LIVE_STT_CORE TASK_CORE_NET
+#define TASK_LIVE_STT_PRIORITY 5
+#define TASK_LIVE_STT_STACK 8192
+
+#define TASK_OPENAI_LIVE_CORE TASK_CORE_NET
+#define TASK_OPENAI_LIVE_PRIORITY 5
+#define TASK_OPENAI_LIVE_STACK 16384
+
+#define TASK_STT_UPLOAD_CORE TASK_CORE_NET
+#define TASK_STT_UPLOAD_PRIORITY 5
+#define TASK_STT_UPLOAD_STACK 16384    // HTTPS; used by stt_transcribe and stt_upload
+
+#define TASK_TTS_WORKER_CORE TASK_CORE_NET
+#define TASK_TTS_WORKER_PRIORITY 5
+#define TASK_TTS_WORKER_STACK 16384    // HTTPS requests run on this task
+
+#define TASK_TTS_PREFETCH_CORE TASK_CORE_NET
+#define TASK_TTS_PREFETCH_PRIORITY 5
+#define TASK_TTS_PREFETCH_STACK 12288  // HTTPS request on the second connection
+
+#define TASK_CONVERSATION_CORE TASK_CORE_NET
+#define TASK_CONVERSATION_PRIORITY 4
+#define TASK_CONVERSATION_STACK 12288  // HTTPS request runs on this task
+
+#define TASK_HTTP_POOL_CORE TASK_CORE_NET
+#define TASK_HTTP_POOL_PRIORITY 3
+#define TASK_HTTP_POOL_STACK 8192
@@ -0,0 +1,207 @@
+/**
+ * Transcript Push
+ *
+ * Producers hand a serialized message to the server task with
+ * httpd_queue_work(); the work function fans it out to every WebSocket
+ * client, so sockets are only touched from the server task.
+ */
+
+#include "transcript_push.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "cJSON.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "transcript_push";
+
+#define PUSH_MAX_PENDING 16             // Queued messages before new ones are dropped
+#define PUSH_MAX_CLIENTS CONFIG_LWIP_MAX_SOCKETS  // httpd_get_client_list() needs >= max_open_sockets
+#define PUSH_MAX_RX_FRAME 128           // Clients only send pings and short commands
+
+static httpd_handle_t s_server = NULL;
+static uint32_t s_pending = 0;          // Messages queued on the server task
+static uint32_t s_dropped = 0;
+
+static const char *const s_source_names[TRANSCRIPT_SOURCE_MAX] = {
+    [TRANSCRIPT_SOURCE_STT] = "stt",
+    [TRANSCRIPT_SOURCE_LIVE] = "live",
+    [TRANSCRIPT_SOURCE_OPENAI_LIVE] = "openai-live",
+};
+
+/**
+ * Send one message to all WebSocket clients (server task)
+ */
+static void push_work(void *arg)
+{
+    char *json = arg;
+    httpd_handle_t server = s_server;
+
+    if (server) {
+        size_t count = PUSH_MAX_CLIENTS;
+        int fds[PUSH_MAX_CLIENTS];
+        if (httpd_get_client_list(server, &count, fds) == ESP_OK) {
+            httpd_ws_frame_t frame = {
+                .final = true,
+                .type = HTTPD_WS_TYPE_TEXT,
+                .payload = (uint8_t *)json,
+                .len = strlen(json),
+            };
+            for (size_t i = 0; i < count; i++) {
+                if (httpd_ws_get_fd_info(server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+                    httpd_ws_send_frame_async(server, fds[i], &frame);
+                }
+            }
+        }
+    }
+
+    free(json);
+    __atomic_fetch_sub(&s_pending, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Serialize and queue a message; consumes root
+ */
+static void push_message(cJSON *root)
+{
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json) {
+        return;
+    }
+
+    // A client that misses a delta notices the offset gap and resyncs
+    httpd_handle_t server = s_server;
+    if (!server || __atomic_add_fetch(&s_pending, 1, __ATOMIC_RELAXED) > PUSH_MAX_PENDING) {
+        if (server) {
+            __atomic_fetch_sub(&s_pending, 1, __ATOMIC_RELAXED);
+            if (s_dropped++ % 32 == 0) {
+                ESP_LOGW(TAG, "Push queue full, dropped %lu messages", (unsigned long)s_dropped);
+            }
+        }
+        free(json);
+        return;
+    }
+
+    if (httpd_queue_work(server, push_work, json) != ESP_OK) {
+        __atomic_fetch_sub(&s_pending, 1, __ATOMIC_RELAXED);
+        free(json);
+    }
+}
+
+static cJSON *new_message(transcript_source_t source, const char *type)
+{
+    if (!s_server || source >= TRANSCRIPT_SOURCE_MAX) {
+        return NULL;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (root) {
+        cJSON_AddStringToObject(root, "source", s_source_names[source]);
+        cJSON_AddStringToObject(root, "type", type);
+    }
+    return root;
+}
+
+void transcript_push_delta(transcript_source_t source, size_t offset, const char *text, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    cJSON *root = new_message(source, "delta");
+    if (!root) {
+        return;
+    }
+
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        cJSON_Delete(root);
+        return;
+    }
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+
+    cJSON_AddNumberToObject(root, "offset", offset);
+    cJSON_AddStringToObject(root, "text", copy);
+    free(copy);
+    push_message(root);
+}
+
+void transcript_push_state(transcript_source_t source, const char *state, const char *error,
+                           const char *text)
+{
+    cJSON *root = new_message(source, "state");
+    if (!root) {
+        return;
+    }
+
+    cJSON_AddStringToObject(root, "state", state);
+    if (error) {
+        cJSON_AddStringToObject(root, "error", error);
+    }
+    if (text) {
+        cJSON_AddStringToObject(root, "text", text);
+    }
+    push_message(root);
+}
+
+void transcript_push_clear(transcript_source_t source)
+{
+    cJSON *root = new_message(source, "clear");
+    if (root) {
+        push_message(root);
+    }
+}
+
+/**
+ * WebSocket handler - accepts the handshake and discards client frames
+ */
+static esp_err_t transcripts_ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        ESP_LOGI(TAG, "Transcript client connected (fd %d)", httpd_req_to_sockfd(req));
+        return ESP_OK;
+    }
+
+    httpd_ws_frame_t frame = {0};
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (frame.len == 0) {
+        return ESP_OK;
+    }
+    if (frame.len > PUSH_MAX_RX_FRAME) {
+        return ESP_ERR_INVALID_SIZE;  // Closes the connection
+    }
+
+    uint8_t buf[PUSH_MAX_RX_FRAME];
+    frame.payload = buf;
+    return httpd_ws_recv_frame(req, &frame, sizeof(buf));
+}
+
+static const httpd_uri_t uri_transcripts_ws = {
+    .uri          = "/ws/transcripts",
+    .method       = HTTP_GET,
+    .handler      = transcripts_ws_handler,
+    .user_ctx     = NULL,
+    .is_websocket = true,
+};
+
+esp_err_t transcript_push_register(httpd_handle_t server)
+{
+    esp_err_t err = httpd_register_uri_handler(server, &uri_transcripts_ws);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register transcript WebSocket: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_server = server;
+    return ESP_OK;
+}
+
+void transcript_push_unregister(void)
+{
+    s_server = NULL;
+}
@@ -0,0 +1,87 @@
+/**
+ * Transcript Push
+ *
+ * WebSocket endpoint (/ws/transcripts) that pushes transcript deltas and
+ * state transitions of the STT modules to the web pages, replacing status
+ * polling. Messages are JSON text frames:
+ *
+ *   {"source":"live","type":"delta","offset":120,"text":" next words"}
+ *   {"source":"live","type":"state","state":"error","error":"Connection lost"}
+ *   {"source":"stt","type":"state","state":"done","text":"full transcription"}
+ *   {"source":"live","type":"clear"}
+ *
+ * A delta's offset is the byte length of the transcript before it; a client
+ * whose own length differs has missed a message and re-reads the status API.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Transcript producers
+ */
+typedef enum {
+    TRANSCRIPT_SOURCE_STT = 0,          // Batch/pipelined Whisper (/stt)
+    TRANSCRIPT_SOURCE_LIVE,             // Deepgram live (/live)
+    TRANSCRIPT_SOURCE_OPENAI_LIVE,      // OpenAI Realtime (/openai-live)
+    TRANSCRIPT_SOURCE_MAX,
+} transcript_source_t;
+
+/**
+ * @brief URI handlers transcript_push_register() adds
+ */
+#define TRANSCRIPT_PUSH_URI_HANDLERS 1
+
+/**
+ * @brief Register the /ws/transcripts endpoint on a running server
+ *
+ * @param server HTTP server handle
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t transcript_push_register(httpd_handle_t server);
+
+/**
+ * @brief Stop pushing (server is being stopped)
+ */
+void transcript_push_unregister(void);
+
+/**
+ * @brief Push text appended to a transcript
+ *
+ * The text is copied; safe to call with the producer's lock held.
+ *
+ * @param source Producer
+ * @param offset Transcript length in bytes before the append
+ * @param text Appended bytes
+ * @param len Number of bytes
+ */
+void transcript_push_delta(transcript_source_t source, size_t offset, const char *text, size_t len);
+
+/**
+ * @brief Push a state transition
+ *
+ * @param source Producer
+ * @param state State name as used by the status API
+ * @param error Error message (may be NULL)
+ * @param text Final text for producers without deltas (may be NULL)
+ */
+void transcript_push_state(transcript_source_t source, const char *state, const char *error,
+                           const char *text);
+
+/**
+ * @brief Push that a transcript was cleared
+ *
+ * @param source Producer
+ */
+void transcript_push_clear(transcript_source_t source);
+
+#ifdef __cplusplus
+}
+#endif
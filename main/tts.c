@@ -1,20 +1,36 @@
 /**
  * Text-to-Speech Module
  *
- * Streams PCM audio from ElevenLabs or OpenAI API directly to I2S output.
- * Uses a ring buffer to smooth network jitter.
+ * Streams PCM audio from ElevenLabs or OpenAI API to an audio engine playback stream.
+ * Uses a lock-free SPSC ring buffer to smooth network jitter.
+ *
+ * Long texts are split at sentence boundaries and synthesized as a pipeline:
+ * even segments stream straight into the ring while a prefetch task fetches
+ * the following segment on a second pooled connection into a staging ring,
+ * which is appended once the current segment is complete.
+ *
+ * Callers can also push their own PCM through the same ring, pre-roll and
+ * flow control (tts_pcm_begin/write/end), e.g. for /api/audio/play.
  */
 
 #include "tts.h"
+#include <ctype.h>
 #include <string.h>
 #include <stdio.h>
 #include "esp_log.h"
 #include "esp_http_client.h"
-#include "esp_crt_bundle.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "cJSON.h"
+#include "http_pool.h"
+#include "tts_segment.h"
+#include "tts_cache.h"
+#include "spsc_ring.h"
+#include "audio_dsp.h"
 #include "bsp_board_extra.h"
-#include "driver/i2s_std.h"
+#include "audio_engine.h"
+#include "metrics.h"
+#include "task_topology.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -33,262 +49,178 @@ static const char *TAG = "tts";
 #define OPENAI_SAMPLE_RATE 24000
 
 // Ring buffer configuration
-#define RING_BUFFER_SIZE (1024 * 1024)  // 1MB
+#define RING_BUFFER_SIZE (1024 * 1024)  // 1MB, must be a power of two
 #define PLAYBACK_CHUNK_SIZE 2048        // Mono bytes to read at once
-#define MIN_BUFFER_BEFORE_PLAY (32 * 1024)  // Start playing after 32KB buffered
+#define PLAYBACK_GAIN_Q8 (2 * AUDIO_DSP_GAIN_UNITY)  // 2x digital gain
+#define PLAYBACK_STREAM_MS 100          // Engine-side queue; the ring above holds the jitter buffer
+#define PLAYBACK_WRITE_TIMEOUT_MS 1000
+#define PLAYBACK_DRAIN_TIMEOUT_MS 1000
+#define RING_HIGH_WATERMARK (CONFIG_TTS_RING_HIGH_WATERMARK_KB * 1024)  // Producer pauses above this
+#define RING_LOW_WATERMARK (CONFIG_TTS_RING_LOW_WATERMARK_KB * 1024)    // ...and resumes below this
+#define RING_WAIT_SLICE_MS 100              // Upper bound on a single ring wait
+#define FLOW_CONTROL_TIMEOUT_MS 5000        // Give up if playback stops draining
+#define STOP_TIMEOUT_MS 5000                // tts_stop() waits at most this long
+
+// Adaptive pre-roll
+#define PREROLL_MIN_MS CONFIG_TTS_PREROLL_MIN_MS            // Jitter floor, always buffered
+#define PREROLL_MAX_BYTES (CONFIG_TTS_PREROLL_MAX_KB * 1024) // Start regardless once this much is buffered
+#define PREROLL_MEASURE_BYTES 4096          // Data needed before throughput is trusted
+#define PREROLL_EVAL_MS 20                  // Re-estimate interval while pre-rolling
+#define SPEECH_CHARS_PER_SEC 12             // Conservative speaking rate at 1.0x, for length estimate
+
+// Segmented synthesis
+#define SEGMENT_THRESHOLD_CHARS CONFIG_TTS_SEGMENT_THRESHOLD_CHARS  // Longer texts are segmented (0 = never)
+#define SEGMENT_FIRST_MAX_CHARS CONFIG_TTS_FIRST_SEGMENT_MAX_CHARS
+#define SEGMENT_MAX_CHARS CONFIG_TTS_SEGMENT_MAX_CHARS
+#define PREFETCH_RING_SIZE (256 * 1024)     // Staged PCM of the prefetched segment, power of two
+#define STITCH_CHUNK_SIZE 4096              // Bytes moved from staging to the playback ring at once
+
+#if RING_LOW_WATERMARK >= RING_HIGH_WATERMARK || RING_HIGH_WATERMARK > RING_BUFFER_SIZE - 8192
+#error "TTS ring watermarks must satisfy low < high <= ring size - 8KB"
+#endif
 
 // Test message
 #define TTS_TEST_MESSAGE "Hello! The WiFi connection is now active and text to speech is working."
 
-// Ring buffer structure
-typedef struct {
-    uint8_t *buffer;
-    size_t size;
-    size_t head;  // Write position
-    size_t tail;  // Read position
-    SemaphoreHandle_t mutex;
-    volatile bool overflow;
-} ring_buffer_t;
+// Utterance sources, index of the per-source metrics
+typedef enum {
+    SOURCE_NETWORK = 0,
+    SOURCE_CACHE,
+    SOURCE_PUSH,
+    SOURCE_COUNT,
+} speak_source_t;
 
 // Module state
 static bool s_initialized = false;
 static volatile bool s_streaming = false;
 static volatile bool s_playing = false;
 static volatile bool s_stop_requested = false;
-static ring_buffer_t s_ring_buffer = {0};
+static portMUX_TYPE s_claim_lock = portMUX_INITIALIZER_UNLOCKED;  // Makes the idle check and s_streaming one step
+static spsc_ring_handle_t s_ring = NULL;
 static TaskHandle_t s_playback_task = NULL;
 static SemaphoreHandle_t s_playback_done_sem = NULL;
+static SemaphoreHandle_t s_idle_sem = NULL;    // Given each time the player goes idle, for tts_stop()
 static tts_provider_t s_current_provider = TTS_PROVIDER_ELEVENLABS;
-static uint32_t s_current_sample_rate = ELEVENLABS_SAMPLE_RATE;
-
-// Forward declarations
-static esp_err_t ring_buffer_init(ring_buffer_t *rb, size_t size);
-static void ring_buffer_free(ring_buffer_t *rb);
-static size_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *data, size_t len);
-static size_t ring_buffer_read(ring_buffer_t *rb, uint8_t *data, size_t len);
-static size_t ring_buffer_available(ring_buffer_t *rb);
-static void ring_buffer_reset(ring_buffer_t *rb);
-static void playback_task(void *arg);
-static esp_err_t http_event_handler(esp_http_client_event_t *evt);
+static uint32_t s_current_sample_rate = ELEVENLABS_SAMPLE_RATE;  // Provider PCM rate; the engine resamples to the codec rate
+static uint32_t s_play_rate = ELEVENLABS_SAMPLE_RATE;            // Rate of the current utterance
+static volatile int s_total_bytes = 0;        // Bytes received for the current request
+static volatile int64_t s_first_byte_us = 0;  // Arrival time of the first audio byte
+static volatile int s_expected_bytes = 0;     // Estimated (or Content-Length) response size
+static volatile int64_t s_audio_start_us = 0; // First sample of the last utterance handed to the engine
+static int64_t s_speak_start_us = 0;          // tts_speak_with_speed() or tts_pcm_begin() entry, for the latency metrics
+static speak_source_t s_speak_source = SOURCE_NETWORK;
+static bool s_segmented = false;              // Current text is synthesized in segments
+static tts_cache_writer_t *s_cache_writer = NULL;  // Records the current response for the cache
 
 /**
- * Initialize ring buffer in PSRAM
+ * Wake a tts_stop() waiting for the player, once nothing is streaming or playing
  */
-static esp_err_t ring_buffer_init(ring_buffer_t *rb, size_t size)
+static void signal_idle(void)
 {
-    rb->buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
-    if (!rb->buffer) {
-        ESP_LOGE(TAG, "Failed to allocate ring buffer (%d bytes)", size);
-        return ESP_ERR_NO_MEM;
-    }
-
-    rb->size = size;
-    rb->head = 0;
-    rb->tail = 0;
-    rb->overflow = false;
-
-    rb->mutex = xSemaphoreCreateMutex();
-    if (!rb->mutex) {
-        heap_caps_free(rb->buffer);
-        rb->buffer = NULL;
-        return ESP_ERR_NO_MEM;
+    if (!s_streaming && !s_playing && s_idle_sem) {
+        xSemaphoreGive(s_idle_sem);
     }
-
-    return ESP_OK;
 }
 
 /**
- * Free ring buffer resources
+ * Prefetch lane: fetches one segment ahead into its own staging ring
  */
-static void ring_buffer_free(ring_buffer_t *rb)
-{
-    if (rb->mutex) {
-        vSemaphoreDelete(rb->mutex);
-        rb->mutex = NULL;
-    }
-    if (rb->buffer) {
-        heap_caps_free(rb->buffer);
-        rb->buffer = NULL;
-    }
-    rb->size = 0;
-    rb->head = 0;
-    rb->tail = 0;
-}
+static struct {
+    spsc_ring_handle_t ring;           // Producer: prefetch task, consumer: speaking task
+    SemaphoreHandle_t start_sem;       // A segment was assigned (text == NULL to exit)
+    SemaphoreHandle_t done_sem;        // The assigned segment finished, or the task exited
+    const char *text;
+    float speed;
+    volatile bool done;
+    volatile size_t bytes;             // PCM staged for the current segment
+    volatile esp_err_t result;
+} s_lane = {0};
 
-/**
- * Reset ring buffer (clear all data)
- */
-static void ring_buffer_reset(ring_buffer_t *rb)
-{
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-    rb->head = 0;
-    rb->tail = 0;
-    rb->overflow = false;
-    xSemaphoreGive(rb->mutex);
-}
+// Forward declarations
+static metrics_metric_t s_m_first_byte = METRICS_HISTOGRAM_MS_INIT(
+    "tts_first_byte_ms", "Speak request to first PCM byte from the provider", NULL, NULL);
+static metrics_metric_t s_m_first_audio[SOURCE_COUNT] = {
+    METRICS_HISTOGRAM_MS_INIT("tts_first_audio_ms", "Speak request to first sample handed to the audio engine",
+                              "source", "network"),
+    METRICS_HISTOGRAM_MS_INIT("tts_first_audio_ms", "Speak request to first sample handed to the audio engine",
+                              "source", "cache"),
+    METRICS_HISTOGRAM_MS_INIT("tts_first_audio_ms", "Speak request to first sample handed to the audio engine",
+                              "source", "push"),
+};
+static metrics_metric_t s_m_utterances[SOURCE_COUNT] = {
+    METRICS_COUNTER_INIT("tts_utterances_total", "Utterances started", "source", "network"),
+    METRICS_COUNTER_INIT("tts_utterances_total", "Utterances started", "source", "cache"),
+    METRICS_COUNTER_INIT("tts_utterances_total", "Utterances started", "source", "push"),
+};
+static metrics_metric_t s_m_underruns = METRICS_COUNTER_INIT(
+    "tts_ring_underruns_total", "Playback found the PCM ring empty mid-utterance", NULL, NULL);
+static metrics_metric_t s_m_dropped = METRICS_COUNTER_INIT(
+    "tts_dropped_samples_total", "Samples dropped because the engine playback stream stalled", NULL, NULL);
 
-/**
- * Get free space in ring buffer (call with mutex held)
- */
-static size_t ring_buffer_free_space_internal(ring_buffer_t *rb)
-{
-    if (rb->head >= rb->tail) {
-        return rb->size - rb->head + rb->tail - 1;
-    } else {
-        return rb->tail - rb->head - 1;
-    }
-}
+static void playback_task(void *arg);
+static esp_err_t http_event_handler(esp_http_client_event_t *evt);
+static esp_err_t fetch_segment(const char *text, float speed, bool staged);
 
 /**
- * Write data to ring buffer using bulk memcpy
- * Returns number of bytes written
+ * Compute how many bytes must be buffered before playback can start
+ *
+ * With playback rate P and measured network rate R < P, the buffer drains
+ * by (P - R) per second until the download finishes, so starting with
+ * B >= (P - R) * remaining / R never underruns. If R >= P only the jitter
+ * floor is needed.
  */
-static size_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *data, size_t len)
+static size_t preroll_target(void)
 {
-    if (!rb->buffer || !data || len == 0) {
-        return 0;
-    }
-
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-
-    size_t free_space = ring_buffer_free_space_internal(rb);
-    if (free_space == 0) {
-        rb->overflow = true;
-        xSemaphoreGive(rb->mutex);
-        return 0;
-    }
-
-    size_t to_write = (len < free_space) ? len : free_space;
-    size_t written = 0;
-
-    // Write in up to two chunks (handle wrap-around)
-    while (written < to_write) {
-        size_t chunk_size;
-        if (rb->head >= rb->tail) {
-            // Write from head to end of buffer
-            chunk_size = rb->size - rb->head;
-            if (rb->tail == 0) {
-                chunk_size--;  // Leave one byte gap
-            }
-        } else {
-            // Write from head to tail-1
-            chunk_size = rb->tail - rb->head - 1;
-        }
-
-        if (chunk_size == 0) break;
-        if (chunk_size > to_write - written) {
-            chunk_size = to_write - written;
-        }
+    const size_t play_rate = s_play_rate * 2;  // Mono 16-bit bytes/s
+    size_t floor_bytes = (play_rate * PREROLL_MIN_MS / 1000) & ~1;
+    size_t received = s_total_bytes;
 
-        memcpy(&rb->buffer[rb->head], &data[written], chunk_size);
-        rb->head = (rb->head + chunk_size) % rb->size;
-        written += chunk_size;
-    }
-
-    if (written < len) {
-        rb->overflow = true;
-    }
-
-    xSemaphoreGive(rb->mutex);
-    return written;
-}
-
-/**
- * Read data from ring buffer using bulk memcpy
- * Returns number of bytes read
- */
-static size_t ring_buffer_read(ring_buffer_t *rb, uint8_t *data, size_t len)
-{
-    if (!rb->buffer || !data || len == 0) {
-        return 0;
+    if (received < PREROLL_MEASURE_BYTES) {
+        return PREROLL_MAX_BYTES;
     }
 
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-
-    size_t available;
-    if (rb->head >= rb->tail) {
-        available = rb->head - rb->tail;
-    } else {
-        available = rb->size - rb->tail + rb->head;
+    int64_t elapsed_us = esp_timer_get_time() - s_first_byte_us;
+    if (elapsed_us <= 0) {
+        return PREROLL_MAX_BYTES;
     }
 
-    if (available == 0) {
-        xSemaphoreGive(rb->mutex);
-        return 0;
+    uint64_t net_rate = (uint64_t)received * 1000000 / elapsed_us;
+    if (net_rate >= play_rate) {
+        return floor_bytes;
     }
 
-    size_t to_read = (len < available) ? len : available;
-    size_t read_count = 0;
-
-    // Read in up to two chunks (handle wrap-around)
-    while (read_count < to_read) {
-        size_t chunk_size;
-        if (rb->head >= rb->tail) {
-            // Read from tail to head
-            chunk_size = rb->head - rb->tail;
-        } else {
-            // Read from tail to end of buffer
-            chunk_size = rb->size - rb->tail;
-        }
-
-        if (chunk_size == 0) break;
-        if (chunk_size > to_read - read_count) {
-            chunk_size = to_read - read_count;
-        }
+    size_t expected = s_expected_bytes;
+    size_t remaining = (expected > received) ? expected - received : 0;
+    uint64_t target = (uint64_t)(play_rate - net_rate) * remaining / net_rate;
 
-        memcpy(&data[read_count], &rb->buffer[rb->tail], chunk_size);
-        rb->tail = (rb->tail + chunk_size) % rb->size;
-        read_count += chunk_size;
+    if (target < floor_bytes) {
+        target = floor_bytes;
     }
-
-    xSemaphoreGive(rb->mutex);
-    return read_count;
-}
-
-/**
- * Get number of bytes available to read
- */
-static size_t ring_buffer_available(ring_buffer_t *rb)
-{
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-    size_t available;
-    if (rb->head >= rb->tail) {
-        available = rb->head - rb->tail;
-    } else {
-        available = rb->size - rb->tail + rb->head;
+    if (target > PREROLL_MAX_BYTES) {
+        target = PREROLL_MAX_BYTES;
     }
-    xSemaphoreGive(rb->mutex);
-    return available;
+    return (size_t)target;
 }
 
 /**
- * Playback task - reads mono PCM from ring buffer, converts to stereo, writes to I2S
+ * Playback task - reads mono PCM in place from ring buffer and queues it on the audio engine
  */
 static void playback_task(void *arg)
 {
-    // Allocate buffers: mono input and stereo output (2x size for stereo)
-    uint8_t *mono_chunk = heap_caps_malloc(PLAYBACK_CHUNK_SIZE, MALLOC_CAP_INTERNAL);
-    uint8_t *stereo_chunk = heap_caps_malloc(PLAYBACK_CHUNK_SIZE * 2, MALLOC_CAP_INTERNAL);
-
-    if (!mono_chunk || !stereo_chunk) {
-        ESP_LOGE(TAG, "Failed to allocate playback chunks");
-        if (mono_chunk) heap_caps_free(mono_chunk);
-        if (stereo_chunk) heap_caps_free(stereo_chunk);
+    // Stream at the utterance rate (16kHz ElevenLabs, 24kHz OpenAI, or pushed PCM); the engine resamples and mixes
+    audio_engine_stream_handle_t stream = NULL;
+    esp_err_t err = audio_engine_playback_open(s_play_rate, PLAYBACK_STREAM_MS,
+                                               PLAYBACK_GAIN_Q8, &stream);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open playback stream: %s", esp_err_to_name(err));
         s_playing = false;
+        signal_idle();
         xSemaphoreGive(s_playback_done_sem);
         vTaskDelete(NULL);
         return;
     }
 
-    ESP_LOGI(TAG, "Playback task started");
-
-    // Configure codec for current sample rate (16kHz for ElevenLabs, 24kHz for OpenAI)
-    esp_err_t err = bsp_extra_codec_set_fs(s_current_sample_rate, 16, I2S_SLOT_MODE_STEREO);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure codec: %s", esp_err_to_name(err));
-    } else {
-        ESP_LOGI(TAG, "Codec configured for %luHz stereo", (unsigned long)s_current_sample_rate);
-    }
+    ESP_LOGI(TAG, "Playback task started (%lu Hz)", (unsigned long)s_play_rate);
 
     // Unmute codec (audio player may have left codec muted)
     // Don't change volume - respect the user's volume setting from web interface
@@ -296,98 +228,180 @@ static void playback_task(void *arg)
     int current_volume = bsp_extra_codec_volume_get();
     ESP_LOGI(TAG, "Codec unmuted, volume is %d", current_volume);
 
-    // Wait for minimum buffer before starting playback
+    // Pre-roll: wait until the buffered audio covers the projected download shortfall
+    int64_t preroll_start = esp_timer_get_time();
     while (s_streaming && !s_stop_requested) {
-        size_t available = ring_buffer_available(&s_ring_buffer);
-        if (available >= MIN_BUFFER_BEFORE_PLAY) {
-            ESP_LOGI(TAG, "Buffer ready (%d bytes), starting playback", available);
+        size_t target = preroll_target();
+        if (spsc_ring_wait_data(s_ring, target, pdMS_TO_TICKS(PREROLL_EVAL_MS)) &&
+            spsc_ring_available(s_ring) >= preroll_target()) {
+            ESP_LOGI(TAG, "Buffer ready (%d bytes, target %d) after %lld ms, starting playback",
+                     spsc_ring_available(s_ring), target,
+                     (esp_timer_get_time() - preroll_start) / 1000);
             break;
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 
     s_playing = true;
 
     // Playback loop
-    int loop_count = 0;
+    int underruns = 0;
+    bool starved = false;
+    bool first_written = false;
     while (!s_stop_requested) {
-        size_t available = ring_buffer_available(&s_ring_buffer);
-
-        if (available > 0) {
-            // Read mono samples (must be even number of bytes for 16-bit samples)
-            size_t to_read = (available < PLAYBACK_CHUNK_SIZE) ? available : PLAYBACK_CHUNK_SIZE;
-            to_read = to_read & ~1;  // Ensure even number of bytes
-
-            size_t read_len = ring_buffer_read(&s_ring_buffer, mono_chunk, to_read);
-
-            if (read_len > 0) {
-                // Convert mono to stereo by duplicating each 16-bit sample
-                // Also apply digital gain (2x boost) to increase loudness
-                int16_t *mono_samples = (int16_t *)mono_chunk;
-                int16_t *stereo_samples = (int16_t *)stereo_chunk;
-                size_t num_samples = read_len / 2;  // Number of 16-bit samples
-
-                for (size_t i = 0; i < num_samples; i++) {
-                    // Apply 2x digital gain with clipping protection
-                    int32_t amplified = (int32_t)mono_samples[i] * 2;
-                    if (amplified > 32767) amplified = 32767;
-                    if (amplified < -32768) amplified = -32768;
-                    int16_t sample = (int16_t)amplified;
-
-                    stereo_samples[i * 2] = sample;      // Left channel
-                    stereo_samples[i * 2 + 1] = sample;  // Right channel
-                }
+        const uint8_t *mono_chunk;
+        size_t read_len = spsc_ring_peek_read(s_ring, &mono_chunk);
 
-                // Write stereo data to I2S (2x the mono size)
-                size_t stereo_len = read_len * 2;
-                size_t written = 0;
-                esp_err_t err = bsp_extra_i2s_write(stereo_chunk, stereo_len, &written, 1000);
-                if (err != ESP_OK) {
-                    ESP_LOGW(TAG, "I2S write error: %s", esp_err_to_name(err));
-                }
+        // Consume whole vector blocks so the read position stays SIMD-aligned;
+        // only the final tail of a stream is taken in smaller pieces
+        if (read_len >= AUDIO_DSP_ALIGN || s_streaming) {
+            read_len &= ~(size_t)(AUDIO_DSP_ALIGN - 1);
+        } else {
+            read_len &= ~1;  // Whole 16-bit samples only
+        }
+
+        if (read_len > 0) {
+            starved = false;
+            if (read_len > PLAYBACK_CHUNK_SIZE) {
+                read_len = PLAYBACK_CHUNK_SIZE;
             }
 
-            // Yield periodically to prevent watchdog and allow HTTP task to run
-            if (++loop_count >= 10) {
-                loop_count = 0;
-                vTaskDelay(1);  // Use delay instead of yield to let lower-priority tasks run
+            // Blocks while the engine queue is full, which paces this loop
+            size_t samples = read_len / 2;
+            size_t queued = audio_engine_playback_write(stream, (const int16_t *)mono_chunk, samples,
+                                                        PLAYBACK_WRITE_TIMEOUT_MS);
+            if (queued < samples) {
+                ESP_LOGW(TAG, "Playback stream stalled, dropped %d samples", samples - queued);
+                metrics_add(&s_m_dropped, samples - queued);
+            }
+            if (queued > 0 && !first_written) {
+                first_written = true;
+                s_audio_start_us = esp_timer_get_time();
+                metrics_observe_since(&s_m_first_audio[s_speak_source], s_speak_start_us);
             }
-        } else if (!s_streaming) {
+
+            // Samples are copied out, hand the space back to the producer
+            spsc_ring_commit_read(s_ring, read_len);
+        } else if (!s_streaming && spsc_ring_available(s_ring) < 2) {
             // No more data and streaming is done
             ESP_LOGI(TAG, "Playback complete");
             break;
         } else {
-            // Buffer underrun - wait for more data
-            vTaskDelay(pdMS_TO_TICKS(5));
+            // Buffer underrun - block until the producer commits more data
+            if (!starved) {
+                starved = true;
+                underruns++;
+                metrics_inc(&s_m_underruns);
+            }
+            spsc_ring_wait_data(s_ring, AUDIO_DSP_ALIGN, pdMS_TO_TICKS(RING_WAIT_SLICE_MS));
         }
     }
 
-    heap_caps_free(mono_chunk);
-    heap_caps_free(stereo_chunk);
+    if (!s_stop_requested) {
+        audio_engine_playback_drain(stream, PLAYBACK_DRAIN_TIMEOUT_MS);
+    }
+    audio_engine_stream_close(stream);
     s_playing = false;
+    signal_idle();
 
-    ESP_LOGI(TAG, "Playback task finished");
+    ESP_LOGI(TAG, "Playback task finished (%d underruns)", underruns);
     xSemaphoreGive(s_playback_done_sem);
     vTaskDelete(NULL);
 }
 
 /**
- * Get free space in ring buffer
+ * Append PCM to the playback ring with flow control
+ *
+ * Above the high watermark, blocks until playback drains the ring to the
+ * low watermark. All of the data is queued unless the stream is stopped
+ * or playback stalls.
+ */
+static esp_err_t ring_push(const uint8_t *data, size_t len)
+{
+    if (s_first_byte_us == 0) {
+        s_first_byte_us = esp_timer_get_time();
+        if (s_speak_source == SOURCE_NETWORK) {
+            metrics_observe_since(&s_m_first_byte, s_speak_start_us);
+        }
+    }
+
+    if (spsc_ring_available(s_ring) + len > RING_HIGH_WATERMARK) {
+        size_t level = spsc_ring_available(s_ring);
+        TickType_t last_progress = xTaskGetTickCount();
+
+        while (level > RING_LOW_WATERMARK && !s_stop_requested) {
+            spsc_ring_wait_space(s_ring, RING_BUFFER_SIZE - RING_LOW_WATERMARK,
+                                 pdMS_TO_TICKS(RING_WAIT_SLICE_MS));
+            size_t new_level = spsc_ring_available(s_ring);
+            if (new_level < level) {
+                last_progress = xTaskGetTickCount();
+            } else if (xTaskGetTickCount() - last_progress > pdMS_TO_TICKS(FLOW_CONTROL_TIMEOUT_MS)) {
+                ESP_LOGE(TAG, "Flow control timeout - playback stalled?");
+                return ESP_FAIL;
+            }
+            level = new_level;
+        }
+    }
+
+    // Near the top of the ring a write can come up short; the rest waits for playback
+    TickType_t last_progress = xTaskGetTickCount();
+    while (len > 0) {
+        if (s_stop_requested) {
+            return ESP_FAIL;
+        }
+        size_t written = spsc_ring_write(s_ring, data, len);
+        if (written > 0) {
+            s_total_bytes += written;
+            tts_cache_append(s_cache_writer, data, written);
+            data += written;
+            len -= written;
+            last_progress = xTaskGetTickCount();
+        } else if (xTaskGetTickCount() - last_progress > pdMS_TO_TICKS(FLOW_CONTROL_TIMEOUT_MS)) {
+            ESP_LOGE(TAG, "Flow control timeout - playback stalled?");
+            return ESP_FAIL;
+        }
+        if (len > 0) {
+            spsc_ring_wait_space(s_ring, len < RING_BUFFER_SIZE / 2 ? len : RING_BUFFER_SIZE / 2,
+                                 pdMS_TO_TICKS(RING_WAIT_SLICE_MS));
+        }
+    }
+
+    // Log progress periodically (latencies are in the metrics)
+    if (s_total_bytes % 131072 == 0) {
+        ESP_LOGD(TAG, "Streaming: %d KB received", s_total_bytes / 1024);
+    }
+    return ESP_OK;
+}
+
+/**
+ * Stage prefetched PCM, blocking while the staging ring is full
  */
-static size_t ring_buffer_free_space(ring_buffer_t *rb)
+static esp_err_t lane_write(const uint8_t *data, size_t len)
 {
-    xSemaphoreTake(rb->mutex, portMAX_DELAY);
-    size_t free_space = ring_buffer_free_space_internal(rb);
-    xSemaphoreGive(rb->mutex);
-    return free_space;
+    size_t half_ring = PREFETCH_RING_SIZE / 2;
+
+    while (len > 0) {
+        if (s_stop_requested) {
+            return ESP_FAIL;
+        }
+        size_t written = spsc_ring_write(s_lane.ring, data, len);
+        data += written;
+        len -= written;
+        s_lane.bytes += written;
+        if (len > 0) {
+            spsc_ring_wait_space(s_lane.ring, len < half_ring ? len : half_ring,
+                                 pdMS_TO_TICKS(RING_WAIT_SLICE_MS));
+        }
+    }
+    return ESP_OK;
 }
 
 /**
- * HTTP event handler - writes PCM data to ring buffer with flow control
+ * HTTP event handler - writes PCM data to the playback ring, or to the
+ * staging ring when the request belongs to the prefetch lane
  */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
-    static int total_bytes = 0;
+    bool staged = (evt->user_data == &s_lane);
 
     switch (evt->event_id) {
         case HTTP_EVENT_ERROR:
@@ -396,7 +410,6 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 
         case HTTP_EVENT_ON_CONNECTED:
             ESP_LOGI(TAG, "Connected to %s API", tts_get_provider_name(s_current_provider));
-            total_bytes = 0;
             break;
 
         case HTTP_EVENT_ON_DATA:
@@ -404,33 +417,21 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
                 return ESP_FAIL;  // Abort request
             }
 
-            // Flow control: wait if buffer is too full
-            int wait_count = 0;
-            while (ring_buffer_free_space(&s_ring_buffer) < evt->data_len && !s_stop_requested) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-                wait_count++;
-                if (wait_count > 500) {  // 5 second timeout
-                    ESP_LOGE(TAG, "Flow control timeout - playback stalled?");
-                    return ESP_FAIL;
-                }
+            if (staged) {
+                return lane_write(evt->data, evt->data_len);
             }
 
-            if (s_stop_requested) {
-                return ESP_FAIL;
-            }
-
-            // Write PCM data to ring buffer
-            size_t written = ring_buffer_write(&s_ring_buffer, evt->data, evt->data_len);
-            total_bytes += written;
-
-            // Log progress periodically
-            if (total_bytes % 131072 == 0) {
-                ESP_LOGI(TAG, "Streaming: %d KB received", total_bytes / 1024);
+            // A single request knows the real response size
+            if (s_first_byte_us == 0 && !s_segmented) {
+                int64_t content_length = esp_http_client_get_content_length(evt->client);
+                if (content_length > 0) {
+                    s_expected_bytes = content_length;
+                }
             }
-            break;
+            return ring_push(evt->data, evt->data_len);
 
         case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "Download complete: %d bytes total", total_bytes);
+            ESP_LOGI(TAG, "Download complete: %d bytes total", staged ? (int)s_lane.bytes : s_total_bytes);
             break;
 
         case HTTP_EVENT_DISCONNECTED:
@@ -444,6 +445,14 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
+/**
+ * Map a TTS provider to its connection pool host
+ */
+static http_pool_host_t provider_pool_host(tts_provider_t provider)
+{
+    return (provider == TTS_PROVIDER_OPENAI) ? HTTP_POOL_HOST_OPENAI : HTTP_POOL_HOST_ELEVENLABS;
+}
+
 /**
  * Build ElevenLabs API URL
  */
@@ -511,13 +520,251 @@ static char *build_openai_body(const char *text, float speed)
     return json_str;
 }
 
+/**
+ * Synthesize one text with a single request
+ *
+ * @param staged false to stream into the playback ring, true to stage the
+ *               PCM in the prefetch lane
+ */
+static esp_err_t fetch_segment(const char *text, float speed, bool staged)
+{
+    char url[256];
+    char *json_body = NULL;
+
+    // Build request based on provider
+    if (s_current_provider == TTS_PROVIDER_OPENAI) {
+        strncpy(url, OPENAI_API_URL, sizeof(url));
+        json_body = build_openai_body(text, speed);
+    } else {
+        build_elevenlabs_url(url, sizeof(url));
+        json_body = build_elevenlabs_body(text, speed);
+    }
+
+    if (!json_body) {
+        ESP_LOGE(TAG, "Failed to build request body");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Get a pooled connection (usually already connected)
+    http_pool_conn_t *conn = http_pool_acquire(provider_pool_host(s_current_provider),
+                                               pdMS_TO_TICKS(5000));
+    if (!conn) {
+        ESP_LOGE(TAG, "No HTTP connection available");
+        free(json_body);
+        return ESP_FAIL;
+    }
+
+    esp_http_client_handle_t client = http_pool_client(conn);
+    esp_http_client_set_url(client, url);
+    esp_http_client_set_method(client, HTTP_METHOD_POST);
+
+    // Authorization is set by the pool; only request-specific headers here
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    if (s_current_provider != TTS_PROVIDER_OPENAI) {
+        esp_http_client_set_header(client, "Accept", "audio/pcm");
+    }
+
+    // Set POST body
+    esp_http_client_set_post_field(client, json_body, strlen(json_body));
+
+    // Perform HTTP request (this streams data to the ring via the event handler)
+    esp_err_t ret = http_pool_perform(conn, http_event_handler, staged ? &s_lane : NULL);
+
+    int status = 0;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(ret));
+    } else {
+        status = esp_http_client_get_status_code(client);
+        if (status != 200) {
+            ESP_LOGE(TAG, "API error (HTTP %d)", status);
+            ret = ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "Request served on %s connection",
+                 http_pool_last_was_handshake(conn) ? "new" : "reused");
+    }
+
+    // Keep the socket only if the body was read to the end
+    http_pool_release(conn, ret == ESP_OK && !s_stop_requested);
+    free(json_body);
+
+    return ret;
+}
+
+/**
+ * Prefetch task - fetches each assigned segment into the staging ring
+ */
+static void prefetch_task(void *arg)
+{
+    while (true) {
+        xSemaphoreTake(s_lane.start_sem, portMAX_DELAY);
+        if (!s_lane.text) {
+            break;
+        }
+
+        s_lane.result = fetch_segment(s_lane.text, s_lane.speed, true);
+        s_lane.done = true;
+        spsc_ring_wake(s_lane.ring);
+        xSemaphoreGive(s_lane.done_sem);
+    }
+
+    xSemaphoreGive(s_lane.done_sem);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Hand a segment to the prefetch task (lane must be idle)
+ */
+static void lane_start(const char *text, float speed)
+{
+    spsc_ring_reset(s_lane.ring);
+    s_lane.text = text;
+    s_lane.speed = speed;
+    s_lane.bytes = 0;
+    s_lane.result = ESP_OK;
+    s_lane.done = false;
+    xSemaphoreGive(s_lane.start_sem);
+}
+
+/**
+ * Append the prefetched segment to the playback ring as it arrives
+ *
+ * @return Result of the prefetch request, or of the flow control
+ */
+static esp_err_t lane_stitch(void)
+{
+    while (!s_stop_requested) {
+        const uint8_t *data;
+        size_t len = spsc_ring_peek_read(s_lane.ring, &data);
+        if (len > 0) {
+            if (len > STITCH_CHUNK_SIZE) {
+                len = STITCH_CHUNK_SIZE;
+            }
+            esp_err_t err = ring_push(data, len);
+            if (err != ESP_OK) {
+                return err;
+            }
+            spsc_ring_commit_read(s_lane.ring, len);
+        } else if (s_lane.done) {
+            // The last commit may have landed just before `done`
+            if (spsc_ring_available(s_lane.ring) == 0) {
+                return s_lane.result;
+            }
+        } else {
+            spsc_ring_wait_data(s_lane.ring, AUDIO_DSP_ALIGN, pdMS_TO_TICKS(RING_WAIT_SLICE_MS));
+        }
+    }
+    return ESP_FAIL;
+}
+
+/**
+ * Cut the next non-empty segment and advance the cursor
+ *
+ * @return Trimmed copy of the segment (caller frees), NULL at the end of the text
+ */
+static char *take_segment(const char **cursor, size_t max_chars, bool first_sentence)
+{
+    while (**cursor != '\0') {
+        const char *start = *cursor;
+        size_t len = tts_segment_next(start, max_chars, first_sentence);
+        *cursor += len;
+
+        while (len > 0 && isspace((unsigned char)start[len - 1])) {
+            len--;
+        }
+        while (len > 0 && isspace((unsigned char)*start)) {
+            start++;
+            len--;
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        char *segment = malloc(len + 1);
+        if (!segment) {
+            ESP_LOGE(TAG, "Failed to allocate segment");
+            return NULL;
+        }
+        memcpy(segment, start, len);
+        segment[len] = '\0';
+        return segment;
+    }
+    return NULL;
+}
+
+/**
+ * Synthesize long text as a pipeline of sentence-aligned requests
+ *
+ * The short first segment keeps time-to-first-audio low. Every odd segment
+ * is prefetched while the even one before it streams, so the next request's
+ * latency is hidden behind playback of the current one.
+ */
+static esp_err_t speak_segmented(const char *text, float speed)
+{
+    if (xTaskCreatePinnedToCore(prefetch_task, "tts_prefetch", TASK_TTS_PREFETCH_STACK, NULL,
+                                TASK_TTS_PREFETCH_PRIORITY, NULL, TASK_TTS_PREFETCH_CORE) != pdPASS) {
+        ESP_LOGW(TAG, "No prefetch task, sending text as one request");
+        return fetch_segment(text, speed, false);
+    }
+
+    const char *cursor = text;
+    char *current = take_segment(&cursor, SEGMENT_FIRST_MAX_CHARS, true);
+    esp_err_t ret = ESP_OK;
+    int index = 0;
+
+    while (current && ret == ESP_OK && !s_stop_requested) {
+        char *ahead = take_segment(&cursor, SEGMENT_MAX_CHARS, false);
+        if (ahead) {
+            lane_start(ahead, speed);
+        }
+
+        ESP_LOGI(TAG, "Segment %d (%d chars)%s", index, (int)strlen(current), ahead ? ", next prefetching" : "");
+        ret = fetch_segment(current, speed, false);
+        free(current);
+        current = NULL;
+        index++;
+
+        if (ahead) {
+            // A prefetch that failed before any audio (e.g. no connection) is retried inline
+            bool retry = false;
+            if (ret == ESP_OK) {
+                ret = lane_stitch();
+                retry = (ret != ESP_OK && !s_stop_requested && s_lane.done && s_lane.bytes == 0);
+            }
+            if (ret != ESP_OK && !retry) {
+                s_stop_requested = true;  // Abort the prefetch too
+            }
+            xSemaphoreTake(s_lane.done_sem, portMAX_DELAY);
+
+            if (retry) {
+                ESP_LOGW(TAG, "Prefetch of segment %d failed, fetching it inline", index);
+                ret = fetch_segment(ahead, speed, false);
+            }
+            free(ahead);
+            index++;
+        }
+
+        if (ret == ESP_OK) {
+            current = take_segment(&cursor, SEGMENT_MAX_CHARS, false);
+        }
+    }
+    free(current);
+
+    // Stop the prefetch task
+    s_lane.text = NULL;
+    xSemaphoreGive(s_lane.start_sem);
+    xSemaphoreTake(s_lane.done_sem, portMAX_DELAY);
+
+    ESP_LOGI(TAG, "Segmented synthesis finished after %d segments", index);
+    return ret;
+}
+
 /**
  * Initialize the TTS module
  */
 esp_err_t tts_init(void)
 {
     if (s_initialized) {
-        ESP_LOGW(TAG, "TTS already initialized");
+        ESP_LOGD(TAG, "TTS already initialized");
         return ESP_OK;
     }
 
@@ -539,19 +786,58 @@ esp_err_t tts_init(void)
         s_current_sample_rate = OPENAI_SAMPLE_RATE;
     }
 
+    // Start connection pool and open a session to the default provider early
+    esp_err_t err = http_pool_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init HTTP pool: %s", esp_err_to_name(err));
+        return err;
+    }
+    http_pool_prewarm(provider_pool_host(s_current_provider));
+
     // Initialize ring buffer
-    esp_err_t err = ring_buffer_init(&s_ring_buffer, RING_BUFFER_SIZE);
+    err = spsc_ring_create(RING_BUFFER_SIZE, MALLOC_CAP_SPIRAM, &s_ring);
     if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate ring buffer (%d bytes)", RING_BUFFER_SIZE);
         return err;
     }
 
-    // Create semaphore for playback completion
+    // Create semaphores for playback completion and for tts_stop()
     s_playback_done_sem = xSemaphoreCreateBinary();
-    if (!s_playback_done_sem) {
-        ring_buffer_free(&s_ring_buffer);
+    s_idle_sem = xSemaphoreCreateBinary();
+    if (!s_playback_done_sem || !s_idle_sem) {
+        if (s_playback_done_sem) vSemaphoreDelete(s_playback_done_sem);
+        if (s_idle_sem) vSemaphoreDelete(s_idle_sem);
+        s_playback_done_sem = NULL;
+        s_idle_sem = NULL;
+        spsc_ring_delete(s_ring);
+        s_ring = NULL;
         return ESP_ERR_NO_MEM;
     }
 
+    // Prefetch lane for segmented synthesis
+    s_lane.start_sem = xSemaphoreCreateBinary();
+    s_lane.done_sem = xSemaphoreCreateBinary();
+    err = spsc_ring_create(PREFETCH_RING_SIZE, MALLOC_CAP_SPIRAM, &s_lane.ring);
+    if (!s_lane.start_sem || !s_lane.done_sem || err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate prefetch lane");
+        if (s_lane.start_sem) vSemaphoreDelete(s_lane.start_sem);
+        if (s_lane.done_sem) vSemaphoreDelete(s_lane.done_sem);
+        spsc_ring_delete(s_lane.ring);
+        memset(&s_lane, 0, sizeof(s_lane));
+        vSemaphoreDelete(s_playback_done_sem);
+        s_playback_done_sem = NULL;
+        vSemaphoreDelete(s_idle_sem);
+        s_idle_sem = NULL;
+        spsc_ring_delete(s_ring);
+        s_ring = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // The cache is optional; speaking works without it
+    if (tts_cache_init() != ESP_OK) {
+        ESP_LOGW(TAG, "TTS cache unavailable");
+    }
+
     s_initialized = true;
     ESP_LOGI(TAG, "TTS initialized (provider: %s, ring buffer: %d bytes)",
              tts_get_provider_name(s_current_provider), RING_BUFFER_SIZE);
@@ -577,6 +863,8 @@ esp_err_t tts_set_provider(tts_provider_t provider)
     ESP_LOGI(TAG, "TTS provider set to %s (%luHz)",
              tts_get_provider_name(provider), (unsigned long)s_current_sample_rate);
 
+    http_pool_prewarm(provider_pool_host(provider));
+
     return ESP_OK;
 }
 
@@ -626,6 +914,111 @@ bool tts_is_provider_available(tts_provider_t provider)
     }
 }
 
+/**
+ * Cache key of a text with the current provider settings
+ */
+static uint64_t cache_key(const char *text, float speed)
+{
+    uint32_t speed_centi = (uint32_t)(speed * 100.0f + 0.5f);
+
+    if (s_current_provider == TTS_PROVIDER_OPENAI) {
+        return tts_cache_key(s_current_provider, CONFIG_OPENAI_TTS_VOICE, CONFIG_OPENAI_TTS_MODEL,
+                             speed_centi, text);
+    }
+    return tts_cache_key(s_current_provider, CONFIG_ELEVENLABS_VOICE_ID,
+                         ELEVENLABS_MODEL_ID "/" ELEVENLABS_OUTPUT_FORMAT, speed_centi, text);
+}
+
+/**
+ * Mark the player busy if it is idle
+ *
+ * Checks and sets s_streaming in one step so tts_speak() and
+ * tts_pcm_begin() from different tasks cannot both start.
+ */
+static bool claim_playback(void)
+{
+    taskENTER_CRITICAL(&s_claim_lock);
+    bool idle = !s_streaming && !s_playing;
+    if (idle) {
+        s_streaming = true;
+    }
+    taskEXIT_CRITICAL(&s_claim_lock);
+    return idle;
+}
+
+/**
+ * Reset the ring and start the playback task for a claimed utterance
+ */
+static esp_err_t start_playback(uint32_t sample_rate, size_t expected_bytes)
+{
+    spsc_ring_reset(s_ring);
+    s_total_bytes = 0;
+    s_first_byte_us = 0;
+    s_expected_bytes = (int)expected_bytes;
+    s_play_rate = sample_rate;
+
+    BaseType_t task_created = xTaskCreatePinnedToCore(
+        playback_task,
+        "tts_playback",
+        TASK_TTS_PLAYBACK_STACK,
+        NULL,
+        TASK_TTS_PLAYBACK_PRIORITY,
+        &s_playback_task,
+        TASK_TTS_PLAYBACK_CORE
+    );
+
+    if (task_created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create playback task");
+        s_streaming = false;
+        signal_idle();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Producer is done; let the playback task drain and finish
+ */
+static void end_streaming(esp_err_t ret)
+{
+    if (ret != ESP_OK) {
+        s_stop_requested = true;
+    }
+    s_streaming = false;
+    signal_idle();
+    spsc_ring_wake(s_ring);
+}
+
+/**
+ * Wait for the playback task to finish (it always does)
+ */
+static void wait_playback(void)
+{
+    xSemaphoreTake(s_playback_done_sem, portMAX_DELAY);
+    s_playback_task = NULL;
+    s_stop_requested = false;
+}
+
+/**
+ * Feed a cached utterance to the playback ring
+ */
+static esp_err_t play_cached(const tts_cache_hit_t *hit)
+{
+    size_t offset = 0;
+    while (offset < hit->len) {
+        size_t len = hit->len - offset;
+        if (len > STITCH_CHUNK_SIZE) {
+            len = STITCH_CHUNK_SIZE;
+        }
+        esp_err_t err = ring_push(hit->pcm + offset, len);
+        if (err != ESP_OK) {
+            return err;
+        }
+        offset += len;
+    }
+    return ESP_OK;
+}
+
 /**
  * Speak the given text using current TTS provider (default speed)
  */
@@ -639,6 +1032,8 @@ esp_err_t tts_speak(const char *text)
  */
 esp_err_t tts_speak_with_speed(const char *text, float speed)
 {
+    int64_t start_us = esp_timer_get_time();
+
     if (!s_initialized) {
         ESP_LOGE(TAG, "TTS not initialized");
         return ESP_ERR_INVALID_STATE;
@@ -649,11 +1044,19 @@ esp_err_t tts_speak_with_speed(const char *text, float speed)
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (s_streaming || s_playing) {
+    if (!claim_playback()) {
         ESP_LOGW(TAG, "TTS already in progress");
         return ESP_ERR_INVALID_STATE;
     }
 
+    if (s_stop_requested) {
+        ESP_LOGI(TAG, "Stopped before start");
+        s_stop_requested = false;
+        s_streaming = false;
+        signal_idle();
+        return ESP_FAIL;
+    }
+
     // Clamp speed to valid range based on provider
     if (s_current_provider == TTS_PROVIDER_OPENAI) {
         if (speed < 0.25f) speed = 0.25f;
@@ -663,117 +1066,117 @@ esp_err_t tts_speak_with_speed(const char *text, float speed)
         if (speed > 2.0f) speed = 2.0f;
     }
 
-    esp_err_t ret = ESP_OK;
-    char *json_body = NULL;
-    char url[256];
+    // Repeated utterances are served from the cache without a request
+    uint64_t key = cache_key(text, speed);
+    tts_cache_hit_t hit;
+    bool cached = tts_cache_lookup(key, &hit);
+    if (cached && hit.sample_rate != s_current_sample_rate) {
+        tts_cache_release(&hit);
+        cached = false;
+    }
 
-    // Reset state
-    ring_buffer_reset(&s_ring_buffer);
-    s_stop_requested = false;
-    s_streaming = true;
+    // A pending tts_stop_async() is kept and aborts this call
+    s_speak_start_us = start_us;
+    s_speak_source = cached ? SOURCE_CACHE : SOURCE_NETWORK;
+    metrics_inc(&s_m_utterances[s_speak_source]);
+    size_t expected = cached ? hit.len :
+                      (size_t)(strlen(text) * s_current_sample_rate * 2 / (SPEECH_CHARS_PER_SEC * speed));
+    s_segmented = !cached && SEGMENT_THRESHOLD_CHARS > 0 && strlen(text) > SEGMENT_THRESHOLD_CHARS;
 
-    // Build request based on provider
-    if (s_current_provider == TTS_PROVIDER_OPENAI) {
-        strncpy(url, OPENAI_API_URL, sizeof(url));
-        json_body = build_openai_body(text, speed);
+    ESP_LOGI(TAG, "Starting TTS (%s) for: %.50s%s (speed: %.2fx%s)",
+             cached ? (hit.from_disk ? "cache, SD" : "cache") : tts_get_provider_name(s_current_provider),
+             text, strlen(text) > 50 ? "..." : "", speed, s_segmented ? ", segmented" : "");
+
+    esp_err_t ret = start_playback(s_current_sample_rate, expected);
+    if (ret != ESP_OK) {
+        if (cached) {
+            tts_cache_release(&hit);
+        }
+        return ret;
+    }
+
+    if (cached) {
+        ret = play_cached(&hit);
+        tts_cache_release(&hit);
     } else {
-        build_elevenlabs_url(url, sizeof(url));
-        json_body = build_elevenlabs_body(text, speed);
+        s_cache_writer = tts_cache_begin(key, s_current_sample_rate);
+        ret = s_segmented ? speak_segmented(text, speed) : fetch_segment(text, speed, false);
     }
 
-    if (!json_body) {
-        ESP_LOGE(TAG, "Failed to build request body");
-        s_streaming = false;
-        return ESP_ERR_NO_MEM;
+    end_streaming(ret);
+
+    // Only complete responses are cached; this may spill to SD while playback drains
+    if (s_cache_writer) {
+        if (ret == ESP_OK && !s_stop_requested) {
+            tts_cache_commit(s_cache_writer);
+        } else {
+            tts_cache_abort(s_cache_writer);
+        }
+        s_cache_writer = NULL;
     }
 
-    ESP_LOGI(TAG, "Starting TTS (%s) for: %.50s%s (speed: %.2fx)",
-             tts_get_provider_name(s_current_provider),
-             text, strlen(text) > 50 ? "..." : "", speed);
+    wait_playback();
+    return ret;
+}
 
-    // Create playback task
-    BaseType_t task_created = xTaskCreate(
-        playback_task,
-        "tts_playback",
-        4096,
-        NULL,
-        5,
-        &s_playback_task
-    );
+esp_err_t tts_pcm_begin(uint32_t sample_rate, size_t expected_bytes)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "TTS not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    if (task_created != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create playback task");
-        free(json_body);
-        s_streaming = false;
-        return ESP_ERR_NO_MEM;
+    if (!claim_playback()) {
+        ESP_LOGW(TAG, "TTS already in progress");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    // Configure HTTP client
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_event_handler,
-        .timeout_ms = 30000,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .buffer_size = 4096,
-        .buffer_size_tx = 2048,
-    };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (!client) {
-        ESP_LOGE(TAG, "Failed to init HTTP client");
+    // Same contract as tts_speak(): a pending stop aborts the stream before it starts
+    if (s_stop_requested) {
+        ESP_LOGI(TAG, "Stopped before start");
+        s_stop_requested = false;
         s_streaming = false;
-        s_stop_requested = true;
-        free(json_body);
+        signal_idle();
         return ESP_FAIL;
     }
 
-    // Set headers based on provider
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    if (s_current_provider == TTS_PROVIDER_OPENAI) {
-#ifdef CONFIG_OPENAI_API_KEY
-        char auth_header[256];
-        snprintf(auth_header, sizeof(auth_header), "Bearer %s", CONFIG_OPENAI_API_KEY);
-        esp_http_client_set_header(client, "Authorization", auth_header);
-#endif
-    } else {
-#ifdef CONFIG_ELEVENLABS_API_KEY
-        esp_http_client_set_header(client, "xi-api-key", CONFIG_ELEVENLABS_API_KEY);
-        esp_http_client_set_header(client, "Accept", "audio/pcm");
-#endif
-    }
-
-    // Set POST body
-    esp_http_client_set_post_field(client, json_body, strlen(json_body));
+    s_speak_start_us = esp_timer_get_time();
+    s_speak_source = SOURCE_PUSH;
+    s_segmented = false;
+    metrics_inc(&s_m_utterances[SOURCE_PUSH]);
 
-    // Perform HTTP request (this streams data to ring buffer via event handler)
-    ret = esp_http_client_perform(client);
+    ESP_LOGI(TAG, "Starting pushed PCM (%lu Hz, %u bytes expected)",
+             (unsigned long)sample_rate, (unsigned)expected_bytes);
+    return start_playback(sample_rate, expected_bytes);
+}
 
-    // Streaming is done
-    s_streaming = false;
+esp_err_t tts_pcm_write(const uint8_t *data, size_t len)
+{
+    if (!s_streaming || s_speak_source != SOURCE_PUSH) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(ret));
-        s_stop_requested = true;
-    } else {
-        int status = esp_http_client_get_status_code(client);
-        if (status != 200) {
-            ESP_LOGE(TAG, "API error (HTTP %d)", status);
-            ret = ESP_FAIL;
-            s_stop_requested = true;
+    while (len > 0) {
+        size_t chunk = len > STITCH_CHUNK_SIZE ? STITCH_CHUNK_SIZE : len;
+        esp_err_t err = ring_push(data, chunk);
+        if (err != ESP_OK) {
+            return err;
         }
+        data += chunk;
+        len -= chunk;
     }
+    return ESP_OK;
+}
 
-    // Clean up HTTP client
-    esp_http_client_cleanup(client);
-    free(json_body);
-
-    // Wait for playback to complete (indefinitely - playback task will always finish)
-    xSemaphoreTake(s_playback_done_sem, portMAX_DELAY);
-
-    s_playback_task = NULL;
+esp_err_t tts_pcm_end(bool abort)
+{
+    if (!s_streaming || s_speak_source != SOURCE_PUSH) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    return ret;
+    end_streaming(abort ? ESP_FAIL : ESP_OK);
+    wait_playback();
+    return ESP_OK;
 }
 
 /**
@@ -795,16 +1198,50 @@ esp_err_t tts_stop(void)
     }
 
     ESP_LOGI(TAG, "Stopping TTS");
-    s_stop_requested = true;
-
-    // Wait for playback task to finish
-    if (s_playback_task) {
-        xSemaphoreTake(s_playback_done_sem, pdMS_TO_TICKS(5000));
+    xSemaphoreTake(s_idle_sem, 0);  // Drop a give from an earlier utterance
+    tts_stop_async();
+
+    // Wait for the speaking call to unwind; its done semaphore belongs to tts_speak_with_speed()
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(STOP_TIMEOUT_MS);
+    while (s_streaming || s_playing) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= timeout || xSemaphoreTake(s_idle_sem, timeout - waited) != pdTRUE) {
+            ESP_LOGW(TAG, "TTS still busy after %d ms", STOP_TIMEOUT_MS);
+            break;
+        }
+    }
+    if (!s_streaming && !s_playing) {
+        xSemaphoreGive(s_idle_sem);  // Pass the wake on to any other stopper
     }
 
     return ESP_OK;
 }
 
+/**
+ * Request a stop without waiting
+ */
+void tts_stop_async(void)
+{
+    s_stop_requested = true;
+    if (s_ring) {
+        spsc_ring_wake(s_ring);
+    }
+    if (s_lane.ring) {
+        spsc_ring_wake(s_lane.ring);
+    }
+}
+
+/**
+ * Drop a pending stop request
+ */
+void tts_clear_stop(void)
+{
+    if (!s_streaming && !s_playing) {
+        s_stop_requested = false;
+    }
+}
+
 /**
  * Check if TTS is currently playing
  */
@@ -813,6 +1250,14 @@ bool tts_is_playing(void)
     return s_streaming || s_playing;
 }
 
+/**
+ * Get when the last utterance started playing
+ */
+int64_t tts_get_audio_start_us(void)
+{
+    return s_audio_start_us;
+}
+
 /**
  * Clean up TTS resources
  */
@@ -824,8 +1269,18 @@ void tts_cleanup(void)
         vSemaphoreDelete(s_playback_done_sem);
         s_playback_done_sem = NULL;
     }
+    if (s_idle_sem) {
+        vSemaphoreDelete(s_idle_sem);
+        s_idle_sem = NULL;
+    }
+
+    spsc_ring_delete(s_ring);
+    s_ring = NULL;
 
-    ring_buffer_free(&s_ring_buffer);
+    if (s_lane.start_sem) vSemaphoreDelete(s_lane.start_sem);
+    if (s_lane.done_sem) vSemaphoreDelete(s_lane.done_sem);
+    spsc_ring_delete(s_lane.ring);
+    memset(&s_lane, 0, sizeof(s_lane));
 
     s_initialized = false;
     ESP_LOGI(TAG, "TTS cleaned up");
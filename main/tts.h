@@ -7,6 +7,8 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -77,7 +79,10 @@ esp_err_t tts_speak(const char *text);
  * @brief Speak the given text with custom speed
  *
  * Streams PCM audio from TTS API and plays it through the speaker.
- * Blocks until playback is complete.
+ * Blocks until playback is complete. Texts longer than
+ * CONFIG_TTS_SEGMENT_THRESHOLD_CHARS are split at sentence boundaries and
+ * synthesized as overlapping requests, so playback starts after the first
+ * sentence instead of the whole text.
  *
  * @param text The text to synthesize (max 5000 chars recommended)
  * @param speed Speech speed multiplier (ElevenLabs: 0.5-2.0, OpenAI: 0.25-4.0)
@@ -94,6 +99,42 @@ esp_err_t tts_speak_with_speed(const char *text, float speed);
  */
 esp_err_t tts_speak_test(void);
 
+/**
+ * @brief Start playing PCM pushed by the caller
+ *
+ * The samples go through the TTS playback ring with the same pre-roll and
+ * flow control as a provider response; speak requests are refused until
+ * tts_pcm_end(). tts_stop() aborts the stream. Write and end from the
+ * task that called this.
+ *
+ * @param sample_rate Rate of the mono 16-bit samples, in Hz
+ * @param expected_bytes Total length if known (0 if not), sizes the pre-roll
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if TTS is not
+ *         initialized or already playing, ESP_FAIL if a stop was pending
+ */
+esp_err_t tts_pcm_begin(uint32_t sample_rate, size_t expected_bytes);
+
+/**
+ * @brief Queue pushed PCM
+ *
+ * Blocks while the ring is above its high watermark.
+ *
+ * @param data Mono 16-bit little-endian samples
+ * @param len Length in bytes
+ * @return ESP_OK on success, ESP_FAIL if playback was stopped or stalled
+ */
+esp_err_t tts_pcm_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Finish a pushed stream
+ *
+ * Waits until the queued audio has played (or was dropped).
+ *
+ * @param abort Drop whatever is still queued instead of playing it
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no stream is open
+ */
+esp_err_t tts_pcm_end(bool abort);
+
 /**
  * @brief Stop current TTS playback
  *
@@ -103,6 +144,20 @@ esp_err_t tts_speak_test(void);
  */
 esp_err_t tts_stop(void);
 
+/**
+ * @brief Request a stop without waiting
+ *
+ * Unlike tts_stop(), the request also applies to a tts_speak() call that
+ * is about to start: it stays pending until that call returns or
+ * tts_clear_stop() is called.
+ */
+void tts_stop_async(void);
+
+/**
+ * @brief Drop a pending tts_stop_async() request while idle
+ */
+void tts_clear_stop(void);
+
 /**
  * @brief Check if TTS is currently playing
  *
@@ -110,6 +165,14 @@ esp_err_t tts_stop(void);
  */
 bool tts_is_playing(void);
 
+/**
+ * @brief Get when the last utterance started playing
+ *
+ * @return esp_timer time at which the first sample of the current or last
+ *         utterance was handed to the audio engine, 0 if none yet
+ */
+int64_t tts_get_audio_start_us(void);
+
 /**
  * @brief Clean up TTS resources
  *
@@ -0,0 +1,462 @@
+/**
+ * TTS Utterance Cache
+ *
+ * A small fixed index of PSRAM buffers. LRU order is a use counter per
+ * entry; eviction scans for the oldest unpinned one, which is cheap at this
+ * entry count. Spilled entries are stored as /sdcard/ttscache/<key>.pcm with
+ * a header carrying the full key, rate and length.
+ */
+
+#include "tts_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "tts_cache";
+
+#if CONFIG_TTS_CACHE_ENABLE
+#define CACHE_BUDGET_BYTES (CONFIG_TTS_CACHE_BUDGET_KB * 1024)
+#define CACHE_MAX_ENTRY_BYTES (CONFIG_TTS_CACHE_MAX_ENTRY_KB * 1024)
+#else
+#define CACHE_BUDGET_BYTES 0
+#define CACHE_MAX_ENTRY_BYTES 0
+#endif
+
+#if CONFIG_TTS_CACHE_SPILL_SD
+#define CACHE_SPILL_DESC "on"
+#else
+#define CACHE_SPILL_DESC "off"
+#endif
+
+#define CACHE_MAX_ENTRIES 64
+#define CACHE_WRITER_INITIAL (32 * 1024)    // First recording buffer, doubled as needed
+#define CACHE_DIR "/sdcard/ttscache"
+#define CACHE_SD_ROOT "/sdcard"
+#define CACHE_FILE_MAGIC 0x43535454         // "TTSC"
+#define CACHE_FILE_VERSION 1
+
+#define FNV64_OFFSET 0xcbf29ce484222325ULL
+#define FNV64_PRIME 0x100000001b3ULL
+
+typedef struct {
+    bool used;
+    uint64_t key;
+    uint8_t *pcm;               // PSRAM
+    size_t len;
+    uint32_t sample_rate;
+    uint32_t last_used;         // LRU clock value of the last hit or insert
+    uint16_t refs;              // Pinned by playback or a spill in progress
+} cache_entry_t;
+
+struct tts_cache_writer {
+    uint64_t key;
+    uint32_t sample_rate;
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    bool overflow;
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t sample_rate;
+    uint32_t len;
+} cache_file_header_t;
+
+static struct {
+    bool ready;
+    SemaphoreHandle_t lock;
+    cache_entry_t entries[CACHE_MAX_ENTRIES];
+    uint32_t clock;
+    tts_cache_stats_t stats;
+} s_ctx = {0};
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+uint64_t tts_cache_key(int provider, const char *voice, const char *model, uint32_t speed_centi,
+                       const char *text)
+{
+    // Strings include their terminator so field boundaries are part of the hash
+    uint64_t hash = FNV64_OFFSET;
+    hash = fnv1a(hash, &provider, sizeof(provider));
+    hash = fnv1a(hash, voice, strlen(voice) + 1);
+    hash = fnv1a(hash, model, strlen(model) + 1);
+    hash = fnv1a(hash, &speed_centi, sizeof(speed_centi));
+    hash = fnv1a(hash, text, strlen(text) + 1);
+    return hash;
+}
+
+esp_err_t tts_cache_init(void)
+{
+#if CONFIG_TTS_CACHE_ENABLE
+    if (s_ctx.ready) {
+        return ESP_OK;
+    }
+
+    s_ctx.lock = xSemaphoreCreateMutex();
+    if (!s_ctx.lock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_ctx.stats.budget = CACHE_BUDGET_BYTES;
+    s_ctx.ready = true;
+    ESP_LOGI(TAG, "TTS cache ready (%d KB budget, SD spill %s)", CONFIG_TTS_CACHE_BUDGET_KB,
+             CACHE_SPILL_DESC);
+#endif
+    return ESP_OK;
+}
+
+static cache_entry_t *find_entry(uint64_t key)
+{
+    for (int i = 0; i < CACHE_MAX_ENTRIES; i++) {
+        if (s_ctx.entries[i].used && s_ctx.entries[i].key == key) {
+            return &s_ctx.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void free_entry(cache_entry_t *entry)
+{
+    heap_caps_free(entry->pcm);
+    s_ctx.stats.bytes -= entry->len;
+    s_ctx.stats.entries--;
+    memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * Take ownership of pcm as a new entry, evicting LRU entries to make room (lock held)
+ *
+ * @return Entry, or NULL if it cannot fit (pcm is then freed)
+ */
+static cache_entry_t *insert_entry(uint64_t key, uint8_t *pcm, size_t len, uint32_t sample_rate)
+{
+    cache_entry_t *old = find_entry(key);
+    if (old && old->refs == 0) {
+        free_entry(old);
+    } else if (old) {
+        heap_caps_free(pcm);  // Same utterance already cached and in use
+        return NULL;
+    }
+
+    while (true) {
+        cache_entry_t *free_slot = NULL;
+        cache_entry_t *lru = NULL;
+        for (int i = 0; i < CACHE_MAX_ENTRIES; i++) {
+            cache_entry_t *entry = &s_ctx.entries[i];
+            if (!entry->used) {
+                free_slot = free_slot ? free_slot : entry;
+            } else if (entry->refs == 0 && (!lru || (int32_t)(entry->last_used - lru->last_used) < 0)) {
+                lru = entry;
+            }
+        }
+
+        if (free_slot && s_ctx.stats.bytes + len <= CACHE_BUDGET_BYTES) {
+            free_slot->used = true;
+            free_slot->key = key;
+            free_slot->pcm = pcm;
+            free_slot->len = len;
+            free_slot->sample_rate = sample_rate;
+            free_slot->last_used = ++s_ctx.clock;
+            s_ctx.stats.bytes += len;
+            s_ctx.stats.entries++;
+            s_ctx.stats.inserts++;
+            return free_slot;
+        }
+        if (!lru) {
+            heap_caps_free(pcm);  // Everything left is pinned
+            return NULL;
+        }
+        ESP_LOGD(TAG, "Evicting %016llx (%d bytes)", (unsigned long long)lru->key, (int)lru->len);
+        free_entry(lru);
+        s_ctx.stats.evictions++;
+    }
+}
+
+#if CONFIG_TTS_CACHE_SPILL_SD
+static void cache_path(uint64_t key, char *path, size_t size, const char *ext)
+{
+    snprintf(path, size, CACHE_DIR "/%016llx.%s", (unsigned long long)key, ext);
+}
+
+/**
+ * Check that the SD card is mounted and the cache directory exists
+ */
+static bool spill_available(void)
+{
+    struct stat st;
+    if (stat(CACHE_SD_ROOT, &st) != 0) {
+        return false;
+    }
+    if (stat(CACHE_DIR, &st) == 0) {
+        return true;
+    }
+    return mkdir(CACHE_DIR, 0775) == 0;
+}
+
+/**
+ * Write an entry to the SD card (entry pinned, lock not held)
+ */
+static void spill_entry(const cache_entry_t *entry)
+{
+    if (!spill_available()) {
+        return;
+    }
+
+    char tmp_path[64];
+    char path[64];
+    cache_path(entry->key, tmp_path, sizeof(tmp_path), "tmp");
+    cache_path(entry->key, path, sizeof(path), "pcm");
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot create %s", tmp_path);
+        return;
+    }
+
+    cache_file_header_t header = {
+        .magic = CACHE_FILE_MAGIC,
+        .version = CACHE_FILE_VERSION,
+        .key = entry->key,
+        .sample_rate = entry->sample_rate,
+        .len = entry->len,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(entry->pcm, 1, entry->len, f) == entry->len;
+    ok = (fclose(f) == 0) && ok;
+
+    // Rename last so a power cut never leaves a truncated .pcm behind
+    remove(path);
+    if (!ok || rename(tmp_path, path) != 0) {
+        ESP_LOGW(TAG, "Failed to spill %016llx", (unsigned long long)entry->key);
+        remove(tmp_path);
+        return;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    s_ctx.stats.spills++;
+    xSemaphoreGive(s_ctx.lock);
+}
+
+/**
+ * Load a spilled entry from the SD card into a PSRAM buffer
+ */
+static uint8_t *load_spilled(uint64_t key, size_t *len, uint32_t *sample_rate)
+{
+    char path[64];
+    cache_path(key, path, sizeof(path), "pcm");
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    uint8_t *pcm = NULL;
+    cache_file_header_t header;
+    if (fread(&header, sizeof(header), 1, f) == 1 && header.magic == CACHE_FILE_MAGIC &&
+        header.version == CACHE_FILE_VERSION && header.key == key &&
+        header.len > 0 && header.len <= CACHE_MAX_ENTRY_BYTES) {
+        pcm = heap_caps_malloc(header.len, MALLOC_CAP_SPIRAM);
+        if (pcm && fread(pcm, 1, header.len, f) != header.len) {
+            heap_caps_free(pcm);
+            pcm = NULL;
+        }
+    }
+    fclose(f);
+
+    if (!pcm) {
+        ESP_LOGW(TAG, "Discarding unreadable %s", path);
+        remove(path);
+        return NULL;
+    }
+
+    *len = header.len;
+    *sample_rate = header.sample_rate;
+    return pcm;
+}
+#endif
+
+bool tts_cache_lookup(uint64_t key, tts_cache_hit_t *hit)
+{
+    memset(hit, 0, sizeof(*hit));
+    if (!s_ctx.ready) {
+        return false;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    cache_entry_t *entry = find_entry(key);
+    if (entry) {
+        entry->refs++;
+        entry->last_used = ++s_ctx.clock;
+        s_ctx.stats.hits++;
+    }
+    xSemaphoreGive(s_ctx.lock);
+
+#if CONFIG_TTS_CACHE_SPILL_SD
+    if (!entry && spill_available()) {
+        size_t len = 0;
+        uint32_t sample_rate = 0;
+        uint8_t *pcm = load_spilled(key, &len, &sample_rate);
+        if (pcm) {
+            xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+            entry = insert_entry(key, pcm, len, sample_rate);
+            if (entry) {
+                entry->refs++;
+                s_ctx.stats.disk_hits++;
+                hit->from_disk = true;
+            }
+            xSemaphoreGive(s_ctx.lock);
+        }
+    }
+#endif
+
+    if (!entry) {
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        s_ctx.stats.misses++;
+        xSemaphoreGive(s_ctx.lock);
+        return false;
+    }
+
+    hit->pcm = entry->pcm;
+    hit->len = entry->len;
+    hit->sample_rate = entry->sample_rate;
+    hit->entry = entry;
+    return true;
+}
+
+void tts_cache_release(tts_cache_hit_t *hit)
+{
+    if (!hit->entry) {
+        return;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    ((cache_entry_t *)hit->entry)->refs--;
+    xSemaphoreGive(s_ctx.lock);
+    memset(hit, 0, sizeof(*hit));
+}
+
+tts_cache_writer_t *tts_cache_begin(uint64_t key, uint32_t sample_rate)
+{
+    if (!s_ctx.ready) {
+        return NULL;
+    }
+
+    tts_cache_writer_t *writer = calloc(1, sizeof(*writer));
+    if (!writer) {
+        return NULL;
+    }
+    writer->key = key;
+    writer->sample_rate = sample_rate;
+    writer->cap = CACHE_WRITER_INITIAL;
+    writer->buf = heap_caps_malloc(writer->cap, MALLOC_CAP_SPIRAM);
+    if (!writer->buf) {
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void tts_cache_append(tts_cache_writer_t *writer, const uint8_t *data, size_t len)
+{
+    if (!writer || writer->overflow) {
+        return;
+    }
+
+    if (writer->len + len > CACHE_MAX_ENTRY_BYTES) {
+        writer->overflow = true;  // Too long to be worth caching
+        return;
+    }
+
+    if (writer->len + len > writer->cap) {
+        size_t cap = writer->cap;
+        while (cap < writer->len + len) {
+            cap *= 2;
+        }
+        if (cap > CACHE_MAX_ENTRY_BYTES) {
+            cap = CACHE_MAX_ENTRY_BYTES;
+        }
+        uint8_t *buf = heap_caps_realloc(writer->buf, cap, MALLOC_CAP_SPIRAM);
+        if (!buf) {
+            writer->overflow = true;
+            return;
+        }
+        writer->buf = buf;
+        writer->cap = cap;
+    }
+
+    memcpy(writer->buf + writer->len, data, len);
+    writer->len += len;
+}
+
+void tts_cache_abort(tts_cache_writer_t *writer)
+{
+    if (!writer) {
+        return;
+    }
+    heap_caps_free(writer->buf);
+    free(writer);
+}
+
+void tts_cache_commit(tts_cache_writer_t *writer)
+{
+    if (!writer) {
+        return;
+    }
+    if (writer->overflow || writer->len < 2) {
+        tts_cache_abort(writer);
+        return;
+    }
+
+    // Trim the recording buffer to the PCM size
+    uint8_t *pcm = heap_caps_realloc(writer->buf, writer->len, MALLOC_CAP_SPIRAM);
+    if (!pcm) {
+        pcm = writer->buf;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    cache_entry_t *entry = insert_entry(writer->key, pcm, writer->len, writer->sample_rate);
+    if (entry) {
+        entry->refs++;  // Pinned while spilling
+    }
+    xSemaphoreGive(s_ctx.lock);
+
+    if (entry) {
+        ESP_LOGI(TAG, "Cached %016llx (%d bytes)", (unsigned long long)writer->key, (int)writer->len);
+#if CONFIG_TTS_CACHE_SPILL_SD
+        spill_entry(entry);
+#endif
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        entry->refs--;
+        xSemaphoreGive(s_ctx.lock);
+    }
+    free(writer);
+}
+
+void tts_cache_get_stats(tts_cache_stats_t *stats)
+{
+    if (!s_ctx.ready) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    *stats = s_ctx.stats;
+    xSemaphoreGive(s_ctx.lock);
+}
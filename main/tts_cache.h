@@ -0,0 +1,135 @@
+/**
+ * TTS Utterance Cache
+ *
+ * Content-addressed cache of synthesized PCM, keyed by a hash of provider,
+ * voice, model, speed and text. Entries live in PSRAM under a byte budget
+ * with least-recently-used eviction, and are optionally spilled to the SD
+ * card so they survive a reboot.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cached utterance, pinned until tts_cache_release()
+ */
+typedef struct {
+    const uint8_t *pcm;         // Mono 16-bit PCM
+    size_t len;                 // Bytes
+    uint32_t sample_rate;
+    bool from_disk;             // Loaded from the SD card by this lookup
+    void *entry;                // Internal
+} tts_cache_hit_t;
+
+/**
+ * @brief Opaque recording of a response being downloaded
+ */
+typedef struct tts_cache_writer tts_cache_writer_t;
+
+/**
+ * @brief Cache statistics
+ */
+typedef struct {
+    uint32_t hits;              // Served from PSRAM
+    uint32_t disk_hits;         // Loaded from the SD card
+    uint32_t misses;
+    uint32_t inserts;
+    uint32_t evictions;         // Entries dropped to stay within the budget
+    uint32_t spills;            // Entries written to the SD card
+    uint32_t entries;
+    uint32_t bytes;             // PCM held in PSRAM
+    uint32_t budget;            // CONFIG_TTS_CACHE_BUDGET_KB in bytes
+} tts_cache_stats_t;
+
+/**
+ * @brief Initialize the cache index
+ *
+ * Safe to call more than once. Does nothing if the cache is disabled.
+ *
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t tts_cache_init(void);
+
+/**
+ * @brief Compute the cache key of an utterance (64-bit FNV-1a)
+ *
+ * @param provider Provider id
+ * @param voice Voice id
+ * @param model Model (and output format)
+ * @param speed_centi Speed in hundredths (100 = 1.0x)
+ * @param text Text to speak
+ * @return Key
+ */
+uint64_t tts_cache_key(int provider, const char *voice, const char *model, uint32_t speed_centi,
+                       const char *text);
+
+/**
+ * @brief Look up an utterance in PSRAM, then on the SD card
+ *
+ * @param key Cache key
+ * @param hit Output; pinned until tts_cache_release()
+ * @return true on a hit
+ */
+bool tts_cache_lookup(uint64_t key, tts_cache_hit_t *hit);
+
+/**
+ * @brief Unpin a hit returned by tts_cache_lookup()
+ */
+void tts_cache_release(tts_cache_hit_t *hit);
+
+/**
+ * @brief Start recording a response for the cache
+ *
+ * @param key Cache key
+ * @param sample_rate PCM sample rate
+ * @return Writer, or NULL if the cache is disabled or out of memory
+ */
+tts_cache_writer_t *tts_cache_begin(uint64_t key, uint32_t sample_rate);
+
+/**
+ * @brief Append downloaded PCM
+ *
+ * Recording stops silently once the entry would exceed
+ * CONFIG_TTS_CACHE_MAX_ENTRY_KB; the writer is then discarded on commit.
+ *
+ * @param writer Writer (may be NULL)
+ * @param data PCM bytes
+ * @param len Number of bytes
+ */
+void tts_cache_append(tts_cache_writer_t *writer, const uint8_t *data, size_t len);
+
+/**
+ * @brief Insert the recorded response and free the writer
+ *
+ * Evicts least recently used entries to stay within the budget, then
+ * spills the entry to the SD card if enabled.
+ *
+ * @param writer Writer (may be NULL)
+ */
+void tts_cache_commit(tts_cache_writer_t *writer);
+
+/**
+ * @brief Discard a recording (failed or stopped request)
+ *
+ * @param writer Writer (may be NULL)
+ */
+void tts_cache_abort(tts_cache_writer_t *writer);
+
+/**
+ * @brief Get cache statistics
+ *
+ * @param stats Output statistics
+ */
+void tts_cache_get_stats(tts_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
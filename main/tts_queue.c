@@ -0,0 +1,383 @@
+/**
+ * TTS Job Queue
+ *
+ * Jobs live in a fixed slot table: CONFIG_TTS_QUEUE_DEPTH waiting jobs, the
+ * one speaking, and the most recent finished ones for status queries. The
+ * worker runs tts_speak_with_speed() for the best waiting job (highest
+ * priority, then oldest) and sleeps on a semaphore while the queue is empty.
+ */
+
+#include "tts_queue.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "tts.h"
+#include "task_topology.h"
+
+static const char *TAG = "tts_queue";
+
+#define QUEUE_DEPTH CONFIG_TTS_QUEUE_DEPTH
+#define QUEUE_HISTORY 8                             // Finished jobs kept for status queries
+#define QUEUE_SLOTS (QUEUE_DEPTH + QUEUE_HISTORY + 1)
+
+typedef struct {
+    bool used;
+    tts_job_info_t info;
+    char *text;
+    float speed;
+} job_slot_t;
+
+static struct {
+    bool running;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t wake;         // Given on submit
+    job_slot_t slots[QUEUE_SLOTS];
+    job_slot_t *current;            // Job speaking
+    uint32_t next_id;
+    tts_queue_stats_t stats;
+} s_ctx = {0};
+
+static const char *s_state_names[] = {
+    [TTS_JOB_QUEUED] = "queued",
+    [TTS_JOB_SPEAKING] = "speaking",
+    [TTS_JOB_DONE] = "done",
+    [TTS_JOB_FAILED] = "failed",
+    [TTS_JOB_CANCELLED] = "cancelled",
+    [TTS_JOB_PREEMPTED] = "preempted",
+};
+
+static const char *s_priority_names[TTS_PRIORITY_MAX] = {
+    [TTS_PRIORITY_LOW] = "low",
+    [TTS_PRIORITY_NORMAL] = "normal",
+    [TTS_PRIORITY_ALERT] = "alert",
+};
+
+/**
+ * Pick the waiting job to speak next (lock held)
+ */
+static job_slot_t *best_queued(void)
+{
+    job_slot_t *best = NULL;
+    for (int i = 0; i < QUEUE_SLOTS; i++) {
+        job_slot_t *slot = &s_ctx.slots[i];
+        if (!slot->used || slot->info.state != TTS_JOB_QUEUED) {
+            continue;
+        }
+        if (!best || slot->info.priority > best->info.priority ||
+            (slot->info.priority == best->info.priority && slot->info.id < best->info.id)) {
+            best = slot;
+        }
+    }
+    return best;
+}
+
+/**
+ * Jobs that will be spoken before this one (lock held)
+ */
+static uint32_t queue_position(const job_slot_t *job)
+{
+    uint32_t ahead = 0;
+    for (int i = 0; i < QUEUE_SLOTS; i++) {
+        const job_slot_t *slot = &s_ctx.slots[i];
+        if (slot == job || !slot->used || slot->info.state != TTS_JOB_QUEUED) {
+            continue;
+        }
+        if (slot->info.priority > job->info.priority ||
+            (slot->info.priority == job->info.priority && slot->info.id < job->info.id)) {
+            ahead++;
+        }
+    }
+    return ahead;
+}
+
+/**
+ * Find a free slot, recycling the oldest finished job other than the current one (lock held)
+ */
+static job_slot_t *alloc_slot(void)
+{
+    job_slot_t *oldest = NULL;
+    for (int i = 0; i < QUEUE_SLOTS; i++) {
+        job_slot_t *slot = &s_ctx.slots[i];
+        if (!slot->used) {
+            return slot;
+        }
+        // A preempted or cancelled job stays current until the worker is done with it
+        if (slot == s_ctx.current) {
+            continue;
+        }
+        if (slot->info.state >= TTS_JOB_DONE && (!oldest || slot->info.id < oldest->info.id)) {
+            oldest = slot;
+        }
+    }
+    return oldest;
+}
+
+static job_slot_t *find_job(uint32_t id)
+{
+    for (int i = 0; i < QUEUE_SLOTS; i++) {
+        if (s_ctx.slots[i].used && s_ctx.slots[i].info.id == id) {
+            return &s_ctx.slots[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Finish a job that never started (lock held)
+ */
+static void drop_queued(job_slot_t *job, tts_job_state_t state)
+{
+    job->info.state = state;
+    job->info.finished_us = esp_timer_get_time();
+    free(job->text);
+    job->text = NULL;
+    s_ctx.stats.depth--;
+}
+
+static void worker_task(void *arg)
+{
+    while (true) {
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        job_slot_t *job = best_queued();
+        if (!job) {
+            xSemaphoreGive(s_ctx.lock);
+            xSemaphoreTake(s_ctx.wake, portMAX_DELAY);
+            continue;
+        }
+
+        job->info.state = TTS_JOB_SPEAKING;
+        job->info.started_us = esp_timer_get_time();
+        s_ctx.current = job;
+        s_ctx.stats.depth--;
+        s_ctx.stats.current_id = job->info.id;
+        xSemaphoreGive(s_ctx.lock);
+
+        ESP_LOGI(TAG, "Job %lu (%s) speaking after %lld ms in queue",
+                 (unsigned long)job->info.id, s_priority_names[job->info.priority],
+                 (job->info.started_us - job->info.queued_us) / 1000);
+        esp_err_t ret = tts_speak_with_speed(job->text, job->speed);
+
+        xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+        // A stop aimed at this job must not carry over to the next one
+        tts_clear_stop();
+        job->info.result = ret;
+        job->info.finished_us = esp_timer_get_time();
+        if (job->info.state == TTS_JOB_SPEAKING) {
+            job->info.state = (ret == ESP_OK) ? TTS_JOB_DONE : TTS_JOB_FAILED;
+        }
+        switch (job->info.state) {
+            case TTS_JOB_DONE: s_ctx.stats.completed++; break;
+            case TTS_JOB_FAILED: s_ctx.stats.failed++; break;
+            default: break;  // Preempted/cancelled were counted when requested
+        }
+        free(job->text);
+        job->text = NULL;
+        s_ctx.current = NULL;
+        s_ctx.stats.current_id = 0;
+        xSemaphoreGive(s_ctx.lock);
+
+        ESP_LOGI(TAG, "Job %lu %s", (unsigned long)job->info.id, s_state_names[job->info.state]);
+    }
+}
+
+esp_err_t tts_queue_init(void)
+{
+    if (s_ctx.running) {
+        return ESP_OK;
+    }
+
+    s_ctx.lock = xSemaphoreCreateMutex();
+    s_ctx.wake = xSemaphoreCreateBinary();
+    if (!s_ctx.lock || !s_ctx.wake) {
+        ESP_LOGE(TAG, "Failed to create semaphores");
+        goto fail;
+    }
+
+    s_ctx.next_id = 1;
+    s_ctx.stats.capacity = QUEUE_DEPTH;
+    if (xTaskCreatePinnedToCore(worker_task, "tts_worker", TASK_TTS_WORKER_STACK, NULL, TASK_TTS_WORKER_PRIORITY,
+                                NULL, TASK_TTS_WORKER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create worker task");
+        goto fail;
+    }
+
+    s_ctx.running = true;
+    ESP_LOGI(TAG, "TTS queue started (depth %d)", QUEUE_DEPTH);
+    return ESP_OK;
+
+fail:
+    if (s_ctx.lock) vSemaphoreDelete(s_ctx.lock);
+    if (s_ctx.wake) vSemaphoreDelete(s_ctx.wake);
+    s_ctx.lock = NULL;
+    s_ctx.wake = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t tts_queue_submit(const char *text, float speed, tts_priority_t priority, uint32_t *ret_id)
+{
+    if (!s_ctx.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!text || text[0] == '\0' || priority >= TTS_PRIORITY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char *copy = strdup(text);
+    if (!copy) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    job_slot_t *job = (s_ctx.stats.depth < QUEUE_DEPTH) ? alloc_slot() : NULL;
+    if (!job) {
+        s_ctx.stats.rejected++;
+        xSemaphoreGive(s_ctx.lock);
+        free(copy);
+        ESP_LOGW(TAG, "Queue full, job rejected");
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->used = true;
+    job->text = copy;
+    job->speed = speed;
+    job->info.id = s_ctx.next_id++;
+    job->info.state = TTS_JOB_QUEUED;
+    job->info.priority = priority;
+    job->info.queued_us = esp_timer_get_time();
+    snprintf(job->info.preview, sizeof(job->info.preview), "%s", text);
+
+    s_ctx.stats.submitted++;
+    s_ctx.stats.depth++;
+    if (s_ctx.stats.depth > s_ctx.stats.max_depth) {
+        s_ctx.stats.max_depth = s_ctx.stats.depth;
+    }
+
+    // Outrank the job speaking: stop it so the worker picks this one next
+    job_slot_t *current = s_ctx.current;
+    if (current && current->info.state == TTS_JOB_SPEAKING && priority > current->info.priority) {
+        current->info.state = TTS_JOB_PREEMPTED;
+        s_ctx.stats.preempted++;
+        tts_stop_async();
+        ESP_LOGI(TAG, "Job %lu (%s) preempts job %lu (%s)",
+                 (unsigned long)job->info.id, s_priority_names[priority],
+                 (unsigned long)current->info.id, s_priority_names[current->info.priority]);
+    }
+
+    *ret_id = job->info.id;
+    xSemaphoreGive(s_ctx.lock);
+
+    xSemaphoreGive(s_ctx.wake);
+    return ESP_OK;
+}
+
+esp_err_t tts_queue_cancel(uint32_t id)
+{
+    if (!s_ctx.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    job_slot_t *job = find_job(id);
+    if (job && job->info.state == TTS_JOB_QUEUED) {
+        drop_queued(job, TTS_JOB_CANCELLED);
+        s_ctx.stats.cancelled++;
+    } else if (job && job->info.state == TTS_JOB_SPEAKING) {
+        job->info.state = TTS_JOB_CANCELLED;
+        s_ctx.stats.cancelled++;
+        tts_stop_async();
+    } else {
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    xSemaphoreGive(s_ctx.lock);
+    return ret;
+}
+
+esp_err_t tts_queue_get_job(uint32_t id, tts_job_info_t *info)
+{
+    if (!s_ctx.running) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    job_slot_t *job = find_job(id);
+    if (job) {
+        *info = job->info;
+        info->position = (job->info.state == TTS_JOB_QUEUED) ? queue_position(job) : 0;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_ctx.lock);
+    return ret;
+}
+
+size_t tts_queue_list(tts_job_info_t *jobs, size_t max)
+{
+    if (!s_ctx.running) {
+        return 0;
+    }
+
+    size_t count = 0;
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    for (int i = 0; i < QUEUE_SLOTS && count < max; i++) {
+        job_slot_t *slot = &s_ctx.slots[i];
+        if (!slot->used) {
+            continue;
+        }
+        // Insertion sort by id, newest first
+        size_t pos = count;
+        while (pos > 0 && jobs[pos - 1].id < slot->info.id) {
+            jobs[pos] = jobs[pos - 1];
+            pos--;
+        }
+        jobs[pos] = slot->info;
+        jobs[pos].position = (slot->info.state == TTS_JOB_QUEUED) ? queue_position(slot) : 0;
+        count++;
+    }
+    xSemaphoreGive(s_ctx.lock);
+    return count;
+}
+
+void tts_queue_get_stats(tts_queue_stats_t *stats)
+{
+    if (!s_ctx.running) {
+        memset(stats, 0, sizeof(*stats));
+        stats->capacity = QUEUE_DEPTH;
+        return;
+    }
+
+    xSemaphoreTake(s_ctx.lock, portMAX_DELAY);
+    *stats = s_ctx.stats;
+    xSemaphoreGive(s_ctx.lock);
+}
+
+const char *tts_queue_state_name(tts_job_state_t state)
+{
+    if ((size_t)state < sizeof(s_state_names) / sizeof(s_state_names[0])) {
+        return s_state_names[state];
+    }
+    return "unknown";
+}
+
+const char *tts_queue_priority_name(tts_priority_t priority)
+{
+    return (priority < TTS_PRIORITY_MAX) ? s_priority_names[priority] : "unknown";
+}
+
+bool tts_queue_parse_priority(const char *name, tts_priority_t *priority)
+{
+    for (int p = 0; p < TTS_PRIORITY_MAX; p++) {
+        if (strcmp(name, s_priority_names[p]) == 0) {
+            *priority = (tts_priority_t)p;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,150 @@
+/**
+ * TTS Job Queue
+ *
+ * Persistent worker that speaks queued texts one at a time, highest
+ * priority first. Submitting returns a job id immediately; a job with a
+ * higher priority than the one speaking preempts it (tts_stop()).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Job priority
+ */
+typedef enum {
+    TTS_PRIORITY_LOW = 0,       // Chatter, preempted by anything above it
+    TTS_PRIORITY_NORMAL,
+    TTS_PRIORITY_ALERT,
+    TTS_PRIORITY_MAX,
+} tts_priority_t;
+
+/**
+ * @brief Job state
+ */
+typedef enum {
+    TTS_JOB_QUEUED = 0,
+    TTS_JOB_SPEAKING,
+    TTS_JOB_DONE,
+    TTS_JOB_FAILED,
+    TTS_JOB_CANCELLED,
+    TTS_JOB_PREEMPTED,
+} tts_job_state_t;
+
+#define TTS_JOB_PREVIEW_LEN 48
+
+/**
+ * @brief Snapshot of one job
+ */
+typedef struct {
+    uint32_t id;
+    tts_job_state_t state;
+    tts_priority_t priority;
+    esp_err_t result;                       // tts_speak_with_speed() result once finished
+    uint32_t position;                      // Jobs ahead of this one while queued
+    int64_t queued_us;                      // esp_timer time stamps, 0 if not reached
+    int64_t started_us;
+    int64_t finished_us;
+    char preview[TTS_JOB_PREVIEW_LEN];      // Start of the text
+} tts_job_info_t;
+
+/**
+ * @brief Queue statistics
+ */
+typedef struct {
+    uint32_t depth;                         // Jobs waiting
+    uint32_t max_depth;                     // High-water mark of depth
+    uint32_t capacity;                      // CONFIG_TTS_QUEUE_DEPTH
+    uint32_t current_id;                    // Job speaking, 0 if idle
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t failed;
+    uint32_t cancelled;
+    uint32_t preempted;
+    uint32_t rejected;                      // Refused because the queue was full
+} tts_queue_stats_t;
+
+/**
+ * @brief Start the worker task
+ *
+ * Requires tts_init(). Safe to call more than once.
+ *
+ * @return ESP_OK on success, error code on failure
+ */
+esp_err_t tts_queue_init(void);
+
+/**
+ * @brief Queue a text for speaking
+ *
+ * @param text Text to speak (copied)
+ * @param speed Speech speed multiplier
+ * @param priority Job priority
+ * @param ret_id Output job id
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the queue is full,
+ *         ESP_ERR_INVALID_STATE if the queue is not running
+ */
+esp_err_t tts_queue_submit(const char *text, float speed, tts_priority_t priority, uint32_t *ret_id);
+
+/**
+ * @brief Cancel a queued job or stop the one speaking
+ *
+ * @param id Job id
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the job is unknown or finished
+ */
+esp_err_t tts_queue_cancel(uint32_t id);
+
+/**
+ * @brief Look up a job (queued, speaking, or among the recently finished)
+ *
+ * @param id Job id
+ * @param info Output snapshot
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the job is unknown
+ */
+esp_err_t tts_queue_get_job(uint32_t id, tts_job_info_t *info);
+
+/**
+ * @brief List known jobs, newest first
+ *
+ * @param jobs Output array
+ * @param max Capacity of jobs
+ * @return Number of entries written
+ */
+size_t tts_queue_list(tts_job_info_t *jobs, size_t max);
+
+/**
+ * @brief Get queue statistics
+ *
+ * @param stats Output statistics
+ */
+void tts_queue_get_stats(tts_queue_stats_t *stats);
+
+/**
+ * @brief Get the name of a job state
+ */
+const char *tts_queue_state_name(tts_job_state_t state);
+
+/**
+ * @brief Get the name of a priority
+ */
+const char *tts_queue_priority_name(tts_priority_t priority);
+
+/**
+ * @brief Parse a priority name ("low", "normal", "alert")
+ *
+ * @param name Name to parse
+ * @param priority Output priority
+ * @return true if the name is known
+ */
+bool tts_queue_parse_priority(const char *name, tts_priority_t *priority);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/**
+ * TTS Text Segmentation
+ */
+
+#include "tts_segment.h"
+#include <ctype.h>
+#include <string.h>
+
+#define SEGMENT_MIN_CHARS 16    // Earlier sentence ends are merged ("Hi.", "Dr.")
+
+/**
+ * Length of a sentence terminator at p (with closing quotes), 0 if none
+ *
+ * ASCII terminators only count when followed by whitespace or the end of
+ * the text, so "3.14" and "..." inside a sentence do not split it.
+ */
+static size_t terminator_len(const char *p)
+{
+    if (*p == '\n') {
+        return 1;
+    }
+
+    if (*p == '.' || *p == '!' || *p == '?') {
+        const char *q = p + 1;
+        while (*q == '"' || *q == '\'' || *q == ')') {
+            q++;
+        }
+        return (*q == '\0' || isspace((unsigned char)*q)) ? (size_t)(q - p) : 0;
+    }
+
+    // Fullwidth CJK terminators: 。 ！ ？
+    const unsigned char *u = (const unsigned char *)p;
+    if ((u[0] == 0xE3 && u[1] == 0x80 && u[2] == 0x82) ||
+        (u[0] == 0xEF && u[1] == 0xBC && (u[2] == 0x81 || u[2] == 0x9F))) {
+        return 3;
+    }
+    return 0;
+}
+
+/**
+ * Move a cut point back to the start of a UTF-8 character
+ */
+static size_t utf8_floor(const char *text, size_t pos)
+{
+    while (pos > 0 && (((unsigned char)text[pos]) & 0xC0) == 0x80) {
+        pos--;
+    }
+    return pos;
+}
+
+size_t tts_segment_next(const char *text, size_t max_chars, bool first_sentence)
+{
+    size_t len = strnlen(text, max_chars + 1);
+    if (len == 0) {
+        return 0;
+    }
+
+    size_t limit = (len < max_chars) ? len : max_chars;
+    size_t sentence = 0;
+    size_t clause = 0;
+    size_t word = 0;
+
+    for (size_t i = 0; i < limit; i++) {
+        size_t term = terminator_len(text + i);
+        if (term > 0) {
+            size_t end = i + term;
+            if (end > limit) {
+                break;
+            }
+            if (end >= SEGMENT_MIN_CHARS) {
+                sentence = end;
+                if (first_sentence) {
+                    break;
+                }
+            }
+            i = end - 1;
+            continue;
+        }
+
+        char c = text[i];
+        if ((c == ',' || c == ';' || c == ':') && isspace((unsigned char)text[i + 1])) {
+            clause = i + 1;
+        } else if (isspace((unsigned char)c)) {
+            word = i;
+        }
+    }
+
+    size_t end;
+    if (first_sentence && sentence > 0) {
+        end = sentence;
+    } else if (len <= max_chars) {
+        return len;
+    } else if (sentence > 0) {
+        end = sentence;
+    } else if (clause > 0) {
+        end = clause;
+    } else if (word > 0) {
+        end = word;
+    } else {
+        end = utf8_floor(text, limit);
+        if (end == 0) {
+            end = limit;  // Malformed UTF-8, cut anyway
+        }
+    }
+
+    while (text[end] != '\0' && isspace((unsigned char)text[end])) {
+        end++;
+    }
+    return end;
+}
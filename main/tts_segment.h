@@ -0,0 +1,32 @@
+/**
+ * TTS Text Segmentation
+ *
+ * Splits long text at sentence boundaries (falling back to clause and word
+ * boundaries for overlong sentences) so it can be synthesized as a series
+ * of short requests.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Find the length of the next segment
+ *
+ * @param text Remaining text (NUL-terminated)
+ * @param max_chars Maximum segment length in bytes
+ * @param first_sentence Stop at the first sentence boundary instead of
+ *                       packing as many whole sentences as fit
+ * @return Bytes in the segment, including the whitespace that follows it;
+ *         0 at the end of the text
+ */
+size_t tts_segment_next(const char *text, size_t max_chars, bool first_sentence);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,47 @@
+/**
+ * Live Streaming Silence Gate
+ */
+
+#include "vad_gate.h"
+#include <string.h>
+#include "freertos/task.h"
+#include "audio_engine.h"
+#include "sdkconfig.h"
+
+void vad_gate_init(vad_gate_t *gate, uint32_t keepalive_ms)
+{
+    memset(gate, 0, sizeof(*gate));
+#if CONFIG_LIVE_VAD_GATE
+    gate->hold_ms = CONFIG_LIVE_VAD_HOLD_MS;
+#endif
+    gate->keepalive_ms = keepalive_ms;
+    gate->last_sent = xTaskGetTickCount();
+}
+
+vad_gate_action_t vad_gate_check(vad_gate_t *gate)
+{
+#if CONFIG_LIVE_VAD_GATE
+    audio_engine_vad_t vad;
+    audio_engine_vad_get(&vad);
+    TickType_t now = xTaskGetTickCount();
+
+    if (vad.speech || vad.silence_ms < gate->hold_ms) {
+        gate->closed = false;
+        gate->last_sent = now;
+        return VAD_GATE_SEND;
+    }
+
+    gate->dropped++;
+    if (!gate->closed) {
+        gate->closed = true;
+        return VAD_GATE_CLOSE;
+    }
+    if (gate->keepalive_ms && now - gate->last_sent >= pdMS_TO_TICKS(gate->keepalive_ms)) {
+        gate->last_sent = now;
+        return VAD_GATE_KEEPALIVE;
+    }
+    return VAD_GATE_DROP;
+#else
+    return VAD_GATE_SEND;
+#endif
+}
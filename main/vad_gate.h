@@ -0,0 +1,56 @@
+/**
+ * Live Streaming Silence Gate
+ *
+ * Decides per captured chunk whether a live STT stream sends it, from the
+ * audio engine's voice activity decision. Streaming continues for a hold
+ * time after speech ends so the provider sees the trailing silence its
+ * own endpointing needs, then stops until speech resumes.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What to do with the chunk just read
+ */
+typedef enum {
+    VAD_GATE_SEND = 0,          // Speech or within the hold: send it
+    VAD_GATE_CLOSE,             // First dropped chunk: the utterance is over
+    VAD_GATE_DROP,              // Silence: do not send
+    VAD_GATE_KEEPALIVE,         // Silence, and a keepalive is due
+} vad_gate_action_t;
+
+/**
+ * @brief Gate state
+ */
+typedef struct {
+    uint32_t hold_ms;
+    uint32_t keepalive_ms;      // 0: never ask for keepalives
+    bool closed;                // Dropping chunks
+    TickType_t last_sent;       // Last audio or keepalive
+    uint32_t dropped;           // Chunks not sent
+} vad_gate_t;
+
+/**
+ * @brief Initialize a gate
+ *
+ * @param gate Gate
+ * @param keepalive_ms Interval for VAD_GATE_KEEPALIVE while closed, 0 for none
+ */
+void vad_gate_init(vad_gate_t *gate, uint32_t keepalive_ms);
+
+/**
+ * @brief Classify the chunk just read from a capture stream
+ */
+vad_gate_action_t vad_gate_check(vad_gate_t *gate);
+
+#ifdef __cplusplus
+}
+#endif
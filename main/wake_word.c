@@ -0,0 +1,323 @@
+/**
+ * Wake Word
+ *
+ * The detector runs at a lower priority than the STT pre-roll and the
+ * streamers on the core picked in menuconfig, reading 16 kHz mono straight
+ * from the audio engine. While a session is running frames are still read,
+ * so the stream never overruns, but not passed to the model.
+ */
+
+#include "wake_word.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_WAKE_WORD_ENABLE
+
+#include "esp_wn_iface.h"
+#include "esp_wn_models.h"
+#include "model_path.h"
+#include "audio_engine.h"
+#include "audio_pool.h"
+#include "stt.h"
+#include "live_stt.h"
+#include "task_topology.h"
+
+static const char *TAG = "wake_word";
+
+#define WAKE_WORD_SAMPLE_RATE 16000     // WakeNet models are 16 kHz
+#define CAPTURE_BUFFER_MS 500
+#define READ_TIMEOUT_MS 200
+#define LOAD_WINDOW_MS 5000             // Detector load is averaged over this much audio
+#define COOLDOWN_MS 2000                // Ignore the tail of the same keyword after a session ends
+#define STOP_TIMEOUT_MS 1000            // The task exits within a frame read
+
+#if CONFIG_WAKE_WORD_ACTION_LIVE
+#define ACTION_NAME "live"
+#elif CONFIG_WAKE_WORD_ACTION_OPENAI_LIVE
+#define ACTION_NAME "openai-live"
+#elif CONFIG_WAKE_WORD_ACTION_PIPELINED
+#define ACTION_NAME "pipelined"
+#else
+#define ACTION_NAME "batch"
+#endif
+
+static struct {
+    TaskHandle_t task;
+    SemaphoreHandle_t done;             // Given by the task as it exits
+    volatile bool stop;
+    srmodel_list_t *models;
+    const esp_wn_iface_t *wakenet;
+    model_iface_data_t *model;
+    int chunk;                          // Samples per detector frame
+    wake_word_stats_t stats;
+} s_ctx;
+
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool session_busy(void)
+{
+    return stt_is_busy() || live_stt_is_busy(LIVE_STT_DEEPGRAM) || live_stt_is_busy(LIVE_STT_OPENAI);
+}
+
+/**
+ * Start the configured STT session
+ */
+static esp_err_t start_session(void)
+{
+#if CONFIG_WAKE_WORD_ACTION_LIVE
+    return live_stt_start(LIVE_STT_DEEPGRAM);
+#elif CONFIG_WAKE_WORD_ACTION_OPENAI_LIVE
+    return live_stt_start(LIVE_STT_OPENAI);
+#elif CONFIG_WAKE_WORD_ACTION_PIPELINED
+    return stt_start_recording_mode(STT_MODE_PIPELINED);
+#else
+    return stt_start_recording_mode(STT_MODE_BATCH);
+#endif
+}
+
+/**
+ * Handle a keyword; frame_us is when the frame that triggered it was read
+ */
+static void on_detected(int index, int64_t frame_us)
+{
+    const char *word = s_ctx.wakenet->get_word_name(s_ctx.model, index);
+
+    if (session_busy()) {
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_ctx.stats.ignored++;
+        taskEXIT_CRITICAL(&s_stats_lock);
+        ESP_LOGI(TAG, "Heard \"%s\" during a session, ignored", word);
+        return;
+    }
+
+    esp_err_t err = start_session();
+    uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - frame_us) / 1000);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    if (err == ESP_OK) {
+        s_ctx.stats.detections++;
+        s_ctx.stats.latency_ms = latency_ms;
+        if (latency_ms > s_ctx.stats.latency_max_ms) {
+            s_ctx.stats.latency_max_ms = latency_ms;
+        }
+    } else {
+        s_ctx.stats.start_failures++;
+    }
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Heard \"%s\", %s session started in %lu ms", word, ACTION_NAME,
+                 (unsigned long)latency_ms);
+    } else {
+        ESP_LOGW(TAG, "Heard \"%s\", %s session failed: %s", word, ACTION_NAME, esp_err_to_name(err));
+    }
+}
+
+static void wake_word_task(void *arg)
+{
+    audio_engine_stream_handle_t capture = NULL;
+    int16_t *frame = audio_pool_alloc(AUDIO_POOL_INTERNAL, s_ctx.chunk * sizeof(int16_t));
+    uint32_t frame_us = (uint32_t)((int64_t)s_ctx.chunk * 1000000 / WAKE_WORD_SAMPLE_RATE);
+    uint32_t window_frames = LOAD_WINDOW_MS * 1000 / frame_us;
+
+    if (!frame || audio_engine_capture_open(WAKE_WORD_SAMPLE_RATE, CAPTURE_BUFFER_MS, &capture) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open microphone");
+        goto done;
+    }
+
+    ESP_LOGI(TAG, "Listening on core %d (%lu ms frames)", xPortGetCoreID(), (unsigned long)(frame_us / 1000));
+
+    uint32_t frames = 0;
+    uint64_t busy_us = 0;
+    uint32_t max_us = 0;
+    TickType_t quiet_until = 0;
+    bool was_busy = false;
+
+    while (!s_ctx.stop) {
+        size_t got = 0;
+        while (got < (size_t)s_ctx.chunk && !s_ctx.stop) {
+            got += audio_engine_capture_read(capture, frame + got, s_ctx.chunk - got, READ_TIMEOUT_MS);
+        }
+        if (s_ctx.stop) {
+            break;
+        }
+
+        // Keep the model fed only while it can act on a detection
+        bool busy = session_busy();
+        if (busy || (int32_t)(xTaskGetTickCount() - quiet_until) < 0) {
+            was_busy = was_busy || busy;
+            continue;
+        }
+        if (was_busy) {
+            was_busy = false;
+            quiet_until = xTaskGetTickCount() + pdMS_TO_TICKS(COOLDOWN_MS);
+            continue;
+        }
+
+        int64_t read_us = esp_timer_get_time();
+        wakenet_state_t result = s_ctx.wakenet->detect(s_ctx.model, frame);
+        uint32_t spent_us = (uint32_t)(esp_timer_get_time() - read_us);
+
+        busy_us += spent_us;
+        if (spent_us > max_us) {
+            max_us = spent_us;
+        }
+        if (++frames >= window_frames) {
+            taskENTER_CRITICAL(&s_stats_lock);
+            s_ctx.stats.load_pct = (uint32_t)(busy_us * 100 / ((uint64_t)frames * frame_us));
+            s_ctx.stats.detect_us = (uint32_t)(busy_us / frames);
+            s_ctx.stats.detect_max_us = max_us;
+            taskEXIT_CRITICAL(&s_stats_lock);
+            frames = 0;
+            busy_us = 0;
+            max_us = 0;
+        }
+
+        if (result > 0) {
+            on_detected(result, read_us);
+        }
+    }
+
+done:
+    if (capture) {
+        audio_engine_stream_close(capture);
+    }
+    audio_pool_free(frame);
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_ctx.stats.running = false;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    s_ctx.task = NULL;
+    xSemaphoreGive(s_ctx.done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t wake_word_start(void)
+{
+    if (s_ctx.task) {
+        return ESP_OK;
+    }
+
+#if !CONFIG_WAKE_WORD_ACTION_LIVE && !CONFIG_WAKE_WORD_ACTION_OPENAI_LIVE
+    esp_err_t err = stt_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "STT init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+#endif
+
+    if (!s_ctx.model) {
+        s_ctx.models = esp_srmodel_init("model");
+        char *name = s_ctx.models ? esp_srmodel_filter(s_ctx.models, ESP_WN_PREFIX, NULL) : NULL;
+        if (!name) {
+            ESP_LOGE(TAG, "No WakeNet model in the \"model\" partition");
+            if (s_ctx.models) {
+                esp_srmodel_deinit(s_ctx.models);
+                s_ctx.models = NULL;
+            }
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        s_ctx.wakenet = esp_wn_handle_from_name(name);
+#if CONFIG_WAKE_WORD_AGGRESSIVE
+        s_ctx.model = s_ctx.wakenet ? s_ctx.wakenet->create(name, DET_MODE_95) : NULL;
+#else
+        s_ctx.model = s_ctx.wakenet ? s_ctx.wakenet->create(name, DET_MODE_90) : NULL;
+#endif
+        if (!s_ctx.model) {
+            ESP_LOGE(TAG, "Failed to create WakeNet model %s", name);
+            esp_srmodel_deinit(s_ctx.models);
+            s_ctx.models = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+
+        int rate = s_ctx.wakenet->get_samp_rate(s_ctx.model);
+        if (rate != WAKE_WORD_SAMPLE_RATE) {
+            ESP_LOGW(TAG, "Model %s expects %d Hz, capturing at %d Hz", name, rate,
+                     WAKE_WORD_SAMPLE_RATE);
+        }
+        s_ctx.chunk = s_ctx.wakenet->get_samp_chunksize(s_ctx.model);
+        ESP_LOGI(TAG, "Loaded %s (\"%s\")", name, s_ctx.wakenet->get_word_name(s_ctx.model, 1));
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_ctx.stats.running = true;
+    s_ctx.stats.word = s_ctx.wakenet->get_word_name(s_ctx.model, 1);
+    s_ctx.stats.frame_ms = s_ctx.chunk * 1000 / WAKE_WORD_SAMPLE_RATE;
+    taskEXIT_CRITICAL(&s_stats_lock);
+
+    if (!s_ctx.done) {
+        s_ctx.done = xSemaphoreCreateBinary();
+        if (!s_ctx.done) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreTake(s_ctx.done, 0);  // Still given if the last task exited on its own
+
+    s_ctx.stop = false;
+    BaseType_t created = xTaskCreatePinnedToCore(wake_word_task, "wake_word", TASK_WAKE_WORD_STACK, NULL,
+                                                 TASK_WAKE_WORD_PRIORITY, &s_ctx.task,
+                                                 CONFIG_WAKE_WORD_CORE);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create wake word task");
+        s_ctx.task = NULL;
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_ctx.stats.running = false;
+        taskEXIT_CRITICAL(&s_stats_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void wake_word_stop(void)
+{
+    s_ctx.stop = true;
+    if (s_ctx.task && xSemaphoreTake(s_ctx.done, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Wake word task did not stop");
+        return;  // The model stays loaded while the task may still use it
+    }
+
+    if (s_ctx.model) {
+        s_ctx.wakenet->destroy(s_ctx.model);
+        s_ctx.model = NULL;
+    }
+    if (s_ctx.models) {
+        esp_srmodel_deinit(s_ctx.models);
+        s_ctx.models = NULL;
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_ctx.stats.word = NULL;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+void wake_word_get_stats(wake_word_stats_t *stats)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    *stats = s_ctx.stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    stats->action = ACTION_NAME;
+}
+
+#else  // !CONFIG_WAKE_WORD_ENABLE
+
+esp_err_t wake_word_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void wake_word_stop(void)
+{
+}
+
+void wake_word_get_stats(wake_word_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif  // CONFIG_WAKE_WORD_ENABLE
@@ -0,0 +1,65 @@
+/**
+ * Wake Word
+ *
+ * Always-on keyword spotter (ESP-SR WakeNet) on its own capture stream and
+ * core. When the keyword fires it starts the STT session selected in
+ * menuconfig, so a recording can begin without the web UI. Batch and
+ * pipelined recordings open with the STT pre-roll, which still holds the
+ * words spoken right after the keyword.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Wake word statistics
+ */
+typedef struct {
+    bool running;
+    const char *word;           // Keyword of the loaded model, NULL if not running
+    const char *action;         // Session started on detection ("batch", "pipelined", "live", "openai-live")
+    uint32_t frame_ms;          // Audio per detector frame
+    uint32_t detections;        // Keywords that started a session
+    uint32_t ignored;           // Keywords heard while a session was already running
+    uint32_t start_failures;    // Sessions that failed to start
+    uint32_t load_pct;          // Detector time over audio time, last window
+    uint32_t detect_us;         // Mean detector time per frame, last window
+    uint32_t detect_max_us;     // Slowest frame, last window
+    uint32_t latency_ms;        // Triggering frame read to session started, last detection
+    uint32_t latency_max_ms;
+} wake_word_stats_t;
+
+/**
+ * @brief Load the model and start listening
+ *
+ * Needs the "model" partition flashed with the ESP-SR models and, for
+ * batch and pipelined actions, a working STT configuration. Safe to call
+ * more than once.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if disabled in menuconfig,
+ *         ESP_ERR_NOT_FOUND if no WakeNet model is flashed
+ */
+esp_err_t wake_word_start(void);
+
+/**
+ * @brief Stop listening and free the model
+ */
+void wake_word_stop(void);
+
+/**
+ * @brief Get statistics
+ *
+ * @param stats Output statistics
+ */
+void wake_word_get_stats(wake_word_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
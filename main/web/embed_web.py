@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Compress the web UI into a C source file.
+
+Usage: embed_web.py OUTPUT.c ASSET...
+
+Every asset is gzipped (mtime 0, so builds are reproducible) and emitted as
+a const byte array in a web_asset_t table (see main/web_assets.h), together
+with its content type and an ETag derived from the compressed bytes.
+"""
+
+import gzip
+import hashlib
+import os
+import sys
+
+CONTENT_TYPES = {
+    '.html': 'text/html',
+    '.css': 'text/css',
+    '.js': 'application/javascript',
+}
+
+
+def c_ident(name):
+    return ''.join(c if c.isalnum() else '_' for c in name)
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: embed_web.py OUTPUT.c ASSET...')
+    out_path, assets = sys.argv[1], sys.argv[2:]
+
+    lines = [
+        '/* Generated by main/web/embed_web.py - do not edit */',
+        '',
+        '#include "web_assets.h"',
+        '',
+        '#include <string.h>',
+        '',
+    ]
+    entries = []
+    for path in assets:
+        name = os.path.basename(path)
+        ext = os.path.splitext(name)[1]
+        if ext not in CONTENT_TYPES:
+            sys.exit('embed_web.py: no content type for ' + name)
+        with open(path, 'rb') as f:
+            raw = f.read()
+        data = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '"' + hashlib.sha256(data).hexdigest()[:16] + '"'
+        ident = c_ident(name)
+
+        lines.append('static const uint8_t %s_gz[%d] = {' % (ident, len(data)))
+        for i in range(0, len(data), 16):
+            lines.append('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+        entries.append('    {"%s", "%s", %s_gz, sizeof(%s_gz), %d, "%s"},' % (
+            name, CONTENT_TYPES[ext], ident, ident, len(raw), etag.replace('"', '\\"')))
+
+    lines.append('const web_asset_t web_assets[] = {')
+    lines += entries
+    lines.append('};')
+    lines.append('')
+    lines.append('const size_t web_assets_count = sizeof(web_assets) / sizeof(web_assets[0]);')
+    lines += [
+        '',
+        'const web_asset_t *web_asset_find(const char *name)',
+        '{',
+        '    for (size_t i = 0; i < web_assets_count; i++) {',
+        '        if (strcmp(web_assets[i].name, name) == 0) {',
+        '            return &web_assets[i];',
+        '        }',
+        '    }',
+        '    return NULL;',
+        '}',
+    ]
+
+    with open(out_path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,14 @@
+function byteLen(s) { return new TextEncoder().encode(s).length; }
+function transcriptSocket(source, onMessage, onLink) {
+  if (!('WebSocket' in window)) { onLink(false); return; }
+  const ws = new WebSocket('ws://' + location.host + '/ws/transcripts');
+  ws.onopen = function() { onLink(true); };
+  ws.onmessage = function(ev) {
+    try { const m = JSON.parse(ev.data); if (m.source === source) onMessage(m); }
+    catch (err) { console.error('Push error:', err); }
+  };
+  ws.onclose = function() {
+    onLink(false);
+    setTimeout(function() { transcriptSocket(source, onMessage, onLink); }, 2000);
+  };
+}
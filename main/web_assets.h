@@ -0,0 +1,44 @@
+/**
+ * Web UI Assets
+ *
+ * The pages, stylesheet and scripts under main/web/ are gzipped at build
+ * time (main/web/embed_web.py) and linked into flash as const arrays, so
+ * they are served as-is with Content-Encoding: gzip and never copied at
+ * runtime. Lengths and ETags are fixed at build time.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Embedded asset
+ */
+typedef struct {
+    const char *name;           // File name under main/web/, e.g. "tts.html"
+    const char *content_type;
+    const uint8_t *data;        // gzip stream
+    size_t len;                 // Compressed length
+    size_t raw_len;             // Uncompressed length, for logging
+    const char *etag;           // Quoted, derived from the compressed bytes
+} web_asset_t;
+
+extern const web_asset_t web_assets[];
+extern const size_t web_assets_count;
+
+/**
+ * @brief Look up an asset by file name
+ *
+ * @param name File name, e.g. "common.css"
+ * @return Asset, or NULL if it was not embedded
+ */
+const web_asset_t *web_asset_find(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
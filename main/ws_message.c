@@ -0,0 +1,75 @@
+/**
+ * WebSocket Text Message Reassembly
+ */
+
+#include "ws_message.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "ws_message";
+
+#define WS_OP_CONTINUATION 0x00
+#define WS_OP_TEXT 0x01
+
+esp_err_t ws_message_init(ws_message_t *msg, size_t capacity)
+{
+    memset(msg, 0, sizeof(*msg));
+    msg->buf = heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM);
+    if (!msg->buf) {
+        return ESP_ERR_NO_MEM;
+    }
+    msg->capacity = capacity;
+    return ESP_OK;
+}
+
+void ws_message_free(ws_message_t *msg)
+{
+    heap_caps_free(msg->buf);
+    memset(msg, 0, sizeof(*msg));
+}
+
+bool ws_message_feed(ws_message_t *msg, const esp_websocket_event_data_t *data,
+                     const char **text, size_t *len)
+{
+    bool first_chunk = data->payload_offset == 0;
+    bool frame_done = data->payload_offset + data->data_len >= data->payload_len;
+
+    if (data->op_code == WS_OP_TEXT && first_chunk) {
+        // Whole message in one event: parse in place
+        if (data->fin && frame_done) {
+            msg->active = false;
+            *text = data->data_ptr;
+            *len = data->data_len;
+            return true;
+        }
+        msg->active = true;
+        msg->overflow = false;
+        msg->len = 0;
+    } else if (!msg->active || (data->op_code != WS_OP_CONTINUATION && data->op_code != WS_OP_TEXT)) {
+        // Binary and control frames, or a continuation without a start
+        return false;
+    }
+
+    if (!msg->overflow) {
+        if (msg->len + data->data_len > msg->capacity) {
+            ESP_LOGW(TAG, "Message exceeds %d bytes, dropped", (int)msg->capacity);
+            msg->overflow = true;
+        } else {
+            memcpy(msg->buf + msg->len, data->data_ptr, data->data_len);
+            msg->len += data->data_len;
+        }
+    }
+
+    if (!frame_done || !data->fin) {
+        return false;
+    }
+
+    msg->active = false;
+    if (msg->overflow) {
+        return false;
+    }
+    *text = msg->buf;
+    *len = msg->len;
+    return true;
+}
@@ -0,0 +1,60 @@
+/**
+ * WebSocket Text Message Reassembly
+ *
+ * esp_websocket_client delivers a frame larger than its buffer as several
+ * DATA events, and a fragmented message as a text frame followed by
+ * continuation frames. This collects the pieces into one preallocated
+ * buffer; complete single-event messages are passed through without a copy.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_websocket_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Reassembly state
+ */
+typedef struct {
+    char *buf;                  // PSRAM, allocated once
+    size_t capacity;
+    size_t len;
+    bool active;                // Inside a text message
+    bool overflow;              // Message exceeded capacity and is dropped
+} ws_message_t;
+
+/**
+ * @brief Allocate the reassembly buffer
+ *
+ * @param msg State to initialize
+ * @param capacity Largest message accepted
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on failure
+ */
+esp_err_t ws_message_init(ws_message_t *msg, size_t capacity);
+
+/**
+ * @brief Free the reassembly buffer
+ */
+void ws_message_free(ws_message_t *msg);
+
+/**
+ * @brief Feed a WEBSOCKET_EVENT_DATA event
+ *
+ * @param msg Reassembly state
+ * @param data Event data
+ * @param[out] text Complete message (valid until the next call)
+ * @param[out] len Message length
+ * @return true when a complete text message is available
+ */
+bool ws_message_feed(ws_message_t *msg, const esp_websocket_event_data_t *data,
+                     const char **text, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif